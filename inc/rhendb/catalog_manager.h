@@ -126,6 +126,12 @@ struct catalog_manager
 	// this where new ids come from, each id in the schema is unique across all entities, unless it has partitions
 	pthread_mutex_t global_unique_schema_id_lock;
 	uint64_t global_unique_schema_id; // starts with FIRST_SCHEMA_UNIQUE_ID
+
+	// the catalog tables are never vaccummed (or frozen), so the transaction_table must retain the statuses of all the transaction_ids its rows refer to
+	// has_min_referenced_transaction_id is 0, if no row refers to any transaction_id, computed at boot and lowered on every xmin/xmax written
+	pthread_mutex_t min_referenced_transaction_id_lock;
+	int has_min_referenced_transaction_id;
+	uint256 min_referenced_transaction_id;
 };
 
 typedef enum rhendb_base_type rhendb_base_type;
@@ -315,4 +321,8 @@ data_type_info* get_data_type_info_for_rhendb_table_partition_from_catalog(catal
 
 data_type_info* get_data_type_info_for_rhendb_index_from_catalog(catalog_manager* catmgr_p, const mvcc_snapshot* ss_p, rhendb_index* index);
 
+// returns 1 and sets min_referenced_transaction_id, to the least transaction_id that any row of the catalog refers to, returns 0 if there is none
+// the transaction_table must never be truncated beyond it, see truncate_transaction_table_for_rhendb()
+int get_min_transaction_id_referenced_by_catalog(catalog_manager* catmgr_p, uint256* min_referenced_transaction_id);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,69 @@
+#ifndef FLAT_HASH_TABLE_H
+#define FLAT_HASH_TABLE_H
+
+#include<inttypes.h>
+
+/*
+	flat_hash_table is an in-memory open-addressing (linear probing) hash table, of pointers to tuples owned by someone else
+	it is built once with a known number of entries by a single thread, and is read-only after that, so it needs no locks
+	duplicate hash_values are allowed, the user must compare the tuples of all the entries with the same hash_value, to find the matching ones
+
+	the home slot of a hash_value is picked using its high bits (fibonacci hashing), so its low bits are free to be used for radix partitioning
+*/
+
+typedef struct flat_hash_table_entry flat_hash_table_entry;
+struct flat_hash_table_entry
+{
+	uint64_t hash_value;
+
+	// NULL only for the empty slots
+	const void* tuple;
+};
+
+typedef struct flat_hash_table flat_hash_table;
+struct flat_hash_table
+{
+	// always a power of 2, and atleast twice the entries_count
+	uint64_t slots_count;
+	uint32_t slots_count_bits;
+
+	uint64_t entries_count;
+
+	flat_hash_table_entry* slots;
+
+	// is_matched[i] flags the entry at slots[i], only allocated if asked for
+	uint8_t* is_matched;
+};
+
+#define FLAT_HASH_TABLE_NO_SLOT UINT64_MAX
+
+// max_entries_count is the number of entries that are going to be inserted
+void initialize_flat_hash_table(flat_hash_table* fht_p, uint64_t max_entries_count, int needs_is_matched_flags);
+
+// tuple must not be NULL
+void insert_in_flat_hash_table(flat_hash_table* fht_p, uint64_t hash_value, const void* tuple);
+
+static inline uint64_t get_home_slot_in_flat_hash_table(const flat_hash_table* fht_p, uint64_t hash_value)
+{
+	return (hash_value * UINT64_C(0x9E3779B97F4A7C15)) >> (64 - fht_p->slots_count_bits);
+}
+
+// to be called for the upcoming probes, a few probes ahead of them
+static inline void prefetch_home_slot_in_flat_hash_table(const flat_hash_table* fht_p, uint64_t hash_value)
+{
+	__builtin_prefetch(&(fht_p->slots[get_home_slot_in_flat_hash_table(fht_p, hash_value)]));
+}
+
+// returns the first slot starting at from_slot (in the probing order), holding an entry with hash_value
+// returns FLAT_HASH_TABLE_NO_SLOT, on reaching an empty slot
+// to find all entries of a hash_value, start with its home slot, and continue with 1 slot after the last slot returned
+uint64_t find_in_flat_hash_table(const flat_hash_table* fht_p, uint64_t hash_value, uint64_t from_slot);
+
+static inline uint64_t get_next_slot_in_flat_hash_table(const flat_hash_table* fht_p, uint64_t slot)
+{
+	return (slot + 1) & (fht_p->slots_count - 1);
+}
+
+void deinitialize_flat_hash_table(flat_hash_table* fht_p);
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef HEAP_PAGE_MORSEL_CURSOR_H
+#define HEAP_PAGE_MORSEL_CURSOR_H
+
+#include<pthread.h>
+
+#include<rhendb/fetched_table.h>
+#include<rhendb/rage_engine.h>
+#include<rhendb/heap_table_walks_guard.h>
+
+#include<tupleindexer/heap_table/heap_table.h>
+
+/*
+	a heap_page_morsel is a run of upto morsel_pages_count heap pages, all of a single partition of a fetched_table
+	the heap_page_morsel_cursor hands out the heap_page_morsel-s, from a single shared position, to all the concurrent jobs of an operator
+	so every job claims the next morsel as soon as it is done with the previous one, and even a single partition gets processed by all of them
+
+	the heap pages are enumerated from one of the below sources
+	* HEAP_TABLE_WALK : walks the heap_table of every partition (from the first to the last), and claims the page_ids of the heap pages in it, used by the scans
+	  only 1 job walks at a time, without holding the cursor_lock, so the cursor_lock is never held while the heap pages fault into the bufferpool
+	  the claimed heap pages are locked again by the jobs to process them, they are never freed in between, as the heap_tables are registered as being walked in the heap_table_walks_guard
+	* SORTED_TUPLE_POINTERS : claims ranges of the caller's array of (partition_id, tuple_pointer), sorted by them, a morsel never splits the tuples of a page, used by the pointer_lookup and deletion operators
+*/
+
+// pages in a morsel, large enough to amortize the cursor_lock, small enough to keep the jobs balanced at the end of a partition
+#define DEFAULT_HEAP_PAGES_PER_MORSEL 16
+#define MAX_HEAP_PAGES_PER_MORSEL 64
+
+typedef enum heap_page_morsel_source heap_page_morsel_source;
+enum heap_page_morsel_source
+{
+	HEAP_TABLE_WALK,
+	SORTED_TUPLE_POINTERS,
+};
+
+typedef struct heap_page_morsel heap_page_morsel;
+struct heap_page_morsel
+{
+	// index of the partition in the table_partitions_info of the fetched_table, that all the pages of this morsel belong to
+	uint64_t partition_index_in_info;
+
+	// for HEAP_TABLE_WALK, the page_ids of the heap pages claimed, in the order of the heap_table
+	uint32_t page_ids_count;
+	uint64_t page_ids[MAX_HEAP_PAGES_PER_MORSEL];
+
+	// for SORTED_TUPLE_POINTERS, the range [first_index, last_index) of the caller's array claimed
+	cy_uint first_index;
+	cy_uint last_index;
+};
+
+typedef struct heap_page_morsel_cursor heap_page_morsel_cursor;
+struct heap_page_morsel_cursor
+{
+	// protects all of the below attributes, it is held only while claiming a morsel, except while a job walks the heap_table
+	pthread_mutex_t cursor_lock;
+
+	heap_page_morsel_source source;
+
+	uint32_t morsel_pages_count;
+
+	const fetched_table* ftabl;
+
+	// for HEAP_TABLE_WALK
+
+	rage_engine* engine;
+
+	// the heap_tables of all the partitions are registered as being walked in it, from the initialization to the deinitialization of the cursor
+	heap_table_walks_guard* htwg_p;
+
+	// set while a job walks, then only that job accesses the below walk attributes, even without the cursor_lock, and the other jobs wait on the walk_done
+	int is_being_walked;
+	pthread_cond_t walk_done;
+
+	// partition being walked, the hti_p is positioned at its next heap page yet to be claimed, the hti_p is NULL if the partition is not yet opened
+	uint64_t partition_pos;
+	heap_table_tuple_defs httd;
+	heap_table_iterator* hti_p;
+
+	// set if the walk was aborted, then no more morsels are ever claimed
+	int is_aborted;
+
+	// for SORTED_TUPLE_POINTERS
+
+	const void* tuple_pointers;
+	cy_uint tuple_pointers_count;
+	void (*get_tuple_pointer)(const void* tuple_pointers, cy_uint index, uint64_t* partition_id, tuple_pointer* tptr);
+
+	// index of the next element of the tuple_pointers yet to be claimed, and the index of the partition it belongs to (or lies beyond)
+	cy_uint next_index;
+	uint64_t next_partition_index_in_info;
+};
+
+// a read only walk, i.e. the heap pages are only read locked (and unlocked immediately) to learn their page_ids
+// deinitialize the cursor only after all the claimed heap pages are processed, as no empty heap page of this table is freed until then
+void initialize_heap_page_morsel_cursor_for_heap_table_walk(heap_page_morsel_cursor* hpmc_p, const fetched_table* ftabl, rage_engine* engine, heap_table_walks_guard* htwg_p, uint32_t morsel_pages_count);
+
+// the tuple_pointers must remain sorted by (partition_id, page_id) and unmodified, until the cursor is deinitialized
+void initialize_heap_page_morsel_cursor_for_sorted_tuple_pointers(heap_page_morsel_cursor* hpmc_p, const fetched_table* ftabl, uint32_t morsel_pages_count, const void* tuple_pointers, cy_uint tuple_pointers_count, void (*get_tuple_pointer)(const void* tuple_pointers, cy_uint index, uint64_t* partition_id, tuple_pointer* tptr));
+
+// returns 1 and fills the morsel, if a morsel was claimed, 0 if there are no more morsels left
+// on an abort_error (only for HEAP_TABLE_WALK), 0 is returned for this and every subsequent claim
+int claim_heap_page_morsel(heap_page_morsel_cursor* hpmc_p, heap_page_morsel* morsel, int* abort_error);
+
+void deinitialize_heap_page_morsel_cursor(heap_page_morsel_cursor* hpmc_p);
+
+#endif
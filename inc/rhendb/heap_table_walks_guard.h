@@ -0,0 +1,45 @@
+#ifndef HEAP_TABLE_WALKS_GUARD_H
+#define HEAP_TABLE_WALKS_GUARD_H
+
+#include<pthread.h>
+#include<stdint.h>
+
+/*
+	a heap_page_morsel_cursor hands out the page_ids of the heap pages of a heap_table, and its jobs lock those heap pages only later, to process them
+	in the meantime the vaccum may empty such a heap page, and fixing its unused space entry (fix_unused_space_in_heap_table()) would then free it, for it to be reused as any other page of the database
+	so the unused space entries of a heap_table are fixed, only while no heap_page_morsel_cursor is walking it, else they are left as is, for a later vaccum to fix them
+
+	the heap_tables are striped by their root_page_id, and a stripe counts the walks in progress on all of its heap_tables
+	unrelated heap_tables may share a stripe, that only delays fixing their unused space entries
+*/
+
+#define HEAP_TABLE_WALKS_GUARD_STRIPES_COUNT 64
+
+typedef struct heap_table_walks_guard_stripe heap_table_walks_guard_stripe;
+struct heap_table_walks_guard_stripe
+{
+	// protects the walks_count, it is also held throughout the fixing of the unused space entries of a heap_table of this stripe
+	pthread_mutex_t stripe_lock;
+	uint64_t walks_count;
+};
+
+typedef struct heap_table_walks_guard heap_table_walks_guard;
+struct heap_table_walks_guard
+{
+	heap_table_walks_guard_stripe stripes[HEAP_TABLE_WALKS_GUARD_STRIPES_COUNT];
+};
+
+void initialize_heap_table_walks_guard(heap_table_walks_guard* htwg_p);
+
+// a walk begins before the first page_id of the heap_table is handed out, and ends only after all of them have been processed
+void begin_heap_table_walk(heap_table_walks_guard* htwg_p, uint64_t heap_root_page_id);
+void end_heap_table_walk(heap_table_walks_guard* htwg_p, uint64_t heap_root_page_id);
+
+// returns 1, if no walk is in progress on the heap_table, then the caller may fix its unused space entries, and must call end_fixing_unused_space_entries() right after
+// returns 0, if a walk is in progress, then the caller must not fix them
+int try_begin_fixing_unused_space_entries(heap_table_walks_guard* htwg_p, uint64_t heap_root_page_id);
+void end_fixing_unused_space_entries(heap_table_walks_guard* htwg_p, uint64_t heap_root_page_id);
+
+void deinitialize_heap_table_walks_guard(heap_table_walks_guard* htwg_p);
+
+#endif
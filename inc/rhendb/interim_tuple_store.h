@@ -58,6 +58,20 @@ struct interim_tuple_store
 
 	int fd; // file_descriptor to be accessed for mapping the memory
 
+	// set if the fd is a memfd (anonymous memory), accounted against the process-wide interim memory budget
+	// else the fd is a temp file in INTERIM_TUPLE_STORE_DIR_PATH
+	int is_in_memory;
+
+	// bytes of this interim_tuple_store accounted against the interim memory budget, always equals total_size while is_in_memory is set, else 0
+	uint64_t in_memory_bytes;
+
+	// if set, this interim_tuple_store never spills to a temp file, once created in memory
+	// set it if the interim_tuple_store is being read concurrently through interim_tuple_regions that are not its embed_regions
+	int is_spill_disabled;
+
+	// if set, the written regions of a temp file backed interim_tuple_store are handed to the kernel for write-back as soon as they are unmapped
+	int is_write_behind_enabled;
+
 	// embedded node to possibly put interim_tuple_store inside atmost any one type of datastructure
 	// embed_node_ll will be used to put it inside the output of the operators it gets passed out of
 	union
@@ -88,12 +102,41 @@ struct interim_tuple_store_snapshot
 	int fd;
 };
 
+/*
+	interim_tuple_stores start in memory (on a memfd), as long as the process-wide interim memory budget allows it
+	once the budget is exceeded, new interim_tuple_stores are created as temp files in INTERIM_TUPLE_STORE_DIR_PATH
+	and an in memory interim_tuple_store that needs to grow beyond the budget is spilled to a temp file, at the same fd
+	the spill remaps all the open embed_regions to the temp file at the same addresses, so the tuple pointers in them stay valid
+	but any other interim_tuple_region open on the interim_tuple_store would be left pointing to the stale memory, hence see is_spill_disabled
+*/
+
+#define DEFAULT_INTERIM_MEMORY_BUDGET (UINT64_C(256) * 1024 * 1024)
+
+// the budget is process-wide, and below functions are thread safe
+void set_interim_memory_budget(uint64_t interim_memory_budget);
+uint64_t get_interim_memory_budget();
+
+// total bytes held by all the in memory interim_tuple_stores in this process
+uint64_t get_interim_memory_in_use();
+
 // read-only snapshot but not owning any attributes of the interim_tuple_store
 interim_tuple_store_snapshot get_interim_tuple_store_snapshot(interim_tuple_store* its_p);
 
 // please be sure that initial_total_size will be rounded to the next page_size available
 interim_tuple_store* get_new_interim_tuple_store(uint64_t initial_total_size);
 
+// keeps this interim_tuple_store in its current backing (memory or temp file) for the rest of its life
+void disable_spill_for_interim_tuple_store(interim_tuple_store* its_p);
+
+// once enabled, every written region of this interim_tuple_store (if it is or gets backed by a temp file) is queued for write-back as it is unmapped
+// so the file gets written in large sequential writes, instead of its dirty pages getting evicted in any order under memory pressure
+// enable it for the interim_tuple_stores written once sequentially and read much later, like the sorted runs
+void enable_write_behind_for_interim_tuple_store(interim_tuple_store* its_p);
+
+// starts an asynchronous read-ahead of bytes_count bytes at offset, so that a later mmap_for_reading_tuple() over them does not block on I/O
+// it is a no-op for the in memory interim_tuple_stores and for the bytes beyond the next_tuple_offset
+void read_ahead_interim_tuple_store(const interim_tuple_store* its_p, uint64_t offset, uint64_t bytes_count);
+
 // make the next_tuple_offset and tuple_count = 0,
 // and them ftruncated to a new initial_total_size
 void reinitialize_interim_tuple_store(interim_tuple_store* its_p, uint64_t initial_total_size);
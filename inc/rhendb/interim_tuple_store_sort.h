@@ -1,14 +1,73 @@
 #ifndef INTERIM_TUPLE_STORE_SORT_H
 #define INTERIM_TUPLE_STORE_SORT_H
 
+#include<stdatomic.h>
+
 #include<rhendb/interim_tuple_store.h>
+#include<rhendb/query_plan.h>
 #include<rhendb/transaction.h>
 #include<rhendb/tuples_down_counter.h>
 
 #include<tuplestore/tuple_def.h>
 #include<tuplestore/tuple.h>
 
+/*
+	top_n_threshold is shared by the sorts of all the runs of a sort, that only needs the first k tuples (a finite result_counter)
+	it holds a copy of the best of the k-th tuples of all the runs sorted so far, any tuple at or beyond it can never be among the first k tuples
+
+	every user (a job or the execute of the operator) tests the tuples against its own top_n_threshold_cache, without taking the threshold_lock
+	the cache is refreshed only when the generation of the top_n_threshold moves, i.e. the threshold_lock is taken only once per tightening
+	a cached threshold is never tighter than the shared one, so the tuples it discards are surely not needed
+*/
+typedef struct top_n_threshold top_n_threshold;
+struct top_n_threshold
+{
+	pthread_mutex_t threshold_lock;
+
+	// malloc-ed copy of the threshold tuple, NULL until some run has k tuples
+	void* threshold_tuple;
+
+	// incremented (with the threshold_lock held) every time the threshold_tuple is tightened, 0 while the threshold_tuple is NULL
+	_Atomic uint64_t generation;
+
+	const tuple_def* tpl_d;
+	const positional_accessor* element_ids;
+	const compare_direction* cmp_dir;
+	uint32_t element_count;
+};
+
+typedef struct top_n_threshold_cache top_n_threshold_cache;
+struct top_n_threshold_cache
+{
+	// generation of the top_n_threshold, that the threshold_tuple was copied at
+	uint64_t generation;
+
+	// malloc-ed copy of the threshold_tuple of the top_n_threshold, NULL until there is one
+	void* threshold_tuple;
+	uint32_t threshold_tuple_capacity;
+};
+
+void initialize_top_n_threshold(top_n_threshold* tnt_p, const tuple_def* tpl_d, const positional_accessor* element_ids, const compare_direction* cmp_dir, uint32_t element_count);
+
+void initialize_top_n_threshold_cache(top_n_threshold_cache* tntc_p);
+
+// returns 1, if the tuple orders at or after the threshold (as cached in tntc_p)
+// takes the threshold_lock, only if the top_n_threshold has been tightened, since the tntc_p was last refreshed
+int is_beyond_top_n_threshold(top_n_threshold* tnt_p, top_n_threshold_cache* tntc_p, const void* tuple, transaction* tx);
+
+// updates the threshold to the kth_tuple, if it orders before the current threshold
+// tntc_p may be NULL, else the threshold_lock is not taken, if the kth_tuple is not before the cached threshold
+void tighten_top_n_threshold(top_n_threshold* tnt_p, top_n_threshold_cache* tntc_p, const void* kth_tuple, transaction* tx);
+
+void deinitialize_top_n_threshold_cache(top_n_threshold_cache* tntc_p);
+
+void deinitialize_top_n_threshold(top_n_threshold* tnt_p);
+
 // returns NULL on abort_error
-interim_tuple_store* sort_interim_tuples(interim_tuple_store* its_p, tuples_down_counter result_counter, const tuple_def* tpl_d, const positional_accessor* element_ids, const compare_direction* cmp_dir, uint32_t element_count, transaction* tx);
+// upto parallelism number of threads sort the run, the caller being one of them, and the rest being jobs queued for the operator o using run_concurrent_job_for_operator()
+// o is not used (and may be NULL), if parallelism <= 1
+// if result_counter is finite and smaller than the tuples_count of its_p, only the first result_counter tuples are kept in a bounded heap and sorted
+// tnt_p (may be NULL) is used (through a top_n_threshold_cache local to this call) to discard tuples early, and is tightened if the sorted run ends up with result_counter tuples
+interim_tuple_store* sort_interim_tuples(interim_tuple_store* its_p, tuples_down_counter result_counter, const tuple_def* tpl_d, const positional_accessor* element_ids, const compare_direction* cmp_dir, uint32_t element_count, transaction* tx, uint32_t parallelism, operator* o, top_n_threshold* tnt_p);
 
 #endif
\ No newline at end of file
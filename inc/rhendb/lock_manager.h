@@ -2,6 +2,7 @@
 #define LOCK_MANAGER_H
 
 #include<pthread.h>
+#include<stdatomic.h>
 
 #include<tupleindexer/bplus_tree/bplus_tree.h>
 
@@ -41,7 +42,99 @@ struct lock_manager_notifier
 	// notify that a transaction has encountered a deadlock and must step down, and abort itself
 	void (*notify_deadlocked)(void* context_p, void* transaction);
 
-	// both the above functions are called with the external_lock mutex held
+	// returns 1, if transaction1 is younger than transaction2 (i.e. it began after it), the youngest transaction in a deadlock is chosen as the victim
+	// if it is NULL, the victim is the waiting_transaction of the newest wait in the deadlock
+	int (*is_younger_transaction)(void* context_p, void* transaction1, void* transaction2);
+
+	// all the above functions are called with the external_lock mutex held
+};
+
+/*
+	the lock_entries are held in memory, in a lock table partitioned into LOCK_TABLE_SHARDS_COUNT shards, by the hash of the (resource_type, resource_id)
+	each shard is protected by its own shard_latch, so an uncontended lock can be acquired and released without the external_lock, in O(1), see the try_fast_*() functions
+	only when the lock table holds MAX_IN_MEMORY_LOCK_ENTRIES lock_entries, the resources (that are not already locked in memory) overflow into the tx_locks and rs_locks bplus_tree-s
+	the wait_entries are always in the bplus_tree-s, they are only ever touched on a conflict
+*/
+
+#define LOCK_TABLE_SHARDS_COUNT 64
+
+#define MAX_IN_MEMORY_LOCK_ENTRIES 65536
+
+typedef struct lock_table_shard lock_table_shard;
+struct lock_table_shard
+{
+	// protects the resource_heads and all the lock_entries of the resources in it
+	pthread_mutex_t shard_latch;
+
+	// (resource_type, resource_id) -> all the in memory lock_entries on that resource, for the resources hashing to this shard
+	hashmap resource_heads;
+
+	// number of wait_entries for the resources hashing to this shard, protected by the shard_latch
+	// the try_fast_*() functions fail for all of them while it is non-zero, as the waiters may need to be notified
+	uint64_t wait_entries_count;
+
+	// protects the transaction_heads, take it after the shard_latch (of any shard), if you need both
+	pthread_mutex_t transaction_heads_latch;
+
+	// transaction -> all the in memory lock_entries held by that transaction, for the transactions hashing to this shard
+	hashmap transaction_heads;
+
+	// (transaction, parent resource) -> number of locks held by the transaction on its children, for the transactions hashing to this shard
+	// it is also protected by the transaction_heads_latch
+	hashmap escalation_counters;
+};
+
+/*
+	a resource_type may be made a child of a parent resource_type (registered before it), the first parent_resource_id_size bytes of the resource_id of the child, being the resource_id of its parent
+	i.e. for a "tuple" lock with the resource_id (table_id, partition_id, tuple_pointer), the parent "partition" lock has the resource_id (table_id, partition_id), and its parent "table" lock has the resource_id (table_id)
+	the parent must be registered with the HIERARCHICAL_DB_LOCK, while the child may be registered with the RW_DB_LOCK or the HIERARCHICAL_DB_LOCK
+
+	acquiring a lock on the child, implicitly acquires the corresponding intention lock (IS or IX) on all its ancestors, and a lock on an ancestor in S (or SIX) or X mode implicitly grants the read or write lock on all its descendants
+	once a transaction holds more than escalation_threshold locks on the children of the same parent, they are escalated, i.e. replaced by a single lock on the parent, in S or X mode (as required by the child locks)
+	the escalation is attempted non-blockingly, on a conflict the child locks are kept, and it is reattempted after escalation_threshold more child locks
+*/
+
+#define NO_PARENT_RESOURCE_TYPE UINT32_MAX
+
+typedef struct lock_hierarchy lock_hierarchy;
+struct lock_hierarchy
+{
+	// NO_PARENT_RESOURCE_TYPE, if the resource_type has no parent
+	uint32_t parent_resource_type;
+
+	uint8_t parent_resource_id_size;
+
+	// 0, if the child locks must never be escalated
+	uint64_t escalation_threshold;
+};
+
+/*
+	deadlocks are detected by the deadlock_detector thread, every deadlock_detection_period_us, only if some new wait_entry was inserted since its last run
+	every wait_entry is also an edge (waiting_transaction -> transaction) in the in memory wait_edges, protected by the wait_edges_lock, which is taken (innermost) only while inserting or removing the wait_entries
+	the deadlock_detector copies the wait_edges, and searches for the cycles in this copy without holding any lock, so no lock request is stalled for the search
+	for every cycle found, the external_lock is taken only to verify that all of its edges still exist, and to notify_deadlocked() its victim, the youngest transaction in the cycle
+	a victim is not chosen again, until it concludes all its business with the lock_manager
+*/
+
+typedef struct deadlock_detector_stats deadlock_detector_stats;
+struct deadlock_detector_stats
+{
+	// runs of the deadlock_detector that searched the wait_edges for cycles
+	uint64_t detection_runs_count;
+
+	// cycles found and verified, i.e. the victims notified
+	uint64_t deadlocks_count;
+
+	// cycles found in the copy of the wait_edges, that no longer existed when verified
+	uint64_t stale_cycles_count;
+
+	// detection latency of a deadlock, is the time from the insertion of its newest wait_edge, to the notification of its victim
+	uint64_t total_detection_latency_us;
+	uint64_t max_detection_latency_us;
+
+	// for the last run
+	uint64_t last_run_wait_edges_count;
+	uint64_t last_run_duration_us;
 };
 
 typedef struct lock_manager lock_manager;
@@ -58,6 +151,9 @@ struct lock_manager
 	uint32_t locks_type_count;
 	glock_matrix* lock_matrices;
 
+	// lock_hierarchy of every lock_type, indexed just as the lock_matrices
+	lock_hierarchy* lock_hierarchies;
+
 	// this is the record_def for the lock_table's records
 	tuple_def* lock_record_def;
 
@@ -88,6 +184,41 @@ struct lock_manager
 	// above tables can only be modified by the (waiting_transaction, waiting_task) going for or returning from the wait, using the acquire function
 	// waits_for(transaction), can only read them and call the notify_unblocked(waiting_transaction, waiting_task), and never modify the entries
 
+	// the in memory lock table
+	lock_table_shard lock_table_shards[LOCK_TABLE_SHARDS_COUNT];
+
+	// number of lock_entries in the in memory lock table
+	_Atomic uint64_t in_memory_lock_entries_count;
+
+	// number of lock_entries in the tx_locks and rs_locks bplus_tree-s, while it is 0 no resource is locked there
+	// it is only ever incremented with the shard_latch of the resource being locked held
+	_Atomic uint64_t overflowed_lock_entries_count;
+
+	// number of wait_entries in the waits_for and waits_back bplus_tree-s, protected by the external_lock
+	uint64_t wait_entries_count;
+
+	// the deadlock detector, see the comment above the deadlock_detector_stats struct
+
+	// protects wait_edges, deadlock_victims, wait_edges_inserted_count, stop_deadlock_detector and dd_stats
+	pthread_mutex_t wait_edges_lock;
+
+	// (waiting_transaction, transaction) -> number of wait_entries between them
+	hashmap wait_edges;
+
+	// transactions already notified as deadlocked, that have not yet concluded all their business
+	hashmap deadlock_victims;
+
+	// incremented on every insertion into the wait_edges, the deadlock_detector does not run if it has not changed since its last run
+	uint64_t wait_edges_inserted_count;
+
+	// the deadlock_detector is started only if deadlock_detection_period_us is non-zero
+	uint64_t deadlock_detection_period_us;
+	pthread_cond_t deadlock_detector_wait;
+	pthread_t deadlock_detector;
+	int stop_deadlock_detector;
+
+	deadlock_detector_stats dd_stats;
+
 	// below is the volatile non-ACID rage_engine that powers the transaction_table
 	// preferrably an implementation of the VolatilePageStore based rage_engine
 	rage_engine* lckmgr_engine;
@@ -98,6 +229,7 @@ struct lock_manager
 
 /*
 	If you have a multi threaded function, you must use the external_lock and must call any of the functions below with the external_lock held
+	except for the try_fast_*() functions, that must be called without it
 */
 
 // maximum number of bytes to be allocated for the resource_id of the resource to be locked
@@ -108,14 +240,19 @@ fail_build_on(MAX_RESOURCE_ID_SIZE > 100)
 fail_build_on(sizeof(void*) > sizeof(uint64_t))
 
 // max_active_transaction_count is the capacity used to initialize the bucket_count for the active_transactions
-void initialize_lock_manager(lock_manager* lckmgr_p, pthread_mutex_t* external_lock, const lock_manager_notifier* notifier, rage_engine* lckmgr_engine);
+void initialize_lock_manager(lock_manager* lckmgr_p, pthread_mutex_t* external_lock, const lock_manager_notifier* notifier, rage_engine* lckmgr_engine, uint64_t deadlock_detection_period_us);
 
 // registering a lock_type is same as registering a resource_type
 // both of them dictate what lock_mode-s you can use with them
 uint32_t register_lock_type_with_lock_manager(lock_manager* lckmgr_p, glock_matrix lock_matrix);
 
+// makes the resource_type a child of the parent_resource_type, see the comment above the lock_hierarchy struct
+// call it right after registering the resource_type, before any lock is taken on it
+void set_parent_for_lock_type_with_lock_manager(lock_manager* lckmgr_p, uint32_t resource_type, uint32_t parent_resource_type, uint8_t parent_resource_id_size, uint64_t escalation_threshold);
+
 // below function lets you query if the transaction in context holds lock on the provided resource
 // this function removes all wait_entries corresponding the transaction and it's task, because making this call proves that this task is no longer waiting/blocked
+// if the lock is not held on the resource, but implicitly granted by a lock on its ancestor, the lock_mode so granted is returned
 // but remember that the lock is always held by the transaction as a whole and never by it's task, so task is only used to remove the wait entries
 #define NO_LOCK_HELD_LOCK_MODE UINT32_MAX
 uint32_t get_lock_mode_for_lock_from_lock_manager(lock_manager* lckmgr_p, void* transaction, void* task, uint32_t resource_type, uint8_t* resource_id, uint8_t resource_id_size);
@@ -151,6 +288,14 @@ lock_result acquire_lock_with_lock_manager(lock_manager* lckmgr_p, void* transac
 // the task is accpeted by this function just to discard all the pending wait-entries by this transaction, task, because it is now known to have been not blocked and is deemed to be active
 void release_lock_with_lock_manager(lock_manager* lckmgr_p, void* transaction, void* task, uint32_t resource_type, uint8_t* resource_id, uint8_t resource_id_size);
 
+// below 2 functions are the fast path for the acquire_lock_with_lock_manager() and release_lock_with_lock_manager(), they must be called without the external_lock held
+// they only succeed (returning 1), if the resource is locked in memory and no one is waiting for it, and for the acquire only if there are no conflicts
+// on a failure (returning 0), nothing is done, take the external_lock and call the corresponding function above
+// on a success of try_fast_acquire_lock_with_lock_manager(), (*result) is set to one of LOCK_ACQUIRED, LOCK_TRANSITIONED or LOCK_ALREADY_HELD
+// these do not discard any wait_entries for the task, unlike the functions above
+int try_fast_acquire_lock_with_lock_manager(lock_manager* lckmgr_p, void* transaction, uint32_t resource_type, uint8_t* resource_id, uint8_t resource_id_size, uint32_t new_lock_mode, lock_result* result);
+int try_fast_release_lock_with_lock_manager(lock_manager* lckmgr_p, void* transaction, uint32_t resource_type, uint8_t* resource_id, uint8_t resource_id_size);
+
 // the below 2 tasks are identical, they just remove wair-entries where the (transaction, task) are set as the (waiting_transaction, waiting_task)
 // these functions can be used when the task of a transaction terminates, or the particular query terminates, to discard all the corresponding wait_entries, as they no longer will be waiting
 void discard_all_wait_entries_for_task_in_lock_manager(lock_manager* lckmgr_p, void* transaction, void* task);
@@ -164,8 +309,22 @@ void conclude_all_business_with_lock_manager(lock_manager* lckmgr_p, void* trans
 // prints all the contents of the lock manager to the printf
 void debug_print_lock_manager_tables(lock_manager* lckmgr_p);
 
+// must be called without the external_lock held
+deadlock_detector_stats get_deadlock_detector_stats_from_lock_manager(lock_manager* lckmgr_p);
+
+// stops the deadlock_detector and releases the in-memory resources, call it only after all the transactions have concluded all their business with the lock_manager, and without the external_lock held
+void deinitialize_lock_manager(lock_manager* lckmgr_p);
+
 extern const glock_matrix RW_DB_LOCK;
 #define RW_DB_LOCK_R_MODE 0
 #define RW_DB_LOCK_W_MODE 1
 
+// multi granularity lock, to be used for the parents in a lock_hierarchy
+extern const glock_matrix HIERARCHICAL_DB_LOCK;
+#define HIERARCHICAL_DB_LOCK_IS_MODE  0 // intention shared
+#define HIERARCHICAL_DB_LOCK_IX_MODE  1 // intention exclusive
+#define HIERARCHICAL_DB_LOCK_S_MODE   2 // shared
+#define HIERARCHICAL_DB_LOCK_SIX_MODE 3 // shared and intention exclusive
+#define HIERARCHICAL_DB_LOCK_X_MODE   4 // exclusive
+
 #endif
\ No newline at end of file
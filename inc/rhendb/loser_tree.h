@@ -0,0 +1,55 @@
+#ifndef LOSER_TREE_H
+#define LOSER_TREE_H
+
+#include<inttypes.h>
+
+/*
+	loser_tree is a tournament tree for k-way merging, over leaves_count number of sorted sources (leaves)
+	the leaves are identified by their indices in [0, leaves_count), the loser_tree only stores these indices
+	and the user compares the current heads of the 2 leaves through the compare_leaves function
+
+	every internal node stores the loser of the match played at it, and the overall winner is stored separately
+	so advancing the winner leaf, only replays the matches on the path from that leaf to the root, i.e. exactly ceil(log2(leaves_count)) comparisons
+	unlike a heap, that compares with both the children at each level
+
+	exhausted leaves lose every match, without calling compare_leaves
+	ties are broken using the leaf indices, the lower index wins, making the merge stable
+*/
+
+typedef struct loser_tree loser_tree;
+struct loser_tree
+{
+	uint32_t leaves_count;
+
+	// nodes[0] is the winner leaf, nodes[1 .. (leaves_count-1)] are the loser leaves of the internal nodes
+	// leaf i is at position (leaves_count + i), and the parent of any position p is p/2
+	uint32_t* nodes;
+
+	// is_exhausted[i] is set, if the leaf i has no more elements
+	uint8_t* is_exhausted;
+
+	// returns < 0, if the head of leaf1 orders before the head of leaf2
+	const void* context;
+	int (*compare_leaves)(const void* context, uint32_t leaf1, uint32_t leaf2);
+};
+
+void initialize_loser_tree(loser_tree* lt_p, uint32_t leaves_count, const void* context, int (*compare_leaves)(const void* context, uint32_t leaf1, uint32_t leaf2));
+
+// marks the leaf exhausted, to be called before build_loser_tree() for the empty leaves, or before replaying the winner leaf that got exhausted
+void mark_exhausted_in_loser_tree(loser_tree* lt_p, uint32_t leaf);
+
+// plays all the matches, to be called once all the leaves have their first heads OR are exhausted
+void build_loser_tree(loser_tree* lt_p);
+
+// returns the leaf with the smallest head
+uint32_t get_winner_of_loser_tree(const loser_tree* lt_p);
+
+// returns 1, if all the leaves are exhausted
+int is_exhausted_loser_tree(const loser_tree* lt_p);
+
+// to be called after the head of the winner leaf changes OR it gets exhausted
+void replay_winner_of_loser_tree(loser_tree* lt_p);
+
+void deinitialize_loser_tree(loser_tree* lt_p);
+
+#endif
@@ -23,12 +23,15 @@ data_type_info* get_mvcc_header_type_info(uint8_t transaction_id_width);
 	a funny thing to note before moving forward
 	the values is_xm**_committed and is_xm**_aborted are advisory fields, and atmost only one of them can be and will be set suggesting if the xm** was commited or aborted
 	if none of them are set then, the status of xm** transaction_id is unclear and you need to refer to the transaction table to figure it out
+
+	except for a frozen xmin, that has both of them set, it was committed before any of the active (or future) snapshots were taken, so it is visible to all of them
+	it is never looked up in the transaction table or the mvcc_snapshot, and the transaction table may even be truncated below it
 */
 
 typedef struct transaction_id_with_hints transaction_id_with_hints;
 struct transaction_id_with_hints
 {
-	// is_committed and is_aborted must have atmost 1 of them set
+	// is_committed and is_aborted must have atmost 1 of them set, unless it is frozen
 	// if both of them are unset then the status of the transaction in context is unclear and must be fetched from transaction table
 	unsigned int is_committed:1;
 	unsigned int is_aborted:1;
@@ -49,6 +52,10 @@ struct mvcc_header
 	transaction_id_with_hints xmax; // does not make sense if is_xmax_NULL is set
 };
 
+// a frozen transaction_id has both, is_committed and is_aborted set
+int is_frozen_transaction_id_with_hints(const transaction_id_with_hints* transaction_id);
+void freeze_transaction_id_with_hints(transaction_id_with_hints* transaction_id);
+
 void read_mvcc_header(mvcc_header* mvcchdr_p, const void* mvcchdr_tup, const tuple_def* mvcchdr_def);
 
 void write_mvcc_header(void* mvcchdr_tup, const tuple_def* mvcchdr_def, const mvcc_header* mvcchdr_p);
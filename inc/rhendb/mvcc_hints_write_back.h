@@ -0,0 +1,50 @@
+#ifndef MVCC_HINTS_WRITE_BACK_H
+#define MVCC_HINTS_WRITE_BACK_H
+
+#include<rhendb/rage_engine.h>
+#include<rhendb/mvcc_header.h>
+
+#include<tuplestore/tuple_def.h>
+
+/*
+	the readers (scans and lookups) check the visibility of the tuples with only a READ_LOCK on their heap page, so they can not write the hints that they discover
+	mvcc_hints_write_back accumulates the updated mvcc_headers of the tuples of a single heap page, while it is read
+	and once the READ_LOCK on it is released, writes all of their hints together in a single mini transaction holding a WRITE_LOCK on that page
+
+	the hints are only advisory, so a failure to write them is never an error, they are just dropped
+	a tuple whose xmin or xmax changed in between the read and the write back, only gets the hints for the unchanged transaction_id
+*/
+
+typedef struct pending_mvcc_hints pending_mvcc_hints;
+struct pending_mvcc_hints
+{
+	uint32_t tuple_index;
+
+	// mvcc_header as it was read, with its hints updated
+	mvcc_header hdr;
+};
+
+typedef struct mvcc_hints_write_back mvcc_hints_write_back;
+struct mvcc_hints_write_back
+{
+	// the heap page, whose tuples the pending hints are for
+	uint64_t page_id;
+
+	uint32_t pending_count;
+	uint32_t pending_capacity;
+	pending_mvcc_hints* pending;
+};
+
+void initialize_mvcc_hints_write_back(mvcc_hints_write_back* mhwb_p);
+
+// to be called for every tuple of the page that got its hints updated, while its page is read locked
+// all the tuples appended, in between 2 flushes, must belong to the same page
+void append_to_mvcc_hints_write_back(mvcc_hints_write_back* mhwb_p, uint64_t page_id, uint32_t tuple_index, const mvcc_header* hdr);
+
+// to be called after the READ_LOCK on the page has been released, it is a NO-OP if there are no pending hints
+// partition_tuple_def is the tuple_def of the records on the heap page, with the mvcc_header at its first element, mvcc_def being its tuple_def
+void flush_mvcc_hints_write_back(mvcc_hints_write_back* mhwb_p, rage_engine* engine, const tuple_def* partition_tuple_def, const tuple_def* mvcc_def);
+
+void deinitialize_mvcc_hints_write_back(mvcc_hints_write_back* mhwb_p);
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef MVCC_SNAPSHOT_H
 #define MVCC_SNAPSHOT_H
 
+#include<stdatomic.h>
+
 #include<serint/large_uints.h>
 
 #include<cutlery/value_arraylist.h>
@@ -8,6 +10,9 @@
 
 data_definitions_value_arraylist(sorted_transaction_ids_list, uint256)
 
+// the in_progress_bitmap of a snapshot takes atmost 8 KB
+#define MAX_IN_PROGRESS_BITMAP_BITS (UINT64_C(1) << 16)
+
 typedef struct mvcc_snapshot mvcc_snapshot;
 struct mvcc_snapshot
 {
@@ -20,6 +25,24 @@ struct mvcc_snapshot
 
 	// for any in_progress_transaction_ids <= least_unassigned_transaction_id
 
+	// below attributes are built by finalize_mvcc_snapshot() from the in_progress_transaction_ids, so that was_completed_transaction_at_mvcc_snapshot() does not have to binary search them
+	// any transaction_id < min_in_progress_transaction_id was completed, and any transaction_id >= least_unassigned_transaction_id was not, only the ones in between need to be looked up
+	// if (least_unassigned_transaction_id - min_in_progress_transaction_id) fits in 64 bits (has_compact_in_progress_transaction_ids is set), they are looked up by their 64-bit offsets from min_in_progress_transaction_id
+	// in the in_progress_bitmap if the range is atmost MAX_IN_PROGRESS_BITMAP_BITS, else by binary searching the in_progress_offsets
+	uint256 min_in_progress_transaction_id; // least_unassigned_transaction_id, if there are no in_progress_transaction_ids
+
+	int has_compact_in_progress_transaction_ids;
+	int are_64_bit_transaction_ids; // set if the least_unassigned_transaction_id itself fits in 64 bits, then the transaction_ids are compared as uint64_t-s
+	uint64_t* in_progress_bitmap; // bit at offset is set for every in_progress transaction_id
+	uint64_t* in_progress_offsets; // offsets of the in_progress_transaction_ids in the same order, only if there is no in_progress_bitmap
+
+	// a snapshot without a self_transaction_id may be shared by many read-only transactions, each of them holding a reference to it
+	// reference_count is incremented with atomics, but only with the locks internal to the transaction_table held
+	_Atomic uint64_t reference_count;
+
+	// snapshot_generation of the transaction_table, when this snapshot was taken, a snapshot is equivalent to a new one, as long as the generation has not changed
+	uint64_t generation;
+
 	// below is an embed_node for maintaining a global linkedlist of all active snapshots in the transaction_table
 	// having pointer to mvcc_snapshot does not mean you can access this embed_node
 	// it is protected by the locks/latches internal to the transaction_table
@@ -75,6 +98,9 @@ int is_self_transaction_for_mvcc_snapshot(const mvcc_snapshot* mvccsnp_p, uint25
 // returns (transaction_id < mvccsnp_p->least_unassigned_transaction_id) && (transaction_id not in mvccsnp_p->in_progress_transaction_ids)
 int was_completed_transaction_at_mvcc_snapshot(const mvcc_snapshot* mvccsnp_p, uint256 transaction_id);
 
+// returns a new mvcc_snapshot with the same in_progress_transaction_ids, least_unassigned_transaction_id and self_transaction_id as mvccsnp_p
+mvcc_snapshot* clone_mvcc_snapshot(const mvcc_snapshot* mvccsnp_p);
+
 void delete_mvcc_snapshot(mvcc_snapshot* mvccsnp_p);
 
 #include<rhendb/mvcc_header.h>
@@ -107,4 +133,9 @@ void print_mvcc_snapshot(const mvcc_snapshot* mvccsnp_p);
 // test if a tuple can be vaccummed
 int can_vaccum_tuple_for_mvcc(mvcc_header* mvcchdr_p, transaction_status_getter* tsg_p, uint256 vaccum_horizon_transaction_id, int* were_hints_updated);
 
+// freezes a tuple that can not be vaccummed, its committed xmin below the vaccum_horizon_transaction_id is frozen and its aborted xmax below it is set to NULL
+// after this, the tuple does not refer to any transaction_id below the vaccum_horizon_transaction_id, that would need a look up in the transaction table
+// returns 1, if the mvcchdr_p was modified, and needs to be written back to the tuple
+int freeze_tuple_for_mvcc(mvcc_header* mvcchdr_p, transaction_status_getter* tsg_p, uint256 vaccum_horizon_transaction_id, int* were_hints_updated);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,42 @@
+#ifndef NORMALIZED_KEY_H
+#define NORMALIZED_KEY_H
+
+#include<tuplestore/tuple.h>
+#include<tuplestore/datum.h>
+
+/*
+	normalized_key is a fixed size memcomparable byte string prefix, built from the key datums of a tuple
+	comparing 2 normalized_keys using memcmp gives the same result as compare_datums3_rhendb() on their keys, unless the prefixes tie
+
+	each key element is encoded as a 1 byte NULL marker (0 for NULL, 1 for non-NULL), followed by its big-endian value bytes
+	the signed integers and the floats are bit-flipped to order as unsigned bytes, and all bytes of an element in DESC order are inverted
+
+	only BIT_FIELD, UINT, INT, FLOAT and inline STRING (upto its first '\0') can be encoded
+	the prefix stops at the first element that can not be encoded or that does not fit, a STRING element is always the last one encoded
+	and ties on such incomplete prefixes must be resolved by the full comparator
+*/
+
+#define NORMALIZED_KEY_PREFIX_SIZE 16
+
+typedef struct normalized_key normalized_key;
+struct normalized_key
+{
+	unsigned char prefix[NORMALIZED_KEY_PREFIX_SIZE];
+
+	// number of valid bytes in the prefix
+	uint8_t prefix_size;
+
+	// set if the prefix encodes all of the key elements, so equal prefixes imply equal keys
+	uint8_t is_complete;
+};
+
+// returns 1, if atleast the first key element can be encoded, i.e. if it is worth building normalized_keys for these keys
+int can_build_normalized_key(data_type_info const * const * key_dtis, uint32_t element_count);
+
+void build_normalized_key(normalized_key* nk, const datum* keys, data_type_info const * const * key_dtis, const compare_direction* cmp_dir, uint32_t element_count);
+
+// returns the ordering of the keys, that the normalized_keys were built from, and sets is_decided
+// if is_decided is reset, the prefixes tie and the keys must be compared using the full comparator
+int compare_normalized_keys(const normalized_key* nk1, const normalized_key* nk2, int* is_decided);
+
+#endif
@@ -22,6 +22,10 @@ struct operator_resource_counter
 	uint64_t thread_counter;
 
 	uint64_t job_counter;
+
+	// resource required from the process-wide interim memory budget (in bytes), for the in memory interim_tuple_stores
+
+	uint64_t interim_memory_counter;
 };
 
 /*
@@ -33,6 +37,9 @@ struct operator_resource_counter
 	here spare_buffers is 2 to 3 buffers to allow keeping some of them in cache a bit longer
 	here N (>= 1) is the leverage for threads, jobs come and go, even a single thread for all jobs of the query plan is sometimes fine
 	lower N implies we aim for higher parallelism
+
+	and
+	if interim_memory_counter exceeds (get_interim_memory_budget() - get_interim_memory_in_use()), the operators will end up spilling their interim_tuple_stores to temp files
 */
 
 #define ZERO_OPERATOR_RESOURCE_COUNTER ((operator_resource_counter){})
@@ -42,6 +49,7 @@ static inline void sum_resource_counters(operator_resource_counter* a, operator_
 	a->buffer_counter += b.buffer_counter;
 	a->thread_counter += b.thread_counter;
 	a->job_counter += b.job_counter;
+	a->interim_memory_counter += b.interim_memory_counter;
 }
 
 static inline void max_resource_counters(operator_resource_counter* a, operator_resource_counter b)
@@ -49,6 +57,7 @@ static inline void max_resource_counters(operator_resource_counter* a, operator_
 	a->buffer_counter = max(a->buffer_counter, b.buffer_counter);
 	a->thread_counter = max(a->thread_counter, b.thread_counter);
 	a->job_counter = max(a->job_counter, b.job_counter);
+	a->interim_memory_counter = max(a->interim_memory_counter, b.interim_memory_counter);
 }
 
 #endif
\ No newline at end of file
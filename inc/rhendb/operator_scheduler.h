@@ -0,0 +1,102 @@
+#ifndef OPERATOR_SCHEDULER_H
+#define OPERATOR_SCHEDULER_H
+
+#include<pthread.h>
+#include<stdatomic.h>
+#include<stdint.h>
+
+#include<cutlery/arraylist.h>
+#include<cutlery/singlylist.h>
+
+/*
+	operator_scheduler runs the operators and their concurrent jobs of all the query_plans, on upto max_workers_count workers (threads)
+	the workers are started lazily, a new worker is started only when a job is scheduled and no started worker is sleeping, and once started it lives until the operator_scheduler is deinitialized
+
+	every worker owns a deque of operator_jobs, a job scheduled from a worker is pushed to the back of its own deque
+	and the worker pops its next job from the back of its own deque, so an operator triggered by its producer runs next on the same worker, while its input is still in the cache
+	a worker with an empty deque, takes the oldest job from the injection_queue (jobs scheduled from the threads that are not the workers), and then steals the oldest job from the front of the other workers' deques
+
+	the operator_job-s are recycled from a per worker free list, only ever accessed by its own worker, so scheduling a job from a worker does not malloc
+	the max_workers_count must be as many as the operator threads allowed by the rdb->operator_thread_pool_usage_limiter, as an operator may block its worker, while waiting for a lock
+	but only as many workers are started as the operators have needed at once, so an idle worker only looks for a job to steal in the started workers
+*/
+
+typedef struct operator operator;
+
+typedef struct operator_job operator_job;
+struct operator_job
+{
+	// called by the worker, it must not hold on to the operator_job, after it returns
+	void (*run)(operator_job* job);
+
+	// the rest are for the run function to interpret
+	operator* o;
+	void* param;
+	void (*operator_job_function)(operator* o, void* param);
+
+	// embed_node for the free_jobs of a worker
+	slnode embed_node;
+};
+
+// max number of operator_job-s, cached in the free_jobs of each worker
+#define OPERATOR_JOBS_FREE_LIST_SIZE_PER_WORKER 64
+
+typedef struct operator_scheduler operator_scheduler;
+
+typedef struct operator_scheduler_worker operator_scheduler_worker;
+struct operator_scheduler_worker
+{
+	operator_scheduler* scheduler;
+
+	pthread_t thread;
+
+	// protects the deque, owner pushes and pops at its back, and the thieves pop from its front
+	pthread_mutex_t deque_lock;
+	arraylist deque;
+
+	// accessed only by the worker itself, without any lock
+	singlylist free_jobs;
+	uint32_t free_jobs_count;
+
+	// state of the xorshift generator, to pick the first worker to steal from
+	uint64_t steal_seed;
+};
+
+struct operator_scheduler
+{
+	// the workers array has max_workers_count slots, only the first started_workers_count of them are initialized and running
+	// start_lock serializes starting the workers, the started_workers_count is incremented only after the worker is initialized, so a thief may read it without the start_lock
+	uint32_t max_workers_count;
+	operator_scheduler_worker* workers;
+	pthread_mutex_t start_lock;
+	_Atomic uint32_t started_workers_count;
+
+	// protects the injection_queue, the operator_job-s scheduled from any thread that is not a worker of this operator_scheduler
+	pthread_mutex_t injection_lock;
+	arraylist injection_queue;
+
+	// number of the operator_job-s in all the deques and the injection_queue
+	_Atomic uint64_t queued_jobs_count;
+
+	// the idle workers sleep on the work_available condition variable, with the idle_lock held
+	// a job is scheduled, by first incrementing the queued_jobs_count and then signalling the work_available only if there are sleeping_workers_count
+	// a worker increments the sleeping_workers_count, and then checks the queued_jobs_count, before sleeping, so no wake up is lost
+	pthread_mutex_t idle_lock;
+	pthread_cond_t work_available;
+	_Atomic uint32_t sleeping_workers_count;
+
+	// protected by the idle_lock, once set, the workers exit after all the queued_jobs_count are run
+	int shutdown_called;
+};
+
+// no worker is started here, they are started as the jobs get scheduled
+void initialize_operator_scheduler(operator_scheduler* os_p, uint32_t max_workers_count);
+
+// schedules an operator_job with the given attributes, to be run by one of the workers, the operator_job itself is allocated and recycled by the operator_scheduler
+// returns 0, only if the operator_scheduler was shutdown
+int schedule_operator_job(operator_scheduler* os_p, void (*run)(operator_job* job), operator* o, void* param, void (*operator_job_function)(operator* o, void* param));
+
+// waits for all the scheduled operator_job-s to be run, and for all the workers to exit
+void deinitialize_operator_scheduler(operator_scheduler* os_p);
+
+#endif
@@ -31,6 +31,22 @@ operator_resource_counter setup_simple_aggregation_operator(operator* o, operato
 
 operator_resource_counter setup_sort_operator(operator* o, tuples_down_counter result_counter, operator* input_operator, uint32_t key_element_count, const positional_accessor* key_element_ids, const compare_direction* key_compare_direction, uint64_t min_run_size, uint32_t N_way_sort, uint32_t max_concurrent_jobs_count);
 
+// I/O metrics of a merge pass of the sort_operator, i.e. of all the merges producing runs of the same level
+typedef struct sort_merge_pass_metrics sort_merge_pass_metrics;
+struct sort_merge_pass_metrics
+{
+	uint64_t merges_count;
+	uint64_t runs_read_count;
+	uint64_t bytes_read;
+	uint64_t bytes_written; // 0 for the final merge, that produces its output directly
+	uint64_t minor_page_faults;
+	uint64_t major_page_faults; // faults that had to wait for I/O, many of them imply that the merge pass is I/O-bound
+};
+
+// fills passes[i] with the metrics of the merge pass producing the runs of level (i+1), for i < passes_count
+// returns the number of merge passes done so far, it can be called anytime until the query_plan is destroyed
+uint32_t get_merge_pass_metrics_for_sort_operator(const operator* o, sort_merge_pass_metrics* passes, uint32_t passes_count);
+
 operator_resource_counter setup_offset_limit_operator(operator* o, operator* input_operator, tuples_down_counter offset_counter, tuples_down_counter limit_counter);
 
 operator_resource_counter setup_merge_sorted_inputs_operator(operator* o, operator** input_operators, uint32_t input_operators_count, uint32_t key_element_count, const positional_accessor* key_element_ids, const compare_direction* key_compare_direction);
@@ -89,9 +105,35 @@ operator_resource_counter setup_insertion_operator(operator* o, operator* input_
 // deletes (marks deleted) operator for the tuples of the heap table
 operator_resource_counter setup_deletion_operator(operator* o, operator* input_operator, positional_accessor* partition_id_from_source_positional_accessor, positional_accessor* tuple_pointer_from_source_positional_accessor, const fetched_table* ftabl, uint64_t deletion_batch_size, int output_flags, int additional_flags);
 
-// scan operator
+// scan operator, its jobs claim heap_page_morsel-s (runs of heap pages) from a shared heap_page_morsel_cursor, so even a single partition is scanned by all of them
 operator_resource_counter setup_scan_operator(operator* o, query_plan* qp, const fetched_table* ftabl, uint32_t max_concurrent_jobs_count, int output_flags, int additional_flags);
 
+// vaccum operator, tomb stones the tuples of all the partitions of the heap table, that are not visible to anyone (as per the vaccum horizon at its setup)
+// and freezes the rest of them, so that they do not refer to any transaction_id below that vaccum horizon, that needs a look up in the transaction table
+// once every table is vaccummed, with no heap_pages_skipped and all partitions vaccummed, the transaction table can be truncated upto that vaccum horizon
+// also discards their blobs and fixes the unused space entries of the heap_table and the blob_store
+// produces no tuples, and requests the buffers it needs from the bufferpool_usage_limiter, for every heap page, throttling itself against the queries
+operator_resource_counter setup_vaccum_operator(operator* o, query_plan* qp, const fetched_table* ftabl, uint32_t max_concurrent_jobs_count);
+
+// progress of the vaccum_operator
+typedef struct vaccum_metrics vaccum_metrics;
+struct vaccum_metrics
+{
+	uint256 vaccum_horizon_transaction_id; // pass it to truncate_transaction_table_for_rhendb(), once every table is vaccummed completely
+
+	uint64_t partitions_vaccummed_count;
+	uint64_t heap_pages_scanned_count;
+	uint64_t heap_pages_vaccummed_count; // heap pages that had atleast 1 vaccummable (or freezable) tuple
+	uint64_t heap_pages_skipped_count; // heap pages whose vaccum aborted, they are left as is
+	uint64_t tuples_vaccummed_count;
+	uint64_t tuples_frozen_count;
+	uint64_t blobs_discarded_count;
+	uint64_t unused_space_entries_fixed_count;
+};
+
+// it can be called anytime until the query_plan is destroyed
+vaccum_metrics get_metrics_for_vaccum_operator(const operator* o);
+
 // looks up tuples by the (partition_id, tuple_pointer) pair for the tuples of the heap table
 // does the same thing as deletion_operator but does not delete the tuples returned
 // ideally to be used after index scans for row lookups on the table
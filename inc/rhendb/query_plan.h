@@ -2,6 +2,7 @@
 #define QUERY_PLAN_H
 
 #include<pthread.h>
+#include<stdatomic.h>
 
 #include<rhendb/interim_tuple_store.h>
 #include<rhendb/tuple_transformer_interface.h>
@@ -15,6 +16,38 @@
 
 typedef struct query_plan query_plan;
 
+// policy dictating the sizes of the output_buffers of an operator, and how often are it's consumers notified
+typedef struct operator_output_buffer_policy operator_output_buffer_policy;
+struct operator_output_buffer_policy
+{
+	// the first output_buffer is created with initial_output_buffer_size, and every next one is twice as large as the previous one, until max_output_buffer_size
+	// a new output_buffer is started only once the tail has atleast as many bytes as it was created for
+	// so small results never grow beyond the initial_output_buffer_size
+	uint64_t initial_output_buffer_size;
+	uint64_t max_output_buffer_size;
+
+	// once there are these many output_buffers, the tail keeps growing until the oldest one is consumed by all the consumers
+	uint32_t max_output_buffer_count;
+
+	// minimum bytes to be mmap-ed at once for reading and writing output_buffers, it is further capped by the size of the output_buffer
+	uint32_t min_bytes_to_mmap;
+
+	// bytes produced between notifying the consumers, adapt to how fast the consumers drain the output_buffers
+	// they grow while the consumers lag behind, and shrink (down to a batch (OPERATOR_TUPLE_BATCH_SIZE) of tuples worth of bytes) while the consumers wait on us
+	// but they are always bounded by the below 2 values
+	uint64_t min_bytes_to_notify;
+	uint64_t max_bytes_to_notify;
+};
+
+#define DEFAULT_OPERATOR_OUTPUT_BUFFER_POLICY ((operator_output_buffer_policy){ \
+	.initial_output_buffer_size = (256 * 1024),                               \
+	.max_output_buffer_size = (64 * 1024 * 1024),                             \
+	.max_output_buffer_count = 2,                                             \
+	.min_bytes_to_mmap = (2 * 1024 * 1024),                                   \
+	.min_bytes_to_notify = 4096,                                              \
+	.max_bytes_to_notify = (2 * 1024 * 1024),                                 \
+})
+
 typedef enum operator_state operator_state;
 enum operator_state
 {
@@ -74,12 +107,32 @@ struct operator
 
 	uint64_t output_buffer_bytes_unnotified; // this many bytes worth of tuples were pushed to output_buffer without notifing anyone yet
 
+	// policy for the output_buffers, it is the DEFAULT_OPERATOR_OUTPUT_BUFFER_POLICY, unless changed during the setup phase
+	operator_output_buffer_policy output_buffer_policy;
+
+	// size of the tail of the output_buffers, it grows as per the output_buffer_policy
+	uint64_t output_buffer_size;
+
+	// total number of tuples and bytes produced so far, used to adapt the number of bytes produced between notifying the consumers
+	uint64_t output_tuples_produced;
+	uint64_t output_bytes_produced;
+
+	// number of bytes to be produced before notifying the consumers, it adapts to their drain rate, within the bounds of the output_buffer_policy
+	uint64_t bytes_to_notify;
+
 	// freelist for the above output_buffers
 	singlylist free_output_buffers;
 
 	// list of consumption_iterator-s, pointing into tuple_regions in output_buffers
 	linkedlist output_consumers;
 
+	// the tail of the output_buffers and the offset in it, until which all the tuples are completely written
+	// both of them are only ever modified with the output_lock held, but they are read by the consumers without it
+	// a consumer whose curr_store is the output_tail, may read any tuple that ends before output_tail_published_offset without taking the output_lock
+	// the output_lock is still needed to move a consumer to the next output_buffer, this allows the output_buffers to be retired only when they are not referenced
+	interim_tuple_store* _Atomic output_tail;
+	_Atomic uint64_t output_tail_published_offset;
+
 	// this transformations will be applicable to all the tuples produced by this operator
 	// as soon as it call produce_tuple/s_from_operator
 	// remember output_lock will not be held while calling any of the transformers
@@ -118,8 +171,8 @@ struct consumption_iterator
 	// this flag initializes to 0
 	// once set, it is on cleared on a successfull consume_for_consumption_iterator()
 	// only if this flag is 0, is the next trgger will be done for the consumer
-	// it is protected by the output_lock above
-	int was_consumer_triggered;
+	// it is set only with the output_lock held, but it may be cleared without it, by a consume from the output_tail
+	_Atomic int was_consumer_triggered;
 
 	// this attribute may be NULL, if unused
 	// this callback will be called right before consumer operator is triggered
@@ -127,6 +180,7 @@ struct consumption_iterator
 	void (*notify_callback)(operator* consumer, consumption_iterator* cit_p);
 
 	// it is protected (the pointer) by the output_lock above
+	// but since it is only ever modified by the consumer itself, the consumer may read it without the output_lock
 	interim_tuple_store* curr_store;
 
 	// this attribute of the consumtion_iterator is not protected by the output_lock
@@ -159,7 +213,8 @@ void send_kill_signal_to_operator(operator* o, dstring kill_reason);
 
 #define kill_signal_for_self_operator send_kill_signal_to_operator
 
-// force an OPERATOR_WAITING stated operator into OPERATOR_QUEUED state, and push a corresponding job into the thread_pool for it's execution
+// force an OPERATOR_WAITING stated operator into OPERATOR_QUEUED state, and push a corresponding job into the operator_scheduler for it's execution
+// when called from a worker of the operator_scheduler, the job is pushed to the deque of that worker, so it runs on the same worker (unless stolen by an idle worker)
 void trigger_execution_on_operator(operator* o);
 
 // to be called only from the inside of the operator or an operator's concurrently running job
@@ -181,9 +236,41 @@ void OPERATOR_CLEAN_UP_RESOURCE_NO_OP_FUNCTION(operator* o);
 // below is a simple flat free_resource function to be used with simple operators
 void OPERATOR_FREE_RESOURCE_NO_OP_FUNCTION(operator* o);
 
+// to be called only during the setup phase of the operator, before any tuple is produced
+void set_output_buffer_policy_for_operator(operator* o, operator_output_buffer_policy output_buffer_policy);
+
 // produce a tuple from the operator o
 int produce_tuple_from_operator(operator* o, void* tuple);
 
+// preferred number of tuples to be accumulated by an operator, before producing/consuming them as a batch
+#define OPERATOR_TUPLE_BATCH_SIZE 64
+
+// produce tuples_count number of tuples from the operator o, taking the output_lock only once for every OPERATOR_TUPLE_BATCH_SIZE tuples
+// the output_tuple_transformers are still run on every tuple, outside the output_lock
+// returns 0, if any of the tuples could not be produced, in which case the operator must kill itself
+int produce_tuples_from_operator(operator* o, void** tuples, uint32_t tuples_count);
+
+// a batch of malloc-ed output tuples, accumulated by an operator (or any of it's jobs) before being produced together
+// it must be zero initialized before use, and must not be shared between concurrently running jobs
+typedef struct operator_output_batch operator_output_batch;
+struct operator_output_batch
+{
+	uint32_t tuples_count;
+	void* tuples[OPERATOR_TUPLE_BATCH_SIZE];
+};
+
+#define INIT_OPERATOR_OUTPUT_BATCH ((operator_output_batch){})
+
+// the output_batch takes ownership of the malloc-ed tuple, and the whole batch is produced (and freed) if it gets full
+// returns 0, if the batch could not be produced
+int append_to_output_batch_for_operator(operator* o, operator_output_batch* ob, void* tuple);
+
+// produces all the tuples in the output_batch and frees them, returns 0, if the batch could not be produced
+int flush_output_batch_for_operator(operator* o, operator_output_batch* ob);
+
+// frees all the tuples in the output_batch without producing them, to be used on the error paths
+void discard_output_batch_for_operator(operator_output_batch* ob);
+
 // clone_cti_p may be NULL
 // notify_callback may be NULL
 consumption_iterator* create_consumption_iterator(operator* producer, operator* consumer, void (*notify_callback)(operator* consumer, consumption_iterator* cit_p), consumption_iterator* clone_cit_p);
@@ -199,6 +286,11 @@ int points_to_same_tuple_for_consumtion_iterators(const consumption_iterator* ci
 // it presents the pointer from the tuple_region itself
 const void* consume_for_consumption_iterator(consumption_iterator* cit_p, int* no_more_data);
 
+// consume atmost max_tuples_count tuples, that are laid out contiguously in the curr_region of the iterator, taking the output_lock only once
+// returns the number of tuples placed in the tuples array, all of them stay valid only until the next consume call on this iterator
+// a return of 0 with no_more_data unset, implies nothing is available to be consumed right now, same as a NULL from consume_for_consumption_iterator()
+uint32_t consume_batch_for_consumption_iterator(consumption_iterator* cit_p, const void** tuples, uint32_t max_tuples_count, int* no_more_data);
+
 // this is the tuple_def that the consumer of the operator should be ready to consume
 // this is the tuple_def that is required to be used to read tuples returned from consume_from_operator()
 const tuple_def* get_tuple_def_for_tuples_to_be_consumed_from(operator* o);
@@ -237,4 +329,6 @@ void notify_unblocked(void* context_p, void* transaction, void* task);
 
 void notify_deadlocked(void* context_p, void* transaction);
 
+int is_younger_transaction(void* context_p, void* transaction1, void* transaction2);
+
 #endif
\ No newline at end of file
@@ -5,9 +5,10 @@
 #include<rhendb/lock_manager.h>
 #include<rhendb/catalog_manager.h>
 #include<rhendb/query_plan.h>
+#include<rhendb/operator_scheduler.h>
+#include<rhendb/heap_table_walks_guard.h>
 
 #include<boompar/resource_usage_limiter.h>
-#include<boompar/executor.h>
 
 #include<rhendb/rage_engine.h>
 
@@ -31,15 +32,18 @@ struct rhendb
 	// prevent from over allocating operator threads
 	resource_usage_limiter* operator_thread_pool_usage_limiter;
 
-	// cached threadpool for operators
-	// max thread pool size =  max_concurrent_users_count * 10
-	executor* operator_thread_pool;
+	// work stealing workers for the operators, and their concurrent jobs
+	// max workers count = max_concurrent_users_count * 10 (atmost 1024), the same as the resources in the operator_thread_pool_usage_limiter, but they are started only as needed
+	operator_scheduler operator_scheduler;
 
 	rage_engine persistent_acid_rage_engine;
 
 	// same as bufferpool size in persistent_acid_rage_engine
 	resource_usage_limiter* bufferpool_usage_limiter;
 
+	// the heap_tables being walked by the scans, their empty heap pages are not freed until the scans complete
+	heap_table_walks_guard heap_table_walks_guard;
+
 	rage_engine volatile_rage_engine;
 
 	// components of the database the system table structures are here
@@ -67,10 +71,17 @@ void initialize_rhendb(rhendb* rdb, const char* database_file_name,
 		uint32_t page_size_mte, uint32_t lsn_width, uint64_t bufferpool_frame_count, uint64_t wale_buffer_count,
 			uint64_t page_latch_wait_us, uint64_t page_lock_wait_us,
 			uint64_t checkpoint_period_us,
+			uint64_t group_commit_latency_us, uint32_t group_commit_max_batch_size,
+			int is_asynchronous_commit_default, uint64_t async_commit_flush_period_us,
 		uint32_t page_size_vps,
 			uint64_t truncator_period_us,
+		uint64_t deadlock_detection_period_us,
 		uint64_t max_concurrent_users_count);
 
+// truncates the transaction table (see truncate_transaction_table()), but never beyond the least transaction_id that the catalog still refers to, as the catalog tables are never vaccummed
+// returns the transaction_id below which the transaction table is now truncated
+uint256 truncate_transaction_table_for_rhendb(rhendb* rdb, uint256 frozen_transaction_id);
+
 void deinitialize_rhendb(rhendb* rdb);
 
 #endif
\ No newline at end of file
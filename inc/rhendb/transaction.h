@@ -77,7 +77,7 @@ struct transaction
 	temporary_extension_store temp_ext_stores[TEMPORARY_EXTENSION_STORE_COUNT];
 };
 
-// additional_flags for the insertion operator and scan operator, they toggle the additional book keeping
+// additional_flags for the insertion, deletion, scan and pointer_lookup operators, they toggle the additional book keeping
 // that the operator is expected to perform, over and above the insert itself
 #define RESCAN_PROTECTION_ENABLED   1
 // used when the same query scans and inserts OR updates to the same table, only insertion or only scan on the same table does not need it
@@ -85,11 +85,16 @@ struct transaction
 #define SAVEPOINT_LOGGING_ENABLED   2
 // used when there is a savepoint defined prior to this call
 // when passed every insertion and deletion is logged in the savepoint_log as (takble_id, partition_id, tuple_pointer), so that it can be rolled back, by null-ing the xmin or xmax
+#define MVCC_HINTS_WRITE_BACK_ENABLED 4
+// used by the scan, pointer_lookup and deletion operators, to persist the hints (is_xm**_committed/is_xm**_aborted) that they discover on the tuples they read
+// when passed the hints discovered on a heap page are written back in a single mini transaction, so the later readers do not go to the transaction table for them, do not pass it on a read-only replica
 
 #define IS_RESCAN_PROTECTION_ENABLED(flags)  ((flags) & RESCAN_PROTECTION_ENABLED)
 
 #define IS_SAVEPOINT_LOGGING_ENABLED(flags)  ((flags) & SAVEPOINT_LOGGING_ENABLED)
 
+#define IS_MVCC_HINTS_WRITE_BACK_ENABLED(flags)  ((flags) & MVCC_HINTS_WRITE_BACK_ENABLED)
+
 transaction initialize_transaction(rhendb* rdb);
 
 // registers that there was an insert at the given tuple_pointer for the current query
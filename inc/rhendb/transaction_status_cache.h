@@ -0,0 +1,64 @@
+#ifndef TRANSACTION_STATUS_CACHE_H
+#define TRANSACTION_STATUS_CACHE_H
+
+#include<pthread.h>
+#include<stdatomic.h>
+
+#include<serint/large_uints.h>
+
+#include<rhendb/transaction_status.h>
+
+/*
+	transaction_status_cache is a set-associative cache of the statuses of the finished (TX_COMMITTED or TX_ABORTED) transactions
+	a finished transaction never changes its status, so a cached status never gets stale, and it only needs to be read consistently
+
+	lookups take no locks, every entry is guarded by a sequence counter (a seqlock), a lookup that races with a writer is just a miss
+	inserts only lock the set they insert into, and evict using CLOCK (second chance), a hit only sets the is_referenced bit of the entry, if it is not already set
+*/
+
+#define TRANSACTION_STATUS_CACHE_WAYS 8
+
+typedef struct transaction_status_cache_entry transaction_status_cache_entry;
+struct transaction_status_cache_entry
+{
+	// odd while the entry is being written
+	_Atomic uint64_t sequence;
+
+	uint256 transaction_id;
+
+	// 0 for an empty entry
+	transaction_status status;
+
+	_Atomic uint8_t is_referenced;
+};
+
+typedef struct transaction_status_cache_set transaction_status_cache_set;
+struct transaction_status_cache_set
+{
+	// held only by the inserts into this set
+	pthread_mutex_t insert_lock;
+
+	uint32_t clock_hand;
+
+	transaction_status_cache_entry entries[TRANSACTION_STATUS_CACHE_WAYS];
+};
+
+typedef struct transaction_status_cache transaction_status_cache;
+struct transaction_status_cache
+{
+	uint64_t sets_count;
+	transaction_status_cache_set* sets;
+};
+
+// capacity is rounded up to a multiple of TRANSACTION_STATUS_CACHE_WAYS
+void initialize_transaction_status_cache(transaction_status_cache* tsc_p, uint64_t capacity);
+
+// returns 1 and sets the status, only if the status of the transaction_id is cached
+int find_in_transaction_status_cache(transaction_status_cache* tsc_p, uint256 transaction_id, transaction_status* status);
+
+// status must be either TX_COMMITTED or TX_ABORTED
+void insert_in_transaction_status_cache(transaction_status_cache* tsc_p, uint256 transaction_id, transaction_status status);
+
+void deinitialize_transaction_status_cache(transaction_status_cache* tsc_p);
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef TRANSACTION_STATUS_PAGE_MIRROR_H
+#define TRANSACTION_STATUS_PAGE_MIRROR_H
+
+#include<pthread.h>
+#include<stdatomic.h>
+
+#include<serint/large_uints.h>
+
+#include<rhendb/transaction_status.h>
+
+/*
+	transaction_status_page_mirror is an in-memory copy of the bitmap pages of the transaction_table, whose transactions have all completed
+	such a page never changes again, so its copy never gets stale, and it can be read with just an array index and a shift, without any locks or page latches
+
+	the mirrored pages are reached through a fixed 2 level directory of (DIRECTORY_SIZE x CHUNK_SIZE) page slots, indexed by the bucket_id of the bitmap page
+	the chunks and the pages are only ever published (atomically) and never freed until deinitialization, so the lookups take no locks
+	inserts are serialized by the insert_lock
+*/
+
+#define TRANSACTION_STATUS_PAGE_MIRROR_DIRECTORY_SIZE 1024
+#define TRANSACTION_STATUS_PAGE_MIRROR_CHUNK_SIZE     1024
+
+typedef struct transaction_status_page_mirror transaction_status_page_mirror;
+struct transaction_status_page_mirror
+{
+	// number of 2 bit transaction_statuses in every page
+	uint32_t statuses_per_page;
+
+	// no more pages are mirrored, once this many of them have been
+	uint64_t max_pages_count;
+
+	// held only by the inserts
+	pthread_mutex_t insert_lock;
+
+	// only accessed with the insert_lock held
+	uint64_t pages_count;
+
+	_Atomic(_Atomic(const uint8_t*)*) directory[TRANSACTION_STATUS_PAGE_MIRROR_DIRECTORY_SIZE];
+};
+
+void initialize_transaction_status_page_mirror(transaction_status_page_mirror* tspm_p, uint32_t statuses_per_page, uint64_t max_pages_count);
+
+// number of bytes in a mirrored page, 4 statuses per byte
+static inline uint64_t get_bytes_per_mirrored_transaction_status_page(const transaction_status_page_mirror* tspm_p)
+{
+	return (tspm_p->statuses_per_page + 3) / 4;
+}
+
+static inline transaction_status get_status_on_mirrored_transaction_status_page(const uint8_t* page, uint32_t sub_bucket_id)
+{
+	return (page[sub_bucket_id >> 2] >> ((sub_bucket_id & 3) << 1)) & 0x3;
+}
+
+static inline void set_status_on_mirrored_transaction_status_page(uint8_t* page, uint32_t sub_bucket_id, transaction_status status)
+{
+	page[sub_bucket_id >> 2] = (page[sub_bucket_id >> 2] & ~(0x3 << ((sub_bucket_id & 3) << 1))) | ((status & 0x3) << ((sub_bucket_id & 3) << 1));
+}
+
+// returns 1 and sets the status, only if the page of the transaction_id is mirrored
+int find_in_transaction_status_page_mirror(const transaction_status_page_mirror* tspm_p, uint256 transaction_id, transaction_status* status);
+
+// returns 1, if the page of the bucket_id is not mirrored yet, and there is space for it to be mirrored
+// to avoid reading the page on the disk for nothing, it is only a hint as it does not lock
+int can_insert_in_transaction_status_page_mirror(transaction_status_page_mirror* tspm_p, uint64_t bucket_id);
+
+// page must be malloc-ed, with get_bytes_per_mirrored_transaction_status_page() bytes, and all of its statuses must be either TX_COMMITTED or TX_ABORTED
+// the page is owned by the mirror after this call, it is freed right away if it could not be inserted
+// returns 1, if the page got inserted
+int insert_in_transaction_status_page_mirror(transaction_status_page_mirror* tspm_p, uint64_t bucket_id, uint8_t* page);
+
+void deinitialize_transaction_status_page_mirror(transaction_status_page_mirror* tspm_p);
+
+#endif
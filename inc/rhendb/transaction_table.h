@@ -2,13 +2,15 @@
 #define TRANSACTION_TABLE_H
 
 #include<cutlery/linkedlist.h>
+#include<cutlery/singlylist.h>
 #include<cutlery/bst.h>
-#include<cutlery/cachemap.h>
 
 #include<serint/large_uints.h>
 
 #include<lockking/rwlock.h>
 
+#include<pthread.h>
+
 #include<tupleindexer/page_table/page_table.h>
 #include<tupleindexer/bitmap_page/bitmap_page.h>
 #include<tupleindexer/interface/page_access_methods.h>
@@ -16,8 +18,25 @@
 #include<rhendb/rage_engine.h>
 
 #include<rhendb/transaction_status.h>
+#include<rhendb/transaction_status_cache.h>
+#include<rhendb/transaction_status_page_mirror.h>
 #include<rhendb/mvcc_snapshot.h>
 
+// a mirrored page takes about as much memory as a page of the transaction table on the disk
+#define MAX_MIRRORED_TRANSACTION_STATUS_PAGES 4096
+
+// number of transaction_ids reserved (set TX_IN_PROGRESS on the disk) at once, by get_new_transaction_id()
+#define TRANSACTION_ID_RESERVATION_BATCH_SIZE 256
+
+// durability to be provided by update_transaction_status()
+typedef enum commit_durability commit_durability;
+enum commit_durability
+{
+	DEFAULT_COMMIT,      // as configured for the transaction_table, by is_asynchronous_commit_default
+	SYNCHRONOUS_COMMIT,  // returns after the status is durably on the disk
+	ASYNCHRONOUS_COMMIT, // returns after the status is written (i.e. its WAL record is buffered), it becomes durable within atmost async_commit_flush_period_us after that
+};
+
 typedef struct transaction_table transaction_table;
 struct transaction_table
 {
@@ -30,33 +49,115 @@ struct transaction_table
 	// this is read-only attribute
 	uint256 next_assignable_transaction_id_at_boot;
 
-	// locks the next_assignable_transaction_id, currently_active_transaction_ids and transaction_table_cache
-	// transaction_table_cache bumps on even every read of its entry, so you will need an exclusive lock to even read it
+	// locks the next_assignable_transaction_id, reserved_transaction_ids_end, is_reserving_transaction_ids_ahead, currently_active_transaction_ids, active_mvcc_snapshots, cached_vaccum_horizon_transaction_id, snapshot_generation and shared_mvcc_snapshot
+	// the transaction_table_cache is not protected by it, but it is only inserted into while holding it
 	rwlock transaction_table_cache_lock;
 
 	// next transaction id to be assigned
 	uint256 next_assignable_transaction_id;
 
+	// transaction_ids in the range [next_assignable_transaction_id, reserved_transaction_ids_end) are already TX_IN_PROGRESS on the disk
+	// so they are assigned without writing to the disk, they are reserved in batches, in a single flushed mini transaction, never crossing a bitmap page
+	// the reserved ones that never get assigned are just like the TX_IN_PROGRESS ones before a crash, they are considered TX_ABORTED after it, and they are anyway never referenced
+	// the next batch is reserved ahead, by the writer that finds only half a batch left, after it releases the transaction_table_cache_lock, is_reserving_transaction_ids_ahead is set meanwhile
+	// a writer that still finds no reserved transaction_id, reserves one more batch itself, so the reservations may run concurrently, see reserved_transaction_ids_written_end
+	uint256 reserved_transaction_ids_end;
+	int is_reserving_transaction_ids_ahead;
+
 	// this bst stores the ids of all the transaction that are IN_PROGRESS state and could be making progress
 	// it is maintaned continuously (as new transaction_ids are assigned) and is used to generate mvcc_snapshot
 	bst currently_active_transaction_ids;
 
 	// cache to quickly access frequently accessed transaction_ids and their statuses
 	// only holds transaction_id -> transaction_status mappings for TX_COMMITTED or TX_ABORTED transactions (not for TX_IN_PROGRESS transactions)
-	cy_uint transaction_table_cache_capacity; // this is the number of elements that the transaction_table_cache is allowed to hold
-	cachemap transaction_table_cache;
+	// these statuses never change, so it is looked up first without taking any locks
+	transaction_status_cache transaction_table_cache;
+
+	// in-memory copies of the bitmap pages (on the disk) whose transaction_ids are all below the vaccum horizon, i.e. all of them have completed
+	// these pages never change, so they are looked up first, even before the transaction_table_cache, without taking any locks
+	// pages get mirrored lazily, on a miss for any of its transaction_ids, atmost MAX_MIRRORED_TRANSACTION_STATUS_PAGES of them
+	transaction_status_page_mirror transaction_table_mirror;
 
 	// all read-only and read-write transactions get a mvcc_snapshot and they are all linked here for quick access for calculating the vaccum_horizon_transaction_id
+	// a snapshot shared by many read-only transactions is linked here only once
 	linkedlist active_mvcc_snapshots;
 
+	// vaccum horizon, as of the last deletion of a snapshot that bounded it, it is never above the actual vaccum horizon, as that only ever moves up
+	// it is good enough for deciding to mirror a bitmap page, without walking all the active_mvcc_snapshots, on every lookup that misses the caches
+	uint256 cached_vaccum_horizon_transaction_id;
+
+	// incremented every time a transaction with a transaction_id completes
+	// only then can a new snapshot see something that an older one does not, a newly assigned transaction_id is in progress for both of them
+	uint64_t snapshot_generation;
+
+	// last snapshot taken without a self_transaction_id, it is handed out (with its reference_count incremented) to the read-only transactions, until the snapshot_generation changes
+	// it is not an owning reference, it is reset to NULL when the snapshot is deleted or gets a self_transaction_id
+	mvcc_snapshot* shared_mvcc_snapshot;
+
 	// below attributes only work with the transaction_table that is persistently stored on the disk
 
+	// the bitmap pages of all the transaction_ids below it have been freed by truncate_transaction_table(), it is always at a bitmap page boundary
+	// it is protected by the transaction_table_lock
+	uint256 truncated_transaction_id;
+
 	// lock to protect the disk resident transaction table
 	// take it with the transaction_table_cache_lock still held and then release the transaction_table_cache_lock
 	// you may hold only a read lock, while reading its entries
 	// but you must hold a write lock for an update, this allows the cache to be consistently holding the right values, even while writing a new one to the disk
 	rwlock transaction_table_lock;
 
+	// protected by the transaction_table_lock, all the transaction_ids below it have been reserved, i.e. written TX_IN_PROGRESS on the disk
+	// it runs ahead of (or equals) the reserved_transaction_ids_end, a reservation writes only above it, so that it never overwrites the status of a transaction_id that was assigned from an earlier reservation
+	uint256 reserved_transaction_ids_written_end;
+
+	/*
+		group commit, update_transaction_status() does not write the status to the disk itself, it enqueues it in the group_commit_queue and waits
+		one of the waiting committers becomes the leader, it waits atmost group_commit_latency_us for atmost group_commit_max_batch_size statuses to be enqueued,
+		then writes them (in the order of their transaction_ids) with one mini transaction per bitmap page, flushing only the last one of them, i.e. forcing the WAL only once for the whole batch
+		and then wakes up all the committers whose statuses it wrote
+		the enqueued statuses stay in the group_commit_queue until they are written, so that get_transaction_status() can find them there, while they are not yet on the disk
+	*/
+
+	// protects all the group_commit_* attributes below, take it after the transaction_table_lock, if you need both
+	pthread_mutex_t group_commit_lock;
+
+	// the committers wait here for their statuses to be written, and the leader waits here for the batch to fill
+	pthread_cond_t group_commit_wait;
+
+	// singlylist of the enqueued statuses, in the order of their enqueue
+	// the first group_commit_batch_size of them are being written by the leader
+	singlylist group_commit_queue;
+	uint32_t group_commit_queue_size;
+
+	int has_group_commit_leader;
+	uint32_t group_commit_batch_size;
+
+	// configuration of the group commit, a group_commit_latency_us of 0, does not wait for the batch to fill at all
+	uint64_t group_commit_latency_us;
+	uint32_t group_commit_max_batch_size;
+
+	/*
+		asynchronous commit, the leader does not flush a batch with only ASYNCHRONOUS_COMMIT-s (and aborts), it only remembers the minimum of the transaction_ids that it committed this way
+		the async_commit_flusher thread, every async_commit_flush_period_us, moves that minimum to min_flushing_transaction_id and forces the WAL, making them all durable
+		any flushed batch, also makes all of them durable
+		the below attributes are also protected by the group_commit_lock
+	*/
+
+	// used for the DEFAULT_COMMIT, async commits are only possible with a non-zero async_commit_flush_period_us, else all commits are synchronous
+	int is_asynchronous_commit_default;
+	uint64_t async_commit_flush_period_us;
+
+	// minimum of the transaction_ids committed asynchronously, and not yet being flushed
+	int has_undurable_transaction_ids;
+	uint256 min_undurable_transaction_id;
+
+	// minimum of the transaction_ids committed asynchronously, and being flushed right now by the async_commit_flusher
+	int has_flushing_transaction_ids;
+	uint256 min_flushing_transaction_id;
+
+	pthread_t async_commit_flusher;
+	int stop_async_commit_flusher;
+
 	/*
 		transaction table on the disk is maintained as a page_table pointing to bitmap pages
 		no lock is actually needed to access it, as MinTxEngine takes care of it's ACID-compliant access, (unless ofcourse while assigning a brand new transaction_id)
@@ -84,7 +185,9 @@ struct transaction_table
 };
 
 // here the root_page_id is an in-out parameter, pass it as NULL_PAGE_ID to create a new transaction table, or an existing one to open that particular transaction_table
-void initialize_transaction_table(transaction_table* ttbl, uint64_t* root_page_id, rage_engine* ttbl_engine, uint32_t transaction_table_cache_capacity);
+// group_commit_max_batch_size must be atleast 1
+// the async_commit_flusher thread is started only if async_commit_flush_period_us is non-zero
+void initialize_transaction_table(transaction_table* ttbl, uint64_t* root_page_id, rage_engine* ttbl_engine, uint32_t transaction_table_cache_capacity, uint64_t group_commit_latency_us, uint32_t group_commit_max_batch_size, int is_asynchronous_commit_default, uint64_t async_commit_flush_period_us);
 
 // if snp is NULL, a new mvcc_snapshot with a new transaction_id assigned is returned to the user
 // if snp is not NULL, a transaction_id is assigned only if it does not already have one
@@ -96,6 +199,8 @@ mvcc_snapshot* get_new_transaction_id(transaction_table* ttbl, mvcc_snapshot* sn
 mvcc_snapshot* get_or_revise_mvcc_snapshot(transaction_table* ttbl, mvcc_snapshot* snp);
 
 // in both the above 2 function it is assumed that the snp struct is in initialized condition
+// the mvcc_snapshot without a transaction_id may be shared with other read-only transactions, so always continue with the returned snapshot, it may not be the one passed in
+// and never modify it yourself
 
 // exit(-1) if you pass in an unassigned transaction_id
 // else returns the status
@@ -104,9 +209,29 @@ transaction_status get_transaction_status(transaction_table* ttbl, uint256 trans
 // if the snp does not have a self_transaction_id, the snapshot will only be deleted from existence, else it also do the below task
 // updates transaction_status of the transaction from TX_IN_PROGRESS to either TX_COMMITTED or TX_ABORTED status
 // this implies that the transaction_id provided must be in the currently_active_transaction_ids bst
-int update_transaction_status(transaction_table* ttbl, mvcc_snapshot* snp, transaction_status status);
+// durability only matters for a TX_COMMITTED, an abort is never flushed (a TX_IN_PROGRESS after a crash is anyway considered aborted)
+int update_transaction_status(transaction_table* ttbl, mvcc_snapshot* snp, transaction_status status, commit_durability durability);
 
 // returns horizon transaction id, changes of all transactions under this value are visible to one or other future transaction
 uint256 get_vaccum_horizon_transaction_id(transaction_table* ttbl);
 
+// returns durability horizon transaction id, all transactions under this value have completed and their statuses are durably on the disk
+// it never decreases
+uint256 get_durability_horizon_transaction_id(transaction_table* ttbl);
+
+// blocks until the status of the transaction_id is durably on the disk, call it only after its update_transaction_status() has returned
+// returns immediately for a SYNCHRONOUS_COMMIT or an abort
+void wait_for_durability_of_transaction_id(transaction_table* ttbl, uint256 transaction_id);
+
+// frees the bitmap pages of the transaction table, whose transaction_ids are all below both the frozen_transaction_id and the vaccum horizon, the statuses of those transaction_ids can never be looked up after this call
+// call it only after every user table has been completely vaccummed with a vaccum horizon of atleast frozen_transaction_id, so that no tuple refers to an unfrozen transaction_id below it
+// the catalog tables are never vaccummed, so call it through truncate_transaction_table_for_rhendb(), that caps the frozen_transaction_id by the transaction_ids the catalog still refers to
+// the bitmap page of the last transaction_id below them is never freed, it is required to find the next assignable transaction_id at boot
+// returns the transaction_id below which the transaction table is now truncated
+uint256 truncate_transaction_table(transaction_table* ttbl, uint256 frozen_transaction_id);
+
+// stops the async_commit_flusher, after making all the asynchronous commits durable, and releases the in-memory resources
+// call it only after all transactions have completed
+void deinitialize_transaction_table(transaction_table* ttbl);
+
 #endif
\ No newline at end of file
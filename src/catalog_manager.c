@@ -113,8 +113,31 @@ static int catalog_write_extended_blob(catalog_manager* catmgr_p, void* tuple, c
 	return 1;
 }
 
+// the catalog is never vaccummed or frozen, so the least transaction_id referred to by its rows only ever goes down, as new ones are written
+static void note_transaction_id_referenced_by_catalog(catalog_manager* catmgr_p, uint256 transaction_id)
+{
+	pthread_mutex_lock(&(catmgr_p->min_referenced_transaction_id_lock));
+	if(!catmgr_p->has_min_referenced_transaction_id || compare_uint256(transaction_id, catmgr_p->min_referenced_transaction_id) < 0)
+	{
+		catmgr_p->has_min_referenced_transaction_id = 1;
+		catmgr_p->min_referenced_transaction_id = transaction_id;
+	}
+	pthread_mutex_unlock(&(catmgr_p->min_referenced_transaction_id_lock));
+}
+
+// a frozen xmin needs no transaction status anymore, every other non NULL xmin and xmax does
+static void note_mvcc_header_referenced_by_catalog(catalog_manager* catmgr_p, const mvcc_header* mvcchdr_p)
+{
+	if((!mvcchdr_p->is_xmin_NULL) && (!is_frozen_transaction_id_with_hints(&(mvcchdr_p->xmin))))
+		note_transaction_id_referenced_by_catalog(catmgr_p, mvcchdr_p->xmin.transaction_id);
+	if(!mvcchdr_p->is_xmax_NULL)
+		note_transaction_id_referenced_by_catalog(catmgr_p, mvcchdr_p->xmax.transaction_id);
+}
+
 static void catalog_write_mvcc_header(catalog_manager* catmgr_p, void* tuple, const tuple_def* record_def, const mvcc_header* mvcchdr_p)
 {
+	note_mvcc_header_referenced_by_catalog(catmgr_p, mvcchdr_p);
+
 	char mvcc_header_serialized[get_maximum_tuple_size(&(catmgr_p->mvcc_header_tuple_def))];
 
 	write_mvcc_header(mvcc_header_serialized, &(catmgr_p->mvcc_header_tuple_def), mvcchdr_p);
@@ -696,6 +719,92 @@ const positional_accessor key_element_ids1[] = {STATIC_POSITION(1), STATIC_POSIT
 #define OWNER_TO_ATTRIBUTES_IDX_ROOT_PAGE_ID_POS   8
 #define EXT_STORE_ROOT_PAGE_ID_ROOT_PAGE_ID_POS    9
 
+// walks all the rows of the catalog_heap_table, noting the transaction_ids referred to by their mvcc_headers
+static void note_transaction_ids_referenced_by_catalog_heap_table(catalog_manager* catmgr_p, catalog_heap_table* hpt_p, int* abort_error)
+{
+	rage_engine* engine = catmgr_p->catmgr_engine;
+
+	heap_table_iterator* hti_p = get_new_heap_table_iterator(hpt_p->root_page_id, 0, 0, &(hpt_p->heap_table_defs), engine->pam_p, NULL, abort_error);
+	if(*abort_error)
+		return;
+
+	while(1)
+	{
+		uint32_t unused_space = 0;
+		int entry_needs_fixing = 0;
+		persistent_page ppage = lock_and_get_curr_heap_page_heap_table_iterator(hti_p, 0 /* READ_LOCK */, &unused_space, &entry_needs_fixing, NULL, abort_error);
+		if(*abort_error)
+			goto ABORT_ERROR;
+
+		// no more heap pages left
+		if(is_persistent_page_NULL(&ppage, engine->pam_p))
+			break;
+
+		uint32_t tuple_count = get_tuple_count_on_persistent_page(&ppage, engine->pam_p->pas.page_size, &(hpt_p->record_def.size_def));
+		for(uint32_t tuple_index = 0; tuple_index < tuple_count; tuple_index++)
+		{
+			if(!exists_tuple_on_persistent_page(&ppage, engine->pam_p->pas.page_size, &(hpt_p->record_def.size_def), tuple_index))
+				continue;
+
+			const void* row = get_nth_tuple_on_persistent_page(&ppage, engine->pam_p->pas.page_size, &(hpt_p->record_def.size_def), tuple_index);
+			if(row == NULL)
+				continue;
+
+			mvcc_header hdr;
+			catalog_read_mvcc_header(catmgr_p, row, &(hpt_p->record_def), &hdr);
+			note_mvcc_header_referenced_by_catalog(catmgr_p, &hdr);
+		}
+
+		release_lock_on_persistent_page(engine->pam_p, NULL, &ppage, NONE_OPTION, abort_error);
+		if(*abort_error)
+			goto ABORT_ERROR;
+
+		int went_next = next_heap_table_iterator(hti_p, NULL, abort_error);
+		if(*abort_error)
+			goto ABORT_ERROR;
+		if(!went_next)
+			break;
+	}
+
+	delete_heap_table_iterator(hti_p, NULL, abort_error);
+	return;
+
+	ABORT_ERROR:;
+	int ignored_abort_error = 0;
+	delete_heap_table_iterator(hti_p, NULL, &ignored_abort_error);
+}
+
+// walks all the rows of the catalog_clust_table, noting the transaction_ids referred to by their mvcc_headers
+static void note_transaction_ids_referenced_by_catalog_clust_table(catalog_manager* catmgr_p, catalog_clust_table* cct_p, int* abort_error)
+{
+	rage_engine* engine = catmgr_p->catmgr_engine;
+
+	bplus_tree_iterator* bpi_p = find_in_bplus_tree(cct_p->root_page_id, NULL, KEY_ELEMENT_COUNT, MIN, 0, READ_LOCK, &(cct_p->clust_table_defs), engine->pam_p, NULL, NULL, abort_error);
+	if(*abort_error)
+		return;
+
+	while(!is_empty_bplus_tree(bpi_p) && !is_beyond_max_tuple_bplus_tree_iterator(bpi_p))
+	{
+		const void* row = get_tuple_bplus_tree_iterator(bpi_p);
+		if(row != NULL)
+		{
+			mvcc_header hdr;
+			catalog_read_mvcc_header(catmgr_p, row, &(cct_p->record_def), &hdr);
+			note_mvcc_header_referenced_by_catalog(catmgr_p, &hdr);
+		}
+
+		next_bplus_tree_iterator(bpi_p, NULL, abort_error);
+		if(*abort_error)
+		{
+			int ignored_abort_error = 0;
+			delete_bplus_tree_iterator(bpi_p, NULL, &ignored_abort_error);
+			return;
+		}
+	}
+
+	delete_bplus_tree_iterator(bpi_p, NULL, abort_error);
+}
+
 void initialize_catalog_manager(catalog_manager* catmgr_p, uint64_t* root_page_id, data_type_info* mvcc_hdr_dti_p, rage_engine* catmgr_engine, transaction_status_getter* tsg_p)
 {
 	data_type_info* obj_type_dti_p = UINT_NON_NULLABLE[2];
@@ -945,6 +1054,9 @@ void initialize_catalog_manager(catalog_manager* catmgr_p, uint64_t* root_page_i
 
 	pthread_mutex_init(&(catmgr_p->global_unique_schema_id_lock), NULL);
 
+	pthread_mutex_init(&(catmgr_p->min_referenced_transaction_id_lock), NULL);
+	catmgr_p->has_min_referenced_transaction_id = 0;
+
 	page_table_tuple_defs pttd;
 	init_page_table_tuple_definitions(&pttd, &(catmgr_engine->pam_p->pas));
 
@@ -1199,6 +1311,36 @@ void initialize_catalog_manager(catalog_manager* catmgr_p, uint64_t* root_page_i
 				delete_bplus_tree_iterator(bpi_p, NULL, &abort_error);
 		}
 
+		// find the least transaction_id, that the rows of the catalog refer to, see get_min_transaction_id_referenced_by_catalog()
+		while(1)
+		{
+			int abort_error = 0;
+
+			catmgr_p->has_min_referenced_transaction_id = 0;
+
+			note_transaction_ids_referenced_by_catalog_heap_table(catmgr_p, &(catmgr_p->attributes_table), &abort_error);
+			if(abort_error)
+				continue;
+
+			note_transaction_ids_referenced_by_catalog_clust_table(catmgr_p, &(catmgr_p->index_fragments_table), &abort_error);
+			if(abort_error)
+				continue;
+
+			note_transaction_ids_referenced_by_catalog_heap_table(catmgr_p, &(catmgr_p->indices_table), &abort_error);
+			if(abort_error)
+				continue;
+
+			note_transaction_ids_referenced_by_catalog_clust_table(catmgr_p, &(catmgr_p->table_partitions_table), &abort_error);
+			if(abort_error)
+				continue;
+
+			note_transaction_ids_referenced_by_catalog_heap_table(catmgr_p, &(catmgr_p->tables_table), &abort_error);
+			if(abort_error)
+				continue;
+
+			break;
+		}
+
 		catmgr_p->catalog_root_page_id = (*root_page_id);
 	}
 
@@ -2391,6 +2533,7 @@ static void write_xmax_at(catalog_manager* catmgr_p, const mvcc_snapshot* ss_p,
 	catalog_read_mvcc_header(catmgr_p, row, record_def, &hdr);
 	hdr.is_xmax_NULL = 0;
 	hdr.xmax = (transaction_id_with_hints){.is_committed = 0, .is_aborted = 0, .transaction_id = ss_p->self_transaction_id};
+	note_mvcc_header_referenced_by_catalog(catmgr_p, &hdr);
 
 	// keep the serialized mvcc buffer in its own block so its variable length type does not span the goto
 	{
@@ -2951,6 +3094,7 @@ uint64_t alter_table_drop_column(catalog_manager* catmgr_p, const mvcc_snapshot*
 			catalog_read_mvcc_header(catmgr_p, row, &(catmgr_p->attributes_table.record_def), &hdr);
 			hdr.is_xmax_NULL = 0;
 			hdr.xmax = (transaction_id_with_hints){.is_committed = 0, .is_aborted = 0, .transaction_id = ss_p->self_transaction_id};
+			note_mvcc_header_referenced_by_catalog(catmgr_p, &hdr);
 
 			char mvcc_hdr_serialized[get_maximum_tuple_size(&(catmgr_p->mvcc_header_tuple_def))];
 			write_mvcc_header(mvcc_hdr_serialized, &(catmgr_p->mvcc_header_tuple_def), &hdr);
@@ -3731,6 +3875,7 @@ static int drop_index_simple(catalog_manager* catmgr_p, const mvcc_snapshot* ss_
 			{
 				hdr.is_xmax_NULL = 0;
 				hdr.xmax = (transaction_id_with_hints){.is_committed = 0, .is_aborted = 0, .transaction_id = ss_p->self_transaction_id};
+				note_mvcc_header_referenced_by_catalog(catmgr_p, &hdr);
 
 				char mvcc_hdr_serialized[get_maximum_tuple_size(&(catmgr_p->mvcc_header_tuple_def))];
 				write_mvcc_header(mvcc_hdr_serialized, &(catmgr_p->mvcc_header_tuple_def), &hdr);
@@ -3840,6 +3985,7 @@ static int drop_table_simple(catalog_manager* catmgr_p, const mvcc_snapshot* ss_
 			{
 				hdr.is_xmax_NULL = 0;
 				hdr.xmax = (transaction_id_with_hints){.is_committed = 0, .is_aborted = 0, .transaction_id = ss_p->self_transaction_id};
+				note_mvcc_header_referenced_by_catalog(catmgr_p, &hdr);
 
 				char mvcc_hdr_serialized[get_maximum_tuple_size(&(catmgr_p->mvcc_header_tuple_def))];
 				write_mvcc_header(mvcc_hdr_serialized, &(catmgr_p->mvcc_header_tuple_def), &hdr);
@@ -4194,4 +4340,14 @@ data_type_info* get_data_type_info_for_rhendb_index_from_catalog(catalog_manager
 	}
 	read_unlock(&(catmgr_p->catlog_manager_lock));
 	return index_data_type_info;
-}
\ No newline at end of file
+}
+
+int get_min_transaction_id_referenced_by_catalog(catalog_manager* catmgr_p, uint256* min_referenced_transaction_id)
+{
+	pthread_mutex_lock(&(catmgr_p->min_referenced_transaction_id_lock));
+	int has_min_referenced_transaction_id = catmgr_p->has_min_referenced_transaction_id;
+	if(has_min_referenced_transaction_id)
+		(*min_referenced_transaction_id) = catmgr_p->min_referenced_transaction_id;
+	pthread_mutex_unlock(&(catmgr_p->min_referenced_transaction_id_lock));
+	return has_min_referenced_transaction_id;
+}
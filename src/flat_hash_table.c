@@ -0,0 +1,58 @@
+#include<rhendb/flat_hash_table.h>
+
+#include<stdio.h>
+#include<stdlib.h>
+
+void initialize_flat_hash_table(flat_hash_table* fht_p, uint64_t max_entries_count, int needs_is_matched_flags)
+{
+	// keep the load factor under 0.5, so that the probe sequences stay short
+	fht_p->slots_count_bits = 3;
+	while((UINT64_C(1) << fht_p->slots_count_bits) < 2 * max_entries_count)
+		fht_p->slots_count_bits++;
+	fht_p->slots_count = UINT64_C(1) << fht_p->slots_count_bits;
+
+	fht_p->entries_count = 0;
+
+	fht_p->slots = calloc(fht_p->slots_count, sizeof(flat_hash_table_entry));
+	fht_p->is_matched = needs_is_matched_flags ? calloc(fht_p->slots_count, sizeof(uint8_t)) : NULL;
+	if(fht_p->slots == NULL || (needs_is_matched_flags && fht_p->is_matched == NULL))
+	{
+		printf("FAILED to allocate memory for flat_hash_table\n");
+		exit(-1);
+	}
+}
+
+void insert_in_flat_hash_table(flat_hash_table* fht_p, uint64_t hash_value, const void* tuple)
+{
+	if(2 * (fht_p->entries_count + 1) > fht_p->slots_count)
+	{
+		printf("flat_hash_table is full, it was initialized for lesser entries\n");
+		exit(-1);
+	}
+
+	uint64_t slot = get_home_slot_in_flat_hash_table(fht_p, hash_value);
+	while(fht_p->slots[slot].tuple != NULL)
+		slot = get_next_slot_in_flat_hash_table(fht_p, slot);
+
+	fht_p->slots[slot] = (flat_hash_table_entry){.hash_value = hash_value, .tuple = tuple};
+	fht_p->entries_count++;
+}
+
+uint64_t find_in_flat_hash_table(const flat_hash_table* fht_p, uint64_t hash_value, uint64_t from_slot)
+{
+	// there is always an empty slot, so this loop terminates
+	for(uint64_t slot = from_slot; fht_p->slots[slot].tuple != NULL; slot = get_next_slot_in_flat_hash_table(fht_p, slot))
+	{
+		if(fht_p->slots[slot].hash_value == hash_value)
+			return slot;
+	}
+	return FLAT_HASH_TABLE_NO_SLOT;
+}
+
+void deinitialize_flat_hash_table(flat_hash_table* fht_p)
+{
+	free(fht_p->slots);
+	free(fht_p->is_matched);
+	fht_p->slots = NULL;
+	fht_p->is_matched = NULL;
+}
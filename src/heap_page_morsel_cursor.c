@@ -0,0 +1,274 @@
+#include<rhendb/heap_page_morsel_cursor.h>
+
+#include<tupleindexer/heap_page/heap_page.h>
+
+#include<stdio.h>
+#include<stdlib.h>
+
+static void initialize_heap_page_morsel_cursor(heap_page_morsel_cursor* hpmc_p, heap_page_morsel_source source, const fetched_table* ftabl, uint32_t morsel_pages_count)
+{
+	if(morsel_pages_count == 0 || morsel_pages_count > MAX_HEAP_PAGES_PER_MORSEL)
+	{
+		printf("BUG :: morsel_pages_count must be in range [1, %d] for the heap_page_morsel_cursor\n", MAX_HEAP_PAGES_PER_MORSEL);
+		exit(-1);
+	}
+
+	pthread_mutex_init(&(hpmc_p->cursor_lock), NULL);
+	pthread_cond_init(&(hpmc_p->walk_done), NULL);
+	hpmc_p->source = source;
+	hpmc_p->morsel_pages_count = morsel_pages_count;
+	hpmc_p->ftabl = ftabl;
+
+	hpmc_p->engine = NULL;
+	hpmc_p->htwg_p = NULL;
+	hpmc_p->is_being_walked = 0;
+	hpmc_p->partition_pos = 0;
+	hpmc_p->hti_p = NULL;
+	hpmc_p->is_aborted = 0;
+
+	hpmc_p->tuple_pointers = NULL;
+	hpmc_p->tuple_pointers_count = 0;
+	hpmc_p->get_tuple_pointer = NULL;
+	hpmc_p->next_index = 0;
+	hpmc_p->next_partition_index_in_info = 0;
+}
+
+void initialize_heap_page_morsel_cursor_for_heap_table_walk(heap_page_morsel_cursor* hpmc_p, const fetched_table* ftabl, rage_engine* engine, heap_table_walks_guard* htwg_p, uint32_t morsel_pages_count)
+{
+	initialize_heap_page_morsel_cursor(hpmc_p, HEAP_TABLE_WALK, ftabl, morsel_pages_count);
+	hpmc_p->engine = engine;
+	hpmc_p->htwg_p = htwg_p;
+
+	// from now on, until the cursor is deinitialized, the empty heap pages of these heap_tables are not freed
+	for(uint64_t i = 0; i < ftabl->partitions_count; i++)
+		begin_heap_table_walk(htwg_p, ftabl->table_partitions_info[i].heap_root_page_id);
+}
+
+void initialize_heap_page_morsel_cursor_for_sorted_tuple_pointers(heap_page_morsel_cursor* hpmc_p, const fetched_table* ftabl, uint32_t morsel_pages_count, const void* tuple_pointers, cy_uint tuple_pointers_count, void (*get_tuple_pointer)(const void* tuple_pointers, cy_uint index, uint64_t* partition_id, tuple_pointer* tptr))
+{
+	initialize_heap_page_morsel_cursor(hpmc_p, SORTED_TUPLE_POINTERS, ftabl, morsel_pages_count);
+	hpmc_p->tuple_pointers = tuple_pointers;
+	hpmc_p->tuple_pointers_count = tuple_pointers_count;
+	hpmc_p->get_tuple_pointer = get_tuple_pointer;
+}
+
+// closes the partition being walked, and moves on to the next one
+static void close_partition_being_walked(heap_page_morsel_cursor* hpmc_p, int* abort_error)
+{
+	if(hpmc_p->hti_p != NULL)
+	{
+		delete_heap_table_iterator(hpmc_p->hti_p, NULL, abort_error);
+		hpmc_p->hti_p = NULL;
+		deinit_heap_table_tuple_definitions(&(hpmc_p->httd));
+	}
+	hpmc_p->partition_pos++;
+}
+
+// must be called with the cursor_lock held, it is released while walking, and held again on return
+static int claim_heap_page_morsel_from_heap_table_walk(heap_page_morsel_cursor* hpmc_p, heap_page_morsel* morsel, int* abort_error)
+{
+	rage_engine* engine = hpmc_p->engine;
+
+	// wait for the job walking, to continue the walk from where it stops
+	while(hpmc_p->is_being_walked)
+		pthread_cond_wait(&(hpmc_p->walk_done), &(hpmc_p->cursor_lock));
+
+	if(hpmc_p->is_aborted)
+	{
+		(*abort_error) = 1;
+		return 0;
+	}
+
+	morsel->page_ids_count = 0;
+
+	// nothing left to walk
+	if(hpmc_p->partition_pos == hpmc_p->ftabl->partitions_count)
+		return 0;
+
+	// walk without the cursor_lock, the heap pages locked below may have to be read from the disk
+	hpmc_p->is_being_walked = 1;
+	pthread_mutex_unlock(&(hpmc_p->cursor_lock));
+
+	// a partition may have no heap pages, so keep walking, until a page is claimed or there are no partitions left
+	while(morsel->page_ids_count == 0 && hpmc_p->partition_pos < hpmc_p->ftabl->partitions_count)
+	{
+		if(hpmc_p->hti_p == NULL)
+		{
+			const rhendb_table_partition* table_partition = &(hpmc_p->ftabl->table_partitions_info[hpmc_p->partition_pos]);
+			init_heap_table_tuple_definitions(&(hpmc_p->httd), &(engine->pam_p->pas), &(hpmc_p->ftabl->table_partition_tuple_defs[hpmc_p->partition_pos]));
+			hpmc_p->hti_p = get_new_heap_table_iterator(table_partition->heap_root_page_id, 0, 0, &(hpmc_p->httd), engine->pam_p, NULL, abort_error);
+			if(*abort_error)
+			{
+				hpmc_p->hti_p = NULL;
+				deinit_heap_table_tuple_definitions(&(hpmc_p->httd));
+				goto ABORT_ERROR;
+			}
+		}
+
+		morsel->partition_index_in_info = hpmc_p->partition_pos;
+
+		int is_partition_walked = 0;
+		while(morsel->page_ids_count < hpmc_p->morsel_pages_count)
+		{
+			// the heap page is locked only to know its page_id, the claimer locks it again to process it
+			uint32_t unused_space = 0;
+			int entry_needs_fixing = 0;
+			persistent_page ppage = lock_and_get_curr_heap_page_heap_table_iterator(hpmc_p->hti_p, 0 /* READ_LOCK */, &unused_space, &entry_needs_fixing, NULL, abort_error);
+			if(*abort_error)
+				goto ABORT_ERROR;
+
+			// no more heap pages left in this partition
+			if(is_persistent_page_NULL(&ppage, engine->pam_p))
+			{
+				is_partition_walked = 1;
+				break;
+			}
+
+			morsel->page_ids[morsel->page_ids_count++] = ppage.page_id;
+
+			release_lock_on_persistent_page(engine->pam_p, NULL, &ppage, NONE_OPTION, abort_error);
+			if(*abort_error)
+				goto ABORT_ERROR;
+
+			int went_next = next_heap_table_iterator(hpmc_p->hti_p, NULL, abort_error);
+			if(*abort_error)
+				goto ABORT_ERROR;
+			if(!went_next)
+			{
+				is_partition_walked = 1;
+				break;
+			}
+		}
+
+		if(is_partition_walked)
+		{
+			close_partition_being_walked(hpmc_p, abort_error);
+			if(*abort_error)
+				goto ABORT_ERROR;
+		}
+	}
+
+	pthread_mutex_lock(&(hpmc_p->cursor_lock));
+	hpmc_p->is_being_walked = 0;
+	// wake all the waiting jobs, a single woken job would not pass on the wake up, if it finds nothing left to walk
+	pthread_cond_broadcast(&(hpmc_p->walk_done));
+
+	return morsel->page_ids_count > 0;
+
+	ABORT_ERROR:;
+
+	// the pages claimed so far are never handed out, the operator kills itself anyway
+	if(hpmc_p->hti_p != NULL)
+	{
+		int ignored_abort_error = 0;
+		delete_heap_table_iterator(hpmc_p->hti_p, NULL, &ignored_abort_error);
+		hpmc_p->hti_p = NULL;
+		deinit_heap_table_tuple_definitions(&(hpmc_p->httd));
+	}
+
+	// all the waiting jobs must see the is_aborted
+	pthread_mutex_lock(&(hpmc_p->cursor_lock));
+	hpmc_p->is_aborted = 1;
+	hpmc_p->is_being_walked = 0;
+	pthread_cond_broadcast(&(hpmc_p->walk_done));
+
+	return 0;
+}
+
+// must be called with the cursor_lock held
+static int claim_heap_page_morsel_from_sorted_tuple_pointers(heap_page_morsel_cursor* hpmc_p, heap_page_morsel* morsel)
+{
+	if(hpmc_p->next_index >= hpmc_p->tuple_pointers_count)
+		return 0;
+
+	uint64_t partition_id;
+	tuple_pointer tptr;
+	hpmc_p->get_tuple_pointer(hpmc_p->tuple_pointers, hpmc_p->next_index, &partition_id, &tptr);
+
+	// advance over all the partitions that no tuple_pointer points into, the tuple_pointers are sorted, so this is linear in the partitions_count over all the claims
+	while(hpmc_p->next_partition_index_in_info < hpmc_p->ftabl->partitions_count && hpmc_p->ftabl->table_partitions_info[hpmc_p->next_partition_index_in_info].partition_id < partition_id)
+		hpmc_p->next_partition_index_in_info++;
+
+	if(hpmc_p->next_partition_index_in_info == hpmc_p->ftabl->partitions_count || hpmc_p->ftabl->table_partitions_info[hpmc_p->next_partition_index_in_info].partition_id != partition_id)
+	{
+		printf("ISSUE in (heap_page_morsel_cursor) :: no partition with partition_id = %" PRIu64 " in table with table_id = %" PRIu64 "\n", partition_id, hpmc_p->ftabl->table_info.id);
+		exit(-1);
+	}
+
+	morsel->partition_index_in_info = hpmc_p->next_partition_index_in_info;
+	morsel->page_ids_count = 0;
+	morsel->first_index = hpmc_p->next_index;
+
+	// claim all the tuple_pointers of the next morsel_pages_count pages of this partition
+	uint64_t curr_page_id = tptr.page_id;
+	uint32_t pages_count = 1;
+	cy_uint i = hpmc_p->next_index + 1;
+	for(; i < hpmc_p->tuple_pointers_count; i++)
+	{
+		uint64_t next_partition_id;
+		tuple_pointer next_tptr;
+		hpmc_p->get_tuple_pointer(hpmc_p->tuple_pointers, i, &next_partition_id, &next_tptr);
+
+		if(next_partition_id != partition_id)
+			break;
+
+		if(next_tptr.page_id != curr_page_id)
+		{
+			if(pages_count == hpmc_p->morsel_pages_count)
+				break;
+			curr_page_id = next_tptr.page_id;
+			pages_count++;
+		}
+	}
+
+	morsel->last_index = i;
+	hpmc_p->next_index = i;
+
+	return 1;
+}
+
+int claim_heap_page_morsel(heap_page_morsel_cursor* hpmc_p, heap_page_morsel* morsel, int* abort_error)
+{
+	pthread_mutex_lock(&(hpmc_p->cursor_lock));
+
+	int claimed = 0;
+	switch(hpmc_p->source)
+	{
+		case HEAP_TABLE_WALK :
+		{
+			claimed = claim_heap_page_morsel_from_heap_table_walk(hpmc_p, morsel, abort_error);
+			break;
+		}
+		case SORTED_TUPLE_POINTERS :
+		{
+			claimed = claim_heap_page_morsel_from_sorted_tuple_pointers(hpmc_p, morsel);
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&(hpmc_p->cursor_lock));
+
+	return claimed;
+}
+
+void deinitialize_heap_page_morsel_cursor(heap_page_morsel_cursor* hpmc_p)
+{
+	// a walk that was not completed, still has its partition open
+	if(hpmc_p->hti_p != NULL)
+	{
+		int abort_error = 0;
+		delete_heap_table_iterator(hpmc_p->hti_p, NULL, &abort_error);
+		hpmc_p->hti_p = NULL;
+		deinit_heap_table_tuple_definitions(&(hpmc_p->httd));
+	}
+
+	// all the claimed heap pages have been processed, so now they may be freed
+	if(hpmc_p->source == HEAP_TABLE_WALK)
+	{
+		for(uint64_t i = 0; i < hpmc_p->ftabl->partitions_count; i++)
+			end_heap_table_walk(hpmc_p->htwg_p, hpmc_p->ftabl->table_partitions_info[i].heap_root_page_id);
+	}
+
+	pthread_cond_destroy(&(hpmc_p->walk_done));
+	pthread_mutex_destroy(&(hpmc_p->cursor_lock));
+}
@@ -0,0 +1,67 @@
+#include<rhendb/heap_table_walks_guard.h>
+
+#include<stdio.h>
+#include<stdlib.h>
+
+static heap_table_walks_guard_stripe* get_stripe_for_heap_table(heap_table_walks_guard* htwg_p, uint64_t heap_root_page_id)
+{
+	// mix the bits of the root_page_id, the root pages of the heap_tables created together are often adjacent
+	uint64_t h = heap_root_page_id * 0x9E3779B97F4A7C15ULL;
+	return &(htwg_p->stripes[(h >> 32) % HEAP_TABLE_WALKS_GUARD_STRIPES_COUNT]);
+}
+
+void initialize_heap_table_walks_guard(heap_table_walks_guard* htwg_p)
+{
+	for(uint32_t i = 0; i < HEAP_TABLE_WALKS_GUARD_STRIPES_COUNT; i++)
+	{
+		pthread_mutex_init(&(htwg_p->stripes[i].stripe_lock), NULL);
+		htwg_p->stripes[i].walks_count = 0;
+	}
+}
+
+void begin_heap_table_walk(heap_table_walks_guard* htwg_p, uint64_t heap_root_page_id)
+{
+	heap_table_walks_guard_stripe* stripe_p = get_stripe_for_heap_table(htwg_p, heap_root_page_id);
+	pthread_mutex_lock(&(stripe_p->stripe_lock));
+	stripe_p->walks_count++;
+	pthread_mutex_unlock(&(stripe_p->stripe_lock));
+}
+
+void end_heap_table_walk(heap_table_walks_guard* htwg_p, uint64_t heap_root_page_id)
+{
+	heap_table_walks_guard_stripe* stripe_p = get_stripe_for_heap_table(htwg_p, heap_root_page_id);
+	pthread_mutex_lock(&(stripe_p->stripe_lock));
+	if(stripe_p->walks_count == 0)
+	{
+		printf("BUG :: ending a heap_table walk, that never began\n");
+		exit(-1);
+	}
+	stripe_p->walks_count--;
+	pthread_mutex_unlock(&(stripe_p->stripe_lock));
+}
+
+int try_begin_fixing_unused_space_entries(heap_table_walks_guard* htwg_p, uint64_t heap_root_page_id)
+{
+	heap_table_walks_guard_stripe* stripe_p = get_stripe_for_heap_table(htwg_p, heap_root_page_id);
+	pthread_mutex_lock(&(stripe_p->stripe_lock));
+	if(stripe_p->walks_count > 0)
+	{
+		pthread_mutex_unlock(&(stripe_p->stripe_lock));
+		return 0;
+	}
+
+	// the stripe_lock is held until the fixing ends, so that no walk begins in the meantime
+	return 1;
+}
+
+void end_fixing_unused_space_entries(heap_table_walks_guard* htwg_p, uint64_t heap_root_page_id)
+{
+	heap_table_walks_guard_stripe* stripe_p = get_stripe_for_heap_table(htwg_p, heap_root_page_id);
+	pthread_mutex_unlock(&(stripe_p->stripe_lock));
+}
+
+void deinitialize_heap_table_walks_guard(heap_table_walks_guard* htwg_p)
+{
+	for(uint32_t i = 0; i < HEAP_TABLE_WALKS_GUARD_STRIPES_COUNT; i++)
+		pthread_mutex_destroy(&(htwg_p->stripes[i].stripe_lock));
+}
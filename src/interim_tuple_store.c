@@ -8,11 +8,231 @@
 #include<sys/mman.h>
 
 #include<stdlib.h>
+#include<errno.h>
 
 #include<fcntl.h>
 #include<unistd.h>
 #include<sys/types.h>
 
+// process-wide interim memory budget, and the bytes of the in memory interim_tuple_stores accounted against it
+
+static pthread_mutex_t interim_memory_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t interim_memory_budget = DEFAULT_INTERIM_MEMORY_BUDGET;
+static uint64_t interim_memory_in_use = 0;
+
+void set_interim_memory_budget(uint64_t new_interim_memory_budget)
+{
+	pthread_mutex_lock(&interim_memory_lock);
+	interim_memory_budget = new_interim_memory_budget;
+	pthread_mutex_unlock(&interim_memory_lock);
+}
+
+uint64_t get_interim_memory_budget()
+{
+	pthread_mutex_lock(&interim_memory_lock);
+	uint64_t result = interim_memory_budget;
+	pthread_mutex_unlock(&interim_memory_lock);
+	return result;
+}
+
+uint64_t get_interim_memory_in_use()
+{
+	pthread_mutex_lock(&interim_memory_lock);
+	uint64_t result = interim_memory_in_use;
+	pthread_mutex_unlock(&interim_memory_lock);
+	return result;
+}
+
+static int is_within_interim_memory_budget_UNSAFE(uint64_t additional_bytes)
+{
+	return (interim_memory_in_use <= interim_memory_budget) && (additional_bytes <= (interim_memory_budget - interim_memory_in_use));
+}
+
+static int is_within_interim_memory_budget(uint64_t additional_bytes)
+{
+	pthread_mutex_lock(&interim_memory_lock);
+	int result = is_within_interim_memory_budget_UNSAFE(additional_bytes);
+	pthread_mutex_unlock(&interim_memory_lock);
+	return result;
+}
+
+// accounts additional_bytes against the budget, only if they fit in it, returns 1 on success
+// with force set, the additional_bytes are accounted for even if they overshoot the budget
+static int charge_interim_memory(uint64_t additional_bytes, int force)
+{
+	pthread_mutex_lock(&interim_memory_lock);
+	int charged = force || is_within_interim_memory_budget_UNSAFE(additional_bytes);
+	if(charged)
+		interim_memory_in_use += additional_bytes;
+	pthread_mutex_unlock(&interim_memory_lock);
+	return charged;
+}
+
+static void uncharge_interim_memory(uint64_t bytes)
+{
+	pthread_mutex_lock(&interim_memory_lock);
+	interim_memory_in_use -= bytes;
+	pthread_mutex_unlock(&interim_memory_lock);
+}
+
+static int open_temp_file_for_interim_tuple_store()
+{
+	int fd = open64(INTERIM_TUPLE_STORE_DIR_PATH, O_TMPFILE | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+	if(fd == -1)
+	{
+		printf("FAILED to open a file for interim_tuple_store\n");
+		exit(-1);
+	}
+	return fd;
+}
+
+// size of the bounce buffer, used when copy_file_range can not copy across the 2 files
+#define COPY_BOUNCE_BUFFER_SIZE (1024 * 1024)
+
+// copies bytes_to_copy bytes from fd_in at off_in to fd_out at off_out, through a bounce buffer in user space
+static void copy_bytes_across_files_using_bounce_buffer(int fd_in, uint64_t off_in, int fd_out, uint64_t off_out, uint64_t bytes_to_copy)
+{
+	void* bounce_buffer = malloc(min(bytes_to_copy, COPY_BOUNCE_BUFFER_SIZE));
+	if(bounce_buffer == NULL)
+	{
+		printf("FAILED to allocate bounce buffer to copy across files for interim_tuple_store\n");
+		exit(-1);
+	}
+
+	while(bytes_to_copy > 0)
+	{
+		ssize_t bytes_read = pread64(fd_in, bounce_buffer, min(bytes_to_copy, COPY_BOUNCE_BUFFER_SIZE), off_in);
+		if(bytes_read == -1 && errno == EINTR)
+			continue;
+		if(bytes_read <= 0)
+		{
+			printf("FAILED to pread to copy across files for interim_tuple_store\n");
+			exit(-1);
+		}
+
+		for(ssize_t bytes_written = 0; bytes_written < bytes_read;)
+		{
+			ssize_t w = pwrite64(fd_out, ((char*)bounce_buffer) + bytes_written, bytes_read - bytes_written, off_out + bytes_written);
+			if(w == -1 && errno == EINTR)
+				continue;
+			if(w <= 0)
+			{
+				printf("FAILED to pwrite to copy across files for interim_tuple_store\n");
+				exit(-1);
+			}
+			bytes_written += w;
+		}
+
+		off_in += bytes_read;
+		off_out += bytes_read;
+		bytes_to_copy -= bytes_read;
+	}
+
+	free(bounce_buffer);
+}
+
+// copies bytes_to_copy bytes from fd_in at off_in to fd_out at off_out, directly in the kernel
+// copy_file_range fails with EXDEV (or EINVAL, on the older kernels) when the files are on different file systems
+// i.e. from a memfd (on tmpfs) to a temp file (on the disk) or the other way round, for those the rest of the bytes go through a bounce buffer
+// this is linux specific
+static void copy_bytes_across_files(int fd_in, uint64_t off_in, int fd_out, uint64_t off_out, uint64_t bytes_to_copy)
+{
+	off64_t off_in_t = off_in;
+	off64_t off_out_t = off_out;
+	size_t remaining_bytes = bytes_to_copy;
+	while(remaining_bytes > 0)
+	{
+		ssize_t bytes_copied = copy_file_range(fd_in, &off_in_t, fd_out, &off_out_t, remaining_bytes, 0);
+		if(bytes_copied == -1 && errno == EINTR)
+			continue;
+		if(bytes_copied == -1 && (errno == EXDEV || errno == EINVAL || errno == ENOSYS || errno == EOPNOTSUPP))
+		{
+			copy_bytes_across_files_using_bounce_buffer(fd_in, off_in_t, fd_out, off_out_t, remaining_bytes);
+			return;
+		}
+		if(bytes_copied == -1)
+		{
+			printf("FAILED to copy_file_range for interim_tuple_store\n");
+			exit(-1);
+		}
+		if(bytes_copied == 0)
+		{
+			printf("FAILED because copy_file_range for interim_tuple_store returned an unexpected 0 bytes transferred\n");
+			exit(-1);
+		}
+		remaining_bytes -= bytes_copied;
+	}
+}
+
+// moves the contents of an in memory interim_tuple_store to a temp file, that then takes over its fd
+static void spill_interim_tuple_store_to_temp_file(interim_tuple_store* its_p)
+{
+	int temp_fd = open_temp_file_for_interim_tuple_store();
+
+	if(-1 == ftruncate64(temp_fd, its_p->total_size))
+	{
+		printf("FAILED to extend the file for interim_tuple_store, while spilling it\n");
+		exit(-1);
+	}
+
+	// copy the whole of the memfd and not just upto the next_tuple_offset, there could be a tuple written but not yet finalized
+	copy_bytes_across_files(its_p->fd, 0, temp_fd, 0, its_p->total_size);
+
+	// the open embed_regions are remapped to the temp file at the same addresses, the contents are the same, so the tuple pointers in them remain valid
+	for(int i = 0; i < sizeof(its_p->embed_regions)/sizeof(its_p->embed_regions[0]); i++)
+	{
+		interim_tuple_region* itr_p = &(its_p->embed_regions[i]);
+		if(is_empty_interim_tuple_region(itr_p))
+			continue;
+
+		if(MAP_FAILED == mmap64(itr_p->region_memory, itr_p->region_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, temp_fd, itr_p->region_offset))
+		{
+			printf("FAILED to remap a interim_tuple_region for interim_tuple_store, while spilling it\n");
+			exit(-1);
+		}
+	}
+
+	// the temp file now takes the fd of the memfd, closing the memfd, so the snapshots of this interim_tuple_store still have a valid fd
+	if(-1 == dup2(temp_fd, its_p->fd))
+	{
+		printf("FAILED to dup2 the spilled file for interim_tuple_store\n");
+		exit(-1);
+	}
+	close(temp_fd);
+
+	uncharge_interim_memory(its_p->in_memory_bytes);
+	its_p->in_memory_bytes = 0;
+	its_p->is_in_memory = 0;
+}
+
+// every change in the size of the file of the interim_tuple_store must go through this function, so that the in memory bytes stay accounted for
+static void resize_interim_tuple_store(interim_tuple_store* its_p, uint64_t new_total_size)
+{
+	if(its_p->is_in_memory)
+	{
+		if(new_total_size > its_p->in_memory_bytes)
+		{
+			// an interim_tuple_store with spilling disabled can only overshoot the budget
+			if(charge_interim_memory(new_total_size - its_p->in_memory_bytes, its_p->is_spill_disabled))
+				its_p->in_memory_bytes = new_total_size;
+			else
+				spill_interim_tuple_store_to_temp_file(its_p);
+		}
+		else
+		{
+			uncharge_interim_memory(its_p->in_memory_bytes - new_total_size);
+			its_p->in_memory_bytes = new_total_size;
+		}
+	}
+
+	if(-1 == ftruncate64(its_p->fd, new_total_size))
+	{
+		printf("FAILED to extend the file for interim_tuple_store\n");
+		exit(-1);
+	}
+	its_p->total_size = new_total_size;
+}
+
 interim_tuple_store_snapshot get_interim_tuple_store_snapshot(interim_tuple_store* its_p)
 {
 	return (interim_tuple_store_snapshot) {
@@ -37,12 +257,20 @@ interim_tuple_store* get_new_interim_tuple_store(uint64_t initial_total_size)
 
 	its_p->tuples_count = 0;
 
-	its_p->fd = open64(INTERIM_TUPLE_STORE_DIR_PATH, O_TMPFILE | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
-	if(its_p->fd == -1)
+	its_p->is_in_memory = 0;
+	its_p->in_memory_bytes = 0;
+	its_p->is_spill_disabled = 0;
+	its_p->is_write_behind_enabled = 0;
+
+	// start in memory if the budget has room for the initial_total_size, else (or if memfd_create fails) use a temp file
+	its_p->fd = -1;
+	if(is_within_interim_memory_budget(UINT_ALIGN_UP(initial_total_size, sysconf(_SC_PAGE_SIZE))))
 	{
-		printf("FAILED to open a file for interim_tuple_store\n");
-		exit(-1);
+		its_p->fd = memfd_create("interim_tuple_store", MFD_CLOEXEC);
+		its_p->is_in_memory = (its_p->fd != -1);
 	}
+	if(its_p->fd == -1)
+		its_p->fd = open_temp_file_for_interim_tuple_store();
 
 	// cutlery always assigns all embedded nodes that are free to be 0 initialized, so the below calls are just an formality
 	initialize_llnode(&(its_p->embed_node_ll));
@@ -75,27 +303,63 @@ void reinitialize_interim_tuple_store(interim_tuple_store* its_p, uint64_t initi
 	its_p->tuples_count = 0;
 
 	if(initial_total_size != UINT64_MAX)
-	{
-		its_p->total_size = UINT_ALIGN_UP(initial_total_size, sysconf(_SC_PAGE_SIZE));
-		if(-1 == ftruncate64(its_p->fd, its_p->total_size))
-		{
-			printf("FAILED to extend the file for interim_tuple_store\n");
-			exit(-1);
-			return;
-		}
-	}
+		resize_interim_tuple_store(its_p, UINT_ALIGN_UP(initial_total_size, sysconf(_SC_PAGE_SIZE)));
+}
+
+void disable_spill_for_interim_tuple_store(interim_tuple_store* its_p)
+{
+	its_p->is_spill_disabled = 1;
+}
+
+void enable_write_behind_for_interim_tuple_store(interim_tuple_store* its_p)
+{
+	its_p->is_write_behind_enabled = 1;
+}
+
+// queues the written bytes of the itr_p for write-back, without waiting for them to be written
+static void write_behind_interim_tuple_region(const interim_tuple_store* its_p, const interim_tuple_region* itr_p)
+{
+	if(!its_p->is_write_behind_enabled || its_p->is_in_memory || is_empty_interim_tuple_region(itr_p))
+		return;
+
+	// there are no bytes written in this region
+	if(itr_p->region_offset >= its_p->next_tuple_offset)
+		return;
+
+	uint64_t bytes_written = min(itr_p->region_size, its_p->next_tuple_offset - itr_p->region_offset);
+
+	// a failure here only loses the write-behind, the dirty pages still get written back eventually
+	sync_file_range(its_p->fd, itr_p->region_offset, bytes_written, SYNC_FILE_RANGE_WRITE);
+}
+
+void read_ahead_interim_tuple_store(const interim_tuple_store* its_p, uint64_t offset, uint64_t bytes_count)
+{
+	if(its_p->is_in_memory || offset >= its_p->next_tuple_offset)
+		return;
+
+	bytes_count = min(bytes_count, its_p->next_tuple_offset - offset);
+
+	// a failure here only loses the read-ahead
+	posix_fadvise(its_p->fd, offset, bytes_count, POSIX_FADV_WILLNEED);
 }
 
 void unmap_all_embed_regions_in_interim_tuple_store(interim_tuple_store* its_p)
 {
 	for(int i = 0; i < sizeof(its_p->embed_regions)/sizeof(its_p->embed_regions[0]); i++)
+	{
+		write_behind_interim_tuple_region(its_p, &(its_p->embed_regions[i]));
 		unmap_for_interim_tuple_region(&(its_p->embed_regions[i]));
+	}
 }
 
 void delete_interim_tuple_store(interim_tuple_store* its_p)
 {
+	// no need to write back a file that is being deleted
+	its_p->is_write_behind_enabled = 0;
 	unmap_all_embed_regions_in_interim_tuple_store(its_p);
 	close(its_p->fd);
+	if(its_p->is_in_memory)
+		uncharge_interim_memory(its_p->in_memory_bytes);
 	free(its_p);
 }
 
@@ -107,22 +371,17 @@ void extend_interim_tuple_store(interim_tuple_store* its_p, uint64_t additional_
 		exit(-1);
 		return;
 	}
-	its_p->total_size += additional_total_size;
+	uint64_t new_total_size = its_p->total_size + additional_total_size;
 
-	if(will_UINT_ALIGN_UP_overflow(uint64_t, its_p->total_size, sysconf(_SC_PAGE_SIZE)))
+	if(will_UINT_ALIGN_UP_overflow(uint64_t, new_total_size, sysconf(_SC_PAGE_SIZE)))
 	{
 		printf("FAILED to increment the size of the interim_tuple_store, total_size overflowed on aligning up\n");
 		exit(-1);
 		return;
 	}
-	its_p->total_size = UINT_ALIGN_UP(its_p->total_size, sysconf(_SC_PAGE_SIZE));
+	new_total_size = UINT_ALIGN_UP(new_total_size, sysconf(_SC_PAGE_SIZE));
 
-	if(-1 == ftruncate64(its_p->fd, its_p->total_size))
-	{
-		printf("FAILED to extend the file for interim_tuple_store\n");
-		exit(-1);
-		return;
-	}
+	resize_interim_tuple_store(its_p, new_total_size);
 }
 
 uint64_t get_total_bytes_in_interim_tuple_store(const interim_tuple_store* its_p)
@@ -241,9 +500,12 @@ int mmap_for_writing_tuple(interim_tuple_store* its_p, interim_tuple_region* itr
 		return 1;
 	}
 
-	// now we free up the old region
+	// now we free up the old region, handing its finalized bytes for write-back
 	if(!is_empty_interim_tuple_region(itr_p))
+	{
+		write_behind_interim_tuple_region(its_p, itr_p);
 		unmap_for_interim_tuple_region(itr_p);
+	}
 
 	// build up region offsets
 	uint64_t region_offset_start = UINT_ALIGN_DOWN(tuple_offset_start, sysconf(_SC_PAGE_SIZE));
@@ -253,17 +515,9 @@ int mmap_for_writing_tuple(interim_tuple_store* its_p, interim_tuple_region* itr
 
 	// ftruncate to extend the file, if the region_offset_end is greater than total_size
 	// we do not need to extend if region_offset_end <= total_size
+	// this may also spill the interim_tuple_store to a temp file, but itr_p is already unmapped by now
 	if(region_offset_end > its_p->total_size)
-	{
-		if(-1 == ftruncate64(its_p->fd, region_offset_end))
-		{
-			printf("FAILED to extend the file for interim_tuple_store\n");
-			exit(-1);
-			return 0;
-		}
-		else
-			its_p->total_size = region_offset_end;
-	}
+		resize_interim_tuple_store(its_p, region_offset_end);
 
 	// map the new interim_tuple_region and return it
 	void* region_memory = mmap64(NULL, region_size, PROT_READ | PROT_WRITE, MAP_SHARED, its_p->fd, region_offset_start);
@@ -326,17 +580,9 @@ uint64_t append_tuple_to_interim_tuple_store(interim_tuple_store* its_p, const v
 
 	// assign the new_size and align it to the next multiple of page_size
 	uint64_t new_total_size = UINT_ALIGN_UP(its_p->next_tuple_offset, sysconf(_SC_PAGE_SIZE));
+	// and extend the file to the new size
 	if(its_p->total_size < new_total_size)
-	{
-		its_p->total_size = new_total_size;
-		// and extend the file to the new size
-		if(-1 == ftruncate64(its_p->fd, its_p->total_size))
-		{
-			printf("FAILED to extend the file for interim_tuple_store\n");
-			exit(-1);
-			return 0;
-		}
-	}
+		resize_interim_tuple_store(its_p, new_total_size);
 
 	// directly do a pwrite instead
 	if(tuple_size != pwrite64(its_p->fd, tupl, tuple_size, offset))
@@ -392,42 +638,12 @@ uint64_t append_all_from_another_interim_tuple_store2(interim_tuple_store* its_p
 
 	// assign the new_size and align it to the next multiple of page_size
 	uint64_t new_total_size = UINT_ALIGN_UP(its_p->next_tuple_offset, sysconf(_SC_PAGE_SIZE));
+	// and extend the file to the new size
 	if(its_p->total_size < new_total_size)
-	{
-		its_p->total_size = new_total_size;
-		// and extend the file to the new size
-		if(-1 == ftruncate64(its_p->fd, its_p->total_size))
-		{
-			printf("FAILED to extend the file for interim_tuple_store\n");
-			exit(-1);
-			return 0;
-		}
-	}
+		resize_interim_tuple_store(its_p, new_total_size);
 
 	// now perform file descriptor copy directly in the kernel
-	// this is linux specific
-	{
-		off64_t off_in = from_tuple_offset;
-		off64_t off_out = offset;
-		size_t remaining_bytes = (get_total_bytes_in_interim_tuple_store(other_its_p) - from_tuple_offset); // these many bytes are needed to be transferred
-		while(remaining_bytes > 0)
-		{
-			ssize_t bytes_copied = copy_file_range(other_its_p->fd, &off_in, its_p->fd, &off_out, remaining_bytes, 0);
-			if(bytes_copied == -1)
-			{
-				printf("FAILED to copy_file_range for interim_tuple_store\n");
-				exit(-1);
-				return 0;
-			}
-			if(bytes_copied == 0)
-			{
-				printf("FAILED because copy_file_range for interim_tuple_store returned an unexpected 0 bytes transferred\n");
-				exit(-1);
-				return 0;
-			}
-			remaining_bytes -= bytes_copied;
-		}
-	}
+	copy_bytes_across_files(other_its_p->fd, from_tuple_offset, its_p->fd, offset, get_total_bytes_in_interim_tuple_store(other_its_p) - from_tuple_offset);
 
 	return offset;
 }
@@ -3,9 +3,11 @@
 #include<cutlery/value_arraylist.h>
 
 #include<stdlib.h>
+#include<stdatomic.h>
 #include<setjmp.h>
 
 #include<rhendb/function_compare.h>
+#include<rhendb/normalized_key.h>
 
 typedef struct sorting_context sorting_context;
 struct sorting_context
@@ -17,6 +19,9 @@ struct sorting_context
 	const compare_direction* key_cmp_dirs;
 
 	transaction* tx;
+
+	// if set, the normalized_keys of the sortable_tuple_references are compared first
+	int use_normalized_keys;
 };
 
 typedef struct sortable_tuple_reference sortable_tuple_reference;
@@ -26,6 +31,9 @@ struct sortable_tuple_reference
 
 	// keys for the tuple at this offset
 	datum* keys;
+
+	// memcomparable prefix of the keys, only built if use_normalized_keys is set
+	normalized_key nkey;
 };
 
 static int compare_tuples_for_interim_tuple_store_sort(const void* sc_vp, const void* ref1_vp, const void* ref2_vp)
@@ -34,6 +42,15 @@ static int compare_tuples_for_interim_tuple_store_sort(const void* sc_vp, const
 	const sortable_tuple_reference* ref1 = ref1_vp;
 	const sortable_tuple_reference* ref2 = ref2_vp;
 
+	// prefix comparison decides most of the comparisons, without the type dispatch of the full comparator
+	if(sc_p->use_normalized_keys)
+	{
+		int is_decided = 0;
+		int cmp = compare_normalized_keys(&(ref1->nkey), &(ref2->nkey), &is_decided);
+		if(is_decided)
+			return cmp;
+	}
+
 	return compare_datums3_rhendb(ref1->keys, ref2->keys, sc_p->key_dtis, sc_p->key_cmp_dirs, sc_p->element_count, sc_p->tx);
 }
 
@@ -42,36 +59,389 @@ declarations_value_arraylist(sortable_tuple_references, sortable_tuple_reference
 #define EXPANSION_FACTOR 1.5
 function_definitions_value_arraylist(sortable_tuple_references, sortable_tuple_reference, static inline)
 
-interim_tuple_store* sort_interim_tuples(interim_tuple_store* its_p, tuples_down_counter result_counter, const tuple_def* tpl_d, const positional_accessor* element_ids, const compare_direction* cmp_dir, uint32_t element_count, transaction* tx)
+/*
+	parallel sort of the sortable_tuple_references
+	the references are split into equal sized chunks, that are sorted concurrently and copied into a plain array
+	then the sorted chunks are merged pairwise in rounds, each round merging concurrently from one plain array into the other, until 1 chunk remains
+
+	each round is a set of tasks, that are claimed (under the lock) and executed by the caller and by the queued jobs of the operator alike
+	so the caller never waits for a job that has not yet started, it only waits for the tasks claimed by the jobs to complete
+	the parallel_sort_context is reference counted, as the queued jobs may start after the caller has already returned
+*/
+
+// the parallel sort is not worth it for the runs smaller than (parallelism * MIN_TUPLES_PER_PARALLEL_SORT_TASK) tuples
+#define MIN_TUPLES_PER_PARALLEL_SORT_TASK 4096
+
+typedef enum parallel_sort_task_type parallel_sort_task_type;
+enum parallel_sort_task_type
 {
-	// if the its_p is empty, OR if no result is expected, then return immediately
-	if(its_p->tuples_count == 0 || is_zero_tuples_down_counter(&result_counter))
-		return get_new_interim_tuple_store(0);
+	SORT_CHUNK,
+	MERGE_CHUNKS,
+};
 
-	// create a list_of_sortable_tuple_references
-	sortable_tuple_references list_of_sortable_tuple_references;
-	if(!initialize_sortable_tuple_references(&list_of_sortable_tuple_references, its_p->tuples_count))
+typedef struct parallel_sort_task parallel_sort_task;
+struct parallel_sort_task
+{
+	parallel_sort_task_type type;
+
+	// for SORT_CHUNK, sort [start, mid) of the sortable_tuple_references and copy it to the same positions in dst
+	// for MERGE_CHUNKS, merge the sorted [start, mid) and [mid, end) from src to the same positions in dst
+	uint64_t start;
+	uint64_t mid;
+	uint64_t end;
+
+	const sortable_tuple_reference* src;
+	sortable_tuple_reference* dst;
+};
+
+typedef struct parallel_sort_context parallel_sort_context;
+struct parallel_sort_context
+{
+	pthread_mutex_t lock;
+
+	// signalled when all the tasks of the current round are completed
+	pthread_cond_t wait_for_round_completion;
+
+	// 1 for the caller and 1 for every queued job, the last one to release it frees it
+	uint32_t reference_count;
+
+	// tasks of the current round, tasks at index >= next_task_index are yet to be claimed
+	parallel_sort_task* tasks;
+	uint32_t tasks_count;
+	uint32_t next_task_index;
+
+	// tasks that are claimed but not yet completed
+	uint32_t running_tasks_count;
+
+	// owned by the caller, and only accessed while executing a task
+	const sorting_context* sc;
+	sortable_tuple_references* list_of_sortable_tuple_references;
+};
+
+static void execute_parallel_sort_task(parallel_sort_context* psc, const parallel_sort_task* t)
+{
+	switch(t->type)
+	{
+		case SORT_CHUNK :
+		{
+			merge_sort_sortable_tuple_references(psc->list_of_sortable_tuple_references, t->start, t->mid - 1, &contexted_comparator((void*)(psc->sc), compare_tuples_for_interim_tuple_store_sort), STD_C_mem_allocator);
+			for(uint64_t i = t->start; i < t->mid; i++)
+				t->dst[i] = *get_from_front_of_sortable_tuple_references(psc->list_of_sortable_tuple_references, i);
+			break;
+		}
+		case MERGE_CHUNKS :
+		{
+			// stable merge, ties are taken from the left chunk
+			uint64_t l = t->start;
+			uint64_t r = t->mid;
+			uint64_t i = t->start;
+			while(l < t->mid && r < t->end)
+			{
+				if(compare_tuples_for_interim_tuple_store_sort(psc->sc, &(t->src[r]), &(t->src[l])) < 0)
+					t->dst[i++] = t->src[r++];
+				else
+					t->dst[i++] = t->src[l++];
+			}
+			while(l < t->mid)
+				t->dst[i++] = t->src[l++];
+			while(r < t->end)
+				t->dst[i++] = t->src[r++];
+			break;
+		}
+	}
+}
+
+// claims and executes the tasks of the current round, until there are none left to be claimed
+static void work_on_parallel_sort_tasks(parallel_sort_context* psc)
+{
+	pthread_mutex_lock(&(psc->lock));
+	while(psc->next_task_index < psc->tasks_count)
+	{
+		parallel_sort_task* t = &(psc->tasks[psc->next_task_index++]);
+		psc->running_tasks_count++;
+		pthread_mutex_unlock(&(psc->lock));
+
+		execute_parallel_sort_task(psc, t);
+
+		pthread_mutex_lock(&(psc->lock));
+		psc->running_tasks_count--;
+		if(psc->next_task_index == psc->tasks_count && psc->running_tasks_count == 0)
+			pthread_cond_broadcast(&(psc->wait_for_round_completion));
+	}
+	pthread_mutex_unlock(&(psc->lock));
+}
+
+static void release_parallel_sort_context(parallel_sort_context* psc)
+{
+	pthread_mutex_lock(&(psc->lock));
+	int should_free = ((--psc->reference_count) == 0);
+	pthread_mutex_unlock(&(psc->lock));
+
+	if(should_free)
+	{
+		pthread_mutex_destroy(&(psc->lock));
+		pthread_cond_destroy(&(psc->wait_for_round_completion));
+		free(psc);
+	}
+}
+
+static void parallel_sort_job(operator* o, void* param)
+{
+	parallel_sort_context* psc = param;
+	work_on_parallel_sort_tasks(psc);
+	release_parallel_sort_context(psc);
+}
+
+// runs the given tasks as a round, with upto parallelism threads including the caller, and waits for all of them to complete
+static void run_parallel_sort_round(parallel_sort_context* psc, parallel_sort_task* tasks, uint32_t tasks_count, uint32_t parallelism, operator* o)
+{
+	pthread_mutex_lock(&(psc->lock));
+	psc->tasks = tasks;
+	psc->tasks_count = tasks_count;
+	psc->next_task_index = 0;
+	pthread_mutex_unlock(&(psc->lock));
+
+	// the caller works on one of the tasks, so (tasks_count - 1) jobs suffice
+	for(uint32_t j = 0; j < min(parallelism - 1, tasks_count - 1); j++)
+	{
+		pthread_mutex_lock(&(psc->lock));
+		psc->reference_count++;
+		pthread_mutex_unlock(&(psc->lock));
+
+		// if the job could not be queued, the caller ends up executing its tasks
+		if(!run_concurrent_job_for_operator(o, psc, parallel_sort_job))
+		{
+			release_parallel_sort_context(psc);
+			break;
+		}
+	}
+
+	work_on_parallel_sort_tasks(psc);
+
+	pthread_mutex_lock(&(psc->lock));
+	while(psc->running_tasks_count > 0)
+		pthread_cond_wait(&(psc->wait_for_round_completion), &(psc->lock));
+	// the jobs queued for this round, starting late, must not find any tasks
+	psc->tasks = NULL;
+	psc->tasks_count = 0;
+	psc->next_task_index = 0;
+	pthread_mutex_unlock(&(psc->lock));
+}
+
+// returns the sorted references in a malloc-ed plain array, that the caller must free
+static sortable_tuple_reference* parallel_sort_sortable_tuple_references(sortable_tuple_references* list_of_sortable_tuple_references, const sorting_context* sc, uint32_t parallelism, operator* o)
+{
+	uint64_t references_count = get_element_count_sortable_tuple_references(list_of_sortable_tuple_references);
+
+	sortable_tuple_reference* buffers[2] = {
+		malloc(sizeof(sortable_tuple_reference) * references_count),
+		malloc(sizeof(sortable_tuple_reference) * references_count),
+	};
+	if(buffers[0] == NULL || buffers[1] == NULL)
 		exit(-1);
 
-	// mmap the complete interm tuple store from it's offset 0
-	mmap_for_reading_tuple(its_p, &(its_p->embed_regions[0]), 0, &(tpl_d->size_def), get_total_bytes_in_interim_tuple_store(its_p));
+	// chunk boundaries, chunk i is [bounds[i], bounds[i+1])
+	uint32_t chunks_count = parallelism;
+	uint64_t* bounds = malloc(sizeof(uint64_t) * (chunks_count + 1));
+	parallel_sort_task* tasks = malloc(sizeof(parallel_sort_task) * chunks_count);
+	if(bounds == NULL || tasks == NULL)
+		exit(-1);
+	for(uint32_t i = 0; i <= chunks_count; i++)
+		bounds[i] = (references_count * i) / chunks_count;
 
-	// allocate all datums for materilizing keys all at once
-	datum* keyss = malloc(sizeof(datum) * its_p->tuples_count * element_count);
-	if(keyss == NULL)
+	parallel_sort_context* psc = malloc(sizeof(parallel_sort_context));
+	if(psc == NULL)
 		exit(-1);
+	(*psc) = (parallel_sort_context){
+		.reference_count = 1,
+		.tasks = NULL,
+		.tasks_count = 0,
+		.next_task_index = 0,
+		.running_tasks_count = 0,
+		.sc = sc,
+		.list_of_sortable_tuple_references = list_of_sortable_tuple_references,
+	};
+	pthread_mutex_init(&(psc->lock), NULL);
+	pthread_cond_init(&(psc->wait_for_round_completion), NULL);
+
+	// sort all the chunks into buffers[0]
+	for(uint32_t i = 0; i < chunks_count; i++)
+		tasks[i] = (parallel_sort_task){.type = SORT_CHUNK, .start = bounds[i], .mid = bounds[i+1], .end = bounds[i+1], .src = NULL, .dst = buffers[0]};
+	run_parallel_sort_round(psc, tasks, chunks_count, parallelism, o);
 
-	// gather all the offsets
-	{void* tuple = its_p->embed_regions[0].tuple;
-	for(uint64_t i = 0; i < its_p->tuples_count; i++)
+	// merge them pairwise, flipping between the buffers
+	uint32_t curr = 0;
+	while(chunks_count > 1)
 	{
-		for(uint32_t j = 0; j < element_count; j++)
-			if(!get_value_from_element_from_tuple(&(keyss[i * element_count + j]), tpl_d, element_ids[j], tuple))
-				keyss[i * element_count + j] = (*NULL_DATUM);
-		if(!push_back_to_sortable_tuple_references(&list_of_sortable_tuple_references, &(sortable_tuple_reference){tuple, &(keyss[i * element_count])}))
+		uint32_t tasks_count = 0;
+		for(uint32_t i = 0; i < chunks_count; i += 2)
+		{
+			// an odd chunk out is merged with an empty chunk, i.e. just copied
+			uint64_t end = (i + 2 <= chunks_count) ? bounds[i+2] : bounds[i+1];
+			tasks[tasks_count++] = (parallel_sort_task){.type = MERGE_CHUNKS, .start = bounds[i], .mid = bounds[i+1], .end = end, .src = buffers[curr], .dst = buffers[1 - curr]};
+		}
+		run_parallel_sort_round(psc, tasks, tasks_count, parallelism, o);
+
+		// compact the bounds for the merged chunks
+		for(uint32_t i = 0; i < tasks_count; i++)
+			bounds[i] = tasks[i].start;
+		bounds[tasks_count] = references_count;
+		chunks_count = tasks_count;
+		curr = 1 - curr;
+	}
+
+	release_parallel_sort_context(psc);
+	free(tasks);
+	free(bounds);
+	free(buffers[1 - curr]);
+	return buffers[curr];
+}
+
+// materializes the keys of the tuple into keys, and builds the ref for it
+static void build_sortable_tuple_reference(sortable_tuple_reference* ref, void* tuple, datum* keys, const tuple_def* tpl_d, const positional_accessor* element_ids, const sorting_context* sc)
+{
+	for(uint32_t j = 0; j < sc->element_count; j++)
+		if(!get_value_from_element_from_tuple(&(keys[j]), tpl_d, element_ids[j], tuple))
+			keys[j] = (*NULL_DATUM);
+	(*ref) = (sortable_tuple_reference){tuple, keys};
+	if(sc->use_normalized_keys)
+		build_normalized_key(&(ref->nkey), keys, sc->key_dtis, sc->key_cmp_dirs, sc->element_count);
+}
+
+// bounded max-heap of the top-N candidates, the worst of the candidates is at index 0
+
+static void swap_sortable_tuple_references(sortable_tuple_reference* ref1, sortable_tuple_reference* ref2)
+{
+	sortable_tuple_reference temp = (*ref1);
+	(*ref1) = (*ref2);
+	(*ref2) = temp;
+}
+
+static void sift_up_in_top_n_heap(sortable_tuple_reference* heap, uint64_t i, const sorting_context* sc)
+{
+	while(i > 0)
+	{
+		uint64_t parent = (i - 1) / 2;
+		if(compare_tuples_for_interim_tuple_store_sort(sc, &(heap[parent]), &(heap[i])) >= 0)
+			break;
+		swap_sortable_tuple_references(&(heap[parent]), &(heap[i]));
+		i = parent;
+	}
+}
+
+static void sift_down_in_top_n_heap(sortable_tuple_reference* heap, uint64_t heap_size, uint64_t i, const sorting_context* sc)
+{
+	while(1)
+	{
+		uint64_t largest = i;
+		uint64_t left = 2 * i + 1;
+		uint64_t right = 2 * i + 2;
+		if(left < heap_size && compare_tuples_for_interim_tuple_store_sort(sc, &(heap[left]), &(heap[largest])) > 0)
+			largest = left;
+		if(right < heap_size && compare_tuples_for_interim_tuple_store_sort(sc, &(heap[right]), &(heap[largest])) > 0)
+			largest = right;
+		if(largest == i)
+			break;
+		swap_sortable_tuple_references(&(heap[largest]), &(heap[i]));
+		i = largest;
+	}
+}
+
+void initialize_top_n_threshold(top_n_threshold* tnt_p, const tuple_def* tpl_d, const positional_accessor* element_ids, const compare_direction* cmp_dir, uint32_t element_count)
+{
+	pthread_mutex_init(&(tnt_p->threshold_lock), NULL);
+	tnt_p->threshold_tuple = NULL;
+	atomic_init(&(tnt_p->generation), 0);
+	tnt_p->tpl_d = tpl_d;
+	tnt_p->element_ids = element_ids;
+	tnt_p->cmp_dir = cmp_dir;
+	tnt_p->element_count = element_count;
+}
+
+void initialize_top_n_threshold_cache(top_n_threshold_cache* tntc_p)
+{
+	tntc_p->generation = 0;
+	tntc_p->threshold_tuple = NULL;
+	tntc_p->threshold_tuple_capacity = 0;
+}
+
+// copies the threshold_tuple of the tnt_p into the tntc_p, only if it was tightened since the last refresh
+static void refresh_top_n_threshold_cache(top_n_threshold* tnt_p, top_n_threshold_cache* tntc_p)
+{
+	if(atomic_load_explicit(&(tnt_p->generation), memory_order_acquire) == tntc_p->generation)
+		return;
+
+	pthread_mutex_lock(&(tnt_p->threshold_lock));
+
+	uint32_t threshold_tuple_size = get_tuple_size(tnt_p->tpl_d, tnt_p->threshold_tuple);
+	if(threshold_tuple_size > tntc_p->threshold_tuple_capacity)
+	{
+		void* new_threshold_tuple = realloc(tntc_p->threshold_tuple, threshold_tuple_size);
+		if(new_threshold_tuple == NULL)
+			exit(-1);
+		tntc_p->threshold_tuple = new_threshold_tuple;
+		tntc_p->threshold_tuple_capacity = threshold_tuple_size;
+	}
+	memory_move(tntc_p->threshold_tuple, tnt_p->threshold_tuple, threshold_tuple_size);
+	tntc_p->generation = atomic_load_explicit(&(tnt_p->generation), memory_order_relaxed);
+
+	pthread_mutex_unlock(&(tnt_p->threshold_lock));
+}
+
+int is_beyond_top_n_threshold(top_n_threshold* tnt_p, top_n_threshold_cache* tntc_p, const void* tuple, transaction* tx)
+{
+	refresh_top_n_threshold_cache(tnt_p, tntc_p);
+	return (tntc_p->threshold_tuple != NULL) && (compare_tuples2_rhendb(tuple, tntc_p->threshold_tuple, tnt_p->tpl_d, tnt_p->element_ids, tnt_p->cmp_dir, tnt_p->element_count, tx) >= 0);
+}
+
+void tighten_top_n_threshold(top_n_threshold* tnt_p, top_n_threshold_cache* tntc_p, const void* kth_tuple, transaction* tx)
+{
+	// the shared threshold is atleast as tight as the cached one, so a kth_tuple at or beyond the cached one can not tighten it
+	if(tntc_p != NULL && is_beyond_top_n_threshold(tnt_p, tntc_p, kth_tuple, tx))
+		return;
+
+	pthread_mutex_lock(&(tnt_p->threshold_lock));
+	if((tnt_p->threshold_tuple == NULL) || (compare_tuples2_rhendb(kth_tuple, tnt_p->threshold_tuple, tnt_p->tpl_d, tnt_p->element_ids, tnt_p->cmp_dir, tnt_p->element_count, tx) < 0))
+	{
+		uint32_t kth_tuple_size = get_tuple_size(tnt_p->tpl_d, kth_tuple);
+		void* new_threshold_tuple = malloc(kth_tuple_size);
+		if(new_threshold_tuple == NULL)
 			exit(-1);
-		tuple += get_tuple_size(tpl_d, tuple);
-	}}
+		memory_move(new_threshold_tuple, kth_tuple, kth_tuple_size);
+
+		if(tnt_p->threshold_tuple != NULL)
+			free(tnt_p->threshold_tuple);
+		tnt_p->threshold_tuple = new_threshold_tuple;
+
+		// publish the new threshold_tuple, for the caches to pick it up
+		atomic_fetch_add_explicit(&(tnt_p->generation), 1, memory_order_release);
+	}
+	pthread_mutex_unlock(&(tnt_p->threshold_lock));
+}
+
+void deinitialize_top_n_threshold_cache(top_n_threshold_cache* tntc_p)
+{
+	if(tntc_p->threshold_tuple != NULL)
+		free(tntc_p->threshold_tuple);
+	initialize_top_n_threshold_cache(tntc_p);
+}
+
+void deinitialize_top_n_threshold(top_n_threshold* tnt_p)
+{
+	if(tnt_p->threshold_tuple != NULL)
+		free(tnt_p->threshold_tuple);
+	tnt_p->threshold_tuple = NULL;
+	pthread_mutex_destroy(&(tnt_p->threshold_lock));
+}
+
+interim_tuple_store* sort_interim_tuples(interim_tuple_store* its_p, tuples_down_counter result_counter, const tuple_def* tpl_d, const positional_accessor* element_ids, const compare_direction* cmp_dir, uint32_t element_count, transaction* tx, uint32_t parallelism, operator* o, top_n_threshold* tnt_p)
+{
+	// if the its_p is empty, OR if no result is expected, then return immediately
+	if(its_p->tuples_count == 0 || is_zero_tuples_down_counter(&result_counter))
+		return get_new_interim_tuple_store(0);
+
+	// mmap the complete interm tuple store from it's offset 0
+	mmap_for_reading_tuple(its_p, &(its_p->embed_regions[0]), 0, &(tpl_d->size_def), get_total_bytes_in_interim_tuple_store(its_p));
 
 	// build sorting context
 	sorting_context sc = {
@@ -79,35 +449,136 @@ interim_tuple_store* sort_interim_tuples(interim_tuple_store* its_p, tuples_down
 		NULL,
 		cmp_dir,
 		tx,
+		0,
 	};
 	sc.key_dtis = malloc(sizeof(data_type_info*) * element_count);
 	if(sc.key_dtis == NULL)
 		exit(-1);
 	for(uint32_t j = 0; j < element_count; j++)
 		sc.key_dtis[j] = get_type_info_for_element_from_tuple_def(tpl_d, element_ids[j]);
+	sc.use_normalized_keys = can_build_normalized_key(sc.key_dtis, element_count);
+
+	// sorted references are either in a plain array sorted_references OR in the list_of_sortable_tuple_references
+	sortable_tuple_reference* sorted_references = NULL;
+	sortable_tuple_references list_of_sortable_tuple_references;
+	uint64_t references_count = 0;
 
-	// sort its_p using sc and iai
-	merge_sort_sortable_tuple_references(&list_of_sortable_tuple_references, 0, get_element_count_sortable_tuple_references(&list_of_sortable_tuple_references)-1, &contexted_comparator(&sc, compare_tuples_for_interim_tuple_store_sort), STD_C_mem_allocator);
+	datum* keyss = NULL;
+
+	// copy of the threshold local to this sort, so that the tuples are tested against it without the threshold_lock
+	top_n_threshold_cache tntc;
+	initialize_top_n_threshold_cache(&tntc);
+
+	// if fewer than all the tuples are needed, keep only that many candidates in a bounded max-heap, instead of sorting all of them
+	int is_top_n_mode = (!is_inf_tuples_down_counter(&result_counter)) && (result_counter.counter < its_p->tuples_count);
+
+	if(is_top_n_mode)
+	{
+		uint64_t k = result_counter.counter;
+
+		// 1 spare slot of keys for the tuple being considered
+		keyss = malloc(sizeof(datum) * (k + 1) * element_count);
+		sorted_references = malloc(sizeof(sortable_tuple_reference) * k);
+		if(keyss == NULL || sorted_references == NULL)
+			exit(-1);
+		datum* spare_keys = &(keyss[k * element_count]);
+
+		void* tuple = its_p->embed_regions[0].tuple;
+		for(uint64_t i = 0; i < its_p->tuples_count; i++, tuple += get_tuple_size(tpl_d, tuple))
+		{
+			// until the heap is full, the threshold shared with the other runs is what keeps out the tuples that can never be in the result
+			if(references_count < k)
+			{
+				if(tnt_p != NULL && is_beyond_top_n_threshold(tnt_p, &tntc, tuple, tx))
+					continue;
+
+				build_sortable_tuple_reference(&(sorted_references[references_count]), tuple, &(keyss[references_count * element_count]), tpl_d, element_ids, &sc);
+				references_count++;
+				sift_up_in_top_n_heap(sorted_references, references_count - 1, &sc);
+			}
+			else
+			{
+				sortable_tuple_reference ref;
+				build_sortable_tuple_reference(&ref, tuple, spare_keys, tpl_d, element_ids, &sc);
+
+				// replace the worst candidate, only if this one is better
+				if(compare_tuples_for_interim_tuple_store_sort(&sc, &ref, &(sorted_references[0])) < 0)
+				{
+					spare_keys = sorted_references[0].keys;
+					sorted_references[0] = ref;
+					sift_down_in_top_n_heap(sorted_references, references_count, 0, &sc);
+				}
+			}
+		}
+
+		// heap sort the candidates in place, into the sorted order
+		for(uint64_t heap_size = references_count; heap_size > 1; heap_size--)
+		{
+			swap_sortable_tuple_references(&(sorted_references[0]), &(sorted_references[heap_size - 1]));
+			sift_down_in_top_n_heap(sorted_references, heap_size - 1, 0, &sc);
+		}
+	}
+	else
+	{
+		// create a list_of_sortable_tuple_references
+		if(!initialize_sortable_tuple_references(&list_of_sortable_tuple_references, its_p->tuples_count))
+			exit(-1);
+
+		// allocate all datums for materilizing keys all at once
+		keyss = malloc(sizeof(datum) * its_p->tuples_count * element_count);
+		if(keyss == NULL)
+			exit(-1);
+
+		// gather all the offsets
+		{void* tuple = its_p->embed_regions[0].tuple;
+		for(uint64_t i = 0; i < its_p->tuples_count; i++)
+		{
+			sortable_tuple_reference ref;
+			build_sortable_tuple_reference(&ref, tuple, &(keyss[i * element_count]), tpl_d, element_ids, &sc);
+			if(!push_back_to_sortable_tuple_references(&list_of_sortable_tuple_references, &ref))
+				exit(-1);
+			tuple += get_tuple_size(tpl_d, tuple);
+		}}
+		references_count = its_p->tuples_count;
+
+		// do not use more threads than there are enough tuples for
+		parallelism = min(parallelism, its_p->tuples_count / MIN_TUPLES_PER_PARALLEL_SORT_TASK);
+
+		// sort its_p using sc and iai
+		if(parallelism > 1 && o != NULL)
+			sorted_references = parallel_sort_sortable_tuple_references(&list_of_sortable_tuple_references, &sc, parallelism, o);
+		else
+			merge_sort_sortable_tuple_references(&list_of_sortable_tuple_references, 0, get_element_count_sortable_tuple_references(&list_of_sortable_tuple_references)-1, &contexted_comparator(&sc, compare_tuples_for_interim_tuple_store_sort), STD_C_mem_allocator);
+	}
 
 	// create output interim_tuple_store
 	interim_tuple_store* ots_p = get_new_interim_tuple_store(get_total_bytes_in_interim_tuple_store(its_p));
 
-	for(uint32_t i = 0; i < get_element_count_sortable_tuple_references(&list_of_sortable_tuple_references) && can_decrement_tuples_down_counter(&result_counter); i++, decrement_tuples_down_counter(&result_counter))
+	for(uint64_t i = 0; i < references_count && can_decrement_tuples_down_counter(&result_counter); i++, decrement_tuples_down_counter(&result_counter))
 	{
 		// fetch the tuple to be copied
-		const sortable_tuple_reference* ref = get_from_front_of_sortable_tuple_references(&list_of_sortable_tuple_references, i);
+		const sortable_tuple_reference* ref = (sorted_references != NULL) ? &(sorted_references[i]) : get_from_front_of_sortable_tuple_references(&list_of_sortable_tuple_references, i);
 
 		// apped it to output
 		append_tuple_to_interim_tuple_store2(ots_p, &(ots_p->embed_regions[0]), ref->tuple, &(tpl_d->size_def), get_total_bytes_in_interim_tuple_store(its_p));
 	}
 
+	// if this run has all the tuples needed, then the last one appended bounds the result for all the other runs
+	if(tnt_p != NULL && !can_decrement_tuples_down_counter(&result_counter))
+		tighten_top_n_threshold(tnt_p, &tntc, ots_p->embed_regions[0].tuple, tx);
+
 	// destroy all regions we might have useds
 	unmap_all_embed_regions_in_interim_tuple_store(its_p);
 	unmap_all_embed_regions_in_interim_tuple_store(ots_p);
 
+	deinitialize_top_n_threshold_cache(&tntc);
+
 	// destroy the sortable_tuple_references
-	deinitialize_sortable_tuple_references(&list_of_sortable_tuple_references);
+	if(!is_top_n_mode)
+		deinitialize_sortable_tuple_references(&list_of_sortable_tuple_references);
+	if(sorted_references != NULL)
+		free(sorted_references);
 	free(sc.key_dtis);
 	free(keyss);
 	return ots_p;
-}
\ No newline at end of file
+}
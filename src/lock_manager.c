@@ -5,7 +5,12 @@
 
 #include<tupleindexer/interface/page_access_methods.h>
 
+#include<cutlery/linkedlist.h>
+
+#include<posixutils/pthread_cond_utils.h>
+
 #include<stdlib.h>
+#include<time.h>
 
 char const * const lock_result_strings[] = {
 	[LOCK_ACQUIRED] = "LOCK_ACQUIRED",
@@ -170,6 +175,14 @@ static positional_accessor waits_back_keys[] = {STATIC_POSITION(3), STATIC_POSIT
 ** utility functions
 */
 
+// the wait_entries are counted per shard of the in memory lock table, both the below functions are defined in section 7
+static lock_table_shard* get_lock_table_shard_for_resource(lock_manager* lckmgr_p, uint32_t resource_type, const uint8_t* resource_id, uint8_t resource_id_size);
+static void forget_wait_entry(lock_manager* lckmgr_p, const wait_entry* we_p);
+
+// every wait_entry is also a wait_edge for the deadlock detector, both the below functions are defined in section 10
+static void insert_wait_edge(lock_manager* lckmgr_p, const wait_entry* we_p);
+static void remove_wait_edge(lock_manager* lckmgr_p, const wait_entry* we_p);
+
 // 1 - basic functionality for the wait_entries
 static int insert_wait_entry(lock_manager* lckmgr_p, const wait_entry* we_p)
 {
@@ -182,6 +195,14 @@ static int insert_wait_entry(lock_manager* lckmgr_p, const wait_entry* we_p)
 	res = res && insert_in_bplus_tree(lckmgr_p->waits_for_root_page_id, wait_entry_tuple, lckmgr_p->waits_for_td, lckmgr_p->lckmgr_engine->pam_p, lckmgr_p->lckmgr_engine->pmm_p, NULL, &abort_error);
 	res = res && insert_in_bplus_tree(lckmgr_p->waits_back_root_page_id, wait_entry_tuple, lckmgr_p->waits_back_td, lckmgr_p->lckmgr_engine->pam_p, lckmgr_p->lckmgr_engine->pmm_p, NULL, &abort_error);
 
+	// the caller holds the shard_latch of the resource
+	if(res)
+	{
+		lckmgr_p->wait_entries_count++;
+		get_lock_table_shard_for_resource(lckmgr_p, we_p->resource_type, we_p->resource_id, we_p->resource_id_size)->wait_entries_count++;
+		insert_wait_edge(lckmgr_p, we_p);
+	}
+
 	return res;
 }
 
@@ -215,6 +236,10 @@ static int remove_wait_entry(lock_manager* lckmgr_p, const wait_entry* we_p)
 // 2 - remove wait_entries for a particular waiters
 static void remove_all_wait_entries_for_task(lock_manager* lckmgr_p, void* waiting_transaction, void* waiting_task)
 {
+	// no need to search the waits_for, if it is empty, this is the common case, when there are no conflicts
+	if(lckmgr_p->wait_entries_count == 0)
+		return;
+
 	// we need to construct the wait_entry_key
 	char wait_entry_key[MAX_SERIALIZED_WAIT_ENTRY_SIZE];
 
@@ -254,6 +279,8 @@ static void remove_all_wait_entries_for_task(lock_manager* lckmgr_p, void* waiti
 
 			// then from the table with the iterator
 			remove_from_bplus_tree_iterator(bpi_p, GO_NEXT_AFTER_BPLUS_TREE_ITERATOR_REMOVE_OPERATION, NULL, &abort_error);
+
+			forget_wait_entry(lckmgr_p, &we);
 		}
 	}
 
@@ -262,6 +289,9 @@ static void remove_all_wait_entries_for_task(lock_manager* lckmgr_p, void* waiti
 
 static void remove_all_wait_entries_for_transaction(lock_manager* lckmgr_p, void* waiting_transaction)
 {
+	if(lckmgr_p->wait_entries_count == 0)
+		return;
+
 	// we need to construct the wait_entry_key
 	char wait_entry_key[MAX_SERIALIZED_WAIT_ENTRY_SIZE];
 
@@ -301,6 +331,8 @@ static void remove_all_wait_entries_for_transaction(lock_manager* lckmgr_p, void
 
 			// then from the table with the iterator
 			remove_from_bplus_tree_iterator(bpi_p, GO_NEXT_AFTER_BPLUS_TREE_ITERATOR_REMOVE_OPERATION, NULL, &abort_error);
+
+			forget_wait_entry(lckmgr_p, &we);
 		}
 	}
 
@@ -311,6 +343,9 @@ static void remove_all_wait_entries_for_transaction(lock_manager* lckmgr_p, void
 // it will not remove those wait-entries
 static void notify_all_wait_entries_for_resource_of_being_unblocked(lock_manager* lckmgr_p, uint32_t resource_type, uint8_t* resource_id, uint8_t resource_id_size)
 {
+	if(lckmgr_p->wait_entries_count == 0)
+		return;
+
 	// we need to construct the wait_entry_key
 	char wait_entry_key[MAX_SERIALIZED_WAIT_ENTRY_SIZE];
 
@@ -392,7 +427,8 @@ static uint32_t find_lock_entry(lock_manager* lckmgr_p, void* transaction, uint3
 	return lock_mode;
 }
 
-// 5 - below functions insert or remove the lock_entry and if a prior lock_mode existed, then a wake_up is also called on the corresponding wait_entries using the notify_all_wait_entries_*() function above
+// 5 - below functions insert or remove the lock_entry and if a prior lock_mode existed, then they set must_notify, for the caller to wake up the corresponding wait_entries using the notify_all_wait_entries_*() function above
+// the caller holds the shard_latch of the resource, and calls notify_all_wait_entries_*() only after releasing it, so the waiters are never notified with a shard_latch held
 // uses utility functions of section 3
 
 typedef struct insert_or_update_lock_entry_context insert_or_update_lock_entry_context;
@@ -424,7 +460,7 @@ static int insert_or_update_lock_entry(const void* context, const tuple_def* rec
 	return 1;
 }
 
-static int insert_or_update_lock_entry_and_wake_up_waiters(lock_manager* lckmgr_p, void* transaction, uint32_t resource_type, uint8_t* resource_id, uint8_t resource_id_size, uint32_t new_lock_mode)
+static int insert_or_update_lock_entry_in_bplus_trees(lock_manager* lckmgr_p, void* transaction, uint32_t resource_type, uint8_t* resource_id, uint8_t resource_id_size, uint32_t new_lock_mode, int* must_notify)
 {
 	// construct lock_entry_tuple, that we aim to insert or update with
 	char lock_entry_tuple[MAX_SERIALIZED_LOCK_ENTRY_SIZE];
@@ -441,13 +477,12 @@ static int insert_or_update_lock_entry_and_wake_up_waiters(lock_manager* lckmgr_
 
 	inserted_OR_updated = inserted_OR_updated && inspected_update_in_bplus_tree(lckmgr_p->rs_locks_root_page_id, lock_entry_tuple, &((update_inspector){.context = &((insert_or_update_lock_entry_context){&was_updated, lckmgr_p}), .update_inspect = insert_or_update_lock_entry}), lckmgr_p->rs_locks_td, lckmgr_p->lckmgr_engine->pam_p, lckmgr_p->lckmgr_engine->pmm_p, NULL, &abort_error);
 
-	if(inserted_OR_updated && was_updated)
-		notify_all_wait_entries_for_resource_of_being_unblocked(lckmgr_p, resource_type, resource_id, resource_id_size);
+	(*must_notify) = (inserted_OR_updated && was_updated);
 
 	return inserted_OR_updated;
 }
 
-static int remove_lock_entry_and_wake_up_waiters(lock_manager* lckmgr_p, void* transaction, uint32_t resource_type, uint8_t* resource_id, uint8_t resource_id_size)
+static int remove_lock_entry_from_bplus_trees(lock_manager* lckmgr_p, void* transaction, uint32_t resource_type, uint8_t* resource_id, uint8_t resource_id_size, int* must_notify)
 {
 	lock_entry le = {.transaction = transaction, .resource_type = resource_type, .resource_id_size = resource_id_size};
 	memory_move(le.resource_id, resource_id, resource_id_size);
@@ -472,13 +507,20 @@ static int remove_lock_entry_and_wake_up_waiters(lock_manager* lckmgr_p, void* t
 	}
 
 	if(res)
-		notify_all_wait_entries_for_resource_of_being_unblocked(lckmgr_p, resource_type, resource_id, resource_id_size);
+	{
+		atomic_fetch_sub(&(lckmgr_p->overflowed_lock_entries_count), 1);
+		(*must_notify) = 1;
+	}
 
 	return res;
 }
 
 static void remove_all_lock_entries_and_wake_up_waiters(lock_manager* lckmgr_p, void* transaction)
 {
+	// nothing is locked in the bplus_tree-s
+	if(atomic_load(&(lckmgr_p->overflowed_lock_entries_count)) == 0)
+		return;
+
 	// we need to construct the lock_entry_key
 	char lock_entry_key[MAX_SERIALIZED_LOCK_ENTRY_SIZE];
 
@@ -518,6 +560,7 @@ static void remove_all_lock_entries_and_wake_up_waiters(lock_manager* lckmgr_p,
 
 			// then from the table with the iterator
 			remove_from_bplus_tree_iterator(bpi_p, GO_NEXT_AFTER_BPLUS_TREE_ITERATOR_REMOVE_OPERATION, NULL, &abort_error);
+			atomic_fetch_sub(&(lckmgr_p->overflowed_lock_entries_count), 1);
 
 			// remove was successfull, so wake up all other transactions that are waitinf for this resource
 			notify_all_wait_entries_for_resource_of_being_unblocked(lckmgr_p, le.resource_type, le.resource_id, le.resource_id_size);
@@ -603,153 +646,417 @@ static int check_lock_conflicts(lock_manager* lckmgr_p, void* transaction, void*
 	return has_conflicts;
 }
 
-// --
+// 7 - the in memory lock table, all the below functions must be called with the shard_latch of the resource held, unless mentioned otherwise
 
-void initialize_lock_manager(lock_manager* lckmgr_p, pthread_mutex_t* external_lock, const lock_manager_notifier* notifier, rage_engine* lckmgr_engine)
+typedef struct resource_lock_head resource_lock_head;
+struct resource_lock_head
 {
-	lckmgr_p->external_lock = external_lock;
+	// embed_node for the resource_heads of the lock_table_shard
+	bstnode embed_node;
 
-	lckmgr_p->notifier = (*notifier);
+	uint32_t resource_type;
 
-	lckmgr_p->locks_type_count = 0;
-	lckmgr_p->lock_matrices = NULL;
+	uint8_t resource_id_size;
+	uint8_t resource_id[MAX_RESOURCE_ID_SIZE];
 
-	lckmgr_p->lckmgr_engine = lckmgr_engine;
+	// all the in_memory_lock_entry-s, held on this resource
+	linkedlist holders;
+};
 
-	lckmgr_p->resource_id_type_info = malloc(sizeof(data_type_info));
-	if(lckmgr_p->resource_id_type_info == NULL)
-		exit(-1);
-	*(lckmgr_p->resource_id_type_info) = get_variable_length_binary_type("resource_id_type", MAX_RESOURCE_ID_SIZE + 2);
+typedef struct transaction_lock_head transaction_lock_head;
+struct transaction_lock_head
+{
+	// embed_node for the transaction_heads of the lock_table_shard
+	bstnode embed_node;
 
-	{
-		data_type_info* dti = malloc(sizeof_tuple_data_type_info(4));
-		if(dti == NULL)
-			exit(-1);
-		initialize_tuple_data_type_info(dti, "lock_entry", 0, MAX_SERIALIZED_LOCK_ENTRY_SIZE, 4);
+	void* transaction;
 
-		strcpy(dti->containees[0].field_name, "transaction");
-		dti->containees[0].al.type_info = UINT_NON_NULLABLE[sizeof(void*)];
+	// all the in_memory_lock_entry-s, held by this transaction
+	linkedlist locks;
+};
 
-		strcpy(dti->containees[1].field_name, "resource_type");
-		dti->containees[1].al.type_info = UINT_NON_NULLABLE[4];
+typedef struct in_memory_lock_entry in_memory_lock_entry;
+struct in_memory_lock_entry
+{
+	// transaction that holds the lock
+	void* transaction;
 
-		strcpy(dti->containees[2].field_name, "resource_id");
-		dti->containees[2].al.type_info = lckmgr_p->resource_id_type_info;
+	uint32_t lock_mode;
 
-		strcpy(dti->containees[3].field_name, "lock_mode");
-		dti->containees[3].al.type_info = UINT_NON_NULLABLE[4];
+	// the resource that is locked
+	resource_lock_head* rlh_p;
 
-		lckmgr_p->lock_record_def = malloc(sizeof(tuple_def));
-		if(lckmgr_p->lock_record_def == NULL)
-			exit(-1);
-		initialize_tuple_def(lckmgr_p->lock_record_def, dti);
-	}
+	// embed_node for the holders of the resource_lock_head, protected by its shard_latch
+	llnode resource_embed_node;
 
-	lckmgr_p->tx_locks_td = malloc(sizeof(bplus_tree_tuple_defs));
-	if(lckmgr_p->tx_locks_td == NULL)
-		exit(-1);
-	if(!init_bplus_tree_tuple_definitions(lckmgr_p->tx_locks_td, &(lckmgr_p->lckmgr_engine->pam_p->pas), lckmgr_p->lock_record_def, tx_locks_keys, all_ascending, 3))
+	// embed_node for the locks of the transaction_lock_head, protected by its transaction_heads_latch
+	llnode transaction_embed_node;
+};
+
+// FNV-1a over the resource_type and the resource_id
+static cy_uint hash_resource(uint32_t resource_type, const uint8_t* resource_id, uint8_t resource_id_size)
+{
+	uint64_t h = 14695981039346656037ULL;
+	for(int i = 0; i < 4; i++)
 	{
-		printf("BUG (in lock_manager) :: could not initialize tx_locks_td\n");
-		exit(-1);
+		h ^= ((resource_type >> (8 * i)) & 0xff);
+		h *= 1099511628211ULL;
 	}
-	lckmgr_p->tx_locks_root_page_id = get_new_bplus_tree(lckmgr_p->tx_locks_td, lckmgr_p->lckmgr_engine->pam_p, lckmgr_p->lckmgr_engine->pmm_p, NULL, &abort_error);
+	for(uint8_t i = 0; i < resource_id_size; i++)
+	{
+		h ^= resource_id[i];
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
 
-	lckmgr_p->rs_locks_td = malloc(sizeof(bplus_tree_tuple_defs));
-	if(lckmgr_p->rs_locks_td == NULL)
-		exit(-1);
-	if(!init_bplus_tree_tuple_definitions(lckmgr_p->rs_locks_td, &(lckmgr_p->lckmgr_engine->pam_p->pas), lckmgr_p->lock_record_def, rs_locks_keys, all_ascending, 3))
+static cy_uint hash_resource_lock_head(const void* data)
+{
+	const resource_lock_head* rlh_p = data;
+	return hash_resource(rlh_p->resource_type, rlh_p->resource_id, rlh_p->resource_id_size);
+}
+
+static int compare_resource_lock_head(const void* data1, const void* data2)
+{
+	const resource_lock_head* rlh1_p = data1;
+	const resource_lock_head* rlh2_p = data2;
+	if(rlh1_p->resource_type != rlh2_p->resource_type)
+		return (rlh1_p->resource_type > rlh2_p->resource_type) ? 1 : -1;
+	if(rlh1_p->resource_id_size != rlh2_p->resource_id_size)
+		return (rlh1_p->resource_id_size > rlh2_p->resource_id_size) ? 1 : -1;
+	return memory_compare(rlh1_p->resource_id, rlh2_p->resource_id, rlh1_p->resource_id_size);
+}
+
+static cy_uint hash_transaction(const void* transaction)
+{
+	uintptr_t h = (uintptr_t)transaction;
+	h ^= (h >> 17);
+	h *= (uintptr_t)1099511628211ULL;
+	return (cy_uint)(h ^ (h >> 29));
+}
+
+static cy_uint hash_transaction_lock_head(const void* data)
+{
+	return hash_transaction(((const transaction_lock_head*)data)->transaction);
+}
+
+static int compare_transaction_lock_head(const void* data1, const void* data2)
+{
+	const transaction_lock_head* tlh1_p = data1;
+	const transaction_lock_head* tlh2_p = data2;
+	if(tlh1_p->transaction == tlh2_p->transaction)
+		return 0;
+	return (((uintptr_t)(tlh1_p->transaction)) > ((uintptr_t)(tlh2_p->transaction))) ? 1 : -1;
+}
+
+// the hashmaps of the shard use the lower bits of the same hash, so the shard is picked using the higher bits
+static lock_table_shard* get_lock_table_shard_for_resource(lock_manager* lckmgr_p, uint32_t resource_type, const uint8_t* resource_id, uint8_t resource_id_size)
+{
+	uint64_t h = hash_resource(resource_type, resource_id, resource_id_size);
+	return &(lckmgr_p->lock_table_shards[(h >> 32) % LOCK_TABLE_SHARDS_COUNT]);
+}
+
+static lock_table_shard* get_lock_table_shard_for_transaction(lock_manager* lckmgr_p, void* transaction)
+{
+	uint64_t h = hash_transaction(transaction);
+	return &(lckmgr_p->lock_table_shards[(h >> 32) % LOCK_TABLE_SHARDS_COUNT]);
+}
+
+static void expand_hashmap_if_full(hashmap* hm_p)
+{
+	// expand_hashmap() failing is harmless, the hashmap just stays as it is
+	if(get_element_count_hashmap(hm_p) > 2 * get_bucket_count_hashmap(hm_p))
+		expand_hashmap(hm_p, 2.0f);
+}
+
+static resource_lock_head* find_resource_lock_head(lock_table_shard* shard_p, uint32_t resource_type, const uint8_t* resource_id, uint8_t resource_id_size)
+{
+	resource_lock_head probe = {.resource_type = resource_type, .resource_id_size = resource_id_size};
+	memory_move(probe.resource_id, resource_id, resource_id_size);
+	return (resource_lock_head*) find_equals_in_hashmap(&(shard_p->resource_heads), &probe);
+}
+
+// returns 1, if the resource (with the resource_lock_head rlh_p, NULL if it has none) is to be locked in memory, else it is to be locked in the bplus_tree-s
+// a resource is never locked in both of them, as a resource_lock_head is only created while there are no lock_entries in the bplus_tree-s
+static int is_in_memory_resource(lock_manager* lckmgr_p, const resource_lock_head* rlh_p)
+{
+	if(rlh_p != NULL)
+		return 1;
+
+	return (atomic_load(&(lckmgr_p->overflowed_lock_entries_count)) == 0) && (atomic_load(&(lckmgr_p->in_memory_lock_entries_count)) < MAX_IN_MEMORY_LOCK_ENTRIES);
+}
+
+static in_memory_lock_entry* find_in_memory_lock_entry(const resource_lock_head* rlh_p, void* transaction)
+{
+	if(rlh_p == NULL)
+		return NULL;
+
+	for(in_memory_lock_entry* imle_p = (in_memory_lock_entry*) get_head_of_linkedlist(&(rlh_p->holders)); imle_p != NULL; imle_p = (in_memory_lock_entry*) get_next_of_in_linkedlist(&(rlh_p->holders), imle_p))
+		if(imle_p->transaction == transaction)
+			return imle_p;
+
+	return NULL;
+}
+
+// frees the resource_lock_head, if it is no longer needed
+static void discard_resource_lock_head_if_unused(lock_table_shard* shard_p, resource_lock_head* rlh_p)
+{
+	if(!is_empty_linkedlist(&(rlh_p->holders)))
+		return;
+
+	remove_from_hashmap(&(shard_p->resource_heads), rlh_p);
+	free(rlh_p);
+}
+
+// inserts a new in_memory_lock_entry, creating the resource_lock_head if rlh_p is NULL
+static void insert_in_memory_lock_entry(lock_manager* lckmgr_p, lock_table_shard* shard_p, resource_lock_head* rlh_p, void* transaction, uint32_t resource_type, const uint8_t* resource_id, uint8_t resource_id_size, uint32_t lock_mode)
+{
+	if(rlh_p == NULL)
 	{
-		printf("BUG (in lock_manager) :: could not initialize rs_locks_td\n");
-		exit(-1);
+		rlh_p = malloc(sizeof(resource_lock_head));
+		if(rlh_p == NULL)
+			exit(-1);
+		initialize_bstnode(&(rlh_p->embed_node));
+		rlh_p->resource_type = resource_type;
+		rlh_p->resource_id_size = resource_id_size;
+		memory_move(rlh_p->resource_id, resource_id, resource_id_size);
+		initialize_linkedlist(&(rlh_p->holders), offsetof(in_memory_lock_entry, resource_embed_node));
+
+		insert_in_hashmap(&(shard_p->resource_heads), rlh_p);
+		expand_hashmap_if_full(&(shard_p->resource_heads));
 	}
-	lckmgr_p->rs_locks_root_page_id = get_new_bplus_tree(lckmgr_p->rs_locks_td, lckmgr_p->lckmgr_engine->pam_p, lckmgr_p->lckmgr_engine->pmm_p, NULL, &abort_error);
 
+	in_memory_lock_entry* imle_p = malloc(sizeof(in_memory_lock_entry));
+	if(imle_p == NULL)
+		exit(-1);
+	imle_p->transaction = transaction;
+	imle_p->lock_mode = lock_mode;
+	imle_p->rlh_p = rlh_p;
+	initialize_llnode(&(imle_p->resource_embed_node));
+	initialize_llnode(&(imle_p->transaction_embed_node));
+
+	insert_tail_in_linkedlist(&(rlh_p->holders), imle_p);
+
+	// link it to the transaction_lock_head of its transaction, creating one if it does not exist
+	lock_table_shard* tx_shard_p = get_lock_table_shard_for_transaction(lckmgr_p, transaction);
+	pthread_mutex_lock(&(tx_shard_p->transaction_heads_latch));
+
+	transaction_lock_head* tlh_p = (transaction_lock_head*) find_equals_in_hashmap(&(tx_shard_p->transaction_heads), &((transaction_lock_head){.transaction = transaction}));
+	if(tlh_p == NULL)
 	{
-		data_type_info* dti = malloc(sizeof_tuple_data_type_info(5));
-		if(dti == NULL)
+		tlh_p = malloc(sizeof(transaction_lock_head));
+		if(tlh_p == NULL)
 			exit(-1);
-		initialize_tuple_data_type_info(dti, "wait_entry", 0, MAX_SERIALIZED_WAIT_ENTRY_SIZE, 5);
+		initialize_bstnode(&(tlh_p->embed_node));
+		tlh_p->transaction = transaction;
+		initialize_linkedlist(&(tlh_p->locks), offsetof(in_memory_lock_entry, transaction_embed_node));
 
-		strcpy(dti->containees[0].field_name, "waiting_transaction");
-		dti->containees[0].al.type_info = UINT_NON_NULLABLE[sizeof(void*)];
+		insert_in_hashmap(&(tx_shard_p->transaction_heads), tlh_p);
+		expand_hashmap_if_full(&(tx_shard_p->transaction_heads));
+	}
+	insert_tail_in_linkedlist(&(tlh_p->locks), imle_p);
 
-		strcpy(dti->containees[1].field_name, "waiting_task");
-		dti->containees[1].al.type_info = UINT_NON_NULLABLE[sizeof(void*)];
+	pthread_mutex_unlock(&(tx_shard_p->transaction_heads_latch));
 
-		strcpy(dti->containees[2].field_name, "transaction");
-		dti->containees[2].al.type_info = UINT_NON_NULLABLE[sizeof(void*)];
+	atomic_fetch_add(&(lckmgr_p->in_memory_lock_entries_count), 1);
+}
 
-		strcpy(dti->containees[3].field_name, "resource_type");
-		dti->containees[3].al.type_info = UINT_NON_NULLABLE[4];
+// removes the in_memory_lock_entry from its resource_lock_head and its transaction_lock_head, and frees it, the resource_lock_head is freed if no longer used
+static void remove_in_memory_lock_entry(lock_manager* lckmgr_p, lock_table_shard* shard_p, in_memory_lock_entry* imle_p)
+{
+	resource_lock_head* rlh_p = imle_p->rlh_p;
 
-		strcpy(dti->containees[4].field_name, "resource_id");
-		dti->containees[4].al.type_info = lckmgr_p->resource_id_type_info;
+	remove_from_linkedlist(&(rlh_p->holders), imle_p);
 
-		lckmgr_p->wait_record_def = malloc(sizeof(tuple_def));
-		if(lckmgr_p->wait_record_def == NULL)
-			exit(-1);
-		initialize_tuple_def(lckmgr_p->wait_record_def, dti);
+	lock_table_shard* tx_shard_p = get_lock_table_shard_for_transaction(lckmgr_p, imle_p->transaction);
+	pthread_mutex_lock(&(tx_shard_p->transaction_heads_latch));
+
+	transaction_lock_head* tlh_p = (transaction_lock_head*) find_equals_in_hashmap(&(tx_shard_p->transaction_heads), &((transaction_lock_head){.transaction = imle_p->transaction}));
+	remove_from_linkedlist(&(tlh_p->locks), imle_p);
+	if(is_empty_linkedlist(&(tlh_p->locks)))
+	{
+		remove_from_hashmap(&(tx_shard_p->transaction_heads), tlh_p);
+		free(tlh_p);
 	}
 
-	lckmgr_p->waits_for_td = malloc(sizeof(bplus_tree_tuple_defs));
-	if(lckmgr_p->waits_for_td == NULL)
-		exit(-1);
-	if(!init_bplus_tree_tuple_definitions(lckmgr_p->waits_for_td, &(lckmgr_p->lckmgr_engine->pam_p->pas), lckmgr_p->wait_record_def, waits_for_keys, all_ascending, 5))
+	pthread_mutex_unlock(&(tx_shard_p->transaction_heads_latch));
+
+	free(imle_p);
+	atomic_fetch_sub(&(lckmgr_p->in_memory_lock_entries_count), 1);
+
+	discard_resource_lock_head_if_unused(shard_p, rlh_p);
+}
+
+// acquires or transitions the lock on an in memory resource (rlh_p may be NULL, if it is not yet locked by anyone)
+// on conflicts, it inserts the wait_entries, only if do_insert_wait_entries is set, for which the external_lock must be held
+// (*must_notify) is set, if the lock_mode was transitioned and there are waiters to be notified
+static lock_result acquire_in_memory_lock(lock_manager* lckmgr_p, lock_table_shard* shard_p, resource_lock_head* rlh_p, void* transaction, void* task, uint32_t resource_type, uint8_t* resource_id, uint8_t resource_id_size, uint32_t new_lock_mode, int non_blocking, int do_insert_wait_entries, int* must_notify)
+{
+	in_memory_lock_entry* own_p = find_in_memory_lock_entry(rlh_p, transaction);
+
+	// if the old_lock_mode is same as the one requested, then return success
+	if(own_p != NULL && own_p->lock_mode == new_lock_mode)
+		return LOCK_ALREADY_HELD;
+
+	int has_conflicts = 0;
+
+	if(rlh_p != NULL)
 	{
-		printf("BUG (in lock_manager) :: could not initialize waits_for_td\n");
-		exit(-1);
+		for(in_memory_lock_entry* imle_p = (in_memory_lock_entry*) get_head_of_linkedlist(&(rlh_p->holders)); imle_p != NULL; imle_p = (in_memory_lock_entry*) get_next_of_in_linkedlist(&(rlh_p->holders), imle_p))
+		{
+			// skip entries for the transaction that wants this lock, and the ones that are compatible
+			if(imle_p->transaction == transaction || are_glock_modes_compatible(&(lckmgr_p->lock_matrices[resource_type]), imle_p->lock_mode, new_lock_mode))
+				continue;
+
+			has_conflicts = 1;
+
+			if(!do_insert_wait_entries)
+				break;
+
+			// insert wait entry for this lock conflict
+			wait_entry to_ins = {.waiting_transaction = transaction, .waiting_task = task, .transaction = imle_p->transaction, .resource_type = resource_type, .resource_id_size = resource_id_size};
+			memory_move(to_ins.resource_id, resource_id, resource_id_size);
+			insert_wait_entry(lckmgr_p, &to_ins);
+		}
 	}
-	lckmgr_p->waits_for_root_page_id = get_new_bplus_tree(lckmgr_p->waits_for_td, lckmgr_p->lckmgr_engine->pam_p, lckmgr_p->lckmgr_engine->pmm_p, NULL, &abort_error);
 
-	lckmgr_p->waits_back_td = malloc(sizeof(bplus_tree_tuple_defs));
-	if(lckmgr_p->waits_back_td == NULL)
-		exit(-1);
-	if(!init_bplus_tree_tuple_definitions(lckmgr_p->waits_back_td, &(lckmgr_p->lckmgr_engine->pam_p->pas), lckmgr_p->wait_record_def, waits_back_keys, all_ascending, 5))
+	if(has_conflicts)
+		return non_blocking ? LOCKING_FAILED : MUST_BLOCK_FOR_LOCK;
+
+	if(own_p != NULL)
 	{
-		printf("BUG (in lock_manager) :: could not initialize waits_back_td\n");
-		exit(-1);
+		own_p->lock_mode = new_lock_mode;
+		(*must_notify) = (shard_p->wait_entries_count > 0);
+		return LOCK_TRANSITIONED;
 	}
-	lckmgr_p->waits_back_root_page_id = get_new_bplus_tree(lckmgr_p->waits_back_td, lckmgr_p->lckmgr_engine->pam_p, lckmgr_p->lckmgr_engine->pmm_p, NULL, &abort_error);
+
+	insert_in_memory_lock_entry(lckmgr_p, shard_p, rlh_p, transaction, resource_type, resource_id, resource_id_size, new_lock_mode);
+	return LOCK_ACQUIRED;
 }
 
-uint32_t register_lock_type_with_lock_manager(lock_manager* lckmgr_p, glock_matrix lock_matrix)
+// must be called with external_lock held, but not the shard_latch, it is called for every wait_entry removed from the bplus_tree-s
+static void forget_wait_entry(lock_manager* lckmgr_p, const wait_entry* we_p)
 {
-	// expand the container for lock matrix to hold 1 more element
-	lckmgr_p->lock_matrices = realloc(lckmgr_p->lock_matrices, sizeof(glock_matrix) * (lckmgr_p->locks_type_count + 1));
-	if(lckmgr_p->lock_matrices == NULL)
-		exit(-1);
+	lckmgr_p->wait_entries_count--;
 
-	// add the element to the end and return it's index, then increment the counter
-	lckmgr_p->lock_matrices[lckmgr_p->locks_type_count] = lock_matrix;
-	return lckmgr_p->locks_type_count++;
+	lock_table_shard* shard_p = get_lock_table_shard_for_resource(lckmgr_p, we_p->resource_type, we_p->resource_id, we_p->resource_id_size);
+	pthread_mutex_lock(&(shard_p->shard_latch));
+	shard_p->wait_entries_count--;
+	pthread_mutex_unlock(&(shard_p->shard_latch));
+
+	remove_wait_edge(lckmgr_p, we_p);
 }
 
-uint32_t get_lock_mode_for_lock_from_lock_manager(lock_manager* lckmgr_p, void* transaction, void* task, uint32_t resource_type, uint8_t* resource_id, uint8_t resource_id_size)
+// must be called with external_lock held, but not any of the shard_latches
+// releases all the in memory locks of the transaction, and notifies the waiters on those resources
+static void remove_all_in_memory_lock_entries_and_wake_up_waiters(lock_manager* lckmgr_p, void* transaction)
 {
-	// task, for the transacton_id, is indeed calling this function, so it is no longer blocked or waiting, so remove it's wait entries
-	remove_all_wait_entries_for_task(lckmgr_p, transaction, task);
+	// detach the transaction_lock_head, no one else adds or removes the locks of this transaction concurrently
+	lock_table_shard* tx_shard_p = get_lock_table_shard_for_transaction(lckmgr_p, transaction);
+	pthread_mutex_lock(&(tx_shard_p->transaction_heads_latch));
+	transaction_lock_head* tlh_p = (transaction_lock_head*) find_equals_in_hashmap(&(tx_shard_p->transaction_heads), &((transaction_lock_head){.transaction = transaction}));
+	if(tlh_p != NULL)
+		remove_from_hashmap(&(tx_shard_p->transaction_heads), tlh_p);
+	pthread_mutex_unlock(&(tx_shard_p->transaction_heads_latch));
+
+	if(tlh_p == NULL)
+		return;
+
+	while(!is_empty_linkedlist(&(tlh_p->locks)))
+	{
+		in_memory_lock_entry* imle_p = (in_memory_lock_entry*) get_head_of_linkedlist(&(tlh_p->locks));
+		remove_from_linkedlist(&(tlh_p->locks), imle_p);
+
+		resource_lock_head* rlh_p = imle_p->rlh_p;
+
+		// copy the resource, as the resource_lock_head may be freed
+		uint32_t resource_type = rlh_p->resource_type;
+		uint8_t resource_id_size = rlh_p->resource_id_size;
+		uint8_t resource_id[MAX_RESOURCE_ID_SIZE];
+		memory_move(resource_id, rlh_p->resource_id, resource_id_size);
+
+		lock_table_shard* shard_p = get_lock_table_shard_for_resource(lckmgr_p, resource_type, resource_id, resource_id_size);
+		pthread_mutex_lock(&(shard_p->shard_latch));
+
+		remove_from_linkedlist(&(rlh_p->holders), imle_p);
+		free(imle_p);
+		atomic_fetch_sub(&(lckmgr_p->in_memory_lock_entries_count), 1);
+
+		int must_notify = (shard_p->wait_entries_count > 0);
+		discard_resource_lock_head_if_unused(shard_p, rlh_p);
 
-	return find_lock_entry(lckmgr_p, transaction, resource_type, resource_id, resource_id_size);
+		pthread_mutex_unlock(&(shard_p->shard_latch));
+
+		if(must_notify)
+			notify_all_wait_entries_for_resource_of_being_unblocked(lckmgr_p, resource_type, resource_id, resource_id_size);
+	}
+
+	free(tlh_p);
 }
 
-lock_result acquire_lock_with_lock_manager(lock_manager* lckmgr_p, void* transaction, void* task, uint32_t resource_type, uint8_t* resource_id, uint8_t resource_id_size, uint32_t new_lock_mode, int non_blocking)
+// 8 - acquire and release of a single lock, regardless of its lock_hierarchy
+
+static uint32_t get_single_lock_mode(lock_manager* lckmgr_p, void* transaction, uint32_t resource_type, uint8_t* resource_id, uint8_t resource_id_size)
 {
-	// task, for the transacton_id, is indeed calling this function, so it is no longer blocked or waiting, so remove it's wait entries
-	remove_all_wait_entries_for_task(lckmgr_p, transaction, task);
+	lock_table_shard* shard_p = get_lock_table_shard_for_resource(lckmgr_p, resource_type, resource_id, resource_id_size);
+	pthread_mutex_lock(&(shard_p->shard_latch));
+
+	uint32_t lock_mode = NO_LOCK_HELD_LOCK_MODE;
+
+	resource_lock_head* rlh_p = find_resource_lock_head(shard_p, resource_type, resource_id, resource_id_size);
+	if(rlh_p != NULL)
+	{
+		in_memory_lock_entry* imle_p = find_in_memory_lock_entry(rlh_p, transaction);
+		if(imle_p != NULL)
+			lock_mode = imle_p->lock_mode;
+	}
+	else if(atomic_load(&(lckmgr_p->overflowed_lock_entries_count)) > 0)
+		lock_mode = find_lock_entry(lckmgr_p, transaction, resource_type, resource_id, resource_id_size);
+
+	pthread_mutex_unlock(&(shard_p->shard_latch));
+
+	return lock_mode;
+}
+
+static lock_result acquire_single_lock(lock_manager* lckmgr_p, void* transaction, void* task, uint32_t resource_type, uint8_t* resource_id, uint8_t resource_id_size, uint32_t new_lock_mode, int non_blocking)
+{
+	lock_table_shard* shard_p = get_lock_table_shard_for_resource(lckmgr_p, resource_type, resource_id, resource_id_size);
+	pthread_mutex_lock(&(shard_p->shard_latch));
+
+	resource_lock_head* rlh_p = find_resource_lock_head(shard_p, resource_type, resource_id, resource_id_size);
+
+	// lock it in memory, if we can
+	if(is_in_memory_resource(lckmgr_p, rlh_p))
+	{
+		int must_notify = 0;
+		lock_result res = acquire_in_memory_lock(lckmgr_p, shard_p, rlh_p, transaction, task, resource_type, resource_id, resource_id_size, new_lock_mode, non_blocking, !non_blocking, &must_notify); // do insert wait entries if it is a blocking call
+
+		pthread_mutex_unlock(&(shard_p->shard_latch));
+
+		if(must_notify)
+			notify_all_wait_entries_for_resource_of_being_unblocked(lckmgr_p, resource_type, resource_id, resource_id_size);
+
+		return res;
+	}
+
+	// else the resource is locked in the bplus_tree-s, the shard_latch is held throughout, so that no one starts locking it in memory
 
 	// get the old_lock_mode for the transaction and resource given
 	uint32_t old_lock_mode = find_lock_entry(lckmgr_p, transaction, resource_type, resource_id, resource_id_size);
 
 	// if the old_lock_mode is same as the one requested, then return success
 	if(old_lock_mode == new_lock_mode)
+	{
+		pthread_mutex_unlock(&(shard_p->shard_latch));
 		return LOCK_ALREADY_HELD;
+	}
 
 	// the return value of this function suggests if we encountered any lock conflicts
 	int has_conflicts = check_lock_conflicts(lckmgr_p, transaction, task, resource_type, resource_id, resource_id_size, new_lock_mode, !non_blocking); // do insert wait entries if it is a blocking call
 
 	if(has_conflicts) // this means failure
 	{
+		pthread_mutex_unlock(&(shard_p->shard_latch));
 		if(non_blocking)
 			return LOCKING_FAILED;
 		else
@@ -757,42 +1064,1236 @@ lock_result acquire_lock_with_lock_manager(lock_manager* lckmgr_p, void* transac
 	}
 
 	// now we are sure that we can grab the lock
-	// so add or update the lock entry with the new_lock_mode, and wake up waiters
-	insert_or_update_lock_entry_and_wake_up_waiters(lckmgr_p, transaction, resource_type, resource_id, resource_id_size, new_lock_mode);
+	// so add or update the lock entry with the new_lock_mode
+	int must_notify = 0;
+	insert_or_update_lock_entry_in_bplus_trees(lckmgr_p, transaction, resource_type, resource_id, resource_id_size, new_lock_mode, &must_notify);
 
 	// if the old_lock_mode was not held, then we acquired the lock, else we just transitioned
 	if(old_lock_mode == NO_LOCK_HELD_LOCK_MODE)
-		return LOCK_ACQUIRED;
-	else
-		return LOCK_TRANSITIONED;
-}
+		atomic_fetch_add(&(lckmgr_p->overflowed_lock_entries_count), 1);
 
-void release_lock_with_lock_manager(lock_manager* lckmgr_p, void* transaction, void* task, uint32_t resource_type, uint8_t* resource_id, uint8_t resource_id_size)
-{
-	// task, for the transacton_id, is indeed calling this function, so it is no longer blocked or waiting, so remove it's wait entries
-	remove_all_wait_entries_for_task(lckmgr_p, transaction, task);
+	pthread_mutex_unlock(&(shard_p->shard_latch));
 
-	// try to remove the lock, and wake up waiters if any
-	remove_lock_entry_and_wake_up_waiters(lckmgr_p, transaction, resource_type, resource_id, resource_id_size);
-}
+	// wake up the waiters, only after releasing the shard_latch
+	if(must_notify)
+		notify_all_wait_entries_for_resource_of_being_unblocked(lckmgr_p, resource_type, resource_id, resource_id_size);
 
-void discard_all_wait_entries_for_task_in_lock_manager(lock_manager* lckmgr_p, void* transaction, void* task)
-{
-	remove_all_wait_entries_for_task(lckmgr_p, transaction, task);
+	return (old_lock_mode == NO_LOCK_HELD_LOCK_MODE) ? LOCK_ACQUIRED : LOCK_TRANSITIONED;
 }
 
-void discard_all_wait_entries_for_transaction_in_lock_manager(lock_manager* lckmgr_p, void* transaction)
+static int release_single_lock(lock_manager* lckmgr_p, void* transaction, uint32_t resource_type, uint8_t* resource_id, uint8_t resource_id_size)
 {
-	remove_all_wait_entries_for_transaction(lckmgr_p, transaction);
+	lock_table_shard* shard_p = get_lock_table_shard_for_resource(lckmgr_p, resource_type, resource_id, resource_id_size);
+	pthread_mutex_lock(&(shard_p->shard_latch));
+
+	resource_lock_head* rlh_p = find_resource_lock_head(shard_p, resource_type, resource_id, resource_id_size);
+	if(rlh_p != NULL)
+	{
+		in_memory_lock_entry* imle_p = find_in_memory_lock_entry(rlh_p, transaction);
+		int must_notify = 0;
+		if(imle_p != NULL)
+		{
+			remove_in_memory_lock_entry(lckmgr_p, shard_p, imle_p);
+			must_notify = (shard_p->wait_entries_count > 0);
+		}
+
+		pthread_mutex_unlock(&(shard_p->shard_latch));
+
+		if(must_notify)
+			notify_all_wait_entries_for_resource_of_being_unblocked(lckmgr_p, resource_type, resource_id, resource_id_size);
+		return (imle_p != NULL);
+	}
+
+	// try to remove the lock, and wake up waiters if any, only after releasing the shard_latch
+	int was_released = 0;
+	int must_notify = 0;
+	if(atomic_load(&(lckmgr_p->overflowed_lock_entries_count)) > 0)
+		was_released = remove_lock_entry_from_bplus_trees(lckmgr_p, transaction, resource_type, resource_id, resource_id_size, &must_notify);
+
+	pthread_mutex_unlock(&(shard_p->shard_latch));
+
+	if(must_notify)
+		notify_all_wait_entries_for_resource_of_being_unblocked(lckmgr_p, resource_type, resource_id, resource_id_size);
+
+	return was_released;
 }
 
-void conclude_all_business_with_lock_manager(lock_manager* lckmgr_p, void* transaction)
+static int try_fast_acquire_single_lock(lock_manager* lckmgr_p, void* transaction, uint32_t resource_type, uint8_t* resource_id, uint8_t resource_id_size, uint32_t new_lock_mode, lock_result* result)
 {
-	// transacton_id, is indeed calling this function, so it is no longer expected to be blocked, it is aborting or committing, so we remove all it's wait_entries
-	remove_all_wait_entries_for_transaction(lckmgr_p, transaction);
+	lock_table_shard* shard_p = get_lock_table_shard_for_resource(lckmgr_p, resource_type, resource_id, resource_id_size);
+	pthread_mutex_lock(&(shard_p->shard_latch));
+
+	int res = 0;
+
+	resource_lock_head* rlh_p = find_resource_lock_head(shard_p, resource_type, resource_id, resource_id_size);
+
+	// if there are waiters, a transition may need to notify them, which can only be done with the external_lock held
+	if(shard_p->wait_entries_count == 0 && is_in_memory_resource(lckmgr_p, rlh_p))
+	{
+		int must_notify = 0;
+		lock_result lr = acquire_in_memory_lock(lckmgr_p, shard_p, rlh_p, transaction, NULL, resource_type, resource_id, resource_id_size, new_lock_mode, 1, 0, &must_notify);
+		if(lr != LOCKING_FAILED)
+		{
+			(*result) = lr;
+			res = 1;
+		}
+	}
+
+	pthread_mutex_unlock(&(shard_p->shard_latch));
+
+	return res;
+}
+
+static int try_fast_release_single_lock(lock_manager* lckmgr_p, void* transaction, uint32_t resource_type, uint8_t* resource_id, uint8_t resource_id_size)
+{
+	lock_table_shard* shard_p = get_lock_table_shard_for_resource(lckmgr_p, resource_type, resource_id, resource_id_size);
+	pthread_mutex_lock(&(shard_p->shard_latch));
+
+	int res = 0;
+
+	// the waiters, if any, must be notified of the release, which can only be done with the external_lock held
+	if(shard_p->wait_entries_count == 0)
+	{
+		in_memory_lock_entry* imle_p = find_in_memory_lock_entry(find_resource_lock_head(shard_p, resource_type, resource_id, resource_id_size), transaction);
+		if(imle_p != NULL)
+		{
+			remove_in_memory_lock_entry(lckmgr_p, shard_p, imle_p);
+			res = 1;
+		}
+	}
+
+	pthread_mutex_unlock(&(shard_p->shard_latch));
+
+	return res;
+}
+
+static int try_fast_get_single_lock_mode(lock_manager* lckmgr_p, void* transaction, uint32_t resource_type, uint8_t* resource_id, uint8_t resource_id_size, uint32_t* lock_mode)
+{
+	lock_table_shard* shard_p = get_lock_table_shard_for_resource(lckmgr_p, resource_type, resource_id, resource_id_size);
+	pthread_mutex_lock(&(shard_p->shard_latch));
+
+	int res = 0;
+
+	resource_lock_head* rlh_p = find_resource_lock_head(shard_p, resource_type, resource_id, resource_id_size);
+	if(rlh_p != NULL || atomic_load(&(lckmgr_p->overflowed_lock_entries_count)) == 0) // else the lock may be in the bplus_tree-s
+	{
+		in_memory_lock_entry* imle_p = find_in_memory_lock_entry(rlh_p, transaction);
+		(*lock_mode) = (imle_p != NULL) ? imle_p->lock_mode : NO_LOCK_HELD_LOCK_MODE;
+		res = 1;
+	}
+
+	pthread_mutex_unlock(&(shard_p->shard_latch));
+
+	return res;
+}
+
+// 9 - lock hierarchies and the escalation of the child locks, see the comment above the lock_hierarchy struct in lock_manager.h
+
+static int is_hierarchical_lock_type(const lock_manager* lckmgr_p, uint32_t resource_type)
+{
+	return lckmgr_p->lock_matrices[resource_type].lock_modes_count == HIERARCHICAL_DB_LOCK.lock_modes_count;
+}
+
+// returns 1, if the lock_mode allows modifying the resource (or any of its descendants)
+static int is_exclusive_lock_mode(const lock_manager* lckmgr_p, uint32_t resource_type, uint32_t lock_mode)
+{
+	if(is_hierarchical_lock_type(lckmgr_p, resource_type))
+		return lock_mode != HIERARCHICAL_DB_LOCK_IS_MODE && lock_mode != HIERARCHICAL_DB_LOCK_S_MODE;
+	return lock_mode == RW_DB_LOCK_W_MODE;
+}
+
+// the weakest lock_mode, that is as strong as both of them
+static const uint32_t hierarchical_lock_modes_supremum[5][5] = {
+	//             IS                            IX                             S                              SIX                            X
+	/* IS  */ {HIERARCHICAL_DB_LOCK_IS_MODE,  HIERARCHICAL_DB_LOCK_IX_MODE,  HIERARCHICAL_DB_LOCK_S_MODE,   HIERARCHICAL_DB_LOCK_SIX_MODE, HIERARCHICAL_DB_LOCK_X_MODE},
+	/* IX  */ {HIERARCHICAL_DB_LOCK_IX_MODE,  HIERARCHICAL_DB_LOCK_IX_MODE,  HIERARCHICAL_DB_LOCK_SIX_MODE, HIERARCHICAL_DB_LOCK_SIX_MODE, HIERARCHICAL_DB_LOCK_X_MODE},
+	/* S   */ {HIERARCHICAL_DB_LOCK_S_MODE,   HIERARCHICAL_DB_LOCK_SIX_MODE, HIERARCHICAL_DB_LOCK_S_MODE,   HIERARCHICAL_DB_LOCK_SIX_MODE, HIERARCHICAL_DB_LOCK_X_MODE},
+	/* SIX */ {HIERARCHICAL_DB_LOCK_SIX_MODE, HIERARCHICAL_DB_LOCK_SIX_MODE, HIERARCHICAL_DB_LOCK_SIX_MODE, HIERARCHICAL_DB_LOCK_SIX_MODE, HIERARCHICAL_DB_LOCK_X_MODE},
+	/* X   */ {HIERARCHICAL_DB_LOCK_X_MODE,   HIERARCHICAL_DB_LOCK_X_MODE,   HIERARCHICAL_DB_LOCK_X_MODE,   HIERARCHICAL_DB_LOCK_X_MODE,   HIERARCHICAL_DB_LOCK_X_MODE},
+};
+
+static uint32_t get_supremum_of_hierarchical_lock_modes(uint32_t lock_mode1, uint32_t lock_mode2)
+{
+	if(lock_mode1 == NO_LOCK_HELD_LOCK_MODE)
+		return lock_mode2;
+	if(lock_mode2 == NO_LOCK_HELD_LOCK_MODE)
+		return lock_mode1;
+	return hierarchical_lock_modes_supremum[lock_mode1][lock_mode2];
+}
+
+// returns the lock_mode implicitly granted on the resource by the S, SIX or X locks held on its ancestors, NO_LOCK_HELD_LOCK_MODE if none
+// with fast = 1 it does not look into the bplus_tree-s, and returns 0 if it needs to
+static int get_lock_mode_granted_by_ancestors(lock_manager* lckmgr_p, void* transaction, uint32_t resource_type, uint8_t* resource_id, int fast, uint32_t* granted_lock_mode)
+{
+	(*granted_lock_mode) = NO_LOCK_HELD_LOCK_MODE;
+
+	for(const lock_hierarchy* lh_p = &(lckmgr_p->lock_hierarchies[resource_type]); lh_p->parent_resource_type != NO_PARENT_RESOURCE_TYPE; lh_p = &(lckmgr_p->lock_hierarchies[lh_p->parent_resource_type]))
+	{
+		uint32_t ancestor_lock_mode;
+		if(fast)
+		{
+			if(!try_fast_get_single_lock_mode(lckmgr_p, transaction, lh_p->parent_resource_type, resource_id, lh_p->parent_resource_id_size, &ancestor_lock_mode))
+				return 0;
+		}
+		else
+			ancestor_lock_mode = get_single_lock_mode(lckmgr_p, transaction, lh_p->parent_resource_type, resource_id, lh_p->parent_resource_id_size);
+
+		if(ancestor_lock_mode == HIERARCHICAL_DB_LOCK_X_MODE)
+		{
+			(*granted_lock_mode) = is_hierarchical_lock_type(lckmgr_p, resource_type) ? HIERARCHICAL_DB_LOCK_X_MODE : RW_DB_LOCK_W_MODE;
+			return 1;
+		}
+		if(ancestor_lock_mode == HIERARCHICAL_DB_LOCK_S_MODE || ancestor_lock_mode == HIERARCHICAL_DB_LOCK_SIX_MODE)
+			(*granted_lock_mode) = is_hierarchical_lock_type(lckmgr_p, resource_type) ? HIERARCHICAL_DB_LOCK_S_MODE : RW_DB_LOCK_R_MODE;
+	}
+
+	return 1;
+}
+
+static int is_lock_mode_granted(const lock_manager* lckmgr_p, uint32_t resource_type, uint32_t lock_mode, uint32_t granted_lock_mode)
+{
+	if(granted_lock_mode == NO_LOCK_HELD_LOCK_MODE)
+		return 0;
+	return is_exclusive_lock_mode(lckmgr_p, resource_type, granted_lock_mode) || !is_exclusive_lock_mode(lckmgr_p, resource_type, lock_mode);
+}
+
+typedef struct escalation_counter escalation_counter;
+struct escalation_counter
+{
+	// embed_node for the escalation_counters of the lock_table_shard
+	bstnode embed_node;
+
+	void* transaction;
+
+	// the parent resource
+	uint32_t resource_type;
+	uint8_t resource_id_size;
+	uint8_t resource_id[MAX_RESOURCE_ID_SIZE];
+
+	// number of locks held by the transaction on the children of the parent resource
+	uint64_t child_locks_count;
+
+	// the escalation is attempted, once the child_locks_count reaches this value
+	uint64_t escalate_at_child_locks_count;
+};
+
+static cy_uint hash_escalation_counter(const void* data)
+{
+	const escalation_counter* ec_p = data;
+	return hash_transaction(ec_p->transaction) ^ hash_resource(ec_p->resource_type, ec_p->resource_id, ec_p->resource_id_size);
+}
+
+static int compare_escalation_counter(const void* data1, const void* data2)
+{
+	const escalation_counter* ec1_p = data1;
+	const escalation_counter* ec2_p = data2;
+	if(ec1_p->transaction != ec2_p->transaction)
+		return (((uintptr_t)(ec1_p->transaction)) > ((uintptr_t)(ec2_p->transaction))) ? 1 : -1;
+	if(ec1_p->resource_type != ec2_p->resource_type)
+		return (ec1_p->resource_type > ec2_p->resource_type) ? 1 : -1;
+	if(ec1_p->resource_id_size != ec2_p->resource_id_size)
+		return (ec1_p->resource_id_size > ec2_p->resource_id_size) ? 1 : -1;
+	return memory_compare(ec1_p->resource_id, ec2_p->resource_id, ec1_p->resource_id_size);
+}
+
+// adds delta to the child_locks_count of the transaction for the parent of the resource_type, returns 1 if the escalation is due
+// with delta = 0, it only checks if the escalation is due
+static int update_escalation_counter(lock_manager* lckmgr_p, void* transaction, uint32_t resource_type, uint8_t* resource_id, int64_t delta)
+{
+	const lock_hierarchy* lh_p = &(lckmgr_p->lock_hierarchies[resource_type]);
+	if(lh_p->parent_resource_type == NO_PARENT_RESOURCE_TYPE || lh_p->escalation_threshold == 0)
+		return 0;
+
+	escalation_counter probe = {.transaction = transaction, .resource_type = lh_p->parent_resource_type, .resource_id_size = lh_p->parent_resource_id_size};
+	memory_move(probe.resource_id, resource_id, lh_p->parent_resource_id_size);
+
+	lock_table_shard* tx_shard_p = get_lock_table_shard_for_transaction(lckmgr_p, transaction);
+	pthread_mutex_lock(&(tx_shard_p->transaction_heads_latch));
+
+	escalation_counter* ec_p = (escalation_counter*) find_equals_in_hashmap(&(tx_shard_p->escalation_counters), &probe);
+	if(ec_p == NULL && delta > 0)
+	{
+		ec_p = malloc(sizeof(escalation_counter));
+		if(ec_p == NULL)
+			exit(-1);
+		(*ec_p) = probe;
+		initialize_bstnode(&(ec_p->embed_node));
+		ec_p->child_locks_count = 0;
+		ec_p->escalate_at_child_locks_count = lh_p->escalation_threshold + 1;
+
+		insert_in_hashmap(&(tx_shard_p->escalation_counters), ec_p);
+		expand_hashmap_if_full(&(tx_shard_p->escalation_counters));
+	}
+
+	int is_escalation_due = 0;
+
+	if(ec_p != NULL)
+	{
+		// a child lock taken before the escalation_counter was reset (by an escalation) may be released after it
+		if(delta < 0 && ec_p->child_locks_count < (uint64_t)(-delta))
+			ec_p->child_locks_count = 0;
+		else
+			ec_p->child_locks_count += delta;
+
+		is_escalation_due = (ec_p->child_locks_count >= ec_p->escalate_at_child_locks_count);
+
+		if(ec_p->child_locks_count == 0)
+		{
+			remove_from_hashmap(&(tx_shard_p->escalation_counters), ec_p);
+			free(ec_p);
+		}
+	}
+
+	pthread_mutex_unlock(&(tx_shard_p->transaction_heads_latch));
+
+	return is_escalation_due;
+}
+
+// after a successfull escalation the escalation_counter is discarded, as the child locks are released, else the escalation is postponed by escalation_threshold more child locks
+static void conclude_escalation_attempt(lock_manager* lckmgr_p, void* transaction, uint32_t resource_type, uint8_t* resource_id, int was_escalated)
+{
+	const lock_hierarchy* lh_p = &(lckmgr_p->lock_hierarchies[resource_type]);
+
+	escalation_counter probe = {.transaction = transaction, .resource_type = lh_p->parent_resource_type, .resource_id_size = lh_p->parent_resource_id_size};
+	memory_move(probe.resource_id, resource_id, lh_p->parent_resource_id_size);
+
+	lock_table_shard* tx_shard_p = get_lock_table_shard_for_transaction(lckmgr_p, transaction);
+	pthread_mutex_lock(&(tx_shard_p->transaction_heads_latch));
+
+	escalation_counter* ec_p = (escalation_counter*) find_equals_in_hashmap(&(tx_shard_p->escalation_counters), &probe);
+	if(ec_p != NULL)
+	{
+		if(was_escalated)
+		{
+			remove_from_hashmap(&(tx_shard_p->escalation_counters), ec_p);
+			free(ec_p);
+		}
+		else
+			ec_p->escalate_at_child_locks_count = ec_p->child_locks_count + lh_p->escalation_threshold;
+	}
+
+	pthread_mutex_unlock(&(tx_shard_p->transaction_heads_latch));
+}
+
+static void discard_all_escalation_counters_for_transaction(lock_manager* lckmgr_p, void* transaction)
+{
+	lock_table_shard* tx_shard_p = get_lock_table_shard_for_transaction(lckmgr_p, transaction);
+	pthread_mutex_lock(&(tx_shard_p->transaction_heads_latch));
+
+	for(escalation_counter* ec_p = (escalation_counter*) get_first_of_in_hashmap(&(tx_shard_p->escalation_counters), FIRST_OF_HASHMAP); ec_p != NULL;)
+	{
+		escalation_counter* next_p = (escalation_counter*) get_next_of_in_hashmap(&(tx_shard_p->escalation_counters), ec_p, ANY_IN_HASHMAP);
+		if(ec_p->transaction == transaction)
+		{
+			remove_from_hashmap(&(tx_shard_p->escalation_counters), ec_p);
+			free(ec_p);
+		}
+		ec_p = next_p;
+	}
+
+	pthread_mutex_unlock(&(tx_shard_p->transaction_heads_latch));
+}
+
+typedef struct child_lock child_lock;
+struct child_lock
+{
+	uint8_t resource_id_size;
+	uint8_t resource_id[MAX_RESOURCE_ID_SIZE];
+};
+
+static void append_child_lock(child_lock** child_locks, uint64_t* child_locks_count, uint64_t* child_locks_capacity, const uint8_t* resource_id, uint8_t resource_id_size)
+{
+	if((*child_locks_count) == (*child_locks_capacity))
+	{
+		(*child_locks_capacity) = ((*child_locks_capacity) == 0) ? 64 : (2 * (*child_locks_capacity));
+		(*child_locks) = realloc((*child_locks), sizeof(child_lock) * (*child_locks_capacity));
+		if((*child_locks) == NULL)
+			exit(-1);
+	}
+
+	child_lock* cl_p = &((*child_locks)[(*child_locks_count)++]);
+	cl_p->resource_id_size = resource_id_size;
+	memory_move(cl_p->resource_id, resource_id, resource_id_size);
+}
+
+// returns all the resources of resource_type, locked by the transaction, under the parent (resource_id being the resource_id of the parent)
+static child_lock* collect_child_locks(lock_manager* lckmgr_p, void* transaction, uint32_t resource_type, uint8_t* resource_id, uint8_t parent_resource_id_size, uint64_t* child_locks_count)
+{
+	child_lock* child_locks = NULL;
+	uint64_t child_locks_capacity = 0;
+	(*child_locks_count) = 0;
+
+	// the in memory ones, the resource of an in_memory_lock_entry can not change, while it is linked to the transaction_lock_head
+	{
+		lock_table_shard* tx_shard_p = get_lock_table_shard_for_transaction(lckmgr_p, transaction);
+		pthread_mutex_lock(&(tx_shard_p->transaction_heads_latch));
+
+		transaction_lock_head* tlh_p = (transaction_lock_head*) find_equals_in_hashmap(&(tx_shard_p->transaction_heads), &((transaction_lock_head){.transaction = transaction}));
+		if(tlh_p != NULL)
+		{
+			for(const in_memory_lock_entry* imle_p = get_head_of_linkedlist(&(tlh_p->locks)); imle_p != NULL; imle_p = get_next_of_in_linkedlist(&(tlh_p->locks), imle_p))
+			{
+				const resource_lock_head* rlh_p = imle_p->rlh_p;
+				if(rlh_p->resource_type == resource_type && rlh_p->resource_id_size >= parent_resource_id_size && 0 == memory_compare(rlh_p->resource_id, resource_id, parent_resource_id_size))
+					append_child_lock(&child_locks, child_locks_count, &child_locks_capacity, rlh_p->resource_id, rlh_p->resource_id_size);
+			}
+		}
+
+		pthread_mutex_unlock(&(tx_shard_p->transaction_heads_latch));
+	}
+
+	if(atomic_load(&(lckmgr_p->overflowed_lock_entries_count)) == 0)
+		return child_locks;
+
+	// then the ones in the tx_locks, that are ordered by (transaction, resource_type, resource_id)
+	char lock_entry_key[MAX_SERIALIZED_LOCK_ENTRY_SIZE];
+	{
+		char lock_entry_tuple[MAX_SERIALIZED_LOCK_ENTRY_SIZE];
+		{
+			lock_entry le = {.transaction = transaction, .resource_type = resource_type};
+			serialize_lock_entry_record(lock_entry_tuple, &le, lckmgr_p);
+		}
+		extract_key_from_record_tuple_using_bplus_tree_tuple_definitions(lckmgr_p->tx_locks_td, lock_entry_tuple, lock_entry_key);
+	}
+
+	bplus_tree_iterator* bpi_p = find_in_bplus_tree(lckmgr_p->tx_locks_root_page_id, lock_entry_key, 2, GREATER_THAN_EQUALS, 0, READ_LOCK, lckmgr_p->tx_locks_td, lckmgr_p->lckmgr_engine->pam_p, NULL, NULL, &abort_error);
+
+	while(!is_empty_bplus_tree(bpi_p) && !is_beyond_max_tuple_bplus_tree_iterator(bpi_p))
+	{
+		lock_entry le;
+		deserialize_lock_entry_record(get_tuple_bplus_tree_iterator(bpi_p), &le, lckmgr_p);
+
+		if(le.transaction != transaction || le.resource_type != resource_type)
+			break;
+
+		if(le.resource_id_size >= parent_resource_id_size && 0 == memory_compare(le.resource_id, resource_id, parent_resource_id_size))
+			append_child_lock(&child_locks, child_locks_count, &child_locks_capacity, le.resource_id, le.resource_id_size);
+
+		next_bplus_tree_iterator(bpi_p, NULL, &abort_error);
+	}
+
+	delete_bplus_tree_iterator(bpi_p, NULL, &abort_error);
+
+	return child_locks;
+}
+
+// must be called with external_lock held
+// replaces all the locks of the transaction on the children of the parent of the resource, with a single lock on the parent, if it can be acquired without blocking
+static void escalate_child_locks(lock_manager* lckmgr_p, void* transaction, void* task, uint32_t resource_type, uint8_t* resource_id)
+{
+	const lock_hierarchy* lh_p = &(lckmgr_p->lock_hierarchies[resource_type]);
+
+	uint64_t child_locks_count = 0;
+	child_lock* child_locks = collect_child_locks(lckmgr_p, transaction, resource_type, resource_id, lh_p->parent_resource_id_size, &child_locks_count);
+
+	// the parent must be locked in X mode, if any of the child locks is exclusive, else the S mode suffices
+	uint32_t parent_lock_mode = get_single_lock_mode(lckmgr_p, transaction, lh_p->parent_resource_type, resource_id, lh_p->parent_resource_id_size);
+	uint32_t escalated_lock_mode = get_supremum_of_hierarchical_lock_modes(parent_lock_mode, HIERARCHICAL_DB_LOCK_S_MODE);
+	for(uint64_t i = 0; i < child_locks_count && escalated_lock_mode != HIERARCHICAL_DB_LOCK_X_MODE; i++)
+		if(is_exclusive_lock_mode(lckmgr_p, resource_type, get_single_lock_mode(lckmgr_p, transaction, resource_type, child_locks[i].resource_id, child_locks[i].resource_id_size)))
+			escalated_lock_mode = HIERARCHICAL_DB_LOCK_X_MODE;
+
+	// the intention locks on the ancestors of the parent are already held, it is only a transition on the parent itself
+	lock_result res = acquire_single_lock(lckmgr_p, transaction, task, lh_p->parent_resource_type, resource_id, lh_p->parent_resource_id_size, escalated_lock_mode, 1);
+	int was_escalated = (res != LOCKING_FAILED);
+
+	if(was_escalated)
+	{
+		for(uint64_t i = 0; i < child_locks_count; i++)
+			release_single_lock(lckmgr_p, transaction, resource_type, child_locks[i].resource_id, child_locks[i].resource_id_size);
+	}
+
+	conclude_escalation_attempt(lckmgr_p, transaction, resource_type, resource_id, was_escalated);
+
+	free(child_locks);
+}
+
+// must be called with external_lock held
+// acquires the intention locks on all the ancestors, and then the lock on the resource, escalating the child locks under its parent if due
+static lock_result acquire_lock_hierarchically(lock_manager* lckmgr_p, void* transaction, void* task, uint32_t resource_type, uint8_t* resource_id, uint8_t resource_id_size, uint32_t new_lock_mode, int non_blocking)
+{
+	const lock_hierarchy* lh_p = &(lckmgr_p->lock_hierarchies[resource_type]);
+	if(lh_p->parent_resource_type == NO_PARENT_RESOURCE_TYPE)
+		return acquire_single_lock(lckmgr_p, transaction, task, resource_type, resource_id, resource_id_size, new_lock_mode, non_blocking);
+
+	uint32_t granted_lock_mode;
+	get_lock_mode_granted_by_ancestors(lckmgr_p, transaction, resource_type, resource_id, 0, &granted_lock_mode);
+	if(is_lock_mode_granted(lckmgr_p, resource_type, new_lock_mode, granted_lock_mode))
+		return LOCK_ALREADY_HELD;
+
+	uint32_t parent_lock_mode = get_single_lock_mode(lckmgr_p, transaction, lh_p->parent_resource_type, resource_id, lh_p->parent_resource_id_size);
+	uint32_t intention_lock_mode = is_exclusive_lock_mode(lckmgr_p, resource_type, new_lock_mode) ? HIERARCHICAL_DB_LOCK_IX_MODE : HIERARCHICAL_DB_LOCK_IS_MODE;
+	uint32_t new_parent_lock_mode = get_supremum_of_hierarchical_lock_modes(parent_lock_mode, intention_lock_mode);
+	if(new_parent_lock_mode != parent_lock_mode)
+	{
+		lock_result res = acquire_lock_hierarchically(lckmgr_p, transaction, task, lh_p->parent_resource_type, resource_id, lh_p->parent_resource_id_size, new_parent_lock_mode, non_blocking);
+		if(res == LOCKING_FAILED || res == MUST_BLOCK_FOR_LOCK)
+			return res;
+	}
+
+	lock_result res = acquire_single_lock(lckmgr_p, transaction, task, resource_type, resource_id, resource_id_size, new_lock_mode, non_blocking);
+
+	if(res == LOCK_ACQUIRED && update_escalation_counter(lckmgr_p, transaction, resource_type, resource_id, 1))
+		escalate_child_locks(lckmgr_p, transaction, task, resource_type, resource_id);
+
+	return res;
+}
+
+// the fast path counterpart of the above function, it never escalates, it fails if the escalation is due
+// the intention locks acquired on the ancestors are retained, even if it fails to acquire the lock on the resource
+static int try_fast_acquire_lock_hierarchically(lock_manager* lckmgr_p, void* transaction, uint32_t resource_type, uint8_t* resource_id, uint8_t resource_id_size, uint32_t new_lock_mode, lock_result* result)
+{
+	const lock_hierarchy* lh_p = &(lckmgr_p->lock_hierarchies[resource_type]);
+	if(lh_p->parent_resource_type == NO_PARENT_RESOURCE_TYPE)
+		return try_fast_acquire_single_lock(lckmgr_p, transaction, resource_type, resource_id, resource_id_size, new_lock_mode, result);
+
+	uint32_t granted_lock_mode;
+	if(!get_lock_mode_granted_by_ancestors(lckmgr_p, transaction, resource_type, resource_id, 1, &granted_lock_mode))
+		return 0;
+	if(is_lock_mode_granted(lckmgr_p, resource_type, new_lock_mode, granted_lock_mode))
+	{
+		(*result) = LOCK_ALREADY_HELD;
+		return 1;
+	}
+
+	if(update_escalation_counter(lckmgr_p, transaction, resource_type, resource_id, 0))
+		return 0;
+
+	uint32_t parent_lock_mode;
+	if(!try_fast_get_single_lock_mode(lckmgr_p, transaction, lh_p->parent_resource_type, resource_id, lh_p->parent_resource_id_size, &parent_lock_mode))
+		return 0;
+	uint32_t intention_lock_mode = is_exclusive_lock_mode(lckmgr_p, resource_type, new_lock_mode) ? HIERARCHICAL_DB_LOCK_IX_MODE : HIERARCHICAL_DB_LOCK_IS_MODE;
+	uint32_t new_parent_lock_mode = get_supremum_of_hierarchical_lock_modes(parent_lock_mode, intention_lock_mode);
+	if(new_parent_lock_mode != parent_lock_mode)
+	{
+		lock_result parent_result;
+		if(!try_fast_acquire_lock_hierarchically(lckmgr_p, transaction, lh_p->parent_resource_type, resource_id, lh_p->parent_resource_id_size, new_parent_lock_mode, &parent_result))
+			return 0;
+	}
+
+	if(!try_fast_acquire_single_lock(lckmgr_p, transaction, resource_type, resource_id, resource_id_size, new_lock_mode, result))
+		return 0;
+
+	if((*result) == LOCK_ACQUIRED)
+		update_escalation_counter(lckmgr_p, transaction, resource_type, resource_id, 1);
+
+	return 1;
+}
+
+// 10 - the deadlock detector, see the comment above the deadlock_detector_stats struct in lock_manager.h
+
+static uint64_t get_current_time_in_microseconds()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (((uint64_t)now.tv_sec) * 1000000ULL) + (now.tv_nsec / 1000);
+}
+
+typedef struct wait_edge wait_edge;
+struct wait_edge
+{
+	// embed_node for the wait_edges of the lock_manager
+	bstnode embed_node;
+
+	void* waiting_transaction;
+	void* transaction;
+
+	// number of wait_entries between the above 2 transactions, for different tasks and resources
+	uint64_t wait_entries_count;
+
+	// time of the insertion of the newest of the above wait_entries
+	uint64_t inserted_at_us;
+};
+
+static cy_uint hash_wait_edge(const void* data)
+{
+	const wait_edge* e_p = data;
+	return hash_transaction(e_p->waiting_transaction) ^ (hash_transaction(e_p->transaction) * 31);
+}
+
+static int compare_wait_edge(const void* data1, const void* data2)
+{
+	const wait_edge* e1_p = data1;
+	const wait_edge* e2_p = data2;
+	if(e1_p->waiting_transaction != e2_p->waiting_transaction)
+		return (((uintptr_t)(e1_p->waiting_transaction)) > ((uintptr_t)(e2_p->waiting_transaction))) ? 1 : -1;
+	if(e1_p->transaction != e2_p->transaction)
+		return (((uintptr_t)(e1_p->transaction)) > ((uintptr_t)(e2_p->transaction))) ? 1 : -1;
+	return 0;
+}
+
+typedef struct deadlock_victim deadlock_victim;
+struct deadlock_victim
+{
+	// embed_node for the deadlock_victims of the lock_manager
+	bstnode embed_node;
+
+	void* transaction;
+};
+
+static cy_uint hash_deadlock_victim(const void* data)
+{
+	return hash_transaction(((const deadlock_victim*)data)->transaction);
+}
+
+static int compare_deadlock_victim(const void* data1, const void* data2)
+{
+	const deadlock_victim* v1_p = data1;
+	const deadlock_victim* v2_p = data2;
+	if(v1_p->transaction == v2_p->transaction)
+		return 0;
+	return (((uintptr_t)(v1_p->transaction)) > ((uintptr_t)(v2_p->transaction))) ? 1 : -1;
+}
+
+static void notify_removal_by_free(void* resource_p, const void* data_p)
+{
+	free((void*)data_p);
+}
+
+static void insert_wait_edge(lock_manager* lckmgr_p, const wait_entry* we_p)
+{
+	pthread_mutex_lock(&(lckmgr_p->wait_edges_lock));
+
+	wait_edge* e_p = (wait_edge*) find_equals_in_hashmap(&(lckmgr_p->wait_edges), &((wait_edge){.waiting_transaction = we_p->waiting_transaction, .transaction = we_p->transaction}));
+	if(e_p == NULL)
+	{
+		e_p = malloc(sizeof(wait_edge));
+		if(e_p == NULL)
+			exit(-1);
+		initialize_bstnode(&(e_p->embed_node));
+		e_p->waiting_transaction = we_p->waiting_transaction;
+		e_p->transaction = we_p->transaction;
+		e_p->wait_entries_count = 0;
+
+		insert_in_hashmap(&(lckmgr_p->wait_edges), e_p);
+		expand_hashmap_if_full(&(lckmgr_p->wait_edges));
+	}
+
+	e_p->wait_entries_count++;
+	e_p->inserted_at_us = get_current_time_in_microseconds();
+	lckmgr_p->wait_edges_inserted_count++;
+
+	pthread_mutex_unlock(&(lckmgr_p->wait_edges_lock));
+}
+
+static void remove_wait_edge(lock_manager* lckmgr_p, const wait_entry* we_p)
+{
+	pthread_mutex_lock(&(lckmgr_p->wait_edges_lock));
+
+	wait_edge* e_p = (wait_edge*) find_equals_in_hashmap(&(lckmgr_p->wait_edges), &((wait_edge){.waiting_transaction = we_p->waiting_transaction, .transaction = we_p->transaction}));
+	if(e_p != NULL && (--(e_p->wait_entries_count)) == 0)
+	{
+		remove_from_hashmap(&(lckmgr_p->wait_edges), e_p);
+		free(e_p);
+	}
+
+	pthread_mutex_unlock(&(lckmgr_p->wait_edges_lock));
+}
+
+// a copy of a wait_edge, taken by the deadlock_detector
+typedef struct wait_edge_copy wait_edge_copy;
+struct wait_edge_copy
+{
+	void* waiting_transaction;
+	void* transaction;
+	uint64_t inserted_at_us;
+};
+
+static int compare_wait_edge_copies(const void* e1, const void* e2)
+{
+	return compare_wait_edge(&((wait_edge){.waiting_transaction = ((const wait_edge_copy*)e1)->waiting_transaction, .transaction = ((const wait_edge_copy*)e1)->transaction}), &((wait_edge){.waiting_transaction = ((const wait_edge_copy*)e2)->waiting_transaction, .transaction = ((const wait_edge_copy*)e2)->transaction}));
+}
+
+// index of the first edge going out of the transaction, in the sorted edges, edges_count if it has none
+static uint64_t find_first_out_edge(const wait_edge_copy* edges, uint64_t edges_count, void* transaction)
+{
+	uint64_t l = 0;
+	uint64_t h = edges_count;
+	while(l < h)
+	{
+		uint64_t m = l + (h - l) / 2;
+		if(((uintptr_t)(edges[m].waiting_transaction)) < ((uintptr_t)transaction))
+			l = m + 1;
+		else
+			h = m;
+	}
+	return (l < edges_count && edges[l].waiting_transaction == transaction) ? l : edges_count;
+}
+
+// dfs states of the edges (i.e. their waiting_transactions), as the sorted edges are grouped by them, the state is stored at the first edge of the group
+#define DFS_UNVISITED 0
+#define DFS_ON_STACK  1
+#define DFS_VISITED   2
+#define DFS_REMOVED   3 // victims (chosen now or before), their edges are ignored
+
+// index of the first edge of the next group, after the group of the edge at index i
+static uint64_t find_next_group(const wait_edge_copy* edges, uint64_t edges_count, uint64_t i)
+{
+	uint64_t j = i;
+	while(j < edges_count && edges[j].waiting_transaction == edges[i].waiting_transaction)
+		j++;
+	return j;
+}
+
+// returns 1, if a cycle was found, its edges being (*cycle)[0 .. (*cycle_edges_count) - 1] (indices into edges)
+// the dfs_state and the stack must have edges_count elements each, the dfs_state must be reset (by reset_dfs_state()) before every call
+static int find_cycle(const wait_edge_copy* edges, uint64_t edges_count, uint8_t* dfs_state, uint64_t* stack, uint64_t** cycle, uint64_t* cycle_edges_count)
+{
+	for(uint64_t root = 0; root < edges_count; root = find_next_group(edges, edges_count, root))
+	{
+		if(dfs_state[root] != DFS_UNVISITED)
+			continue;
+
+		// the stack holds the edge being followed, out of every transaction on the dfs path
+		uint64_t stack_size = 0;
+		dfs_state[root] = DFS_ON_STACK;
+		stack[stack_size++] = root;
+
+		while(stack_size > 0)
+		{
+			uint64_t curr = stack[stack_size - 1];
+			uint64_t next = find_first_out_edge(edges, edges_count, edges[curr].transaction);
+
+			if(next != edges_count && dfs_state[next] == DFS_ON_STACK)
+			{
+				// the cycle starts at the edge, out of edges[curr].transaction on the stack, and ends at the top
+				uint64_t start = stack_size - 1;
+				while(edges[stack[start]].waiting_transaction != edges[next].waiting_transaction)
+					start--;
+				(*cycle) = stack + start;
+				(*cycle_edges_count) = stack_size - start;
+				return 1;
+			}
+
+			if(next != edges_count && dfs_state[next] == DFS_UNVISITED)
+			{
+				dfs_state[next] = DFS_ON_STACK;
+				stack[stack_size++] = next;
+				continue;
+			}
+
+			// edges[curr].transaction is not waiting, or it can not be a part of any cycle, so follow the next edge out of edges[curr].waiting_transaction
+			if(curr + 1 < edges_count && edges[curr + 1].waiting_transaction == edges[curr].waiting_transaction)
+			{
+				stack[stack_size - 1] = curr + 1;
+				continue;
+			}
+
+			// all its edges are followed, so pop it
+			stack_size--;
+			dfs_state[find_first_out_edge(edges, edges_count, edges[curr].waiting_transaction)] = DFS_VISITED;
+		}
+	}
+
+	return 0;
+}
+
+// a cycle found by the deadlock_detector, its edges_count edges are at edges_offset in the found_cycle_edges
+typedef struct found_cycle found_cycle;
+struct found_cycle
+{
+	uint64_t edges_offset;
+	uint64_t edges_count;
+	uint64_t newest_inserted_at_us;
+
+	// the victim chosen, only to continue the search, the other cycles through it are not searched in this run
+	void* provisional_victim;
+};
+
+// the victim is the youngest waiting_transaction in the cycle, or the waiting_transaction of its newest edge, if the notifier can not tell their ages
+// the notifier is only asked with the external_lock held, after the cycle is verified, as only then are its transactions known to exist
+static void* choose_deadlock_victim(lock_manager* lckmgr_p, const wait_edge_copy* cycle_edges, uint64_t cycle_edges_count, int ask_notifier)
+{
+	const wait_edge_copy* victim_p = &(cycle_edges[0]);
+	for(uint64_t i = 1; i < cycle_edges_count; i++)
+	{
+		if(ask_notifier && lckmgr_p->notifier.is_younger_transaction != NULL)
+		{
+			if(lckmgr_p->notifier.is_younger_transaction(lckmgr_p->notifier.context_p, cycle_edges[i].waiting_transaction, victim_p->waiting_transaction))
+				victim_p = &(cycle_edges[i]);
+		}
+		else if(cycle_edges[i].inserted_at_us > victim_p->inserted_at_us)
+			victim_p = &(cycle_edges[i]);
+	}
+	return victim_p->waiting_transaction;
+}
+
+static void reset_dfs_state(const wait_edge_copy* edges, uint64_t edges_count, uint8_t* dfs_state, void* const * victims, uint64_t victims_count)
+{
+	memory_set(dfs_state, DFS_UNVISITED, edges_count);
+	for(uint64_t i = 0; i < victims_count; i++)
+	{
+		uint64_t first_out_edge = find_first_out_edge(edges, edges_count, victims[i]);
+		if(first_out_edge != edges_count)
+			dfs_state[first_out_edge] = DFS_REMOVED;
+	}
+}
+
+// must be called without any lock held
+// returns 1, if a victim chosen differs from the provisional_victim of its cycle, then the cycles hidden by the provisional_victim must be searched in the next run
+static int run_deadlock_detection(lock_manager* lckmgr_p)
+{
+	// copy the wait_edges and the deadlock_victims
+	pthread_mutex_lock(&(lckmgr_p->wait_edges_lock));
+
+	uint64_t edges_count = get_element_count_hashmap(&(lckmgr_p->wait_edges));
+	wait_edge_copy* edges = malloc(sizeof(wait_edge_copy) * (edges_count + 1));
+	if(edges == NULL)
+		exit(-1);
+	{
+		uint64_t i = 0;
+		for(const wait_edge* e_p = get_first_of_in_hashmap(&(lckmgr_p->wait_edges), FIRST_OF_HASHMAP); e_p != NULL; e_p = get_next_of_in_hashmap(&(lckmgr_p->wait_edges), e_p, ANY_IN_HASHMAP))
+			edges[i++] = (wait_edge_copy){.waiting_transaction = e_p->waiting_transaction, .transaction = e_p->transaction, .inserted_at_us = e_p->inserted_at_us};
+	}
+
+	// victims chosen in the earlier runs, and then in this run
+	uint64_t victims_count = get_element_count_hashmap(&(lckmgr_p->deadlock_victims));
+	uint64_t victims_capacity = victims_count + 16;
+	void** victims = malloc(sizeof(void*) * victims_capacity);
+	if(victims == NULL)
+		exit(-1);
+	{
+		uint64_t i = 0;
+		for(const deadlock_victim* v_p = get_first_of_in_hashmap(&(lckmgr_p->deadlock_victims), FIRST_OF_HASHMAP); v_p != NULL; v_p = get_next_of_in_hashmap(&(lckmgr_p->deadlock_victims), v_p, ANY_IN_HASHMAP))
+			victims[i++] = v_p->transaction;
+	}
+
+	pthread_mutex_unlock(&(lckmgr_p->wait_edges_lock));
+
+	uint64_t run_start_us = get_current_time_in_microseconds();
+
+	qsort(edges, edges_count, sizeof(wait_edge_copy), compare_wait_edge_copies);
+
+	uint8_t* dfs_state = malloc(sizeof(uint8_t) * (edges_count + 1));
+	uint64_t* stack = malloc(sizeof(uint64_t) * (edges_count + 1));
+	if(dfs_state == NULL || stack == NULL)
+		exit(-1);
+
+	// search for the cycles, removing the victim of every cycle found, from the search
+	found_cycle* cycles = NULL;
+	uint64_t cycles_count = 0;
+	wait_edge_copy* found_cycle_edges = NULL;
+	uint64_t found_cycle_edges_count = 0;
+
+	reset_dfs_state(edges, edges_count, dfs_state, victims, victims_count);
+
+	uint64_t* cycle;
+	uint64_t cycle_edges_count;
+	while(find_cycle(edges, edges_count, dfs_state, stack, &cycle, &cycle_edges_count))
+	{
+		found_cycle fc = {.edges_offset = found_cycle_edges_count, .edges_count = cycle_edges_count, .newest_inserted_at_us = 0, .provisional_victim = NULL};
+
+		found_cycle_edges = realloc(found_cycle_edges, sizeof(wait_edge_copy) * (found_cycle_edges_count + cycle_edges_count));
+		cycles = realloc(cycles, sizeof(found_cycle) * (cycles_count + 1));
+		if(found_cycle_edges == NULL || cycles == NULL)
+			exit(-1);
+		for(uint64_t i = 0; i < cycle_edges_count; i++)
+		{
+			found_cycle_edges[found_cycle_edges_count++] = edges[cycle[i]];
+			if(edges[cycle[i]].inserted_at_us > fc.newest_inserted_at_us)
+				fc.newest_inserted_at_us = edges[cycle[i]].inserted_at_us;
+		}
+
+		// only a provisional victim, to break the cycle for the rest of the search
+		fc.provisional_victim = choose_deadlock_victim(lckmgr_p, found_cycle_edges + fc.edges_offset, fc.edges_count, 0);
+		cycles[cycles_count++] = fc;
+
+		if(victims_count == victims_capacity)
+		{
+			victims_capacity *= 2;
+			victims = realloc(victims, sizeof(void*) * victims_capacity);
+			if(victims == NULL)
+				exit(-1);
+		}
+		victims[victims_count++] = fc.provisional_victim;
+
+		// the partially searched states are no longer valid, so restart the search without the new victim
+		reset_dfs_state(edges, edges_count, dfs_state, victims, victims_count);
+	}
+
+	uint64_t run_duration_us = get_current_time_in_microseconds() - run_start_us;
+
+	free(stack);
+	free(dfs_state);
+	free(victims);
+	free(edges);
+
+	// verify each cycle in the current wait_edges, and notify its victim, the external_lock is held only so that notify_deadlocked() could be called
+	// a cycle with a waiting_transaction already chosen as a victim, will be broken by it, so it is skipped
+	uint64_t deadlocks_count = 0;
+	uint64_t stale_cycles_count = 0;
+	uint64_t total_detection_latency_us = 0;
+	uint64_t max_detection_latency_us = 0;
+	int needs_rerun = 0;
+	for(uint64_t c = 0; c < cycles_count; c++)
+	{
+		pthread_mutex_lock(lckmgr_p->external_lock);
+		pthread_mutex_lock(&(lckmgr_p->wait_edges_lock));
+
+		const wait_edge_copy* cycle_edges = found_cycle_edges + cycles[c].edges_offset;
+
+		int is_deadlocked = 1;
+		int is_being_broken = 0;
+		for(uint64_t i = 0; i < cycles[c].edges_count && is_deadlocked && !is_being_broken; i++)
+		{
+			is_deadlocked = (NULL != find_equals_in_hashmap(&(lckmgr_p->wait_edges), &((wait_edge){.waiting_transaction = cycle_edges[i].waiting_transaction, .transaction = cycle_edges[i].transaction})));
+			is_being_broken = (NULL != find_equals_in_hashmap(&(lckmgr_p->deadlock_victims), &((deadlock_victim){.transaction = cycle_edges[i].waiting_transaction})));
+		}
+
+		void* victim = NULL;
+		if(is_deadlocked && !is_being_broken)
+		{
+			victim = choose_deadlock_victim(lckmgr_p, cycle_edges, cycles[c].edges_count, 1);
+			if(victim != cycles[c].provisional_victim)
+				needs_rerun = 1;
+
+			deadlock_victim* v_p = malloc(sizeof(deadlock_victim));
+			if(v_p == NULL)
+				exit(-1);
+			initialize_bstnode(&(v_p->embed_node));
+			v_p->transaction = victim;
+			insert_in_hashmap(&(lckmgr_p->deadlock_victims), v_p);
+			expand_hashmap_if_full(&(lckmgr_p->deadlock_victims));
+		}
+
+		pthread_mutex_unlock(&(lckmgr_p->wait_edges_lock));
+
+		if(victim != NULL)
+		{
+			lckmgr_p->notifier.notify_deadlocked(lckmgr_p->notifier.context_p, victim);
+
+			uint64_t detection_latency_us = get_current_time_in_microseconds() - cycles[c].newest_inserted_at_us;
+			deadlocks_count++;
+			total_detection_latency_us += detection_latency_us;
+			if(detection_latency_us > max_detection_latency_us)
+				max_detection_latency_us = detection_latency_us;
+		}
+		else if(!is_deadlocked)
+			stale_cycles_count++;
+
+		pthread_mutex_unlock(lckmgr_p->external_lock);
+	}
+
+	free(cycles);
+	free(found_cycle_edges);
+
+	pthread_mutex_lock(&(lckmgr_p->wait_edges_lock));
+
+	lckmgr_p->dd_stats.detection_runs_count++;
+	lckmgr_p->dd_stats.deadlocks_count += deadlocks_count;
+	lckmgr_p->dd_stats.stale_cycles_count += stale_cycles_count;
+	lckmgr_p->dd_stats.total_detection_latency_us += total_detection_latency_us;
+	if(max_detection_latency_us > lckmgr_p->dd_stats.max_detection_latency_us)
+		lckmgr_p->dd_stats.max_detection_latency_us = max_detection_latency_us;
+	lckmgr_p->dd_stats.last_run_wait_edges_count = edges_count;
+	lckmgr_p->dd_stats.last_run_duration_us = run_duration_us;
+
+	pthread_mutex_unlock(&(lckmgr_p->wait_edges_lock));
+
+	return needs_rerun;
+}
+
+// body of the deadlock_detector thread
+static void* deadlock_detector(void* lckmgr_vp)
+{
+	lock_manager* lckmgr_p = lckmgr_vp;
+
+	uint64_t last_wait_edges_inserted_count = 0;
+	int needs_rerun = 0;
+
+	pthread_mutex_lock(&(lckmgr_p->wait_edges_lock));
+
+	while(!lckmgr_p->stop_deadlock_detector)
+	{
+		uint64_t timeout_in_microseconds = lckmgr_p->deadlock_detection_period_us;
+		while(!lckmgr_p->stop_deadlock_detector && timeout_in_microseconds > 0)
+		{
+			if(pthread_cond_timedwait_for_microseconds(&(lckmgr_p->deadlock_detector_wait), &(lckmgr_p->wait_edges_lock), &timeout_in_microseconds))
+				break;
+		}
+
+		if(lckmgr_p->stop_deadlock_detector)
+			break;
+
+		// a new cycle can only be formed by a new wait_edge
+		if(lckmgr_p->wait_edges_inserted_count == last_wait_edges_inserted_count && !needs_rerun)
+			continue;
+		last_wait_edges_inserted_count = lckmgr_p->wait_edges_inserted_count;
+
+		pthread_mutex_unlock(&(lckmgr_p->wait_edges_lock));
+
+		needs_rerun = run_deadlock_detection(lckmgr_p);
+
+		pthread_mutex_lock(&(lckmgr_p->wait_edges_lock));
+	}
+
+	pthread_mutex_unlock(&(lckmgr_p->wait_edges_lock));
+
+	return NULL;
+}
+
+// --
+
+void initialize_lock_manager(lock_manager* lckmgr_p, pthread_mutex_t* external_lock, const lock_manager_notifier* notifier, rage_engine* lckmgr_engine, uint64_t deadlock_detection_period_us)
+{
+	lckmgr_p->external_lock = external_lock;
+
+	lckmgr_p->notifier = (*notifier);
+
+	lckmgr_p->locks_type_count = 0;
+	lckmgr_p->lock_matrices = NULL;
+	lckmgr_p->lock_hierarchies = NULL;
+
+	lckmgr_p->lckmgr_engine = lckmgr_engine;
+
+	lckmgr_p->resource_id_type_info = malloc(sizeof(data_type_info));
+	if(lckmgr_p->resource_id_type_info == NULL)
+		exit(-1);
+	*(lckmgr_p->resource_id_type_info) = get_variable_length_binary_type("resource_id_type", MAX_RESOURCE_ID_SIZE + 2);
+
+	{
+		data_type_info* dti = malloc(sizeof_tuple_data_type_info(4));
+		if(dti == NULL)
+			exit(-1);
+		initialize_tuple_data_type_info(dti, "lock_entry", 0, MAX_SERIALIZED_LOCK_ENTRY_SIZE, 4);
+
+		strcpy(dti->containees[0].field_name, "transaction");
+		dti->containees[0].al.type_info = UINT_NON_NULLABLE[sizeof(void*)];
+
+		strcpy(dti->containees[1].field_name, "resource_type");
+		dti->containees[1].al.type_info = UINT_NON_NULLABLE[4];
+
+		strcpy(dti->containees[2].field_name, "resource_id");
+		dti->containees[2].al.type_info = lckmgr_p->resource_id_type_info;
+
+		strcpy(dti->containees[3].field_name, "lock_mode");
+		dti->containees[3].al.type_info = UINT_NON_NULLABLE[4];
+
+		lckmgr_p->lock_record_def = malloc(sizeof(tuple_def));
+		if(lckmgr_p->lock_record_def == NULL)
+			exit(-1);
+		initialize_tuple_def(lckmgr_p->lock_record_def, dti);
+	}
+
+	lckmgr_p->tx_locks_td = malloc(sizeof(bplus_tree_tuple_defs));
+	if(lckmgr_p->tx_locks_td == NULL)
+		exit(-1);
+	if(!init_bplus_tree_tuple_definitions(lckmgr_p->tx_locks_td, &(lckmgr_p->lckmgr_engine->pam_p->pas), lckmgr_p->lock_record_def, tx_locks_keys, all_ascending, 3))
+	{
+		printf("BUG (in lock_manager) :: could not initialize tx_locks_td\n");
+		exit(-1);
+	}
+	lckmgr_p->tx_locks_root_page_id = get_new_bplus_tree(lckmgr_p->tx_locks_td, lckmgr_p->lckmgr_engine->pam_p, lckmgr_p->lckmgr_engine->pmm_p, NULL, &abort_error);
+
+	lckmgr_p->rs_locks_td = malloc(sizeof(bplus_tree_tuple_defs));
+	if(lckmgr_p->rs_locks_td == NULL)
+		exit(-1);
+	if(!init_bplus_tree_tuple_definitions(lckmgr_p->rs_locks_td, &(lckmgr_p->lckmgr_engine->pam_p->pas), lckmgr_p->lock_record_def, rs_locks_keys, all_ascending, 3))
+	{
+		printf("BUG (in lock_manager) :: could not initialize rs_locks_td\n");
+		exit(-1);
+	}
+	lckmgr_p->rs_locks_root_page_id = get_new_bplus_tree(lckmgr_p->rs_locks_td, lckmgr_p->lckmgr_engine->pam_p, lckmgr_p->lckmgr_engine->pmm_p, NULL, &abort_error);
+
+	{
+		data_type_info* dti = malloc(sizeof_tuple_data_type_info(5));
+		if(dti == NULL)
+			exit(-1);
+		initialize_tuple_data_type_info(dti, "wait_entry", 0, MAX_SERIALIZED_WAIT_ENTRY_SIZE, 5);
+
+		strcpy(dti->containees[0].field_name, "waiting_transaction");
+		dti->containees[0].al.type_info = UINT_NON_NULLABLE[sizeof(void*)];
+
+		strcpy(dti->containees[1].field_name, "waiting_task");
+		dti->containees[1].al.type_info = UINT_NON_NULLABLE[sizeof(void*)];
+
+		strcpy(dti->containees[2].field_name, "transaction");
+		dti->containees[2].al.type_info = UINT_NON_NULLABLE[sizeof(void*)];
+
+		strcpy(dti->containees[3].field_name, "resource_type");
+		dti->containees[3].al.type_info = UINT_NON_NULLABLE[4];
+
+		strcpy(dti->containees[4].field_name, "resource_id");
+		dti->containees[4].al.type_info = lckmgr_p->resource_id_type_info;
+
+		lckmgr_p->wait_record_def = malloc(sizeof(tuple_def));
+		if(lckmgr_p->wait_record_def == NULL)
+			exit(-1);
+		initialize_tuple_def(lckmgr_p->wait_record_def, dti);
+	}
+
+	lckmgr_p->waits_for_td = malloc(sizeof(bplus_tree_tuple_defs));
+	if(lckmgr_p->waits_for_td == NULL)
+		exit(-1);
+	if(!init_bplus_tree_tuple_definitions(lckmgr_p->waits_for_td, &(lckmgr_p->lckmgr_engine->pam_p->pas), lckmgr_p->wait_record_def, waits_for_keys, all_ascending, 5))
+	{
+		printf("BUG (in lock_manager) :: could not initialize waits_for_td\n");
+		exit(-1);
+	}
+	lckmgr_p->waits_for_root_page_id = get_new_bplus_tree(lckmgr_p->waits_for_td, lckmgr_p->lckmgr_engine->pam_p, lckmgr_p->lckmgr_engine->pmm_p, NULL, &abort_error);
+
+	lckmgr_p->waits_back_td = malloc(sizeof(bplus_tree_tuple_defs));
+	if(lckmgr_p->waits_back_td == NULL)
+		exit(-1);
+	if(!init_bplus_tree_tuple_definitions(lckmgr_p->waits_back_td, &(lckmgr_p->lckmgr_engine->pam_p->pas), lckmgr_p->wait_record_def, waits_back_keys, all_ascending, 5))
+	{
+		printf("BUG (in lock_manager) :: could not initialize waits_back_td\n");
+		exit(-1);
+	}
+	lckmgr_p->waits_back_root_page_id = get_new_bplus_tree(lckmgr_p->waits_back_td, lckmgr_p->lckmgr_engine->pam_p, lckmgr_p->lckmgr_engine->pmm_p, NULL, &abort_error);
+
+	for(uint32_t i = 0; i < LOCK_TABLE_SHARDS_COUNT; i++)
+	{
+		lock_table_shard* shard_p = &(lckmgr_p->lock_table_shards[i]);
+		pthread_mutex_init(&(shard_p->shard_latch), NULL);
+		if(!initialize_hashmap(&(shard_p->resource_heads), ELEMENTS_AS_RED_BLACK_BST, 64, &simple_hasher(hash_resource_lock_head), &simple_comparator(compare_resource_lock_head), offsetof(resource_lock_head, embed_node)))
+			exit(-1);
+		shard_p->wait_entries_count = 0;
+		pthread_mutex_init(&(shard_p->transaction_heads_latch), NULL);
+		if(!initialize_hashmap(&(shard_p->transaction_heads), ELEMENTS_AS_RED_BLACK_BST, 64, &simple_hasher(hash_transaction_lock_head), &simple_comparator(compare_transaction_lock_head), offsetof(transaction_lock_head, embed_node)))
+			exit(-1);
+		if(!initialize_hashmap(&(shard_p->escalation_counters), ELEMENTS_AS_RED_BLACK_BST, 64, &simple_hasher(hash_escalation_counter), &simple_comparator(compare_escalation_counter), offsetof(escalation_counter, embed_node)))
+			exit(-1);
+	}
+
+	atomic_init(&(lckmgr_p->in_memory_lock_entries_count), 0);
+	atomic_init(&(lckmgr_p->overflowed_lock_entries_count), 0);
+	lckmgr_p->wait_entries_count = 0;
+
+	pthread_mutex_init(&(lckmgr_p->wait_edges_lock), NULL);
+	if(!initialize_hashmap(&(lckmgr_p->wait_edges), ELEMENTS_AS_RED_BLACK_BST, 64, &simple_hasher(hash_wait_edge), &simple_comparator(compare_wait_edge), offsetof(wait_edge, embed_node)))
+		exit(-1);
+	if(!initialize_hashmap(&(lckmgr_p->deadlock_victims), ELEMENTS_AS_RED_BLACK_BST, 64, &simple_hasher(hash_deadlock_victim), &simple_comparator(compare_deadlock_victim), offsetof(deadlock_victim, embed_node)))
+		exit(-1);
+	lckmgr_p->wait_edges_inserted_count = 0;
+	lckmgr_p->dd_stats = (deadlock_detector_stats){};
+
+	lckmgr_p->deadlock_detection_period_us = deadlock_detection_period_us;
+	pthread_cond_init(&(lckmgr_p->deadlock_detector_wait), NULL);
+	lckmgr_p->stop_deadlock_detector = 0;
+	if(lckmgr_p->deadlock_detection_period_us > 0 && pthread_create(&(lckmgr_p->deadlock_detector), NULL, deadlock_detector, lckmgr_p))
+	{
+		printf("FAILED to start the deadlock_detector for the lock_manager\n");
+		exit(-1);
+	}
+}
+
+uint32_t register_lock_type_with_lock_manager(lock_manager* lckmgr_p, glock_matrix lock_matrix)
+{
+	// expand the container for lock matrix to hold 1 more element
+	lckmgr_p->lock_matrices = realloc(lckmgr_p->lock_matrices, sizeof(glock_matrix) * (lckmgr_p->locks_type_count + 1));
+	if(lckmgr_p->lock_matrices == NULL)
+		exit(-1);
+
+	lckmgr_p->lock_hierarchies = realloc(lckmgr_p->lock_hierarchies, sizeof(lock_hierarchy) * (lckmgr_p->locks_type_count + 1));
+	if(lckmgr_p->lock_hierarchies == NULL)
+		exit(-1);
+
+	// add the element to the end and return it's index, then increment the counter
+	lckmgr_p->lock_matrices[lckmgr_p->locks_type_count] = lock_matrix;
+	lckmgr_p->lock_hierarchies[lckmgr_p->locks_type_count] = (lock_hierarchy){.parent_resource_type = NO_PARENT_RESOURCE_TYPE};
+	return lckmgr_p->locks_type_count++;
+}
+
+void set_parent_for_lock_type_with_lock_manager(lock_manager* lckmgr_p, uint32_t resource_type, uint32_t parent_resource_type, uint8_t parent_resource_id_size, uint64_t escalation_threshold)
+{
+	// the parent must be registered before the child, this also prevents any cycles
+	if(resource_type >= lckmgr_p->locks_type_count || parent_resource_type >= resource_type)
+	{
+		printf("BUG (in lock_manager) :: parent_resource_type must be registered before the resource_type\n");
+		exit(-1);
+	}
+
+	if(!is_hierarchical_lock_type(lckmgr_p, parent_resource_type) || (!is_hierarchical_lock_type(lckmgr_p, resource_type) && lckmgr_p->lock_matrices[resource_type].lock_modes_count != RW_DB_LOCK.lock_modes_count))
+	{
+		printf("BUG (in lock_manager) :: parent must be a HIERARCHICAL_DB_LOCK, and the child either a RW_DB_LOCK or a HIERARCHICAL_DB_LOCK\n");
+		exit(-1);
+	}
+
+	if(parent_resource_id_size > MAX_RESOURCE_ID_SIZE)
+	{
+		printf("BUG (in lock_manager) :: parent_resource_id_size must not exceed MAX_RESOURCE_ID_SIZE\n");
+		exit(-1);
+	}
+
+	lckmgr_p->lock_hierarchies[resource_type] = (lock_hierarchy){.parent_resource_type = parent_resource_type, .parent_resource_id_size = parent_resource_id_size, .escalation_threshold = escalation_threshold};
+}
+
+uint32_t get_lock_mode_for_lock_from_lock_manager(lock_manager* lckmgr_p, void* transaction, void* task, uint32_t resource_type, uint8_t* resource_id, uint8_t resource_id_size)
+{
+	// task, for the transacton_id, is indeed calling this function, so it is no longer blocked or waiting, so remove it's wait entries
+	remove_all_wait_entries_for_task(lckmgr_p, transaction, task);
+
+	uint32_t lock_mode = get_single_lock_mode(lckmgr_p, transaction, resource_type, resource_id, resource_id_size);
+
+	// the lock may be implicitly granted by a lock on one of its ancestors, possibly after an escalation
+	if(lock_mode == NO_LOCK_HELD_LOCK_MODE)
+		get_lock_mode_granted_by_ancestors(lckmgr_p, transaction, resource_type, resource_id, 0, &lock_mode);
+
+	return lock_mode;
+}
+
+lock_result acquire_lock_with_lock_manager(lock_manager* lckmgr_p, void* transaction, void* task, uint32_t resource_type, uint8_t* resource_id, uint8_t resource_id_size, uint32_t new_lock_mode, int non_blocking)
+{
+	// task, for the transacton_id, is indeed calling this function, so it is no longer blocked or waiting, so remove it's wait entries
+	remove_all_wait_entries_for_task(lckmgr_p, transaction, task);
+
+	return acquire_lock_hierarchically(lckmgr_p, transaction, task, resource_type, resource_id, resource_id_size, new_lock_mode, non_blocking);
+}
+
+void release_lock_with_lock_manager(lock_manager* lckmgr_p, void* transaction, void* task, uint32_t resource_type, uint8_t* resource_id, uint8_t resource_id_size)
+{
+	// task, for the transacton_id, is indeed calling this function, so it is no longer blocked or waiting, so remove it's wait entries
+	remove_all_wait_entries_for_task(lckmgr_p, transaction, task);
+
+	if(release_single_lock(lckmgr_p, transaction, resource_type, resource_id, resource_id_size))
+		update_escalation_counter(lckmgr_p, transaction, resource_type, resource_id, -1);
+}
+
+int try_fast_acquire_lock_with_lock_manager(lock_manager* lckmgr_p, void* transaction, uint32_t resource_type, uint8_t* resource_id, uint8_t resource_id_size, uint32_t new_lock_mode, lock_result* result)
+{
+	return try_fast_acquire_lock_hierarchically(lckmgr_p, transaction, resource_type, resource_id, resource_id_size, new_lock_mode, result);
+}
+
+int try_fast_release_lock_with_lock_manager(lock_manager* lckmgr_p, void* transaction, uint32_t resource_type, uint8_t* resource_id, uint8_t resource_id_size)
+{
+	if(!try_fast_release_single_lock(lckmgr_p, transaction, resource_type, resource_id, resource_id_size))
+		return 0;
+
+	update_escalation_counter(lckmgr_p, transaction, resource_type, resource_id, -1);
+	return 1;
+}
+
+void discard_all_wait_entries_for_task_in_lock_manager(lock_manager* lckmgr_p, void* transaction, void* task)
+{
+	remove_all_wait_entries_for_task(lckmgr_p, transaction, task);
+}
+
+void discard_all_wait_entries_for_transaction_in_lock_manager(lock_manager* lckmgr_p, void* transaction)
+{
+	remove_all_wait_entries_for_transaction(lckmgr_p, transaction);
+}
+
+void conclude_all_business_with_lock_manager(lock_manager* lckmgr_p, void* transaction)
+{
+	// transacton_id, is indeed calling this function, so it is no longer expected to be blocked, it is aborting or committing, so we remove all it's wait_entries
+	remove_all_wait_entries_for_transaction(lckmgr_p, transaction);
 
 	// remove all lock_entries and wake up all waiters on those resources
+	remove_all_in_memory_lock_entries_and_wake_up_waiters(lckmgr_p, transaction);
 	remove_all_lock_entries_and_wake_up_waiters(lckmgr_p, transaction);
+
+	discard_all_escalation_counters_for_transaction(lckmgr_p, transaction);
+
+	// if it was a victim of a deadlock, it has now stepped down
+	pthread_mutex_lock(&(lckmgr_p->wait_edges_lock));
+	deadlock_victim* v_p = (deadlock_victim*) find_equals_in_hashmap(&(lckmgr_p->deadlock_victims), &((deadlock_victim){.transaction = transaction}));
+	if(v_p != NULL)
+	{
+		remove_from_hashmap(&(lckmgr_p->deadlock_victims), v_p);
+		free(v_p);
+	}
+	pthread_mutex_unlock(&(lckmgr_p->wait_edges_lock));
 }
 
 void debug_print_lock_manager_tables(lock_manager* lckmgr_p)
@@ -813,8 +2314,84 @@ void debug_print_lock_manager_tables(lock_manager* lckmgr_p)
 	printf("WAITS_BACK : \n\n");
 	print_bplus_tree(lckmgr_p->waits_back_root_page_id, 1, lckmgr_p->waits_back_td, lckmgr_p->lckmgr_engine->pam_p, NULL, &abort_error);
 	printf("-----------------------------------------------------------------------\n\n");
+
+	printf("IN_MEMORY_LOCKS (%"PRIu64" in memory, %"PRIu64" overflowed) : \n\n", atomic_load(&(lckmgr_p->in_memory_lock_entries_count)), atomic_load(&(lckmgr_p->overflowed_lock_entries_count)));
+	for(uint32_t i = 0; i < LOCK_TABLE_SHARDS_COUNT; i++)
+	{
+		lock_table_shard* shard_p = &(lckmgr_p->lock_table_shards[i]);
+		pthread_mutex_lock(&(shard_p->shard_latch));
+		for(const resource_lock_head* rlh_p = get_first_of_in_hashmap(&(shard_p->resource_heads), FIRST_OF_HASHMAP); rlh_p != NULL; rlh_p = get_next_of_in_hashmap(&(shard_p->resource_heads), rlh_p, ANY_IN_HASHMAP))
+		{
+			printf("%"PRIu32" : ", rlh_p->resource_type);
+			for(uint8_t j = 0; j < rlh_p->resource_id_size; j++)
+				printf("%02x", rlh_p->resource_id[j]);
+			printf(" ->");
+			for(const in_memory_lock_entry* imle_p = get_head_of_linkedlist(&(rlh_p->holders)); imle_p != NULL; imle_p = get_next_of_in_linkedlist(&(rlh_p->holders), imle_p))
+				printf(" (%p, %"PRIu32")", imle_p->transaction, imle_p->lock_mode);
+			printf("\n");
+		}
+		pthread_mutex_unlock(&(shard_p->shard_latch));
+	}
+	printf("-----------------------------------------------------------------------\n\n");
+}
+
+deadlock_detector_stats get_deadlock_detector_stats_from_lock_manager(lock_manager* lckmgr_p)
+{
+	pthread_mutex_lock(&(lckmgr_p->wait_edges_lock));
+	deadlock_detector_stats dd_stats = lckmgr_p->dd_stats;
+	pthread_mutex_unlock(&(lckmgr_p->wait_edges_lock));
+	return dd_stats;
+}
+
+void deinitialize_lock_manager(lock_manager* lckmgr_p)
+{
+	if(lckmgr_p->deadlock_detection_period_us > 0)
+	{
+		pthread_mutex_lock(&(lckmgr_p->wait_edges_lock));
+		lckmgr_p->stop_deadlock_detector = 1;
+		pthread_cond_broadcast(&(lckmgr_p->deadlock_detector_wait));
+		pthread_mutex_unlock(&(lckmgr_p->wait_edges_lock));
+
+		pthread_join(lckmgr_p->deadlock_detector, NULL);
+	}
+
+	// all of them are empty, if all the transactions have concluded
+	for(uint32_t i = 0; i < LOCK_TABLE_SHARDS_COUNT; i++)
+	{
+		lock_table_shard* shard_p = &(lckmgr_p->lock_table_shards[i]);
+		remove_all_from_hashmap(&(shard_p->resource_heads), &((notifier_interface){NULL, notify_removal_by_free}));
+		deinitialize_hashmap(&(shard_p->resource_heads));
+		remove_all_from_hashmap(&(shard_p->transaction_heads), &((notifier_interface){NULL, notify_removal_by_free}));
+		deinitialize_hashmap(&(shard_p->transaction_heads));
+		remove_all_from_hashmap(&(shard_p->escalation_counters), &((notifier_interface){NULL, notify_removal_by_free}));
+		deinitialize_hashmap(&(shard_p->escalation_counters));
+		pthread_mutex_destroy(&(shard_p->shard_latch));
+		pthread_mutex_destroy(&(shard_p->transaction_heads_latch));
+	}
+
+	remove_all_from_hashmap(&(lckmgr_p->wait_edges), &((notifier_interface){NULL, notify_removal_by_free}));
+	deinitialize_hashmap(&(lckmgr_p->wait_edges));
+	remove_all_from_hashmap(&(lckmgr_p->deadlock_victims), &((notifier_interface){NULL, notify_removal_by_free}));
+	deinitialize_hashmap(&(lckmgr_p->deadlock_victims));
+	pthread_mutex_destroy(&(lckmgr_p->wait_edges_lock));
+	pthread_cond_destroy(&(lckmgr_p->deadlock_detector_wait));
+
+	free(lckmgr_p->lock_matrices);
+	free(lckmgr_p->lock_hierarchies);
 }
 
+const glock_matrix HIERARCHICAL_DB_LOCK = {
+	.lock_modes_count = 5,// there are 5 modes
+	.matrix = (uint8_t[GLOCK_MATRIX_SIZE(5)]){
+	//  IS IX S  SIX X
+		1,             // IS
+		1, 1,          // IX
+		1, 0, 1,       // S
+		1, 0, 0, 0,    // SIX
+		0, 0, 0, 0, 0, // X
+	},
+};
+
 const glock_matrix RW_DB_LOCK = {
 	.lock_modes_count = 2,// there are 2 modes
 	.matrix = (uint8_t[GLOCK_MATRIX_SIZE(2)]){
@@ -0,0 +1,107 @@
+#include<rhendb/loser_tree.h>
+
+#include<stdio.h>
+#include<stdlib.h>
+
+void initialize_loser_tree(loser_tree* lt_p, uint32_t leaves_count, const void* context, int (*compare_leaves)(const void* context, uint32_t leaf1, uint32_t leaf2))
+{
+	if(leaves_count == 0)
+	{
+		printf("leaves_count can not be 0 for loser_tree\n");
+		exit(-1);
+	}
+
+	lt_p->leaves_count = leaves_count;
+	lt_p->nodes = malloc(sizeof(uint32_t) * leaves_count);
+	lt_p->is_exhausted = calloc(leaves_count, sizeof(uint8_t));
+	if(lt_p->nodes == NULL || lt_p->is_exhausted == NULL)
+	{
+		printf("FAILED to allocate memory for loser_tree\n");
+		exit(-1);
+	}
+	lt_p->context = context;
+	lt_p->compare_leaves = compare_leaves;
+
+	for(uint32_t i = 0; i < leaves_count; i++)
+		lt_p->nodes[i] = i;
+}
+
+void mark_exhausted_in_loser_tree(loser_tree* lt_p, uint32_t leaf)
+{
+	lt_p->is_exhausted[leaf] = 1;
+}
+
+// returns 1, if leaf1 wins over leaf2
+static int wins_over(const loser_tree* lt_p, uint32_t leaf1, uint32_t leaf2)
+{
+	if(lt_p->is_exhausted[leaf1])
+		return 0;
+	if(lt_p->is_exhausted[leaf2])
+		return 1;
+
+	int cmp = lt_p->compare_leaves(lt_p->context, leaf1, leaf2);
+	return (cmp < 0) || ((cmp == 0) && (leaf1 < leaf2));
+}
+
+// plays all the matches in the subtree at position, storing the losers and returning the winner
+static uint32_t build_subtree(loser_tree* lt_p, uint32_t position)
+{
+	if(position >= lt_p->leaves_count)
+		return position - lt_p->leaves_count;
+
+	uint32_t left_winner = build_subtree(lt_p, 2 * position);
+	uint32_t right_winner = build_subtree(lt_p, 2 * position + 1);
+
+	if(wins_over(lt_p, left_winner, right_winner))
+	{
+		lt_p->nodes[position] = right_winner;
+		return left_winner;
+	}
+	else
+	{
+		lt_p->nodes[position] = left_winner;
+		return right_winner;
+	}
+}
+
+void build_loser_tree(loser_tree* lt_p)
+{
+	if(lt_p->leaves_count == 1)
+		lt_p->nodes[0] = 0;
+	else
+		lt_p->nodes[0] = build_subtree(lt_p, 1);
+}
+
+uint32_t get_winner_of_loser_tree(const loser_tree* lt_p)
+{
+	return lt_p->nodes[0];
+}
+
+int is_exhausted_loser_tree(const loser_tree* lt_p)
+{
+	return lt_p->is_exhausted[lt_p->nodes[0]];
+}
+
+void replay_winner_of_loser_tree(loser_tree* lt_p)
+{
+	uint32_t winner = lt_p->nodes[0];
+	for(uint32_t position = (lt_p->leaves_count + winner) / 2; position > 0; position /= 2)
+	{
+		// the loser stored here, wins this time, so it carries on up the tree and the winner stays back as the loser
+		if(wins_over(lt_p, lt_p->nodes[position], winner))
+		{
+			uint32_t temp = lt_p->nodes[position];
+			lt_p->nodes[position] = winner;
+			winner = temp;
+		}
+	}
+	lt_p->nodes[0] = winner;
+}
+
+void deinitialize_loser_tree(loser_tree* lt_p)
+{
+	free(lt_p->nodes);
+	free(lt_p->is_exhausted);
+	lt_p->nodes = NULL;
+	lt_p->is_exhausted = NULL;
+}
@@ -16,8 +16,9 @@ data_type_info* get_mvcc_header_type_info(uint8_t transaction_id_width)
 	strcpy(dti_p->containees[1].field_name, "is_xmin_aborted");
 	dti_p->containees[1].al.type_info = BIT_FIELD_NON_NULLABLE[1];
 
+	// transaction_ids that fit in 8 bytes are stored as UINTs, as they decode into a single uint64_t, without going through a uint256
 	strcpy(dti_p->containees[2].field_name, "xmin");
-	dti_p->containees[2].al.type_info = LARGE_UINT_NULLABLE[transaction_id_width];
+	dti_p->containees[2].al.type_info = (transaction_id_width <= 8) ? UINT_NULLABLE[transaction_id_width] : LARGE_UINT_NULLABLE[transaction_id_width];
 
 	strcpy(dti_p->containees[3].field_name, "is_xmax_committed");
 	dti_p->containees[3].al.type_info = BIT_FIELD_NON_NULLABLE[1];
@@ -26,15 +27,34 @@ data_type_info* get_mvcc_header_type_info(uint8_t transaction_id_width)
 	dti_p->containees[4].al.type_info = BIT_FIELD_NON_NULLABLE[1];
 
 	strcpy(dti_p->containees[5].field_name, "xmax");
-	dti_p->containees[5].al.type_info = LARGE_UINT_NULLABLE[transaction_id_width];
+	dti_p->containees[5].al.type_info = (transaction_id_width <= 8) ? UINT_NULLABLE[transaction_id_width] : LARGE_UINT_NULLABLE[transaction_id_width];
 
 	return dti_p;
 }
 
+// xmin and xmax are both either UINTs or LARGE_UINTs, see get_mvcc_header_type_info()
+static int has_narrow_transaction_ids(const tuple_def* mvcchdr_def)
+{
+	return get_type_info_for_element_from_tuple_def(mvcchdr_def, STATIC_POSITION(2))->type == UINT;
+}
+
+int is_frozen_transaction_id_with_hints(const transaction_id_with_hints* transaction_id)
+{
+	return transaction_id->is_committed && transaction_id->is_aborted;
+}
+
+void freeze_transaction_id_with_hints(transaction_id_with_hints* transaction_id)
+{
+	transaction_id->is_committed = 1;
+	transaction_id->is_aborted = 1;
+}
+
 void read_mvcc_header(mvcc_header* mvcchdr_p, const void* mvcchdr_tup, const tuple_def* mvcchdr_def)
 {
 	datum uval;
 
+	int is_narrow = has_narrow_transaction_ids(mvcchdr_def);
+
 	if(!get_value_from_element_from_tuple(&uval, mvcchdr_def, STATIC_POSITION(2), mvcchdr_tup))
 		exit(-1);
 	if(is_datum_NULL(&uval))
@@ -44,7 +64,7 @@ void read_mvcc_header(mvcc_header* mvcchdr_p, const void* mvcchdr_tup, const tup
 	else
 	{
 		mvcchdr_p->is_xmin_NULL = 0;
-		mvcchdr_p->xmin.transaction_id = uval.large_uint_value;
+		mvcchdr_p->xmin.transaction_id = is_narrow ? get_uint256(uval.uint_value) : uval.large_uint_value;
 
 		if(!get_value_from_element_from_tuple(&uval, mvcchdr_def, STATIC_POSITION(0), mvcchdr_tup))
 			exit(-1);
@@ -64,7 +84,7 @@ void read_mvcc_header(mvcc_header* mvcchdr_p, const void* mvcchdr_tup, const tup
 	else
 	{
 		mvcchdr_p->is_xmax_NULL = 0;
-		mvcchdr_p->xmax.transaction_id = uval.large_uint_value;
+		mvcchdr_p->xmax.transaction_id = is_narrow ? get_uint256(uval.uint_value) : uval.large_uint_value;
 
 		if(!get_value_from_element_from_tuple(&uval, mvcchdr_def, STATIC_POSITION(3), mvcchdr_tup))
 			exit(-1);
@@ -80,6 +100,8 @@ void write_mvcc_header(void* mvcchdr_tup, const tuple_def* mvcchdr_def, const mv
 {
 	init_tuple(mvcchdr_def, mvcchdr_tup);
 
+	int is_narrow = has_narrow_transaction_ids(mvcchdr_def);
+
 	if(mvcchdr_p->is_xmin_NULL)
 	{
 		if(!set_element_in_tuple(mvcchdr_def, STATIC_POSITION(2), mvcchdr_tup, NULL_DATUM, 0))
@@ -93,7 +115,7 @@ void write_mvcc_header(void* mvcchdr_tup, const tuple_def* mvcchdr_def, const mv
 		if(!set_element_in_tuple(mvcchdr_def, STATIC_POSITION(1), mvcchdr_tup, &((datum){.bit_field_value = mvcchdr_p->xmin.is_aborted}), 0))
 			exit(-1);
 
-		if(!set_element_in_tuple(mvcchdr_def, STATIC_POSITION(2), mvcchdr_tup, &((datum){.large_uint_value = mvcchdr_p->xmin.transaction_id}), 0))
+		if(!set_element_in_tuple(mvcchdr_def, STATIC_POSITION(2), mvcchdr_tup, is_narrow ? &((datum){.uint_value = mvcchdr_p->xmin.transaction_id.limbs[0]}) : &((datum){.large_uint_value = mvcchdr_p->xmin.transaction_id}), 0))
 			exit(-1);
 	}
 
@@ -110,7 +132,7 @@ void write_mvcc_header(void* mvcchdr_tup, const tuple_def* mvcchdr_def, const mv
 		if(!set_element_in_tuple(mvcchdr_def, STATIC_POSITION(4), mvcchdr_tup, &((datum){.bit_field_value = mvcchdr_p->xmax.is_aborted}), 0))
 			exit(-1);
 
-		if(!set_element_in_tuple(mvcchdr_def, STATIC_POSITION(5), mvcchdr_tup, &((datum){.large_uint_value = mvcchdr_p->xmax.transaction_id}), 0))
+		if(!set_element_in_tuple(mvcchdr_def, STATIC_POSITION(5), mvcchdr_tup, is_narrow ? &((datum){.uint_value = mvcchdr_p->xmax.transaction_id.limbs[0]}) : &((datum){.large_uint_value = mvcchdr_p->xmax.transaction_id}), 0))
 			exit(-1);
 	}
 }
@@ -138,7 +160,7 @@ void print_mvcc_header(const mvcc_header* mvcchdr_p)
 
 transaction_status fetch_status_for_transaction_id_with_hints(transaction_id_with_hints* transaction_id, transaction_status_getter* tsg_p, int* were_hints_updated)
 {
-	// first try and answer from hints if possible
+	// first try and answer from hints if possible, a frozen one is committed too
 	if(transaction_id->is_committed)
 		return TX_COMMITTED;
 
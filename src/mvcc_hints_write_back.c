@@ -0,0 +1,131 @@
+#include<rhendb/mvcc_hints_write_back.h>
+
+#include<tupleindexer/heap_page/heap_page.h>
+
+#include<tuplestore/tuple.h>
+
+#include<stdio.h>
+#include<stdlib.h>
+
+void initialize_mvcc_hints_write_back(mvcc_hints_write_back* mhwb_p)
+{
+	mhwb_p->page_id = 0;
+	mhwb_p->pending_count = 0;
+	mhwb_p->pending_capacity = 0;
+	mhwb_p->pending = NULL;
+}
+
+void append_to_mvcc_hints_write_back(mvcc_hints_write_back* mhwb_p, uint64_t page_id, uint32_t tuple_index, const mvcc_header* hdr)
+{
+	if(mhwb_p->pending_count > 0 && mhwb_p->page_id != page_id)
+	{
+		printf("BUG (in mvcc_hints_write_back) :: hints for a different page appended, before flushing the pending ones\n");
+		exit(-1);
+	}
+
+	if(mhwb_p->pending_count == mhwb_p->pending_capacity)
+	{
+		mhwb_p->pending_capacity = (mhwb_p->pending_capacity == 0) ? 16 : (2 * mhwb_p->pending_capacity);
+		mhwb_p->pending = realloc(mhwb_p->pending, sizeof(pending_mvcc_hints) * mhwb_p->pending_capacity);
+		if(mhwb_p->pending == NULL)
+		{
+			printf("FAILED to allocate memory for mvcc_hints_write_back\n");
+			exit(-1);
+		}
+	}
+
+	mhwb_p->page_id = page_id;
+	mhwb_p->pending[mhwb_p->pending_count++] = (pending_mvcc_hints){.tuple_index = tuple_index, .hdr = (*hdr)};
+}
+
+// copies the discovered hint into curr, only if they are for the same transaction_id and curr has none of them set, returns 1 if curr was changed
+static int merge_hints(transaction_id_with_hints* curr, const transaction_id_with_hints* discovered)
+{
+	if(curr->is_committed || curr->is_aborted)
+		return 0;
+	if(!(discovered->is_committed || discovered->is_aborted))
+		return 0;
+	if(compare_uint256(curr->transaction_id, discovered->transaction_id) != 0)
+		return 0;
+
+	curr->is_committed = discovered->is_committed;
+	curr->is_aborted = discovered->is_aborted;
+	return 1;
+}
+
+void flush_mvcc_hints_write_back(mvcc_hints_write_back* mhwb_p, rage_engine* engine, const tuple_def* partition_tuple_def, const tuple_def* mvcc_def)
+{
+	if(mhwb_p->pending_count == 0)
+		return;
+
+	uint64_t page_latches_to_be_borrowed = 0;
+	int abort_error = 0;
+	void* min_tx_id = engine->allot_new_sub_transaction_id(engine->context, page_latches_to_be_borrowed);
+
+	persistent_page ppage = acquire_persistent_page_with_lock(engine->pam_p, min_tx_id, mhwb_p->page_id, WRITE_LOCK, &abort_error);
+	if(abort_error)
+		goto ABORT_ERROR;
+
+	for(uint32_t i = 0; i < mhwb_p->pending_count; i++)
+	{
+		const pending_mvcc_hints* p = &(mhwb_p->pending[i]);
+
+		// the tuple could have been vaccummed, in the meantime
+		if(!exists_tuple_on_persistent_page(&ppage, engine->pam_p->pas.page_size, &(partition_tuple_def->size_def), p->tuple_index))
+			continue;
+
+		const void* record = get_nth_tuple_on_persistent_page(&ppage, engine->pam_p->pas.page_size, &(partition_tuple_def->size_def), p->tuple_index);
+		if(record == NULL)
+			continue;
+
+		datum mvcc_hdr_datum;
+		get_value_from_element_from_tuple(&mvcc_hdr_datum, partition_tuple_def, STATIC_POSITION(0), record);
+
+		mvcc_header curr;
+		read_mvcc_header(&curr, mvcc_hdr_datum.tuple_value, mvcc_def);
+
+		int was_changed = 0;
+		if(!curr.is_xmin_NULL && !p->hdr.is_xmin_NULL)
+			was_changed = merge_hints(&(curr.xmin), &(p->hdr.xmin)) || was_changed;
+		if(!curr.is_xmax_NULL && !p->hdr.is_xmax_NULL)
+			was_changed = merge_hints(&(curr.xmax), &(p->hdr.xmax)) || was_changed;
+
+		if(!was_changed)
+			continue;
+
+		// keep the serialized mvcc buffer in its own block so its variable length type does not span the goto
+		{
+			char mvcc_hdr_serialized[get_maximum_tuple_size(mvcc_def)];
+			write_mvcc_header(mvcc_hdr_serialized, mvcc_def, &curr);
+			set_element_in_tuple_in_place_on_persistent_page(engine->pmm_p, min_tx_id, &ppage, engine->pam_p->pas.page_size, partition_tuple_def, p->tuple_index, STATIC_POSITION(0), &((datum){.tuple_value = mvcc_hdr_serialized}), &abort_error);
+		}
+		if(abort_error)
+			goto ABORT_ERROR;
+	}
+
+	release_lock_on_persistent_page(engine->pam_p, min_tx_id, &ppage, NONE_OPTION, &abort_error);
+	if(abort_error)
+		goto ABORT_ERROR;
+
+	// hints need not survive a crash, so they are never flushed
+	engine->complete_sub_transaction(engine->context, min_tx_id, 0, NULL, 0, &page_latches_to_be_borrowed);
+
+	mhwb_p->pending_count = 0;
+	return;
+
+	ABORT_ERROR:;
+	if(!is_persistent_page_NULL(&ppage, engine->pam_p))
+		release_lock_on_persistent_page(engine->pam_p, min_tx_id, &ppage, NONE_OPTION, &abort_error);
+	engine->complete_sub_transaction(engine->context, min_tx_id, 0, NULL, 0, &page_latches_to_be_borrowed);
+
+	// the hints are only advisory, so they are just dropped, the next reader will discover them again
+	mhwb_p->pending_count = 0;
+}
+
+void deinitialize_mvcc_hints_write_back(mvcc_hints_write_back* mhwb_p)
+{
+	free(mhwb_p->pending);
+	mhwb_p->pending = NULL;
+	mhwb_p->pending_count = 0;
+	mhwb_p->pending_capacity = 0;
+}
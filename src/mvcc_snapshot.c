@@ -19,15 +19,34 @@ mvcc_snapshot* get_new_mvcc_snapshot()
 
 	mvccsnp_p->has_self_transaction_id = 0;
 
+	atomic_init(&(mvccsnp_p->reference_count), 1);
+	mvccsnp_p->generation = 0;
+
+	mvccsnp_p->has_compact_in_progress_transaction_ids = 0;
+	mvccsnp_p->are_64_bit_transaction_ids = 0;
+	mvccsnp_p->in_progress_bitmap = NULL;
+	mvccsnp_p->in_progress_offsets = NULL;
+
 	initialize_llnode(&(mvccsnp_p->embed_node));
 
 	return mvccsnp_p;
 }
 
+static void remove_compact_in_progress_transaction_ids(mvcc_snapshot* mvccsnp_p)
+{
+	free(mvccsnp_p->in_progress_bitmap);
+	free(mvccsnp_p->in_progress_offsets);
+	mvccsnp_p->in_progress_bitmap = NULL;
+	mvccsnp_p->in_progress_offsets = NULL;
+	mvccsnp_p->has_compact_in_progress_transaction_ids = 0;
+	mvccsnp_p->are_64_bit_transaction_ids = 0;
+}
+
 void begin_taking_mvcc_snapshot(mvcc_snapshot* mvccsnp_p, uint256 least_unassigned_transaction_id)
 {
 	mvccsnp_p->least_unassigned_transaction_id = least_unassigned_transaction_id;
 	remove_all_from_sorted_transaction_ids_list(&(mvccsnp_p->in_progress_transaction_ids));
+	remove_compact_in_progress_transaction_ids(mvccsnp_p);
 }
 
 int insert_in_progress_transaction_in_mvcc_snapshot(mvcc_snapshot* mvccsnp_p, uint256 in_progress_transaction_id)
@@ -51,6 +70,45 @@ void finalize_mvcc_snapshot(mvcc_snapshot* mvccsnp_p)
 {
 	// just shrink to fit
 	shrink_sorted_transaction_ids_list(&(mvccsnp_p->in_progress_transaction_ids));
+
+	cy_uint in_progress_count = get_element_count_sorted_transaction_ids_list(&(mvccsnp_p->in_progress_transaction_ids));
+
+	mvccsnp_p->min_in_progress_transaction_id = (in_progress_count > 0) ? (*get_from_front_of_sorted_transaction_ids_list(&(mvccsnp_p->in_progress_transaction_ids), 0)) : mvccsnp_p->least_unassigned_transaction_id;
+
+	uint256 range;
+	sub_uint256(&range, mvccsnp_p->least_unassigned_transaction_id, mvccsnp_p->min_in_progress_transaction_id);
+	if(range.limbs[1] != 0 || range.limbs[2] != 0 || range.limbs[3] != 0)
+		return;
+
+	if(in_progress_count > 0)
+	{
+		if(range.limbs[0] <= MAX_IN_PROGRESS_BITMAP_BITS)
+		{
+			mvccsnp_p->in_progress_bitmap = calloc((range.limbs[0] + 63) / 64, sizeof(uint64_t));
+			if(mvccsnp_p->in_progress_bitmap == NULL)
+				exit(-1);
+		}
+		else
+		{
+			mvccsnp_p->in_progress_offsets = malloc(sizeof(uint64_t) * in_progress_count);
+			if(mvccsnp_p->in_progress_offsets == NULL)
+				exit(-1);
+		}
+
+		for(cy_uint i = 0; i < in_progress_count; i++)
+		{
+			uint256 offset;
+			sub_uint256(&offset, *get_from_front_of_sorted_transaction_ids_list(&(mvccsnp_p->in_progress_transaction_ids), i), mvccsnp_p->min_in_progress_transaction_id);
+
+			if(mvccsnp_p->in_progress_bitmap != NULL)
+				mvccsnp_p->in_progress_bitmap[offset.limbs[0] / 64] |= (UINT64_C(1) << (offset.limbs[0] % 64));
+			else
+				mvccsnp_p->in_progress_offsets[i] = offset.limbs[0];
+		}
+	}
+
+	mvccsnp_p->has_compact_in_progress_transaction_ids = 1;
+	mvccsnp_p->are_64_bit_transaction_ids = (mvccsnp_p->least_unassigned_transaction_id.limbs[1] == 0 && mvccsnp_p->least_unassigned_transaction_id.limbs[2] == 0 && mvccsnp_p->least_unassigned_transaction_id.limbs[3] == 0);
 }
 
 int set_self_transaction_id_in_mvcc_snapshot(mvcc_snapshot* mvccsnp_p, uint256 self_transaction_id)
@@ -75,12 +133,58 @@ int is_self_transaction_for_mvcc_snapshot(const mvcc_snapshot* mvccsnp_p, uint25
 	return (mvccsnp_p->has_self_transaction_id) && are_equal_uint256(transaction_id, mvccsnp_p->self_transaction_id);
 }
 
+// offset must be lesser than (least_unassigned_transaction_id - min_in_progress_transaction_id), and the snapshot must have compact in_progress_transaction_ids
+static int is_in_progress_offset(const mvcc_snapshot* mvccsnp_p, uint64_t offset)
+{
+	if(mvccsnp_p->in_progress_bitmap != NULL)
+		return (mvccsnp_p->in_progress_bitmap[offset / 64] >> (offset % 64)) & 1;
+
+	if(mvccsnp_p->in_progress_offsets == NULL)
+		return 0;
+
+	cy_uint l = 0;
+	cy_uint h = get_element_count_sorted_transaction_ids_list(&(mvccsnp_p->in_progress_transaction_ids));
+	while(l < h)
+	{
+		cy_uint m = l + (h - l) / 2;
+		if(mvccsnp_p->in_progress_offsets[m] < offset)
+			l = m + 1;
+		else
+			h = m;
+	}
+	return (l < get_element_count_sorted_transaction_ids_list(&(mvccsnp_p->in_progress_transaction_ids))) && (mvccsnp_p->in_progress_offsets[l] == offset);
+}
+
 int was_completed_transaction_at_mvcc_snapshot(const mvcc_snapshot* mvccsnp_p, uint256 transaction_id)
 {
 	// self_transaction_id of the snapshot is never completed
 	if(is_self_transaction_for_mvcc_snapshot(mvccsnp_p, transaction_id))
 		return 0;
 
+	// compare them as uint64_t-s, if they all fit in them
+	if(mvccsnp_p->are_64_bit_transaction_ids)
+	{
+		if(transaction_id.limbs[1] != 0 || transaction_id.limbs[2] != 0 || transaction_id.limbs[3] != 0)
+			return 0;
+		if(transaction_id.limbs[0] >= mvccsnp_p->least_unassigned_transaction_id.limbs[0])
+			return 0;
+		if(transaction_id.limbs[0] < mvccsnp_p->min_in_progress_transaction_id.limbs[0])
+			return 1;
+		return !is_in_progress_offset(mvccsnp_p, transaction_id.limbs[0] - mvccsnp_p->min_in_progress_transaction_id.limbs[0]);
+	}
+
+	if(mvccsnp_p->has_compact_in_progress_transaction_ids)
+	{
+		if(compare_uint256(transaction_id, mvccsnp_p->least_unassigned_transaction_id) >= 0)
+			return 0;
+		if(compare_uint256(transaction_id, mvccsnp_p->min_in_progress_transaction_id) < 0)
+			return 1;
+
+		uint256 offset;
+		sub_uint256(&offset, transaction_id, mvccsnp_p->min_in_progress_transaction_id);
+		return !is_in_progress_offset(mvccsnp_p, offset.limbs[0]);
+	}
+
 	index_accessed_interface iai = get_index_accessed_interface_for_front_of_sorted_transaction_ids_list((sorted_transaction_ids_list*)(&(mvccsnp_p->in_progress_transaction_ids)));
 
 	// (transaction_id < mvccsnp_p->least_unassigned_transaction_id) && (transaction_id not in mvccsnp_p->in_progress_transaction_ids)
@@ -88,15 +192,40 @@ int was_completed_transaction_at_mvcc_snapshot(const mvcc_snapshot* mvccsnp_p, u
 		(INVALID_INDEX == binary_search_in_sorted_iai(&iai, 0, get_element_count_sorted_transaction_ids_list(&(mvccsnp_p->in_progress_transaction_ids)) - 1, &transaction_id, &simple_comparator(compare_uint256_with_ptrs), FIRST_OCCURENCE)));
 }
 
+mvcc_snapshot* clone_mvcc_snapshot(const mvcc_snapshot* mvccsnp_p)
+{
+	mvcc_snapshot* clone_p = get_new_mvcc_snapshot();
+
+	begin_taking_mvcc_snapshot(clone_p, mvccsnp_p->least_unassigned_transaction_id);
+	for(cy_uint i = 0; i < get_element_count_sorted_transaction_ids_list(&(mvccsnp_p->in_progress_transaction_ids)); i++)
+	{
+		if(!insert_in_progress_transaction_in_mvcc_snapshot(clone_p, *get_from_front_of_sorted_transaction_ids_list(&(mvccsnp_p->in_progress_transaction_ids), i)))
+			exit(-1);
+	}
+	finalize_mvcc_snapshot(clone_p);
+
+	if(mvccsnp_p->has_self_transaction_id)
+		set_self_transaction_id_in_mvcc_snapshot(clone_p, mvccsnp_p->self_transaction_id);
+
+	clone_p->generation = mvccsnp_p->generation;
+
+	return clone_p;
+}
+
 void delete_mvcc_snapshot(mvcc_snapshot* mvccsnp_p)
 {
 	deinitialize_sorted_transaction_ids_list(&(mvccsnp_p->in_progress_transaction_ids));
+	remove_compact_in_progress_transaction_ids(mvccsnp_p);
 
 	free(mvccsnp_p);
 }
 
 int are_changes_for_transaction_id_visible_at_mvcc_snapshot(const mvcc_snapshot* mvccsnp_p, transaction_id_with_hints* transaction_id, transaction_status_getter* tsg_p, int* were_hints_updated)
 {
+	// a frozen transaction_id committed before any active snapshot was taken
+	if(is_frozen_transaction_id_with_hints(transaction_id))
+		return 1;
+
 	// you can only see your changes OR changes of transactions that committed before you
 	return is_self_transaction_for_mvcc_snapshot(mvccsnp_p, transaction_id->transaction_id) ||
 		(was_completed_transaction_at_mvcc_snapshot(mvccsnp_p, transaction_id->transaction_id) &&
@@ -210,4 +339,31 @@ int can_vaccum_tuple_for_mvcc(mvcc_header* mvcchdr_p, transaction_status_getter*
 		return 1;
 
 	return 0;
+}
+
+int freeze_tuple_for_mvcc(mvcc_header* mvcchdr_p, transaction_status_getter* tsg_p, uint256 vaccum_horizon_transaction_id, int* were_hints_updated)
+{
+	int was_frozen = 0;
+
+	// a committed xmin below the vaccum horizon is visible to every active and future snapshot
+	if((!mvcchdr_p->is_xmin_NULL)
+		&& (!is_frozen_transaction_id_with_hints(&(mvcchdr_p->xmin)))
+		&& (compare_uint256(mvcchdr_p->xmin.transaction_id, vaccum_horizon_transaction_id) < 0)
+		&& (fetch_status_for_transaction_id_with_hints(&(mvcchdr_p->xmin), tsg_p, were_hints_updated) == TX_COMMITTED))
+	{
+		freeze_transaction_id_with_hints(&(mvcchdr_p->xmin));
+		was_frozen = 1;
+	}
+
+	// an aborted xmax below the vaccum horizon never deleted the tuple, so it can be forgotten
+	// a committed one would have made the tuple vaccummable, and an in-progress one can not be below the vaccum horizon
+	if((!mvcchdr_p->is_xmax_NULL)
+		&& (compare_uint256(mvcchdr_p->xmax.transaction_id, vaccum_horizon_transaction_id) < 0)
+		&& (fetch_status_for_transaction_id_with_hints(&(mvcchdr_p->xmax), tsg_p, were_hints_updated) == TX_ABORTED))
+	{
+		mvcchdr_p->is_xmax_NULL = 1;
+		was_frozen = 1;
+	}
+
+	return was_frozen;
 }
\ No newline at end of file
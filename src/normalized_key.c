@@ -0,0 +1,171 @@
+#include<rhendb/normalized_key.h>
+
+#include<string.h>
+#include<math.h>
+
+// number of bytes that the value of a fixed width element takes in the prefix, 0 if it is not a fixed width element that we can encode
+static uint32_t get_fixed_value_width(const data_type_info* dti)
+{
+	switch(dti->type)
+	{
+		case BIT_FIELD :
+			return (dti->bit_field_size + 7) / 8;
+		case UINT :
+		case INT :
+			return dti->size;
+		case FLOAT :
+			return (dti->size == sizeof(float) || dti->size == sizeof(double)) ? dti->size : 0;
+		default :
+			return 0;
+	}
+}
+
+// an inline STRING is compared element by element as unsigned bytes, so its bytes are already memcomparable
+static int is_encodable_string(const data_type_info* dti)
+{
+	return dti->type == STRING && dti->containee != NULL && dti->containee->type == UINT && dti->containee->size == 1;
+}
+
+static int is_encodable_element(const data_type_info* dti)
+{
+	uint32_t width = get_fixed_value_width(dti);
+	return is_encodable_string(dti) || ((width > 0) && (1 + width <= NORMALIZED_KEY_PREFIX_SIZE));
+}
+
+// returns the fixed width value bits, that order as unsigned integers in the same order as the datums themselves
+// is_orderable is reset for a NaN, as it does not have a place in this ordering
+static uint64_t get_orderable_bits(const datum* uval, const data_type_info* dti, int* is_orderable)
+{
+	switch(dti->type)
+	{
+		case BIT_FIELD :
+			return uval->bit_field_value;
+		case UINT :
+			return uval->uint_value;
+		case INT : // flip the sign bit of the dti->size wide 2's complement value, only the lower dti->size bytes are used
+			return ((uint64_t)(uval->int_value)) ^ (UINT64_C(1) << (dti->size * 8 - 1));
+		case FLOAT :
+		{
+			if(dti->size == sizeof(float))
+			{
+				float f = uval->float_value;
+				if(isnan(f))
+				{
+					(*is_orderable) = 0;
+					return 0;
+				}
+				if(f == 0.0f) // -0.0 and 0.0 compare equal
+					f = 0.0f;
+				uint32_t bits;
+				memcpy(&bits, &f, sizeof(bits));
+				return (bits >> 31) ? ((uint32_t)(~bits)) : (bits | (UINT32_C(1) << 31));
+			}
+			else
+			{
+				double d = uval->double_value;
+				if(isnan(d))
+				{
+					(*is_orderable) = 0;
+					return 0;
+				}
+				if(d == 0.0)
+					d = 0.0;
+				uint64_t bits;
+				memcpy(&bits, &d, sizeof(bits));
+				return (bits >> 63) ? (~bits) : (bits | (UINT64_C(1) << 63));
+			}
+		}
+		default :
+		{
+			(*is_orderable) = 0;
+			return 0;
+		}
+	}
+}
+
+int can_build_normalized_key(data_type_info const * const * key_dtis, uint32_t element_count)
+{
+	return (element_count > 0) && is_encodable_element(key_dtis[0]);
+}
+
+void build_normalized_key(normalized_key* nk, const datum* keys, data_type_info const * const * key_dtis, const compare_direction* cmp_dir, uint32_t element_count)
+{
+	memset(nk->prefix, 0, NORMALIZED_KEY_PREFIX_SIZE);
+	nk->prefix_size = 0;
+	nk->is_complete = 0;
+
+	uint32_t size = 0;
+	for(uint32_t i = 0; i < element_count; i++)
+	{
+		const data_type_info* dti = key_dtis[i];
+		int is_string = is_encodable_string(dti);
+		uint32_t width = get_fixed_value_width(dti);
+
+		// stop at the first element that can not be encoded, or that does not fit
+		if(is_string)
+		{
+			if(size + 1 > NORMALIZED_KEY_PREFIX_SIZE)
+				break;
+		}
+		else if(width == 0 || (size + 1 + width > NORMALIZED_KEY_PREFIX_SIZE))
+			break;
+
+		uint32_t element_start = size;
+
+		if(is_datum_NULL(keys + i))
+		{
+			// NULL marker followed by 0s in place of the value, so that the elements after it stay aligned
+			nk->prefix[size++] = 0;
+			size = is_string ? NORMALIZED_KEY_PREFIX_SIZE : (size + width);
+		}
+		else if(is_string)
+		{
+			nk->prefix[size++] = 1;
+			uint32_t bytes_to_copy = min(strnlen(keys[i].string_value, keys[i].string_size), NORMALIZED_KEY_PREFIX_SIZE - size);
+			memcpy(nk->prefix + size, keys[i].string_value, bytes_to_copy);
+			// the rest of the prefix is 0 padded, so a shorter string orders before the longer strings it is a prefix of
+			size = NORMALIZED_KEY_PREFIX_SIZE;
+		}
+		else
+		{
+			int is_orderable = 1;
+			uint64_t bits = get_orderable_bits(keys + i, dti, &is_orderable);
+			if(!is_orderable)
+				break;
+
+			nk->prefix[size++] = 1;
+			for(uint32_t b = 0; b < width; b++)
+				nk->prefix[size + b] = (bits >> (8 * (width - 1 - b))) & 0xff;
+			size += width;
+		}
+
+		if(cmp_dir != NULL && cmp_dir[i] == DESC)
+		{
+			for(uint32_t b = element_start; b < size; b++)
+				nk->prefix[b] = ~(nk->prefix[b]);
+		}
+
+		// a string is the last element to be encoded, and being possibly truncated it never makes the prefix complete
+		if(is_string)
+			break;
+
+		if(i == element_count - 1)
+			nk->is_complete = 1;
+	}
+
+	nk->prefix_size = size;
+}
+
+int compare_normalized_keys(const normalized_key* nk1, const normalized_key* nk2, int* is_decided)
+{
+	// elements are encoded in the same order and at the same widths in both the prefixes, so their common bytes are comparable
+	int cmp = memcmp(nk1->prefix, nk2->prefix, min(nk1->prefix_size, nk2->prefix_size));
+	if(cmp != 0)
+	{
+		(*is_decided) = 1;
+		return (cmp > 0) ? 1 : -1;
+	}
+
+	(*is_decided) = (nk1->is_complete && nk2->is_complete);
+	return 0;
+}
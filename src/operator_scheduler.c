@@ -0,0 +1,321 @@
+#include<rhendb/operator_scheduler.h>
+
+#include<stdio.h>
+#include<stdlib.h>
+
+// the worker of the operator_scheduler, that the current thread is, NULL for all the other threads
+static _Thread_local operator_scheduler_worker* current_worker = NULL;
+
+static operator_scheduler_worker* get_current_worker(operator_scheduler* os_p)
+{
+	if(current_worker != NULL && current_worker->scheduler == os_p)
+		return current_worker;
+	return NULL;
+}
+
+static operator_job* allocate_operator_job(operator_scheduler_worker* w_p)
+{
+	operator_job* job = NULL;
+
+	if(w_p != NULL && w_p->free_jobs_count > 0)
+	{
+		job = (operator_job*) get_head_of_singlylist(&(w_p->free_jobs));
+		remove_head_from_singlylist(&(w_p->free_jobs));
+		w_p->free_jobs_count--;
+		return job;
+	}
+
+	job = malloc(sizeof(operator_job));
+	if(job == NULL)
+		exit(-1);
+	initialize_slnode(&(job->embed_node));
+	return job;
+}
+
+static void recycle_operator_job(operator_scheduler_worker* w_p, operator_job* job)
+{
+	if(w_p->free_jobs_count < OPERATOR_JOBS_FREE_LIST_SIZE_PER_WORKER)
+	{
+		insert_head_in_singlylist(&(w_p->free_jobs), job);
+		w_p->free_jobs_count++;
+	}
+	else
+		free(job);
+}
+
+static void push_back_to_deque(arraylist* deque, operator_job* job)
+{
+	if(is_full_arraylist(deque) && !expand_arraylist(deque))
+	{
+		printf("BUG :: could not expand a deque of the operator_scheduler\n");
+		exit(-1);
+	}
+	push_back_to_arraylist(deque, job);
+}
+
+// the caller must hold the lock of the deque
+static operator_job* pop_from_deque(arraylist* deque, int from_back)
+{
+	if(is_empty_arraylist(deque))
+		return NULL;
+
+	operator_job* job;
+	if(from_back)
+	{
+		job = (operator_job*) get_back_of_arraylist(deque);
+		pop_back_from_arraylist(deque);
+	}
+	else
+	{
+		job = (operator_job*) get_front_of_arraylist(deque);
+		pop_front_from_arraylist(deque);
+	}
+	return job;
+}
+
+static uint64_t next_steal_seed(operator_scheduler_worker* w_p)
+{
+	w_p->steal_seed ^= w_p->steal_seed << 13;
+	w_p->steal_seed ^= w_p->steal_seed >> 7;
+	w_p->steal_seed ^= w_p->steal_seed << 17;
+	return w_p->steal_seed;
+}
+
+// returns the next job for the worker to run, the newest from its own deque, or the oldest of the injection_queue, or the oldest stolen from the other workers
+static operator_job* take_operator_job(operator_scheduler_worker* w_p)
+{
+	operator_scheduler* os_p = w_p->scheduler;
+
+	if(atomic_load(&(os_p->queued_jobs_count)) == 0)
+		return NULL;
+
+	operator_job* job = NULL;
+
+	pthread_mutex_lock(&(w_p->deque_lock));
+	job = pop_from_deque(&(w_p->deque), 1);
+	pthread_mutex_unlock(&(w_p->deque_lock));
+
+	if(job == NULL)
+	{
+		pthread_mutex_lock(&(os_p->injection_lock));
+		job = pop_from_deque(&(os_p->injection_queue), 0);
+		pthread_mutex_unlock(&(os_p->injection_lock));
+	}
+
+	// steal only from the started workers, they are as many as the operators have ever needed at once, not the max_workers_count
+	// start at a random worker, so that the thieves do not all contend for the same deque
+	uint32_t started_workers_count = atomic_load(&(os_p->started_workers_count));
+	uint32_t first_victim = next_steal_seed(w_p) % started_workers_count;
+	for(uint32_t i = 0; i < started_workers_count && job == NULL; i++)
+	{
+		operator_scheduler_worker* victim_p = &(os_p->workers[(first_victim + i) % started_workers_count]);
+		if(victim_p == w_p)
+			continue;
+
+		pthread_mutex_lock(&(victim_p->deque_lock));
+		job = pop_from_deque(&(victim_p->deque), 0);
+		pthread_mutex_unlock(&(victim_p->deque_lock));
+	}
+
+	if(job != NULL)
+		atomic_fetch_sub(&(os_p->queued_jobs_count), 1);
+
+	return job;
+}
+
+static void* operator_scheduler_worker_function(void* w_vp);
+
+// starts one more worker, unless the max_workers_count are already started
+static void start_a_worker(operator_scheduler* os_p)
+{
+	pthread_mutex_lock(&(os_p->start_lock));
+
+	uint32_t i = atomic_load(&(os_p->started_workers_count));
+	if(i == os_p->max_workers_count)
+	{
+		pthread_mutex_unlock(&(os_p->start_lock));
+		return;
+	}
+
+	// initialize the worker, before it is counted in the started_workers_count, and so before any of the thieves could steal from it
+	operator_scheduler_worker* w_p = &(os_p->workers[i]);
+	w_p->scheduler = os_p;
+	pthread_mutex_init(&(w_p->deque_lock), NULL);
+	if(!initialize_arraylist(&(w_p->deque), 64))
+		exit(-1);
+	initialize_singlylist(&(w_p->free_jobs), offsetof(operator_job, embed_node));
+	w_p->free_jobs_count = 0;
+	w_p->steal_seed = 0x9E3779B97F4A7C15ULL ^ (((uint64_t)i) + 1); // xorshift must never have a 0 state
+
+	// counted before its thread is created, as the worker itself may look for a job to steal right away, only the thread attribute is set after this, and the thieves never read it
+	atomic_store(&(os_p->started_workers_count), i + 1);
+
+	if(pthread_create(&(w_p->thread), NULL, operator_scheduler_worker_function, w_p))
+	{
+		printf("FAILED to start a worker for the operator_scheduler\n");
+		exit(-1);
+	}
+
+	pthread_mutex_unlock(&(os_p->start_lock));
+}
+
+// wakes up a sleeping worker, if there is none then all the started workers are busy (or blocked on a lock), so a new one is started
+static void wake_up_or_start_a_worker(operator_scheduler* os_p)
+{
+	if(atomic_load(&(os_p->sleeping_workers_count)) == 0)
+	{
+		start_a_worker(os_p);
+		return;
+	}
+
+	pthread_mutex_lock(&(os_p->idle_lock));
+	pthread_cond_signal(&(os_p->work_available));
+	pthread_mutex_unlock(&(os_p->idle_lock));
+}
+
+static void* operator_scheduler_worker_function(void* w_vp)
+{
+	operator_scheduler_worker* w_p = w_vp;
+	operator_scheduler* os_p = w_p->scheduler;
+
+	current_worker = w_p;
+
+	while(1)
+	{
+		operator_job* job = take_operator_job(w_p);
+		if(job != NULL)
+		{
+			job->run(job);
+			recycle_operator_job(w_p, job);
+			continue;
+		}
+
+		pthread_mutex_lock(&(os_p->idle_lock));
+
+		atomic_fetch_add(&(os_p->sleeping_workers_count), 1);
+		while(atomic_load(&(os_p->queued_jobs_count)) == 0 && !(os_p->shutdown_called))
+			pthread_cond_wait(&(os_p->work_available), &(os_p->idle_lock));
+		atomic_fetch_sub(&(os_p->sleeping_workers_count), 1);
+
+		int should_exit = (os_p->shutdown_called && atomic_load(&(os_p->queued_jobs_count)) == 0);
+
+		pthread_mutex_unlock(&(os_p->idle_lock));
+
+		if(should_exit)
+			break;
+	}
+
+	// release the cached operator_job-s
+	while(!is_empty_singlylist(&(w_p->free_jobs)))
+	{
+		operator_job* job = (operator_job*) get_head_of_singlylist(&(w_p->free_jobs));
+		remove_head_from_singlylist(&(w_p->free_jobs));
+		free(job);
+	}
+	w_p->free_jobs_count = 0;
+
+	current_worker = NULL;
+
+	return NULL;
+}
+
+void initialize_operator_scheduler(operator_scheduler* os_p, uint32_t max_workers_count)
+{
+	if(max_workers_count == 0)
+	{
+		printf("BUG :: operator_scheduler needs atleast 1 worker\n");
+		exit(-1);
+	}
+
+	pthread_mutex_init(&(os_p->injection_lock), NULL);
+	if(!initialize_arraylist(&(os_p->injection_queue), 64))
+		exit(-1);
+
+	atomic_init(&(os_p->queued_jobs_count), 0);
+
+	pthread_mutex_init(&(os_p->idle_lock), NULL);
+	pthread_cond_init(&(os_p->work_available), NULL);
+	atomic_init(&(os_p->sleeping_workers_count), 0);
+	os_p->shutdown_called = 0;
+
+	// the workers are started lazily, as the jobs are scheduled, see wake_up_or_start_a_worker()
+	os_p->max_workers_count = max_workers_count;
+	os_p->workers = malloc(sizeof(operator_scheduler_worker) * max_workers_count);
+	if(os_p->workers == NULL)
+		exit(-1);
+	pthread_mutex_init(&(os_p->start_lock), NULL);
+	atomic_init(&(os_p->started_workers_count), 0);
+}
+
+int schedule_operator_job(operator_scheduler* os_p, void (*run)(operator_job* job), operator* o, void* param, void (*operator_job_function)(operator* o, void* param))
+{
+	operator_scheduler_worker* w_p = get_current_worker(os_p);
+
+	operator_job* job = allocate_operator_job(w_p);
+	job->run = run;
+	job->o = o;
+	job->param = param;
+	job->operator_job_function = operator_job_function;
+
+	if(w_p != NULL)
+	{
+		// the worker is alive, so it will run this job itself, even if the operator_scheduler is being shutdown
+		pthread_mutex_lock(&(w_p->deque_lock));
+		push_back_to_deque(&(w_p->deque), job);
+		atomic_fetch_add(&(os_p->queued_jobs_count), 1);
+		pthread_mutex_unlock(&(w_p->deque_lock));
+	}
+	else
+	{
+		pthread_mutex_lock(&(os_p->injection_lock));
+		if(os_p->shutdown_called)
+		{
+			pthread_mutex_unlock(&(os_p->injection_lock));
+			free(job);
+			return 0;
+		}
+		push_back_to_deque(&(os_p->injection_queue), job);
+		atomic_fetch_add(&(os_p->queued_jobs_count), 1);
+		pthread_mutex_unlock(&(os_p->injection_lock));
+	}
+
+	wake_up_or_start_a_worker(os_p);
+
+	return 1;
+}
+
+void deinitialize_operator_scheduler(operator_scheduler* os_p)
+{
+	// shutdown_called is set with both the locks held, so no job is injected after the workers decide to exit
+	pthread_mutex_lock(&(os_p->injection_lock));
+	pthread_mutex_lock(&(os_p->idle_lock));
+	os_p->shutdown_called = 1;
+	pthread_cond_broadcast(&(os_p->work_available));
+	pthread_mutex_unlock(&(os_p->idle_lock));
+	pthread_mutex_unlock(&(os_p->injection_lock));
+
+	// a job injected just before the shutdown may still start a worker, so keep joining until all the started workers are joined
+	uint32_t joined_workers_count = 0;
+	pthread_mutex_lock(&(os_p->start_lock));
+	while(joined_workers_count < atomic_load(&(os_p->started_workers_count)))
+	{
+		pthread_mutex_unlock(&(os_p->start_lock));
+		pthread_join(os_p->workers[joined_workers_count++].thread, NULL);
+		pthread_mutex_lock(&(os_p->start_lock));
+	}
+	pthread_mutex_unlock(&(os_p->start_lock));
+
+	for(uint32_t i = 0; i < joined_workers_count; i++)
+	{
+		pthread_mutex_destroy(&(os_p->workers[i].deque_lock));
+		deinitialize_arraylist(&(os_p->workers[i].deque));
+	}
+	free(os_p->workers);
+	pthread_mutex_destroy(&(os_p->start_lock));
+
+	pthread_mutex_destroy(&(os_p->injection_lock));
+	deinitialize_arraylist(&(os_p->injection_queue));
+
+	pthread_mutex_destroy(&(os_p->idle_lock));
+	pthread_cond_destroy(&(os_p->work_available));
+}
@@ -36,7 +36,8 @@ struct input_values
 	uint32_t min_block_size;
 };
 
-static int produce_join_result(operator* o, const void* left_tuple, const void* right_tuple)
+// if ob is not NULL, the join result is only accumulated into it, to be produced along with the rest of the batch
+static int produce_join_result(operator* o, operator_output_batch* ob, const void* left_tuple, const void* right_tuple)
 {
 	input_values* inputs = o->inputs;
 
@@ -71,6 +72,10 @@ static int produce_join_result(operator* o, const void* left_tuple, const void*
 		output_tuple_size = get_tuple_size(inputs->output_tuple_def, output_tuple);
 	}
 
+	// batch output_tuple
+	if(ob != NULL)
+		return append_to_output_batch_for_operator(o, ob, output_tuple);
+
 	// produce output_tuple
 	int produced = produce_tuple_from_operator(o, output_tuple);
 	free(output_tuple);
@@ -90,6 +95,9 @@ static int produce_batched_left_block_loop_over_all_right(operator* o)
 		memory_set(left_tuple_matched_bitmap, 0, UINT_ALIGN_UP(inputs->batched_left_side_tuples->tuples_count, 8) / 8);
 	}
 
+	// join results of this block are accumulated here, and produced together
+	operator_output_batch ob = INIT_OPERATOR_OUTPUT_BATCH;
+
 	uint64_t pairs_checked = 0;
 
 	// iterate over all the right_side_tuples
@@ -109,6 +117,8 @@ static int produce_batched_left_block_loop_over_all_right(operator* o)
 				// region used for the outer loop
 				unmap_for_interim_tuple_region(&_temp_tuple_region);
 
+				discard_output_batch_for_operator(&ob);
+
 				kill_signal_for_self_operator(o, get_dstring_pointing_to_literal_cstring("block_nested_loop_join_killed_abruptly"));
 				return 0;
 			}pairs_checked++;
@@ -134,6 +144,8 @@ static int produce_batched_left_block_loop_over_all_right(operator* o)
 				// region used for the outer loop
 				unmap_for_interim_tuple_region(&_temp_tuple_region);
 
+				discard_output_batch_for_operator(&ob);
+
 				kill_signal_for_self_operator(o, get_dstring_pointing_to_literal_cstring("block_nested_loop_join_matcher_errored"));
 				return 0;
 			}
@@ -149,7 +161,7 @@ static int produce_batched_left_block_loop_over_all_right(operator* o)
 			if(inputs->join_expr == NULL || join_match)
 			{
 				// produce output_tuple
-				int produced = produce_join_result(o, left_tuple, right_tuple);
+				int produced = produce_join_result(o, &ob, left_tuple, right_tuple);
 				if(!produced)
 				{
 					if(left_tuple_matched_bitmap != NULL)
@@ -158,6 +170,8 @@ static int produce_batched_left_block_loop_over_all_right(operator* o)
 					// region used for the outer loop
 					unmap_for_interim_tuple_region(&_temp_tuple_region);
 
+					discard_output_batch_for_operator(&ob);
+
 					kill_signal_for_self_operator(o, get_dstring_pointing_to_literal_cstring("could_not_produce"));
 					return 0;
 				}
@@ -181,12 +195,14 @@ static int produce_batched_left_block_loop_over_all_right(operator* o)
 			if(get_bit(left_tuple_matched_bitmap, left_tuple_index) == 0)
 			{
 				// produce output_tuple
-				int produced = produce_join_result(o, left_tuple, NULL);
+				int produced = produce_join_result(o, &ob, left_tuple, NULL);
 				if(!produced)
 				{
 					if(left_tuple_matched_bitmap != NULL)
 						free(left_tuple_matched_bitmap);
 
+					discard_output_batch_for_operator(&ob);
+
 					kill_signal_for_self_operator(o, get_dstring_pointing_to_literal_cstring("could_not_produce"));
 					return 0;
 				}
@@ -200,6 +216,13 @@ static int produce_batched_left_block_loop_over_all_right(operator* o)
 	if(left_tuple_matched_bitmap != NULL)
 		free(left_tuple_matched_bitmap);
 
+	// produce the remaining join results of this block
+	if(!flush_output_batch_for_operator(o, &ob))
+	{
+		kill_signal_for_self_operator(o, get_dstring_pointing_to_literal_cstring("could_not_produce"));
+		return 0;
+	}
+
 	return 1;
 }
 
@@ -8,6 +8,7 @@
 
 #include<rhendb/table_operator_output_type.h>
 #include<rhendb/fetched_table.h>
+#include<rhendb/heap_page_morsel_cursor.h>
 
 #include<tupleindexer/heap_page/heap_page.h>
 
@@ -77,6 +78,13 @@ static int compare_pending_deletions_by_partition_id_and_tuple_pointer(const voi
 	return 0;
 }
 
+static void get_tuple_pointer_of_pending_deletion(const void* to_be_deleted, cy_uint index, uint64_t* partition_id, tuple_pointer* tptr)
+{
+	const pending_deletion* pd = get_from_front_of_pending_deletions(to_be_deleted, index);
+	(*partition_id) = pd->partition_id;
+	(*tptr) = pd->tptr;
+}
+
 // produces the output tuple for a pending_deletion that was just marked deleted,
 // returns 0, only if the tuple could not be produced, in which case the caller must kill itself
 static int produce_output_for_pending_deletion(operator* o, const pending_deletion* pd, const void* heap_record, uint64_t partition_index_in_info)
@@ -169,24 +177,16 @@ static int mark_buffered_tuples_deleted(operator* o, const char** kill_reason)
 	if(!merge_sort_pending_deletions(&(inputs->to_be_deleted), 0, to_be_deleted_count - 1, &simple_comparator(compare_pending_deletions_by_partition_id_and_tuple_pointer), STD_C_mem_allocator))
 		exit(-1);
 
-	// index over the to_be_deleted buffer, and index over the partitions of the table,
-	// both of them are only ever incremented, making the below loop linear in their lengths
-	cy_uint i = 0;
-	uint64_t p = 0;
+	// the sorted buffer is handed out in morsels, each of them being all the tuples to be deleted on a few pages of a single partition
+	heap_page_morsel_cursor hpmc;
+	initialize_heap_page_morsel_cursor_for_sorted_tuple_pointers(&hpmc, inputs->ftabl, DEFAULT_HEAP_PAGES_PER_MORSEL, &(inputs->to_be_deleted), to_be_deleted_count, get_tuple_pointer_of_pending_deletion);
 
-	while(i < to_be_deleted_count)
+	heap_page_morsel morsel;
+	int claim_abort_error = 0;
+	while(claim_heap_page_morsel(&hpmc, &morsel, &claim_abort_error))
 	{
-		uint64_t partition_id = get_from_front_of_pending_deletions(&(inputs->to_be_deleted), i)->partition_id;
-
-		// advance over all the partitions that no tuple is to be deleted from
-		while(p < inputs->ftabl->partitions_count && inputs->ftabl->table_partitions_info[p].partition_id < partition_id)
-			p++;
-
-		if(p == inputs->ftabl->partitions_count || inputs->ftabl->table_partitions_info[p].partition_id != partition_id)
-		{
-			printf("ISSUE in (deleter_operator) :: no partition with partition_id = %" PRIu64 " in table with table_id = %" PRIu64 "\n", partition_id, inputs->ftabl->table_info.id);
-			exit(-1);
-		}
+		uint64_t p = morsel.partition_index_in_info;
+		uint64_t partition_id = inputs->ftabl->table_partitions_info[p].partition_id;
 
 		const tuple_def* partition_tuple_def = &(inputs->ftabl->table_partition_tuple_defs[p]);
 
@@ -195,7 +195,8 @@ static int mark_buffered_tuples_deleted(operator* o, const char** kill_reason)
 		initialize_tuple_def(&mvcc_def, (data_type_info*)(partition_tuple_def->type_info->containees[0].al.type_info));
 
 		// all the tuples to be deleted on a single page, are marked deleted in a single mini transaction
-		while(i < to_be_deleted_count && get_from_front_of_pending_deletions(&(inputs->to_be_deleted), i)->partition_id == partition_id)
+		cy_uint i = morsel.first_index;
+		while(i < morsel.last_index)
 		{
 			uint64_t page_id = get_from_front_of_pending_deletions(&(inputs->to_be_deleted), i)->tptr.page_id;
 
@@ -212,7 +213,7 @@ static int mark_buffered_tuples_deleted(operator* o, const char** kill_reason)
 			cy_uint page_first_index = i;
 
 			// mark every tuple that is to be deleted on this very page, deleted
-			while(i < to_be_deleted_count)
+			while(i < morsel.last_index)
 			{
 				const pending_deletion* pd = get_from_front_of_pending_deletions(&(inputs->to_be_deleted), i);
 				if(pd->partition_id != partition_id || pd->tptr.page_id != page_id)
@@ -231,6 +232,14 @@ static int mark_buffered_tuples_deleted(operator* o, const char** kill_reason)
 
 				mvcc_header hdr;
 				read_mvcc_header(&hdr, mvcc_hdr_datum.tuple_value, &mvcc_def);
+
+				// the mvcc_header is rewritten anyways, so the hint for its xmin gets written for free along with it
+				if(IS_MVCC_HINTS_WRITE_BACK_ENABLED(inputs->additional_flags) && !hdr.is_xmin_NULL)
+				{
+					int were_hints_updated = 0;
+					fetch_status_for_transaction_id_with_hints(&(hdr.xmin), &(inputs->tx->rdb->tsg), &were_hints_updated);
+				}
+
 				hdr.is_xmax_NULL = 0;
 				hdr.xmax = (transaction_id_with_hints){.is_committed = 0, .is_aborted = 0, .transaction_id = inputs->tx->snapshot->self_transaction_id};
 
@@ -260,6 +269,7 @@ static int mark_buffered_tuples_deleted(operator* o, const char** kill_reason)
 				if(!produce_output_for_pending_deletion(o, pd, record, p))
 				{
 					(*kill_reason) = "could_not_produce";
+					deinitialize_heap_page_morsel_cursor(&hpmc);
 					return 0;
 				}
 			}
@@ -281,6 +291,8 @@ static int mark_buffered_tuples_deleted(operator* o, const char** kill_reason)
 		}
 	}
 
+	deinitialize_heap_page_morsel_cursor(&hpmc);
+
 	// every buffered tuple is marked deleted now, so the buffer can be emptied
 	remove_all_from_pending_deletions(&(inputs->to_be_deleted));
 
@@ -8,6 +8,9 @@
 #include<rhendb/interim_tuple_store.h>
 
 #include<rhendb/function_hash.h>
+#include<rhendb/function_compare.h>
+
+#include<rhendb/flat_hash_table.h>
 
 #include<rhendb/join_type.h>
 
@@ -28,7 +31,32 @@ struct rash_table_partition
 	rash_table_handle rth;
 };
 
-typedef struct input_values input_values;
+// a chunk of hash_value-tuple pairs of a radix_partition, it is filled by only 1 build job before it gets pushed to the radix_partition
+#define RADIX_CHUNK_ENTRIES_COUNT 256
+
+typedef struct radix_chunk radix_chunk;
+struct radix_chunk
+{
+	radix_chunk* next;
+
+	uint32_t entries_count;
+	flat_hash_table_entry entries[RADIX_CHUNK_ENTRIES_COUNT];
+};
+
+typedef struct radix_partition radix_partition;
+struct radix_partition
+{
+	// stack of the chunks of this partition, pushed lock-free by the build jobs
+	_Atomic(radix_chunk*) chunks;
+	_Atomic uint64_t entries_count;
+
+	// built from the chunks, by the only job that claims this partition, no locks are needed after that
+	flat_hash_table table;
+};
+
+// number of left tuples, whose home slots are prefetched before probing for any of them
+#define PROBE_PREFETCH_BATCH_SIZE 16
+
 typedef struct input_values input_values;
 struct input_values
 {
@@ -49,10 +77,26 @@ struct input_values
 	// fill up this buffer before moving it into the tuple_buffers_to_insert
 	interim_tuple_store* pending_buffer;
 
-	// rash_table partitions for the right side
+	// rash_table partitions for the right side, only created if the right side is not radix partitioned
 	uint32_t partitions_count;
 	rash_table_partition** partitions;
 
+	// if set, the right side is radix partitioned in memory, on the low bits of the hash_values of its keys, into radix_partitions
+	// the radix_partitions point to the right tuples inside the right_side_buffers, that stay mapped until the join completes
+	int is_radix_partitioned;
+	uint32_t radix_partitions_count; // a power of 2
+	radix_partition* radix_partitions;
+	linkedlist right_side_buffers;
+
+	// set by the build jobs, if the right side does not fit in the interim memory budget
+	// then the right_side_buffers are built into the rash_table partitions instead
+	_Atomic int is_radix_partitioning_failed;
+
+	// 0 -> radix partition tables not being built, 1 -> being built, 2 -> built
+	int radix_partition_tables_state;
+	uint32_t radix_partition_to_build_next; // protected by partition_to_right_only_join_next_lock
+	uint32_t active_radix_partition_tables_build_job_count;
+
 	// to be used in the last phase to produce tuples on the right side that do not have a match on the left
 	// when DOES_IT_PRESERVE_RIGHT(ptype) == 1
 	pthread_mutex_t partition_to_right_only_join_next_lock;
@@ -75,7 +119,8 @@ struct input_values
 	int phase; // 0, 1, 2
 };
 
-static int produce_join_result(operator* o, const void* left_tuple, const void* right_tuple)
+// if ob is not NULL, the join result is only accumulated into it, to be produced along with the rest of the batch
+static int produce_join_result(operator* o, operator_output_batch* ob, const void* left_tuple, const void* right_tuple)
 {
 	input_values* inputs = o->inputs;
 
@@ -110,6 +155,10 @@ static int produce_join_result(operator* o, const void* left_tuple, const void*
 		output_tuple_size = get_tuple_size(inputs->output_tuple_def, output_tuple);
 	}
 
+	// batch output_tuple
+	if(ob != NULL)
+		return append_to_output_batch_for_operator(o, ob, output_tuple);
+
 	// produce output_tuple
 	int produced = produce_tuple_from_operator(o, output_tuple);
 	free(output_tuple);
@@ -189,6 +238,9 @@ static void probe_right_side_partitions_using_left_tuples(operator* o, void* par
 {
 	input_values* inputs = o->inputs;
 
+	// join results of this job are accumulated here, and produced together
+	operator_output_batch ob = INIT_OPERATOR_OUTPUT_BATCH;
+
 	int failed = 0;
 	while(!failed)
 	{
@@ -234,7 +286,7 @@ static void probe_right_side_partitions_using_left_tuples(operator* o, void* par
 						{
 							if(right_tuple != NULL)
 							{
-								if(!produce_join_result(o, tuple, right_tuple))
+								if(!produce_join_result(o, &ob, tuple, right_tuple))
 								{
 									kill_signal_for_self_operator(o, get_dstring_pointing_to_literal_cstring("could_not_produce"));
 									failed = 1;
@@ -258,7 +310,7 @@ static void probe_right_side_partitions_using_left_tuples(operator* o, void* par
 			{
 				if(DOES_IT_PRESERVE_LEFT(inputs->ptype))
 				{
-					if(!produce_join_result(o, tuple, NULL))
+					if(!produce_join_result(o, &ob, tuple, NULL))
 					{
 						kill_signal_for_self_operator(o, get_dstring_pointing_to_literal_cstring("could_not_produce"));
 						failed = 1;
@@ -276,9 +328,19 @@ static void probe_right_side_partitions_using_left_tuples(operator* o, void* par
 				break;
 		});
 
+		// produce all the join results of this buffer, before picking up the next one
+		if(!failed && !flush_output_batch_for_operator(o, &ob))
+		{
+			kill_signal_for_self_operator(o, get_dstring_pointing_to_literal_cstring("could_not_produce"));
+			failed = 1;
+		}
+
 		delete_interim_tuple_store(its_p);
 	}
 
+	// on a failure, the pending join results are never produced
+	discard_output_batch_for_operator(&ob);
+
 
 	// decrement active build phas jobs count
 	pthread_mutex_lock(&(inputs->buffers_queue_lock));
@@ -293,6 +355,9 @@ static void probe_right_side_partitions_for_right_only_tuples(operator* o, void*
 {
 	input_values* inputs = o->inputs;
 
+	// join results of this job are accumulated here, and produced together
+	operator_output_batch ob = INIT_OPERATOR_OUTPUT_BATCH;
+
 	int failed = 0;
 	while(!failed)
 	{
@@ -329,7 +394,7 @@ static void probe_right_side_partitions_for_right_only_tuples(operator* o, void*
 					{
 						if(tuple != NULL)
 						{
-							if(!produce_join_result(o, NULL, tuple))
+							if(!produce_join_result(o, &ob, NULL, tuple))
 							{
 								kill_signal_for_self_operator(o, get_dstring_pointing_to_literal_cstring("could_not_produce"));
 								failed = 1;
@@ -357,6 +422,13 @@ static void probe_right_side_partitions_for_right_only_tuples(operator* o, void*
 		// delete the fina_all iterator
 		delete_rash_table_iterator(&rti);
 
+		// produce all the join results of this partition, before picking up the next one
+		if(!failed && !flush_output_batch_for_operator(o, &ob))
+		{
+			kill_signal_for_self_operator(o, get_dstring_pointing_to_literal_cstring("could_not_produce"));
+			failed = 1;
+		}
+
 		// destroy the parttion
 		{
 			pthread_mutex_destroy(&(inputs->partitions[partition_id]->build_lock));
@@ -366,6 +438,9 @@ static void probe_right_side_partitions_for_right_only_tuples(operator* o, void*
 		}
 	}
 
+	// on a failure, the pending join results are never produced
+	discard_output_batch_for_operator(&ob);
+
 	// decrement active build phas jobs count
 	pthread_mutex_lock(&(inputs->buffers_queue_lock));
 	inputs->active_right_only_probe_phase_job_count--;
@@ -375,6 +450,326 @@ static void probe_right_side_partitions_for_right_only_tuples(operator* o, void*
 		trigger_execution_on_operator(o);
 }
 
+static void push_chunk_to_radix_partition(radix_partition* rp_p, radix_chunk* chunk)
+{
+	atomic_fetch_add_explicit(&(rp_p->entries_count), chunk->entries_count, memory_order_relaxed);
+	chunk->next = atomic_load_explicit(&(rp_p->chunks), memory_order_relaxed);
+	while(!atomic_compare_exchange_weak_explicit(&(rp_p->chunks), &(chunk->next), chunk, memory_order_release, memory_order_relaxed));
+}
+
+static void free_all_chunks_of_radix_partition(radix_partition* rp_p)
+{
+	radix_chunk* chunk = atomic_exchange_explicit(&(rp_p->chunks), NULL, memory_order_acquire);
+	while(chunk != NULL)
+	{
+		radix_chunk* next = chunk->next;
+		free(chunk);
+		chunk = next;
+	}
+}
+
+static void partition_right_side_tuples(operator* o, void* param)
+{
+	input_values* inputs = o->inputs;
+
+	// the chunks being filled by this job, one for each radix_partition, they need no locks as this job is their only owner
+	radix_chunk** filling_chunks = calloc(inputs->radix_partitions_count, sizeof(radix_chunk*));
+	if(filling_chunks == NULL)
+	{
+		printf("FAILED to allocate memory for partitioning the right side for hash_join_operator\n");
+		exit(-1);
+	}
+
+	while(1)
+	{
+		pthread_mutex_lock(&(inputs->buffers_queue_lock));
+		interim_tuple_store* its_p = (interim_tuple_store*) get_head_of_linkedlist(&(inputs->buffers_queue));
+		if(its_p != NULL)
+		{
+			remove_head_from_linkedlist(&(inputs->buffers_queue));
+			inputs->buffers_queue_size--;
+		}
+		pthread_mutex_unlock(&(inputs->buffers_queue_lock));
+
+		// if no tuple buffer found exit
+		if(its_p == NULL)
+			break;
+
+		// a buffer that is not in memory implies that the right side does not fit in the interim memory budget
+		if(!its_p->is_in_memory)
+			atomic_store_explicit(&(inputs->is_radix_partitioning_failed), 1, memory_order_relaxed);
+
+		// the partitioning is of no use once it fails, the buffer is only retained to be built into the rash_table partitions
+		if(!atomic_load_explicit(&(inputs->is_radix_partitioning_failed), memory_order_relaxed))
+		{
+			// map the whole buffer at once, the radix_partitions point into this mapping
+			uint64_t tuple_offset = 0;
+			while(mmap_for_reading_tuple(its_p, &(its_p->embed_regions[0]), tuple_offset, &(inputs->right_input_tuple_def->size_def), get_total_bytes_in_interim_tuple_store(its_p)))
+			{
+				const void* tuple = its_p->embed_regions[0].tuple;
+				uint64_t hash_value = hash_tuple_rhendb(tuple, inputs->right_input_tuple_def, inputs->right_key_element_ids, FNV_64_TUPLE_HASHER, inputs->key_element_count, o->self_query_plan->curr_tx);
+
+				// the partition is picked on the low bits of the hash_value
+				uint32_t partition_id = hash_value & (inputs->radix_partitions_count - 1);
+
+				radix_chunk* chunk = filling_chunks[partition_id];
+				if(chunk == NULL || chunk->entries_count == RADIX_CHUNK_ENTRIES_COUNT)
+				{
+					if(chunk != NULL)
+						push_chunk_to_radix_partition(&(inputs->radix_partitions[partition_id]), chunk);
+					chunk = malloc(sizeof(radix_chunk));
+					if(chunk == NULL)
+					{
+						printf("FAILED to allocate memory for partitioning the right side for hash_join_operator\n");
+						exit(-1);
+					}
+					chunk->entries_count = 0;
+					filling_chunks[partition_id] = chunk;
+				}
+				chunk->entries[chunk->entries_count++] = (flat_hash_table_entry){.hash_value = hash_value, .tuple = tuple};
+
+				tuple_offset = next_tuple_offset_for_interim_tuple_region(&(its_p->embed_regions[0]));
+			}
+		}
+
+		// retain the buffer, until the join completes
+		pthread_mutex_lock(&(inputs->buffers_queue_lock));
+		insert_tail_in_linkedlist(&(inputs->right_side_buffers), its_p);
+		pthread_mutex_unlock(&(inputs->buffers_queue_lock));
+	}
+
+	// push all the partially filled chunks
+	for(uint32_t i = 0; i < inputs->radix_partitions_count; i++)
+		if(filling_chunks[i] != NULL)
+			push_chunk_to_radix_partition(&(inputs->radix_partitions[i]), filling_chunks[i]);
+	free(filling_chunks);
+
+	// decrement active build phase jobs count
+	pthread_mutex_lock(&(inputs->buffers_queue_lock));
+	inputs->active_build_phase_job_count--;
+	pthread_mutex_unlock(&(inputs->buffers_queue_lock));
+
+	trigger_execution_on_operator(o);
+}
+
+// builds the flat_hash_tables of the radix_partitions claimed, until there are none left to be claimed
+static void build_claimed_radix_partition_tables(operator* o)
+{
+	input_values* inputs = o->inputs;
+
+	while(1)
+	{
+		uint32_t partition_id;
+
+		// fetch the partition to process next
+		pthread_mutex_lock(&(inputs->partition_to_right_only_join_next_lock));
+		partition_id = inputs->radix_partition_to_build_next;
+		if(partition_id < inputs->radix_partitions_count)
+			inputs->radix_partition_to_build_next++;
+		pthread_mutex_unlock(&(inputs->partition_to_right_only_join_next_lock));
+
+		// if out of bounds break out of the loop
+		if(partition_id >= inputs->radix_partitions_count)
+			break;
+
+		radix_partition* rp_p = &(inputs->radix_partitions[partition_id]);
+
+		initialize_flat_hash_table(&(rp_p->table), atomic_load_explicit(&(rp_p->entries_count), memory_order_relaxed), DOES_IT_PRESERVE_RIGHT(inputs->ptype));
+
+		radix_chunk* chunk = atomic_exchange_explicit(&(rp_p->chunks), NULL, memory_order_acquire);
+		while(chunk != NULL)
+		{
+			for(uint32_t i = 0; i < chunk->entries_count; i++)
+				insert_in_flat_hash_table(&(rp_p->table), chunk->entries[i].hash_value, chunk->entries[i].tuple);
+
+			radix_chunk* next = chunk->next;
+			free(chunk);
+			chunk = next;
+		}
+	}
+}
+
+static void build_radix_partition_tables(operator* o, void* param)
+{
+	input_values* inputs = o->inputs;
+
+	build_claimed_radix_partition_tables(o);
+
+	// decrement active radix partition tables build jobs count
+	pthread_mutex_lock(&(inputs->buffers_queue_lock));
+	inputs->active_radix_partition_tables_build_job_count--;
+	pthread_mutex_unlock(&(inputs->buffers_queue_lock));
+
+	trigger_execution_on_operator(o);
+}
+
+// returns 0, if the join results could not be produced
+static int probe_radix_partition_using_left_tuple(operator* o, operator_output_batch* ob, const void* left_tuple, uint64_t hash_value)
+{
+	input_values* inputs = o->inputs;
+
+	flat_hash_table* fht_p = &(inputs->radix_partitions[hash_value & (inputs->radix_partitions_count - 1)].table);
+
+	int has_match = 0;
+	for(uint64_t slot = find_in_flat_hash_table(fht_p, hash_value, get_home_slot_in_flat_hash_table(fht_p, hash_value)); slot != FLAT_HASH_TABLE_NO_SLOT; slot = find_in_flat_hash_table(fht_p, hash_value, get_next_slot_in_flat_hash_table(fht_p, slot)))
+	{
+		const void* right_tuple = fht_p->slots[slot].tuple;
+
+		// same hash_value, does not imply same keys
+		if(0 != compare_tuples_rhendb(left_tuple, inputs->left_input_tuple_def, inputs->left_key_element_ids, right_tuple, inputs->right_input_tuple_def, inputs->right_key_element_ids, NULL, inputs->key_element_count, o->self_query_plan->curr_tx))
+			continue;
+
+		has_match = 1;
+
+		if(fht_p->is_matched != NULL)
+			fht_p->is_matched[slot] = 1; // we matched right with a left, NOTE: doing this without a lock is the same hack as with the state flag of the rash_table
+
+		if(!produce_join_result(o, ob, left_tuple, right_tuple))
+			return 0;
+	}
+
+	// left_tuple is a loner
+	if(!has_match && DOES_IT_PRESERVE_LEFT(inputs->ptype))
+		return produce_join_result(o, ob, left_tuple, NULL);
+
+	return 1;
+}
+
+static void probe_radix_partitions_using_left_tuples(operator* o, void* param)
+{
+	input_values* inputs = o->inputs;
+
+	// join results of this job are accumulated here, and produced together
+	operator_output_batch ob = INIT_OPERATOR_OUTPUT_BATCH;
+
+	int failed = 0;
+	while(!failed)
+	{
+		pthread_mutex_lock(&(inputs->buffers_queue_lock));
+		interim_tuple_store* its_p = (interim_tuple_store*) get_head_of_linkedlist(&(inputs->buffers_queue));
+		if(its_p != NULL)
+		{
+			remove_head_from_linkedlist(&(inputs->buffers_queue));
+			inputs->buffers_queue_size--;
+		}
+		pthread_mutex_unlock(&(inputs->buffers_queue_lock));
+
+		// if no tuple buffer found exit
+		if(its_p == NULL)
+			break;
+
+		// the whole buffer is mapped at once, so the tuples of a batch stay valid, until the buffer is deleted
+		uint64_t tuple_offset = 0;
+		int has_more_tuples = 1;
+		while(!failed && has_more_tuples)
+		{
+			// collect a batch of left_tuple-s, prefetching their home slots, before probing for any of them
+			const void* tuples[PROBE_PREFETCH_BATCH_SIZE];
+			uint64_t hash_values[PROBE_PREFETCH_BATCH_SIZE];
+			uint32_t tuples_count = 0;
+			while(tuples_count < PROBE_PREFETCH_BATCH_SIZE && (has_more_tuples = mmap_for_reading_tuple(its_p, &(its_p->embed_regions[0]), tuple_offset, &(inputs->left_input_tuple_def->size_def), get_total_bytes_in_interim_tuple_store(its_p))))
+			{
+				tuples[tuples_count] = its_p->embed_regions[0].tuple;
+				hash_values[tuples_count] = hash_tuple_rhendb(tuples[tuples_count], inputs->left_input_tuple_def, inputs->left_key_element_ids, FNV_64_TUPLE_HASHER, inputs->key_element_count, o->self_query_plan->curr_tx);
+				prefetch_home_slot_in_flat_hash_table(&(inputs->radix_partitions[hash_values[tuples_count] & (inputs->radix_partitions_count - 1)].table), hash_values[tuples_count]);
+				tuples_count++;
+
+				tuple_offset = next_tuple_offset_for_interim_tuple_region(&(its_p->embed_regions[0]));
+			}
+
+			for(uint32_t i = 0; i < tuples_count && !failed; i++)
+			{
+				if(!probe_radix_partition_using_left_tuple(o, &ob, tuples[i], hash_values[i]))
+				{
+					kill_signal_for_self_operator(o, get_dstring_pointing_to_literal_cstring("could_not_produce"));
+					failed = 1;
+				}
+			}
+		}
+
+		// produce all the join results of this buffer, before picking up the next one
+		if(!failed && !flush_output_batch_for_operator(o, &ob))
+		{
+			kill_signal_for_self_operator(o, get_dstring_pointing_to_literal_cstring("could_not_produce"));
+			failed = 1;
+		}
+
+		delete_interim_tuple_store(its_p);
+	}
+
+	// on a failure, the pending join results are never produced
+	discard_output_batch_for_operator(&ob);
+
+	// decrement active probe phase jobs count
+	pthread_mutex_lock(&(inputs->buffers_queue_lock));
+	inputs->active_probe_phase_job_count--;
+	pthread_mutex_unlock(&(inputs->buffers_queue_lock));
+
+	if(!failed)
+		trigger_execution_on_operator(o);
+}
+
+static void probe_radix_partitions_for_right_only_tuples(operator* o, void* param)
+{
+	input_values* inputs = o->inputs;
+
+	// join results of this job are accumulated here, and produced together
+	operator_output_batch ob = INIT_OPERATOR_OUTPUT_BATCH;
+
+	int failed = 0;
+	while(!failed)
+	{
+		uint32_t partition_id;
+
+		// fetch the parttion to process next
+		pthread_mutex_lock(&(inputs->partition_to_right_only_join_next_lock));
+		partition_id = inputs->partition_to_right_only_join_next;
+		if(partition_id < inputs->radix_partitions_count)
+			inputs->partition_to_right_only_join_next++;
+		pthread_mutex_unlock(&(inputs->partition_to_right_only_join_next_lock));
+
+		// if out of bounds break out of the loop
+		if(partition_id >= inputs->radix_partitions_count)
+			break;
+
+		flat_hash_table* fht_p = &(inputs->radix_partitions[partition_id].table);
+
+		// produce all the unmatched right tuples
+		for(uint64_t slot = 0; slot < fht_p->slots_count && !failed; slot++)
+		{
+			if(fht_p->slots[slot].tuple == NULL || fht_p->is_matched[slot])
+				continue;
+
+			if(!produce_join_result(o, &ob, NULL, fht_p->slots[slot].tuple))
+			{
+				kill_signal_for_self_operator(o, get_dstring_pointing_to_literal_cstring("could_not_produce"));
+				failed = 1;
+			}
+		}
+
+		// produce all the join results of this partition, before picking up the next one
+		if(!failed && !flush_output_batch_for_operator(o, &ob))
+		{
+			kill_signal_for_self_operator(o, get_dstring_pointing_to_literal_cstring("could_not_produce"));
+			failed = 1;
+		}
+
+		// destroy the partition's table
+		deinitialize_flat_hash_table(fht_p);
+	}
+
+	// on a failure, the pending join results are never produced
+	discard_output_batch_for_operator(&ob);
+
+	// decrement active right only probe phase jobs count
+	pthread_mutex_lock(&(inputs->buffers_queue_lock));
+	inputs->active_right_only_probe_phase_job_count--;
+	pthread_mutex_unlock(&(inputs->buffers_queue_lock));
+
+	if(!failed)
+		trigger_execution_on_operator(o);
+}
+
 static void start_right_side_build_jobs(operator* o)
 {
 	input_values* inputs = o->inputs;
@@ -385,7 +780,7 @@ static void start_right_side_build_jobs(operator* o)
 		uint32_t new_jobs = min(inputs->buffers_queue_size, inputs->max_concurrent_jobs_count - inputs->active_build_phase_job_count);
 		while(new_jobs > 0)
 		{
-			if(!run_concurrent_job_for_operator(o, NULL, build_right_side_partitions))
+			if(!run_concurrent_job_for_operator(o, NULL, inputs->is_radix_partitioned ? partition_right_side_tuples : build_right_side_partitions))
 				break;
 			inputs->active_build_phase_job_count++;
 			new_jobs--;
@@ -404,7 +799,7 @@ static void start_right_side_probe_for_left_tupled_jobs(operator* o)
 		uint32_t new_jobs = min(inputs->buffers_queue_size, inputs->max_concurrent_jobs_count - inputs->active_probe_phase_job_count);
 		while(new_jobs > 0)
 		{
-			if(!run_concurrent_job_for_operator(o, NULL, probe_right_side_partitions_using_left_tuples))
+			if(!run_concurrent_job_for_operator(o, NULL, inputs->is_radix_partitioned ? probe_radix_partitions_using_left_tuples : probe_right_side_partitions_using_left_tuples))
 				break;
 			inputs->active_probe_phase_job_count++;
 			new_jobs--;
@@ -421,7 +816,7 @@ static void start_right_side_only_probe_jobs(operator* o)
 	uint32_t new_jobs = inputs->max_concurrent_jobs_count;
 	while(new_jobs > 0)
 	{
-		if(!run_concurrent_job_for_operator(o, NULL, probe_right_side_partitions_for_right_only_tuples))
+		if(!run_concurrent_job_for_operator(o, NULL, inputs->is_radix_partitioned ? probe_radix_partitions_for_right_only_tuples : probe_right_side_partitions_for_right_only_tuples))
 			break;
 		inputs->active_right_only_probe_phase_job_count++;
 		new_jobs--;
@@ -429,6 +824,81 @@ static void start_right_side_only_probe_jobs(operator* o)
 	pthread_mutex_unlock(&(inputs->buffers_queue_lock));
 }
 
+// the right side did not fit in memory, so build all of the right_side_buffers into the rash_table partitions
+static void fall_back_to_rash_table_partitions(operator* o)
+{
+	input_values* inputs = o->inputs;
+
+	for(uint32_t i = 0; i < inputs->radix_partitions_count; i++)
+		free_all_chunks_of_radix_partition(&(inputs->radix_partitions[i]));
+
+	for(uint32_t i = 0; i < inputs->partitions_count; i++)
+	{
+		inputs->partitions[i] = malloc(sizeof(rash_table_partition));
+		pthread_mutex_init(&(inputs->partitions[i]->build_lock), NULL);
+		inputs->partitions[i]->rth = get_new_rash_table(INIT_BUCKET_COUNT, inputs->right_input_tuple_def, inputs->right_key_element_ids, inputs->key_element_count, o->self_query_plan->curr_tx, o->self_query_plan->curr_tx->rdb);
+	}
+
+	inputs->is_radix_partitioned = 0;
+
+	pthread_mutex_lock(&(inputs->buffers_queue_lock));
+	while(!is_empty_linkedlist(&(inputs->right_side_buffers)))
+	{
+		interim_tuple_store* its_p = (interim_tuple_store*) get_head_of_linkedlist(&(inputs->right_side_buffers));
+		remove_head_from_linkedlist(&(inputs->right_side_buffers));
+
+		// its ownership is changing, so unmap it's embed_regions
+		unmap_all_embed_regions_in_interim_tuple_store(its_p);
+
+		insert_tail_in_linkedlist(&(inputs->buffers_queue), its_p);
+		inputs->buffers_queue_size++;
+	}
+	pthread_mutex_unlock(&(inputs->buffers_queue_lock));
+
+	start_right_side_build_jobs(o);
+}
+
+// to be called once the right side is completely partitioned, it returns 1 only after the tables of all the radix_partitions are built
+static int are_radix_partition_tables_built(operator* o)
+{
+	input_values* inputs = o->inputs;
+
+	if(inputs->radix_partition_tables_state == 0)
+	{
+		if(atomic_load_explicit(&(inputs->is_radix_partitioning_failed), memory_order_relaxed))
+		{
+			fall_back_to_rash_table_partitions(o);
+			return 0;
+		}
+
+		inputs->radix_partition_tables_state = 1;
+
+		pthread_mutex_lock(&(inputs->buffers_queue_lock));
+		uint32_t new_jobs = min(inputs->max_concurrent_jobs_count, inputs->radix_partitions_count);
+		while(new_jobs > 0)
+		{
+			if(!run_concurrent_job_for_operator(o, NULL, build_radix_partition_tables))
+				break;
+			inputs->active_radix_partition_tables_build_job_count++;
+			new_jobs--;
+		}
+		pthread_mutex_unlock(&(inputs->buffers_queue_lock));
+
+		// build them here, if no jobs could be started
+		build_claimed_radix_partition_tables(o);
+	}
+
+	if(inputs->radix_partition_tables_state == 1)
+	{
+		pthread_mutex_lock(&(inputs->buffers_queue_lock));
+		if(inputs->active_radix_partition_tables_build_job_count == 0)
+			inputs->radix_partition_tables_state = 2;
+		pthread_mutex_unlock(&(inputs->buffers_queue_lock));
+	}
+
+	return inputs->radix_partition_tables_state == 2;
+}
+
 static int should_produce_more_for_buffers_queue(operator* o)
 {
 	input_values* inputs = o->inputs;
@@ -453,7 +923,8 @@ static void execute(operator* o)
 				return;
 
 			int no_more_data = 0;
-			const void* tuple = consume_for_consumption_iterator(inputs->right_input_iterator, &no_more_data);
+			const void* tuples[OPERATOR_TUPLE_BATCH_SIZE];
+			uint32_t tuples_count = consume_batch_for_consumption_iterator(inputs->right_input_iterator, tuples, OPERATOR_TUPLE_BATCH_SIZE, &no_more_data);
 			if(no_more_data)
 			{
 				// this signals completion of build phase
@@ -484,12 +955,13 @@ static void execute(operator* o)
 				return ;
 			}
 
-			if(tuple != NULL)
+			if(tuples_count > 0)
 			{
 				if(inputs->pending_buffer == NULL)
 					inputs->pending_buffer = get_new_interim_tuple_store(inputs->min_pending_buffer_size);
 
-				append_tuple_to_interim_tuple_store2(inputs->pending_buffer, &(inputs->pending_buffer->embed_regions[0]), tuple, &(inputs->right_input_tuple_def->size_def), inputs->min_pending_buffer_size);
+				for(uint32_t i = 0; i < tuples_count; i++)
+					append_tuple_to_interim_tuple_store2(inputs->pending_buffer, &(inputs->pending_buffer->embed_regions[0]), tuples[i], &(inputs->right_input_tuple_def->size_def), inputs->min_pending_buffer_size);
 
 				if(get_total_bytes_in_interim_tuple_store(inputs->pending_buffer) >= inputs->min_pending_buffer_size)
 				{
@@ -518,10 +990,16 @@ static void execute(operator* o)
 		if(inputs->phase == 0)
 		{
 			pthread_mutex_lock(&(inputs->buffers_queue_lock));
-			if(inputs->buffers_queue_size == 0 && inputs->active_build_phase_job_count == 0)
-				inputs->phase = 1;
+			int is_right_side_built = (inputs->buffers_queue_size == 0 && inputs->active_build_phase_job_count == 0);
 			pthread_mutex_unlock(&(inputs->buffers_queue_lock));
 
+			// the radix_partitions also need their tables built, before they can be probed
+			if(is_right_side_built && inputs->is_radix_partitioned)
+				is_right_side_built = are_radix_partition_tables_built(o);
+
+			if(is_right_side_built)
+				inputs->phase = 1;
+
 			if(inputs->phase == 0) // if the phase is still 0, return immediately
 				return ;
 		}
@@ -532,7 +1010,8 @@ static void execute(operator* o)
 				return;
 
 			int no_more_data = 0;
-			const void* tuple = consume_for_consumption_iterator(inputs->left_input_iterator, &no_more_data);
+			const void* tuples[OPERATOR_TUPLE_BATCH_SIZE];
+			uint32_t tuples_count = consume_batch_for_consumption_iterator(inputs->left_input_iterator, tuples, OPERATOR_TUPLE_BATCH_SIZE, &no_more_data);
 			if(no_more_data)
 			{
 				// this signals completion of probe phase
@@ -563,12 +1042,13 @@ static void execute(operator* o)
 				return ;
 			}
 
-			if(tuple != NULL)
+			if(tuples_count > 0)
 			{
 				if(inputs->pending_buffer == NULL)
 					inputs->pending_buffer = get_new_interim_tuple_store(inputs->min_pending_buffer_size);
 
-				append_tuple_to_interim_tuple_store2(inputs->pending_buffer, &(inputs->pending_buffer->embed_regions[0]), tuple, &(inputs->left_input_tuple_def->size_def), inputs->min_pending_buffer_size);
+				for(uint32_t i = 0; i < tuples_count; i++)
+					append_tuple_to_interim_tuple_store2(inputs->pending_buffer, &(inputs->pending_buffer->embed_regions[0]), tuples[i], &(inputs->left_input_tuple_def->size_def), inputs->min_pending_buffer_size);
 
 				if(get_total_bytes_in_interim_tuple_store(inputs->pending_buffer) >= inputs->min_pending_buffer_size)
 				{
@@ -667,8 +1147,18 @@ static void clean_up_resources(operator* o)
 	}
 	free(inputs->partitions);
 
+	for(uint32_t i = 0; i < inputs->radix_partitions_count; i++)
+	{
+		free_all_chunks_of_radix_partition(&(inputs->radix_partitions[i]));
+		deinitialize_flat_hash_table(&(inputs->radix_partitions[i].table));
+	}
+	free(inputs->radix_partitions);
+
 	remove_all_from_linkedlist(&(inputs->buffers_queue), DELETE_ON_NOTIFY_FOR_INTERIM_TUPLE_STORE);
 
+	// the radix_partitions were pointing into these, so they are deleted only after them
+	remove_all_from_linkedlist(&(inputs->right_side_buffers), DELETE_ON_NOTIFY_FOR_INTERIM_TUPLE_STORE);
+
 	pthread_mutex_destroy(&(inputs->partition_to_right_only_join_next_lock));
 	pthread_mutex_destroy(&(inputs->buffers_queue_lock));
 }
@@ -782,6 +1272,11 @@ operator_resource_counter setup_hash_join_operator(operator* o, operator* left_i
 
 	init_tuple_transformers(&(o->output_tuple_transformers), output_tuple_def);
 
+	// the right side is first attempted to be radix partitioned in memory, into atleast partitions_count partitions
+	uint32_t radix_partitions_count = 1;
+	while(radix_partitions_count < partitions_count)
+		radix_partitions_count <<= 1;
+
 	o->inputs = malloc(sizeof(input_values));
 	input_values* inputs = o->inputs;
 	*inputs = (input_values){
@@ -802,7 +1297,15 @@ operator_resource_counter setup_hash_join_operator(operator* o, operator* left_i
 		.pending_buffer = NULL,
 
 		.partitions_count = partitions_count,
-		.partitions = malloc(sizeof(rash_table_partition*) * partitions_count),
+		.partitions = calloc(partitions_count, sizeof(rash_table_partition*)),
+
+		.is_radix_partitioned = 1,
+		.radix_partitions_count = radix_partitions_count,
+		.radix_partitions = calloc(radix_partitions_count, sizeof(radix_partition)),
+		.is_radix_partitioning_failed = 0,
+		.radix_partition_tables_state = 0,
+		.radix_partition_to_build_next = 0,
+		.active_radix_partition_tables_build_job_count = 0,
 
 		.partition_to_right_only_join_next_lock = PTHREAD_MUTEX_INITIALIZER,
 		.partition_to_right_only_join_next = 0,
@@ -821,14 +1324,10 @@ operator_resource_counter setup_hash_join_operator(operator* o, operator* left_i
 		.phase = 0, // always start with phase 0
 	};
 
-	for(uint32_t i = 0; i < partitions_count; i++)
-	{
-		inputs->partitions[i] = malloc(sizeof(rash_table_partition));
-		pthread_mutex_init(&(inputs->partitions[i]->build_lock), NULL);
-		inputs->partitions[i]->rth = get_new_rash_table(INIT_BUCKET_COUNT, right_input_tuple_def, right_key_element_ids, key_element_count, o->self_query_plan->curr_tx, o->self_query_plan->curr_tx->rdb);
-	}
+	// the rash_table partitions are only created, if the right side does not fit in memory
 
 	initialize_linkedlist(&(inputs->buffers_queue), offsetof(interim_tuple_store, embed_node_ll));
+	initialize_linkedlist(&(inputs->right_side_buffers), offsetof(interim_tuple_store, embed_node_ll));
 
 	return result;
 }
\ No newline at end of file
@@ -5,13 +5,12 @@
 #include<rhendb/transaction.h>
 
 #include<rhendb/function_compare.h>
+#include<rhendb/normalized_key.h>
+#include<rhendb/loser_tree.h>
 
 #include<tuplestore/tuple.h>
 #include<tuplestore/datum.h>
 
-#include<cutlery/singlylist.h>
-#include<cutlery/pheap.h>
-
 #include<stdlib.h>
 
 typedef struct input_values input_values;
@@ -23,79 +22,123 @@ struct input_values
 	const positional_accessor* key_element_ids;
 	const compare_direction* key_compare_direction;
 
-	pheap ready_input_iterators;
+	// input_iterators[i] is the leaf i of the ready_input_iterators, it is set to NULL once the input_iterator is destroyed
+	uint32_t input_iterators_count;
+	consumption_iterator** input_iterators;
 
-	singlylist waiting_input_iterators;
+	// leaves get their first tuples in order, until all of them have it, only then the ready_input_iterators is built
+	// after that only the winner leaf may be waiting for its next tuple
+	uint32_t leaves_fetched_count;
+	int is_winner_waiting;
+	loser_tree ready_input_iterators;
 
 	const data_type_info** key_dtis;
 	datum* keys;
+
+	// normalized_key of the head tuples of the input_iterators, only built if use_normalized_keys is set
+	normalized_key* nkeys;
+	int use_normalized_keys;
 };
 
-static int compare_consumption_iterators(const void* context_p, const void* cit1_vp, const void* cit2_vp)
+static int compare_input_iterator_heads(const void* context_p, uint32_t leaf1, uint32_t leaf2)
 {
 	const operator* o = context_p;
 	const input_values* inputs = o->inputs;
 
-	const consumption_iterator* cit1_p = cit1_vp;
-	const consumption_iterator* cit2_p = cit2_vp;
+	if(inputs->use_normalized_keys)
+	{
+		int is_decided = 0;
+		int cmp = compare_normalized_keys(&(inputs->nkeys[leaf1]), &(inputs->nkeys[leaf2]), &is_decided);
+		if(is_decided)
+			return cmp;
+	}
+
+	const consumption_iterator* cit1_p = inputs->input_iterators[leaf1];
+	const consumption_iterator* cit2_p = inputs->input_iterators[leaf2];
 
 	return compare_datums3_rhendb(cit1_p->embed_ptrs[1], cit2_p->embed_ptrs[1], inputs->key_dtis, inputs->key_compare_direction, inputs->key_element_count, o->self_query_plan->curr_tx);
 }
 
 // we materialize, the keys in cit_p->embed_ptrs[1], using it as datum[] having inputs->key_element_count elements long
-static void revise_materialized_keys_in_consumption_iterator(operator* o, consumption_iterator* cit_p)
+// and build its normalized_key from them
+static void revise_materialized_keys_in_consumption_iterator(operator* o, uint32_t leaf)
 {
 	input_values* inputs = o->inputs;
+	consumption_iterator* cit_p = inputs->input_iterators[leaf];
 
 	for(uint32_t j = 0; j < inputs->key_element_count; j++)
 		if(!get_value_from_element_from_tuple(&(((datum*)(cit_p->embed_ptrs[1]))[j]), inputs->record_def, inputs->key_element_ids[j], cit_p->embed_ptrs[0]))
 			((datum*)(cit_p->embed_ptrs[1]))[j] = (*NULL_DATUM);
+
+	if(inputs->use_normalized_keys)
+		build_normalized_key(&(inputs->nkeys[leaf]), cit_p->embed_ptrs[1], inputs->key_dtis, inputs->key_compare_direction, inputs->key_element_count);
 }
 
-static void execute(operator* o)
+// fetches the next tuple of the input_iterator at the leaf into its embed_ptrs[0]
+// returns 1 if the leaf has a tuple or got exhausted (its input_iterator is then destroyed and the leaf is marked exhausted)
+// returns 0, if the leaf must wait, and the operator is killed if it can not proceed
+static int fetch_head_of_input_iterator(operator* o, uint32_t leaf)
 {
 	input_values* inputs = o->inputs;
+	consumption_iterator* cit_p = inputs->input_iterators[leaf];
 
-	// iterate over all waiting_input_iterators and fetch their next tuples and store it in embed_ptrs[0]
-	// and also move it friom waiting_input_iterators to ready_input_iterators
-	while(!is_empty_singlylist(&(inputs->waiting_input_iterators)))
+	int no_more_data = 0;
+	cit_p->embed_ptrs[0] = (void*) consume_for_consumption_iterator(cit_p, &no_more_data);
+	if(no_more_data)
 	{
-		consumption_iterator* cit_p = (consumption_iterator*) get_head_of_singlylist(&(inputs->waiting_input_iterators));
+		destroy_consumption_iterator(cit_p);
+		inputs->input_iterators[leaf] = NULL;
+		mark_exhausted_in_loser_tree(&(inputs->ready_input_iterators), leaf);
+		return 1;
+	}
+	if(can_not_proceed_for_execution_operator(o))
+	{
+		kill_signal_for_self_operator(o, get_dstring_pointing_to_literal_cstring("could_not_consume"));
+		return 0;
+	}
 
-		int no_more_data = 0;
-		cit_p->embed_ptrs[0] = (void*) consume_for_consumption_iterator(cit_p, &no_more_data);
-		if(no_more_data)
-		{
-			remove_head_from_singlylist(&(inputs->waiting_input_iterators));
-			destroy_consumption_iterator(cit_p);
-			continue;
-		}
-		if(can_not_proceed_for_execution_operator(o))
-		{
-			kill_signal_for_self_operator(o, get_dstring_pointing_to_literal_cstring("could_not_consume"));
-			return ;
-		}
+	if(cit_p->embed_ptrs[0] != NULL)
+	{
+		revise_materialized_keys_in_consumption_iterator(o, leaf);
+		return 1;
+	}
+	else
+		return 0;
+}
+
+static void execute(operator* o)
+{
+	input_values* inputs = o->inputs;
 
-		if(cit_p->embed_ptrs[0] != NULL)
+	// fetch the first tuples of all the input_iterators, in order, before building the ready_input_iterators
+	if(inputs->leaves_fetched_count < inputs->input_iterators_count)
+	{
+		while(inputs->leaves_fetched_count < inputs->input_iterators_count)
 		{
-			remove_head_from_singlylist(&(inputs->waiting_input_iterators));
-			revise_materialized_keys_in_consumption_iterator(o, cit_p);
-			push_to_pheap(&(inputs->ready_input_iterators), cit_p);
-			continue;
+			if(!fetch_head_of_input_iterator(o, inputs->leaves_fetched_count))
+				return;
+			inputs->leaves_fetched_count++;
 		}
-		else
-		{
+
+		build_loser_tree(&(inputs->ready_input_iterators));
+	}
+
+	// the winner was waiting for its next tuple, in the last call to execute
+	if(inputs->is_winner_waiting)
+	{
+		if(!fetch_head_of_input_iterator(o, get_winner_of_loser_tree(&(inputs->ready_input_iterators))))
 			return;
-		}
+		inputs->is_winner_waiting = 0;
+		replay_winner_of_loser_tree(&(inputs->ready_input_iterators));
 	}
 
 	// now we know for sure that we are not waiting for input tuples from any input_operators
 
-	// so iterate over the ready_input_iterators and pick the smallest and produce it, as long as the waiting_input_iteratros is empty
-	while(!is_empty_pheap(&(inputs->ready_input_iterators)))
+	// so pick the winner and produce it, as long as it does not have to wait for its next tuple
+	while(!is_exhausted_loser_tree(&(inputs->ready_input_iterators)))
 	{
-		// fetch the top of the min pheap
-		consumption_iterator* cit_p = (consumption_iterator*) get_top_of_pheap(&(inputs->ready_input_iterators));
+		uint32_t winner = get_winner_of_loser_tree(&(inputs->ready_input_iterators));
+		consumption_iterator* cit_p = inputs->input_iterators[winner];
 
 		const void* tuple = cit_p->embed_ptrs[0];
 		cit_p->embed_ptrs[0] = NULL;
@@ -110,37 +153,14 @@ static void execute(operator* o)
 			}
 		}
 
-		// fetch the next tuple, if it is successfully fetch then heapify and continue
-		// else move it into waiting_input_iterators
-		int no_more_data = 0;
-		cit_p->embed_ptrs[0] = (void*) consume_for_consumption_iterator(cit_p, &no_more_data);
-
-		if(no_more_data)
+		// fetch the next tuple, if it is successfully fetched (or the winner got exhausted) then replay and continue
+		// else the winner waits, and we can no longer proceed with this loop
+		if(!fetch_head_of_input_iterator(o, winner))
 		{
-			remove_from_pheap(&(inputs->ready_input_iterators), cit_p);
-			destroy_consumption_iterator(cit_p);
-			continue;
-		}
-		if(can_not_proceed_for_execution_operator(o))
-		{
-			kill_signal_for_self_operator(o, get_dstring_pointing_to_literal_cstring("could_not_consume"));
-			return ;
-		}
-
-		if(cit_p->embed_ptrs[0] != NULL)
-		{
-			revise_materialized_keys_in_consumption_iterator(o, cit_p);
-			heapify_for_in_pheap(&(inputs->ready_input_iterators), cit_p);
-			continue;
-		}
-		else
-		{
-			remove_from_pheap(&(inputs->ready_input_iterators), cit_p);
-			insert_tail_in_singlylist(&(inputs->waiting_input_iterators), cit_p);
-
-			// waiting_input_iterators now has something so we can no longer proceed with this loop
+			inputs->is_winner_waiting = 1;
 			return;
 		}
+		replay_winner_of_loser_tree(&(inputs->ready_input_iterators));
 	}
 
 	// if there is nothing ready (there already is nothing in waiting also), we are done, we quit with success
@@ -152,11 +172,15 @@ static void clean_up_resources(operator* o)
 {
 	input_values* inputs = o->inputs;
 
-	remove_all_from_pheap(&(inputs->ready_input_iterators), DELETE_ON_NOTIFY_FOR_CONSUMPTION_ITERATOR);
+	for(uint32_t i = 0; i < inputs->input_iterators_count; i++)
+		if(inputs->input_iterators[i] != NULL)
+			destroy_consumption_iterator(inputs->input_iterators[i]);
 
-	remove_all_from_singlylist(&(inputs->waiting_input_iterators), DELETE_ON_NOTIFY_FOR_CONSUMPTION_ITERATOR);
+	deinitialize_loser_tree(&(inputs->ready_input_iterators));
 
+	free(inputs->input_iterators);
 	free(inputs->keys);
+	free(inputs->nkeys);
 	free(inputs->key_dtis);
 }
 
@@ -199,20 +223,24 @@ operator_resource_counter setup_merge_sorted_inputs_operator(operator* o, operat
 		.key_compare_direction = key_compare_direction,
 		.key_dtis = malloc(sizeof(data_type_info*) * key_element_count),
 		.keys = malloc(sizeof(datum) * key_element_count * input_operators_count),
+		.input_iterators_count = input_operators_count,
+		.input_iterators = malloc(sizeof(consumption_iterator*) * input_operators_count),
+		.nkeys = malloc(sizeof(normalized_key) * input_operators_count),
 	};
 
 	for(uint32_t j = 0; j < key_element_count; j++)
 		inputs->key_dtis[j] = get_type_info_for_element_from_tuple_def(inputs->record_def, key_element_ids[j]);
 
-	initialize_pheap(&(inputs->ready_input_iterators), MIN_HEAP, LEFTIST, &contexted_comparator(o, compare_consumption_iterators), offsetof(consumption_iterator, embed_node_php));
-	initialize_singlylist(&(inputs->waiting_input_iterators), offsetof(consumption_iterator, embed_node_sl));
+	inputs->use_normalized_keys = can_build_normalized_key(inputs->key_dtis, key_element_count);
+
+	initialize_loser_tree(&(inputs->ready_input_iterators), input_operators_count, o, compare_input_iterator_heads);
 
 	for(uint32_t i = 0; i < input_operators_count; i++)
 	{
 		consumption_iterator* cit_p = create_consumption_iterator(input_operators[i], o, NULL, NULL);
 		cit_p->embed_ptrs[0] = NULL;
 		cit_p->embed_ptrs[1] = &(inputs->keys[i * key_element_count]);
-		insert_tail_in_singlylist(&(inputs->waiting_input_iterators), cit_p);
+		inputs->input_iterators[i] = cit_p;
 	}
 
 	return result;
@@ -5,9 +5,11 @@
 #include<rhendb/transaction.h>
 
 #include<rhendb/mvcc_header.h>
+#include<rhendb/mvcc_hints_write_back.h>
 
 #include<rhendb/table_operator_output_type.h>
 #include<rhendb/fetched_table.h>
+#include<rhendb/heap_page_morsel_cursor.h>
 
 #include<tupleindexer/heap_page/heap_page.h>
 
@@ -55,6 +57,10 @@ struct input_values
 
 	int additional_flags; // same flags as given in transaction.h, toggles the additional book keeping this operator performs
 
+	// the hints discovered on the tuples of the page being read, to be written back after its read lock is released
+	// only used if MVCC_HINTS_WRITE_BACK_ENABLED is set in the additional_flags
+	mvcc_hints_write_back mhwb;
+
 	transaction* tx;
 };
 
@@ -77,6 +83,13 @@ static int compare_pending_lookups_by_partition_id_and_tuple_pointer(const void*
 	return 0;
 }
 
+static void get_tuple_pointer_of_pending_lookup(const void* to_be_looked_up, cy_uint index, uint64_t* partition_id, tuple_pointer* tptr)
+{
+	const pending_lookup* pl = get_from_front_of_pending_lookups(to_be_looked_up, index);
+	(*partition_id) = pl->partition_id;
+	(*tptr) = pl->tptr;
+}
+
 // produces the output tuple for a pending_lookup that was just found visible,
 // returns 0, only if the tuple could not be produced, in which case the caller must kill itself
 static int produce_output_for_pending_lookup(operator* o, const pending_lookup* pl, const void* heap_record, uint64_t partition_index_in_info)
@@ -173,24 +186,16 @@ static int lookup_buffered_tuples(operator* o, const char** kill_reason)
 	if(!merge_sort_pending_lookups(&(inputs->to_be_looked_up), 0, to_be_looked_up_count - 1, &simple_comparator(compare_pending_lookups_by_partition_id_and_tuple_pointer), STD_C_mem_allocator))
 		exit(-1);
 
-	// index over the to_be_looked_up buffer, and index over the partitions of the table,
-	// both of them are only ever incremented, making the below loop linear in their lengths
-	cy_uint i = 0;
-	uint64_t p = 0;
+	// the sorted buffer is handed out in morsels, each of them being all the tuples to be looked up on a few pages of a single partition
+	heap_page_morsel_cursor hpmc;
+	initialize_heap_page_morsel_cursor_for_sorted_tuple_pointers(&hpmc, inputs->ftabl, DEFAULT_HEAP_PAGES_PER_MORSEL, &(inputs->to_be_looked_up), to_be_looked_up_count, get_tuple_pointer_of_pending_lookup);
 
-	while(i < to_be_looked_up_count)
+	heap_page_morsel morsel;
+	int claim_abort_error = 0;
+	while(claim_heap_page_morsel(&hpmc, &morsel, &claim_abort_error))
 	{
-		uint64_t partition_id = get_from_front_of_pending_lookups(&(inputs->to_be_looked_up), i)->partition_id;
-
-		// advance over all the partitions that no tuple is to be looked up from
-		while(p < inputs->ftabl->partitions_count && inputs->ftabl->table_partitions_info[p].partition_id < partition_id)
-			p++;
-
-		if(p == inputs->ftabl->partitions_count || inputs->ftabl->table_partitions_info[p].partition_id != partition_id)
-		{
-			printf("ISSUE in (pointer_lookup_operator) :: no partition with partition_id = %" PRIu64 " in table with table_id = %" PRIu64 "\n", partition_id, inputs->ftabl->table_info.id);
-			exit(-1);
-		}
+		uint64_t p = morsel.partition_index_in_info;
+		uint64_t partition_id = inputs->ftabl->table_partitions_info[p].partition_id;
 
 		const tuple_def* partition_tuple_def = &(inputs->ftabl->table_partition_tuple_defs[p]);
 
@@ -199,7 +204,8 @@ static int lookup_buffered_tuples(operator* o, const char** kill_reason)
 		initialize_tuple_def(&mvcc_def, (data_type_info*)(partition_tuple_def->type_info->containees[0].al.type_info));
 
 		// all the tuples to be looked up on a single page, are read under a single read lock on it
-		while(i < to_be_looked_up_count && get_from_front_of_pending_lookups(&(inputs->to_be_looked_up), i)->partition_id == partition_id)
+		cy_uint i = morsel.first_index;
+		while(i < morsel.last_index)
 		{
 			uint64_t page_id = get_from_front_of_pending_lookups(&(inputs->to_be_looked_up), i)->tptr.page_id;
 
@@ -211,11 +217,12 @@ static int lookup_buffered_tuples(operator* o, const char** kill_reason)
 			if(abort_error)
 			{
 				(*kill_reason) = "pointer_lookup_read_only_page_read_aborted";
+				deinitialize_heap_page_morsel_cursor(&hpmc);
 				return 0;
 			}
 
 			// read every tuple that is to be looked up on this very page
-			while(i < to_be_looked_up_count)
+			while(i < morsel.last_index)
 			{
 				const pending_lookup* pl = get_from_front_of_pending_lookups(&(inputs->to_be_looked_up), i);
 				if(pl->partition_id != partition_id || pl->tptr.page_id != page_id)
@@ -245,7 +252,12 @@ static int lookup_buffered_tuples(operator* o, const char** kill_reason)
 					read_mvcc_header(&mvcchdr, mvcc_hdr_datum.tuple_value, &mvcc_def);
 
 					int were_hints_updated = 0;
-					if(!is_tuple_visible_to_mvcc_snapshot(inputs->tx->snapshot, &mvcchdr, &(inputs->tx->rdb->tsg), &were_hints_updated))
+					int is_visible = is_tuple_visible_to_mvcc_snapshot(inputs->tx->snapshot, &mvcchdr, &(inputs->tx->rdb->tsg), &were_hints_updated);
+
+					if(were_hints_updated && IS_MVCC_HINTS_WRITE_BACK_ENABLED(inputs->additional_flags))
+						append_to_mvcc_hints_write_back(&(inputs->mhwb), page_id, pl->tptr.tuple_index, &mvcchdr);
+
+					if(!is_visible)
 					{
 						i++;
 						continue;
@@ -255,7 +267,9 @@ static int lookup_buffered_tuples(operator* o, const char** kill_reason)
 				if(!produce_output_for_pending_lookup(o, pl, record, p))
 				{
 					release_lock_on_persistent_page(engine->pam_p, NULL, &ppage, NONE_OPTION, &abort_error);
+					flush_mvcc_hints_write_back(&(inputs->mhwb), engine, partition_tuple_def, &mvcc_def);
 					(*kill_reason) = "could_not_produce";
+					deinitialize_heap_page_morsel_cursor(&hpmc);
 					return 0;
 				}
 
@@ -267,11 +281,17 @@ static int lookup_buffered_tuples(operator* o, const char** kill_reason)
 			if(abort_error)
 			{
 				(*kill_reason) = "pointer_lookup_read_only_page_release_aborted";
+				deinitialize_heap_page_morsel_cursor(&hpmc);
 				return 0;
 			}
+
+			// write back the hints discovered on this page, it is never an error if they could not be written
+			flush_mvcc_hints_write_back(&(inputs->mhwb), engine, partition_tuple_def, &mvcc_def);
 		}
 	}
 
+	deinitialize_heap_page_morsel_cursor(&hpmc);
+
 	// every buffered tuple is looked up now, so the buffer can be emptied
 	remove_all_from_pending_lookups(&(inputs->to_be_looked_up));
 
@@ -361,6 +381,8 @@ static void clean_up_resources(operator* o)
 	}
 
 	deinitialize_pending_lookups(&(inputs->to_be_looked_up));
+
+	deinitialize_mvcc_hints_write_back(&(inputs->mhwb));
 }
 
 static void free_resources(operator* o)
@@ -478,5 +500,7 @@ operator_resource_counter setup_pointer_lookup_operator(operator* o, operator* i
 	if(!initialize_pending_lookups(&(inputs->to_be_looked_up), lookup_batch_size))
 		exit(-1);
 
+	initialize_mvcc_hints_write_back(&(inputs->mhwb));
+
 	return result;
 }
\ No newline at end of file
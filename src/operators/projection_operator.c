@@ -31,6 +31,62 @@ struct input_values
 	const tuple_def* output_tuple_def;
 };
 
+// builds a new output_tuple for the input tuple, returns NULL, only if the projection expression errored
+static void* project_tuple(operator* o, const void* tuple)
+{
+	input_values* inputs = o->inputs;
+
+	// set the input tuples
+	set_input_tuples_in_context_for_rhendb_v(&(inputs->ec), 1, tuple);
+
+	// generate the smallest possible tuple
+	uint32_t output_tuple_size = get_minimum_tuple_size(inputs->output_tuple_def);
+	uint64_t output_tuple_capacity = output_tuple_size;
+	void* output_tuple = malloc(output_tuple_capacity);
+	init_tuple(inputs->output_tuple_def, output_tuple);
+
+	for(uint32_t i = 0, e = 0; i < inputs->projection_descriptions_count; i++)
+	{
+		datum output_uval;
+
+		projected_value temp_proj_uval;
+		if(inputs->projection_descriptions[i].type == PROJECT_EXPRESSION)
+		{
+			int error_code = 0;
+			temp_proj_uval = project_using_evaluate_sql_expr_for_rhendb(inputs->projection_descriptions[i].expr, &(inputs->ec), inputs->projected_expression_type_infos[e], &error_code);
+			if(error_code)
+			{
+				free(output_tuple);
+				return NULL;
+			}
+			output_uval = temp_proj_uval.value;
+		}
+		else
+		{
+			if(!get_value_from_element_from_tuple(&output_uval, inputs->input_tuple_def, inputs->projection_descriptions[i].pa, tuple))
+				output_uval = (*NULL_DATUM);
+		}
+
+		// ensure there are enough bytes in the output_tuple, as we try to insert this datum
+		while(!set_element_in_tuple(inputs->output_tuple_def, STATIC_POSITION(i), output_tuple, &output_uval, output_tuple_capacity - output_tuple_size))
+		{
+			output_tuple_capacity = min(output_tuple_capacity * 2, get_maximum_tuple_size(inputs->output_tuple_def));
+			output_tuple = realloc(output_tuple, output_tuple_capacity);
+		}
+
+		// recompute tuple_size
+		output_tuple_size = get_tuple_size(inputs->output_tuple_def, output_tuple);
+
+		if(inputs->projection_descriptions[i].type == PROJECT_EXPRESSION)
+		{
+			destroy_projected_value(temp_proj_uval);
+			e++;
+		}
+	}
+
+	return output_tuple;
+}
+
 static void execute(operator* o)
 {
 	input_values* inputs = o->inputs;
@@ -38,7 +94,8 @@ static void execute(operator* o)
 	while(1)
 	{
 		int no_more_data = 0;
-		const void* tuple = consume_for_consumption_iterator(inputs->input_iterator, &no_more_data);
+		const void* tuples[OPERATOR_TUPLE_BATCH_SIZE];
+		uint32_t tuples_count = consume_batch_for_consumption_iterator(inputs->input_iterator, tuples, OPERATOR_TUPLE_BATCH_SIZE, &no_more_data);
 		if(no_more_data)
 		{
 			kill_signal_for_self_operator(o, get_dstring_pointing_to_literal_cstring("completed_and_killed"));
@@ -50,59 +107,31 @@ static void execute(operator* o)
 			return ;
 		}
 
-		if(tuple != NULL)
+		if(tuples_count > 0)
 		{
-			// set the input tuples
-			set_input_tuples_in_context_for_rhendb_v(&(inputs->ec), 1, tuple);
+			// project the whole batch, and then produce it all together
+			void* output_tuples[OPERATOR_TUPLE_BATCH_SIZE];
+			uint32_t output_tuples_count = 0;
 
-			// generate the smallest possible tuple
-			uint32_t output_tuple_size = get_minimum_tuple_size(inputs->output_tuple_def);
-			uint64_t output_tuple_capacity = output_tuple_size;
-			void* output_tuple = malloc(output_tuple_capacity);
-			init_tuple(inputs->output_tuple_def, output_tuple);
+			for(; output_tuples_count < tuples_count; output_tuples_count++)
+			{
+				output_tuples[output_tuples_count] = project_tuple(o, tuples[output_tuples_count]);
+				if(output_tuples[output_tuples_count] == NULL)
+					break;
+			}
 
-			for(uint32_t i = 0, e = 0; i < inputs->projection_descriptions_count; i++)
+			// projection errored for some tuple, so the projected ones are discarded
+			if(output_tuples_count < tuples_count)
 			{
-				datum output_uval;
-
-				projected_value temp_proj_uval;
-				if(inputs->projection_descriptions[i].type == PROJECT_EXPRESSION)
-				{
-					int error_code = 0;
-					temp_proj_uval = project_using_evaluate_sql_expr_for_rhendb(inputs->projection_descriptions[i].expr, &(inputs->ec), inputs->projected_expression_type_infos[e], &error_code);
-					if(error_code)
-					{
-						free(output_tuple);
-						kill_signal_for_self_operator(o, get_dstring_pointing_to_literal_cstring("errored_from_projection_expression"));
-						return ;
-					}
-					output_uval = temp_proj_uval.value;
-				}
-				else
-				{
-					if(!get_value_from_element_from_tuple(&output_uval, inputs->input_tuple_def, inputs->projection_descriptions[i].pa, tuple))
-						output_uval = (*NULL_DATUM);
-				}
-
-				// ensure there are enough bytes in the output_tuple, as we try to insert this datum
-				while(!set_element_in_tuple(inputs->output_tuple_def, STATIC_POSITION(i), output_tuple, &output_uval, output_tuple_capacity - output_tuple_size))
-				{
-					output_tuple_capacity = min(output_tuple_capacity * 2, get_maximum_tuple_size(inputs->output_tuple_def));
-					output_tuple = realloc(output_tuple, output_tuple_capacity);
-				}
-
-				// recompute tuple_size
-				output_tuple_size = get_tuple_size(inputs->output_tuple_def, output_tuple);
-
-				if(inputs->projection_descriptions[i].type == PROJECT_EXPRESSION)
-				{
-					destroy_projected_value(temp_proj_uval);
-					e++;
-				}
+				for(uint32_t i = 0; i < output_tuples_count; i++)
+					free(output_tuples[i]);
+				kill_signal_for_self_operator(o, get_dstring_pointing_to_literal_cstring("errored_from_projection_expression"));
+				return ;
 			}
 
-			int produced = produce_tuple_from_operator(o, output_tuple);
-			free(output_tuple);
+			int produced = produce_tuples_from_operator(o, output_tuples, output_tuples_count);
+			for(uint32_t i = 0; i < output_tuples_count; i++)
+				free(output_tuples[i]);
 			if(!produced)
 			{
 				kill_signal_for_self_operator(o, get_dstring_pointing_to_literal_cstring("could_not_produce"));
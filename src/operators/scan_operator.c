@@ -5,9 +5,11 @@
 #include<rhendb/transaction.h>
 
 #include<rhendb/mvcc_header.h>
+#include<rhendb/mvcc_hints_write_back.h>
 
 #include<rhendb/table_operator_output_type.h>
 #include<rhendb/fetched_table.h>
+#include<rhendb/heap_page_morsel_cursor.h>
 
 #include<tupleindexer/heap_page/heap_page.h>
 #include<tupleindexer/heap_table/heap_table.h>
@@ -23,14 +25,14 @@ struct input_values
 	// the table being scanned, all of its partitions are scanned, from the first to the last one
 	const fetched_table* ftabl;
 
-	// number of jobs that may scan the partitions of this table concurrently, one job is assigned
-	// to atmost one partition at any point of time
+	// number of jobs that may scan this table concurrently, they all claim the heap_page_morsel-s from the hpmc
+	// so even the heap pages of a single partition are scanned by all of them
 	uint32_t max_concurrent_jobs_count;
 
-	// partition_pos is the position of the next partition that is yet to be picked up by a scan job,
-	// it starts at 0 and is incremented until it reaches the partitions_count of the ftabl,
-	pthread_mutex_t partition_pos_lock; // also protects active_scan_job_count
-	uint64_t partition_pos;
+	// walks the heap_tables of all the partitions, from the first to the last one, handing out their heap pages to the scan jobs
+	heap_page_morsel_cursor hpmc;
+
+	pthread_mutex_t scan_jobs_lock; // protects active_scan_job_count and scan_jobs_started
 	uint32_t active_scan_job_count;
 
 	int scan_jobs_started; // this flag will be set if the scan jobs were started by the execute function
@@ -44,17 +46,14 @@ struct input_values
 	transaction* tx;
 };
 
-// produces the output tuple for a single visible tuple of the partition at partition_index_in_info,
-// returns 0, only if the tuple could not be produced, in which case the caller must kill itself
-static int produce_output_for_scanned_tuple(operator* o, uint64_t partition_index_in_info, tuple_pointer tptr, const void* heap_record)
+// builds the output tuple for a single visible tuple of the partition at partition_index_in_info,
+// the returned tuple must be freed by the caller, after it has been produced
+static void* build_output_for_scanned_tuple(operator* o, uint64_t partition_index_in_info, tuple_pointer tptr, const void* heap_record)
 {
 	input_values* inputs = o->inputs;
 
 	rage_engine* engine = &(inputs->tx->rdb->persistent_acid_rage_engine);
 
-	if(inputs->output_flags == 0)
-		return 1;
-
 	uint32_t output_tuple_size = get_minimum_tuple_size(inputs->output_tuple_def);
 	uint64_t output_tuple_capacity = output_tuple_size;
 	void* output_tuple = malloc(output_tuple_capacity);
@@ -117,21 +116,18 @@ static int produce_output_for_scanned_tuple(operator* o, uint64_t partition_inde
 		attr_index++;
 	}
 
-	int produced = produce_tuple_from_operator(o, output_tuple);
-	free(output_tuple);
-
-	return produced;
+	return output_tuple;
 }
 
-// scans every tuple of the partition at partition_index_in_info, producing only the ones that are visible to the snapshot of this transaction,
-// returns 0, only if this partition could not be scanned completely, in which case the caller must kill itself
-static int scan_partition(operator* o, uint64_t partition_index_in_info)
+// scans every tuple of every heap page of the morsel, producing only the ones that are visible to the snapshot of this transaction,
+// returns 0, only if this morsel could not be scanned completely, in which case the caller must kill itself
+static int scan_heap_page_morsel(operator* o, const heap_page_morsel* morsel)
 {
 	input_values* inputs = o->inputs;
 
 	rage_engine* engine = &(inputs->tx->rdb->persistent_acid_rage_engine);
 
-	const rhendb_table_partition* table_partition = &(inputs->ftabl->table_partitions_info[partition_index_in_info]);
+	uint64_t partition_index_in_info = morsel->partition_index_in_info;
 	const tuple_def* partition_tuple_def = &(inputs->ftabl->table_partition_tuple_defs[partition_index_in_info]);
 
 	// the mvcc_header is always the first element of the record of any partition
@@ -142,28 +138,23 @@ static int scan_partition(operator* o, uint64_t partition_index_in_info)
 	// the older partitions can not be inserted into, hence they never need this check
 	int must_skip_self_inserted_tuples = (partition_index_in_info == (inputs->ftabl->partitions_count - 1)) && IS_RESCAN_PROTECTION_ENABLED(inputs->additional_flags);
 
-	// the heap_table_tuple_defs of this very partition, every job builds its own for the partition it scans
-	heap_table_tuple_defs httd;
-	init_heap_table_tuple_definitions(&httd, &(engine->pam_p->pas), partition_tuple_def);
+	// output tuples of the visible tuples are accumulated here and produced together, atleast once for every heap page
+	operator_output_batch ob = INIT_OPERATOR_OUTPUT_BATCH;
 
-	int abort_error = 0;
+	// hints discovered on the tuples of a heap page are accumulated here, and written back once its read lock is released
+	int must_write_back_hints = IS_MVCC_HINTS_WRITE_BACK_ENABLED(inputs->additional_flags);
+	mvcc_hints_write_back mhwb;
+	initialize_mvcc_hints_write_back(&mhwb);
 
-	heap_table_iterator* hti_p = get_new_heap_table_iterator(table_partition->heap_root_page_id, 0, 0, &httd, engine->pam_p, NULL, &abort_error);
-	if(abort_error)
-		goto ABORT_ERROR;
+	int abort_error = 0;
 
-	while(1)
+	for(uint32_t page_index = 0; page_index < morsel->page_ids_count; page_index++)
 	{
-		uint32_t unused_space = 0;
-		int entry_needs_fixing = 0;
-		persistent_page ppage = lock_and_get_curr_heap_page_heap_table_iterator(hti_p, 0 /* READ_LOCK */, &unused_space, &entry_needs_fixing, NULL, &abort_error);
+		// this operator never writes, so it needs no mini transaction, a NULL transaction_id with a READ_LOCK is all that is required to read the page
+		persistent_page ppage = acquire_persistent_page_with_lock(engine->pam_p, NULL, morsel->page_ids[page_index], READ_LOCK, &abort_error);
 		if(abort_error)
 			goto ABORT_ERROR;
 
-		// no more heap pages left in this partition
-		if(is_persistent_page_NULL(&ppage, engine->pam_p))
-			break;
-
 		uint32_t tuple_count = get_tuple_count_on_persistent_page(&ppage, engine->pam_p->pas.page_size, &(partition_tuple_def->size_def));
 
 		for(uint32_t tuple_index = 0; tuple_index < tuple_count; tuple_index++)
@@ -185,7 +176,12 @@ static int scan_partition(operator* o, uint64_t partition_index_in_info)
 				read_mvcc_header(&mvcchdr, mvcc_hdr_datum.tuple_value, &mvcc_def);
 
 				int were_hints_updated = 0;
-				if(!is_tuple_visible_to_mvcc_snapshot(inputs->tx->snapshot, &mvcchdr, &(inputs->tx->rdb->tsg), &were_hints_updated))
+				int is_visible = is_tuple_visible_to_mvcc_snapshot(inputs->tx->snapshot, &mvcchdr, &(inputs->tx->rdb->tsg), &were_hints_updated);
+
+				if(were_hints_updated && must_write_back_hints)
+					append_to_mvcc_hints_write_back(&mhwb, ppage.page_id, tuple_index, &mvcchdr);
+
+				if(!is_visible)
 					continue;
 			}
 
@@ -195,13 +191,14 @@ static int scan_partition(operator* o, uint64_t partition_index_in_info)
 			if(must_skip_self_inserted_tuples && was_registered_as_inserted_tuple_pointer(inputs->tx, tptr))
 				continue;
 
-			if(!produce_output_for_scanned_tuple(o, partition_index_in_info, tptr, heap_record))
+			if(inputs->output_flags == 0)
+				continue;
+
+			if(!append_to_output_batch_for_operator(o, &ob, build_output_for_scanned_tuple(o, partition_index_in_info, tptr, heap_record)))
 			{
 				kill_signal_for_self_operator(o, get_dstring_pointing_to_literal_cstring("could_not_produce"));
 				release_lock_on_persistent_page(engine->pam_p, NULL, &ppage, NONE_OPTION, &abort_error);
-				delete_heap_table_iterator(hti_p, NULL, &abort_error);
-				hti_p = NULL;
-				deinit_heap_table_tuple_definitions(&httd);
+				deinitialize_mvcc_hints_write_back(&mhwb);
 				return 0;
 			}
 		}
@@ -210,19 +207,19 @@ static int scan_partition(operator* o, uint64_t partition_index_in_info)
 		if(abort_error)
 			goto ABORT_ERROR;
 
-		int went_next = next_heap_table_iterator(hti_p, NULL, &abort_error);
-		if(abort_error)
-			goto ABORT_ERROR;
-		if(!went_next)
-			break;
-	}
+		// write back the hints discovered on this heap page, they are not needed for the scan itself, so it is never an error if they could not be written
+		flush_mvcc_hints_write_back(&mhwb, engine, partition_tuple_def, &mvcc_def);
 
-	delete_heap_table_iterator(hti_p, NULL, &abort_error);
-	hti_p = NULL;
-	if(abort_error)
-		goto ABORT_ERROR;
+		// produce the remaining outputs of this heap page, after its lock has been released
+		if(ob.tuples_count > 0 && !flush_output_batch_for_operator(o, &ob))
+		{
+			kill_signal_for_self_operator(o, get_dstring_pointing_to_literal_cstring("could_not_produce"));
+			deinitialize_mvcc_hints_write_back(&mhwb);
+			return 0;
+		}
+	}
 
-	deinit_heap_table_tuple_definitions(&httd);
+	deinitialize_mvcc_hints_write_back(&mhwb);
 
 	return 1;
 
@@ -230,16 +227,15 @@ static int scan_partition(operator* o, uint64_t partition_index_in_info)
 
 	kill_signal_for_self_operator(o, get_dstring_pointing_to_literal_cstring("scanner_read_only_mini_tx_aborted"));
 
-	if(hti_p != NULL)
-		delete_heap_table_iterator(hti_p, NULL, &abort_error);
-
-	deinit_heap_table_tuple_definitions(&httd);
+	// the accumulated outputs are never produced, and the accumulated hints are never written back
+	discard_output_batch_for_operator(&ob);
+	deinitialize_mvcc_hints_write_back(&mhwb);
 
 	return 0;
 }
 
-// a single job, it keeps picking up the next partition that is yet to be scanned, until there are none left
-static void scan_partitions_job(operator* o, void* param)
+// a single job, it keeps claiming the next heap_page_morsel that is yet to be scanned, until there are none left
+static void scan_morsels_job(operator* o, void* param)
 {
 	input_values* inputs = o->inputs;
 
@@ -248,26 +244,29 @@ static void scan_partitions_job(operator* o, void* param)
 		if(can_not_proceed_for_execution_operator(o))
 			break;
 
-		// pick up the next partition that no other job has picked up yet
-		pthread_mutex_lock(&(inputs->partition_pos_lock));
-		uint64_t partition_index_in_info = inputs->partition_pos;
-		if(partition_index_in_info < inputs->ftabl->partitions_count)
-			inputs->partition_pos++;
-		pthread_mutex_unlock(&(inputs->partition_pos_lock));
+		// claim the next heap pages that no other job has claimed yet
+		heap_page_morsel morsel;
+		int abort_error = 0;
+		int claimed = claim_heap_page_morsel(&(inputs->hpmc), &morsel, &abort_error);
+		if(abort_error)
+		{
+			kill_signal_for_self_operator(o, get_dstring_pointing_to_literal_cstring("scanner_read_only_mini_tx_aborted"));
+			break;
+		}
 
-		// all the partitions have been picked up already
-		if(partition_index_in_info >= inputs->ftabl->partitions_count)
+		// all the heap pages have been claimed already
+		if(!claimed)
 			break;
 
-		if(!scan_partition(o, partition_index_in_info))
+		if(!scan_heap_page_morsel(o, &morsel))
 			break;
 	}
 
 	// this job is done scanning, if it was the last one, the operator must be woken up to kill itself
-	pthread_mutex_lock(&(inputs->partition_pos_lock));
+	pthread_mutex_lock(&(inputs->scan_jobs_lock));
 	inputs->active_scan_job_count--;
 	int wake_up_operator = (inputs->active_scan_job_count == 0);
-	pthread_mutex_unlock(&(inputs->partition_pos_lock));
+	pthread_mutex_unlock(&(inputs->scan_jobs_lock));
 
 	if(wake_up_operator)
 		trigger_execution_on_operator(o);
@@ -277,22 +276,22 @@ static void start_scan_jobs(operator* o)
 {
 	input_values* inputs = o->inputs;
 
-	pthread_mutex_lock(&(inputs->partition_pos_lock));
+	pthread_mutex_lock(&(inputs->scan_jobs_lock));
 	if(!(inputs->scan_jobs_started))
 	{
 		inputs->scan_jobs_started = 1;
 
-		// one job per partition, but never more than max_concurrent_jobs_count of them
-		uint32_t new_scan_jobs = min(inputs->max_concurrent_jobs_count, inputs->ftabl->partitions_count);
+		// the partitions are split into morsels, so all the max_concurrent_jobs_count jobs get work, even for a single partition
+		uint32_t new_scan_jobs = inputs->max_concurrent_jobs_count;
 		while(new_scan_jobs > 0)
 		{
-			if(!run_concurrent_job_for_operator(o, NULL, scan_partitions_job))
+			if(!run_concurrent_job_for_operator(o, NULL, scan_morsels_job))
 				break;
 			inputs->active_scan_job_count++;
 			new_scan_jobs--;
 		}
 	}
-	pthread_mutex_unlock(&(inputs->partition_pos_lock));
+	pthread_mutex_unlock(&(inputs->scan_jobs_lock));
 }
 
 static void execute(operator* o)
@@ -305,9 +304,9 @@ static void execute(operator* o)
 	else
 	{
 		// the operator is woken up by every job that finishes, it may only kill itself once all of them are done
-		pthread_mutex_lock(&(inputs->partition_pos_lock));
+		pthread_mutex_lock(&(inputs->scan_jobs_lock));
 		uint32_t active_scan_job_count = inputs->active_scan_job_count;
-		pthread_mutex_unlock(&(inputs->partition_pos_lock));
+		pthread_mutex_unlock(&(inputs->scan_jobs_lock));
 
 		if(active_scan_job_count == 0)
 			kill_signal_for_self_operator(o, get_dstring_pointing_to_literal_cstring("completed_and_killed"));
@@ -320,7 +319,10 @@ static void clean_up_resources(operator* o)
 {
 	input_values* inputs = o->inputs;
 
-	pthread_mutex_destroy(&(inputs->partition_pos_lock));
+	// all the scan jobs are done, so the partition being walked (if the walk was cut short) can be closed
+	deinitialize_heap_page_morsel_cursor(&(inputs->hpmc));
+
+	pthread_mutex_destroy(&(inputs->scan_jobs_lock));
 }
 
 static void free_resources(operator* o)
@@ -354,11 +356,8 @@ operator_resource_counter setup_scan_operator(operator* o, query_plan* qp, const
 		exit(-1);
 	}
 
-	// we can not scan more than partition number of tables at once
-	max_concurrent_jobs_count = min(max_concurrent_jobs_count, ftabl->partitions_count);
-
-	// there is latch crabbing at every point hence 2 buffers per worker are needed
-	operator_resource_counter result = {.buffer_counter = 2 * max_concurrent_jobs_count, .job_counter = max_concurrent_jobs_count, .thread_counter = max_concurrent_jobs_count};
+	// every job locks 1 heap page at a time, and the walk of the hpmc holds the heap_table's page and locks a heap page, while a morsel is being claimed
+	operator_resource_counter result = {.buffer_counter = max_concurrent_jobs_count + 2, .job_counter = max_concurrent_jobs_count, .thread_counter = max_concurrent_jobs_count};
 	if(o == NULL)
 		return result;
 
@@ -423,7 +422,6 @@ operator_resource_counter setup_scan_operator(operator* o, query_plan* qp, const
 	*((input_values*)(o->inputs)) = (input_values){
 		.ftabl = ftabl,
 		.max_concurrent_jobs_count = max_concurrent_jobs_count,
-		.partition_pos = 0,
 		.active_scan_job_count = 0,
 		.scan_jobs_started = 0,
 		.output_flags = output_flags,
@@ -433,7 +431,8 @@ operator_resource_counter setup_scan_operator(operator* o, query_plan* qp, const
 	};
 
 	input_values* inputs = o->inputs;
-	pthread_mutex_init(&(inputs->partition_pos_lock), NULL);
+	initialize_heap_page_morsel_cursor_for_heap_table_walk(&(inputs->hpmc), ftabl, &(tx->rdb->persistent_acid_rage_engine), &(tx->rdb->heap_table_walks_guard), DEFAULT_HEAP_PAGES_PER_MORSEL);
+	pthread_mutex_init(&(inputs->scan_jobs_lock), NULL);
 
 	return result;
 }
\ No newline at end of file
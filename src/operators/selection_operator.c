@@ -25,7 +25,8 @@ static void execute(operator* o)
 	while(1)
 	{
 		int no_more_data = 0;
-		const void* tuple = consume_for_consumption_iterator(inputs->input_iterator, &no_more_data);
+		const void* tuples[OPERATOR_TUPLE_BATCH_SIZE];
+		uint32_t tuples_count = consume_batch_for_consumption_iterator(inputs->input_iterator, tuples, OPERATOR_TUPLE_BATCH_SIZE, &no_more_data);
 		if(no_more_data)
 		{
 			kill_signal_for_self_operator(o, get_dstring_pointing_to_literal_cstring("completed_and_killed"));
@@ -37,31 +38,38 @@ static void execute(operator* o)
 			return ;
 		}
 
-		if(tuple != NULL)
+		if(tuples_count > 0)
 		{
-			int selection_match = 0;
-			int error_code = 0;
+			// the matching tuples of this batch, they are all produced together
+			void* selected_tuples[OPERATOR_TUPLE_BATCH_SIZE];
+			uint32_t selected_tuples_count = 0;
 
-			// set the input tuples
-			set_input_tuples_in_context_for_rhendb_v(&(inputs->ec), 1, tuple);
-
-			// evaluate the selection/filter expression
-			selection_match = select_using_evaluate_sql_expr_for_rhendb(inputs->expr, &(inputs->ec), &error_code);
-			if(error_code)
+			for(uint32_t i = 0; i < tuples_count; i++)
 			{
-				kill_signal_for_self_operator(o, get_dstring_pointing_to_literal_cstring("errored_from_selection_booling_expression"));
-				return ;
-			}
+				int selection_match = 0;
+				int error_code = 0;
 
-			// if bool os result says true, produce the tuple
-			if(selection_match)
-			{
-				int produced = produce_tuple_from_operator(o, (void*)tuple);
-				if(!produced)
+				// set the input tuples
+				set_input_tuples_in_context_for_rhendb_v(&(inputs->ec), 1, tuples[i]);
+
+				// evaluate the selection/filter expression
+				selection_match = select_using_evaluate_sql_expr_for_rhendb(inputs->expr, &(inputs->ec), &error_code);
+				if(error_code)
 				{
-					kill_signal_for_self_operator(o, get_dstring_pointing_to_literal_cstring("could_not_produce"));
+					kill_signal_for_self_operator(o, get_dstring_pointing_to_literal_cstring("errored_from_selection_booling_expression"));
 					return ;
 				}
+
+				// if bool os result says true, the tuple is to be produced
+				if(selection_match)
+					selected_tuples[selected_tuples_count++] = (void*)(tuples[i]);
+			}
+
+			int produced = produce_tuples_from_operator(o, selected_tuples, selected_tuples_count);
+			if(!produced)
+			{
+				kill_signal_for_self_operator(o, get_dstring_pointing_to_literal_cstring("could_not_produce"));
+				return ;
 			}
 		}
 		else
@@ -36,7 +36,8 @@ struct input_values
 	uint32_t min_block_size;
 };
 
-static int produce_join_result(operator* o, const void* left_tuple, const void* right_tuple)
+// if ob is not NULL, the join result is only accumulated into it, to be produced along with the rest of the batch
+static int produce_join_result(operator* o, operator_output_batch* ob, const void* left_tuple, const void* right_tuple)
 {
 	input_values* inputs = o->inputs;
 
@@ -71,6 +72,10 @@ static int produce_join_result(operator* o, const void* left_tuple, const void*
 		output_tuple_size = get_tuple_size(inputs->output_tuple_def, output_tuple);
 	}
 
+	// batch output_tuple
+	if(ob != NULL)
+		return append_to_output_batch_for_operator(o, ob, output_tuple);
+
 	// produce output_tuple
 	int produced = produce_tuple_from_operator(o, output_tuple);
 	free(output_tuple);
@@ -83,12 +88,15 @@ static int cross_product_equal_tuples_on_both_sides(operator* o)
 {
 	input_values* inputs = o->inputs;
 
+	// join results of the cross product are accumulated here, and produced together
+	operator_output_batch ob = INIT_OPERATOR_OUTPUT_BATCH;
+
 	int fail = 0;
 
 	// simple nlj over the left and right tuples, UNOPTIMIZED
 	/*FOR_EACH_TUPLE_IN_INTERIM_TUPLE_STORE(left_tuple, left_tuple_index, left_tuple_offset, &(inputs->left_input_tuple_def->size_def), inputs->left_side_equal_tuples_batch, inputs->min_block_size, {
 		FOR_EACH_TUPLE_IN_INTERIM_TUPLE_STORE(right_tuple, right_tuple_index, right_tuple_offset, &(inputs->right_input_tuple_def->size_def), inputs->right_side_equal_tuples_batch, inputs->min_block_size, {
-			if(!produce_join_result(o, left_tuple, right_tuple))
+			if(!produce_join_result(o, NULL, left_tuple, right_tuple))
 				fail = 1;
 			if(fail)
 				break;
@@ -120,7 +128,7 @@ static int cross_product_equal_tuples_on_both_sides(operator* o)
 				{
 					const void* right_tuple = inputs->right_side_equal_tuples_batch->embed_regions[0].tuple;
 
-					if(!produce_join_result(o, left_tuple, right_tuple))
+					if(!produce_join_result(o, &ob, left_tuple, right_tuple))
 						fail = 1;
 					if(fail)
 						break;
@@ -147,6 +155,12 @@ static int cross_product_equal_tuples_on_both_sides(operator* o)
 		left_block_offset = next_left_block_offset;
 	}
 
+	// produce the remaining join results, unless we failed
+	if(!fail && !flush_output_batch_for_operator(o, &ob))
+		fail = 1;
+
+	discard_output_batch_for_operator(&ob);
+
 	if(fail)
 		return 0;
 
@@ -259,7 +273,7 @@ static void execute(operator* o)
 			{
 				if(DOES_IT_PRESERVE_LEFT(inputs->ptype))
 				{
-					if(!produce_join_result(o, inputs->left_input_iterator->embed_ptrs[0], NULL))
+					if(!produce_join_result(o, NULL, inputs->left_input_iterator->embed_ptrs[0], NULL))
 					{
 						kill_signal_for_self_operator(o, get_dstring_pointing_to_literal_cstring("could_not_produce"));
 						return ;
@@ -271,7 +285,7 @@ static void execute(operator* o)
 			{
 				if(DOES_IT_PRESERVE_RIGHT(inputs->ptype))
 				{
-					if(!produce_join_result(o, NULL, inputs->right_input_iterator->embed_ptrs[0]))
+					if(!produce_join_result(o, NULL, NULL, inputs->right_input_iterator->embed_ptrs[0]))
 					{
 						kill_signal_for_self_operator(o, get_dstring_pointing_to_literal_cstring("could_not_produce"));
 						return ;
@@ -1,3 +1,6 @@
+// for RUSAGE_THREAD
+#define _GNU_SOURCE
+
 #include<rhendb/query_plan.h>
 
 #include<rhendb/operator_resource_counter.h>
@@ -5,11 +8,15 @@
 #include<rhendb/transaction.h>
 
 #include<rhendb/function_compare.h>
+#include<rhendb/normalized_key.h>
+#include<rhendb/loser_tree.h>
 
 #include<rhendb/interim_tuple_store_sort.h>
 
 #include<rhendb/tuples_down_counter.h>
 
+#include<sys/resource.h>
+
 typedef struct tuple_runs tuple_runs;
 struct tuple_runs
 {
@@ -63,6 +70,18 @@ static void delete_all_runs_in_tuple_runs(tuple_runs* truns_p)
 
 #define MAX_LEVELS 128
 
+// counters behind the sort_merge_pass_metrics of a merge pass, they are atomic so that they can be read while the merges are running
+typedef struct merge_pass_counters merge_pass_counters;
+struct merge_pass_counters
+{
+	_Atomic uint64_t merges_count;
+	_Atomic uint64_t runs_read_count;
+	_Atomic uint64_t bytes_read;
+	_Atomic uint64_t bytes_written;
+	_Atomic uint64_t minor_page_faults;
+	_Atomic uint64_t major_page_faults;
+};
+
 typedef struct input_values input_values;
 struct input_values
 {
@@ -88,6 +107,12 @@ struct input_values
 	// else if finite, only these many outputs will be produced
 	tuples_down_counter result_counter;
 
+	// only used if the result_counter is finite, it is shared by all the jobs to discard tuples that can never be in the result
+	top_n_threshold top_n;
+
+	// copy of the top_n threshold, used only by the execute, to discard the input tuples without taking the threshold_lock
+	top_n_threshold_cache top_n_cache;
+
 	// potects everything underneath
 	pthread_mutex_t runs_lock;
 
@@ -103,10 +128,21 @@ struct input_values
 
 	linkedlist job_param_list;
 	linkedlist job_param_free_list;
+
+	// merge_passes[i] accounts all the merges producing runs at level i, (i.e. level_for_merged_run = i)
+	// not protected by the runs_lock
+	merge_pass_counters merge_passes[MAX_LEVELS + 1];
 };
 
 static void request_to_process_some_jobs(operator* o);
 
+static top_n_threshold* get_top_n_threshold(input_values* inputs)
+{
+	if(is_inf_tuples_down_counter(&(inputs->result_counter)))
+		return NULL;
+	return &(inputs->top_n);
+}
+
 static void sort_job(operator* o, void* param)
 {
 	input_values* inputs = o->inputs;
@@ -114,6 +150,17 @@ static void sort_job(operator* o, void* param)
 
 	tuple_runs* input_param = param;
 
+	// if there are no other unsorted runs waiting to be sorted, reserve the idle job slots to sort this run in parallel
+	// they are counted in total_concurrent_jobs_count, so that no new jobs are started in them, while we are using them
+	uint32_t reserved_jobs_count = 0;
+	pthread_mutex_lock(&(inputs->runs_lock));
+	if(inputs->un_sorted_runs.runs_count == 0)
+	{
+		reserved_jobs_count = inputs->max_concurrent_jobs_count - inputs->total_concurrent_jobs_count;
+		inputs->total_concurrent_jobs_count += reserved_jobs_count;
+	}
+	pthread_mutex_unlock(&(inputs->runs_lock));
+
 	uint32_t total_runs_to_process = input_param->runs_count;
 	for(uint64_t i = 0; i < total_runs_to_process && !can_not_proceed_for_execution_operator(o); i++)
 	{
@@ -121,7 +168,7 @@ static void sort_job(operator* o, void* param)
 		interim_tuple_store* its_p = pop_run_from_tuple_runs(input_param);
 
 		// sort it into a new run
-		interim_tuple_store* ots_p = sort_interim_tuples(its_p, result_counter, inputs->record_def, inputs->key_element_ids, inputs->key_compare_direction, inputs->key_element_count, o->self_query_plan->curr_tx);
+		interim_tuple_store* ots_p = sort_interim_tuples(its_p, result_counter, inputs->record_def, inputs->key_element_ids, inputs->key_compare_direction, inputs->key_element_count, o->self_query_plan->curr_tx, 1 + reserved_jobs_count, o, get_top_n_threshold(inputs));
 
 		// delete the input run
 		delete_interim_tuple_store(its_p);
@@ -137,117 +184,235 @@ static void sort_job(operator* o, void* param)
 	inputs->total_sorted_runs_count += input_param->runs_count;
 	push_all_runs_in_tuple_runs(&(inputs->sorted_runs[0]), input_param);
 	insert_tail_in_linkedlist(&(inputs->job_param_free_list), input_param);
-	inputs->total_concurrent_jobs_count--;
+	inputs->total_concurrent_jobs_count -= (1 + reserved_jobs_count);
 	pthread_mutex_unlock(&(inputs->runs_lock));
 
 	// request some new jobs to start
 	request_to_process_some_jobs(o);
 }
 
-// we materialize, the keys in its_p->embed_ptrs[0], using it as datum[] having inputs->key_element_count elements long
-static void revise_materialized_keys_in_interim_tuple_store(operator* o, interim_tuple_store* its_p)
+/*
+	run_merger merges the sorted runs of a tuple_runs using a loser_tree, leaf i being runs[i]
+	the keys of the head tuple of each run are materialized only once when the run advances, along with its normalized_key prefix
+	the head tuple of a run is in its embed_regions[0]
+*/
+
+typedef struct run_merger run_merger;
+struct run_merger
 {
-	input_values* inputs = o->inputs;
+	operator* o;
 
-	for(uint32_t j = 0; j < inputs->key_element_count; j++)
-		if(!get_value_from_element_from_tuple(&(((datum*)(its_p->embed_ptrs[0]))[j]), inputs->record_def, inputs->key_element_ids[j], its_p->embed_regions[0].tuple))
-			((datum*)(its_p->embed_ptrs[0]))[j] = (*NULL_DATUM);
+	uint32_t runs_count;
+
+	// runs[i] is set to NULL, once it is exhausted and deleted
+	interim_tuple_store** runs;
+
+	// keys of the head tuples, key_element_count datums for each run
+	datum* keys;
+
+	// normalized_key of the head tuples, only built if use_normalized_keys is set
+	normalized_key* nkeys;
+	int use_normalized_keys;
+
+	loser_tree tournament;
+
+	// total bytes in all the runs being merged
+	uint64_t total_bytes;
+
+	// page faults of this thread, when the merge started
+	struct rusage usage_at_start;
+};
+
+// asynchronously reads ahead the region right after the region of the head tuple of the run at leaf, so that the merge does not block on it
+static void read_ahead_next_region_of_run(run_merger* rm_p, uint32_t leaf)
+{
+	const input_values* inputs = rm_p->o->inputs;
+	interim_tuple_store* its_p = rm_p->runs[leaf];
+	read_ahead_interim_tuple_store(its_p, end_offset_for_interim_tuple_region(&(its_p->embed_regions[0])), inputs->min_run_size);
 }
 
-// comparator to compare materialized tuples at its_p->embed_ptrs[0]
-static int compare_interim_tuple_stores_for_pheap_runs(const void* o_vp, const void* its1_vp, const void* its2_vp)
+static int compare_run_heads(const void* rm_vp, uint32_t leaf1, uint32_t leaf2)
 {
-	const operator* o = o_vp;
-	const input_values* inputs = o->inputs;
+	const run_merger* rm_p = rm_vp;
+	const input_values* inputs = rm_p->o->inputs;
 
-	const interim_tuple_store* its1_p = its1_vp;
-	const interim_tuple_store* its2_p = its2_vp;
+	if(rm_p->use_normalized_keys)
+	{
+		int is_decided = 0;
+		int cmp = compare_normalized_keys(&(rm_p->nkeys[leaf1]), &(rm_p->nkeys[leaf2]), &is_decided);
+		if(is_decided)
+			return cmp;
+	}
 
-	return compare_datums3_rhendb(its1_p->embed_ptrs[0], its2_p->embed_ptrs[0], inputs->key_dtis, inputs->key_compare_direction, inputs->key_element_count, o->self_query_plan->curr_tx);
+	return compare_datums3_rhendb(&(rm_p->keys[leaf1 * inputs->key_element_count]), &(rm_p->keys[leaf2 * inputs->key_element_count]), inputs->key_dtis, inputs->key_compare_direction, inputs->key_element_count, rm_p->o->self_query_plan->curr_tx);
 }
 
-static void merge_into_run_job(operator* o, void* param)
+// materializes the keys of the new head tuple of the run at leaf, and prefetches the tuple right after it
+static void revise_run_head(run_merger* rm_p, uint32_t leaf)
 {
-	input_values* inputs = o->inputs;
-	tuples_down_counter result_counter = inputs->result_counter;
+	const input_values* inputs = rm_p->o->inputs;
+	interim_tuple_store* its_p = rm_p->runs[leaf];
+	datum* keys = &(rm_p->keys[leaf * inputs->key_element_count]);
 
-	tuple_runs* input_param = param;
+	for(uint32_t j = 0; j < inputs->key_element_count; j++)
+		if(!get_value_from_element_from_tuple(&(keys[j]), inputs->record_def, inputs->key_element_ids[j], its_p->embed_regions[0].tuple))
+			keys[j] = (*NULL_DATUM);
 
-	// malloc keys a datum[], to be used by all the runs existing in pheap until they are all merged and destroyed
-	datum* keys = malloc(inputs->N_way_sort * inputs->key_element_count * sizeof(datum));
+	if(rm_p->use_normalized_keys)
+		build_normalized_key(&(rm_p->nkeys[leaf]), keys, inputs->key_dtis, inputs->key_compare_direction, inputs->key_element_count);
 
-	// open runs
-	pheap mergeable_open_runs;
-	initialize_pheap(&mergeable_open_runs, MIN_HEAP, LEFTIST, &contexted_comparator(o, compare_interim_tuple_stores_for_pheap_runs), offsetof(interim_tuple_store, embed_node_php));
+	// the next tuple of this run will be needed when this head wins, so start fetching it now
+	uint64_t next_tuple_offset = next_tuple_offset_for_interim_tuple_region(&(its_p->embed_regions[0]));
+	if(next_tuple_offset < end_offset_for_interim_tuple_region(&(its_p->embed_regions[0])))
+		__builtin_prefetch(its_p->embed_regions[0].region_memory + (next_tuple_offset - its_p->embed_regions[0].region_offset));
+}
 
-	uint64_t total_output_size_in_bytes = 0;
-	uint64_t total_input_runs_count = 0;
+// pops all the runs from input_param into the run_merger, and opens them for merging
+static void initialize_run_merger(run_merger* rm_p, operator* o, tuple_runs* input_param)
+{
+	input_values* inputs = o->inputs;
+
+	rm_p->o = o;
+	rm_p->runs_count = input_param->runs_count;
+	rm_p->runs = malloc(sizeof(interim_tuple_store*) * rm_p->runs_count);
+	rm_p->keys = malloc(sizeof(datum) * rm_p->runs_count * inputs->key_element_count);
+	rm_p->nkeys = malloc(sizeof(normalized_key) * rm_p->runs_count);
+	if(rm_p->runs == NULL || rm_p->keys == NULL || rm_p->nkeys == NULL)
+	{
+		printf("FAILED to allocate memory for merging runs in sort_operator\n");
+		exit(-1);
+	}
+	rm_p->use_normalized_keys = can_build_normalized_key(inputs->key_dtis, inputs->key_element_count);
+	rm_p->total_bytes = 0;
+	getrusage(RUSAGE_THREAD, &(rm_p->usage_at_start));
 
-	// populate runs in mergeable_open_runs
-	for(interim_tuple_store* its_p = pop_run_from_tuple_runs(input_param); its_p != NULL; its_p = pop_run_from_tuple_runs(input_param))
+	initialize_loser_tree(&(rm_p->tournament), rm_p->runs_count, rm_p, compare_run_heads);
+
+	for(uint32_t i = 0; i < rm_p->runs_count; i++)
 	{
+		interim_tuple_store* its_p = pop_run_from_tuple_runs(input_param);
+		rm_p->total_bytes += get_total_bytes_in_interim_tuple_store(its_p);
+
 		if(!mmap_for_reading_tuple(its_p, &(its_p->embed_regions[0]), 0, &(inputs->record_def->size_def), inputs->min_run_size))
+		{
+			// happens only if the run is empty
 			delete_interim_tuple_store(its_p);
+			rm_p->runs[i] = NULL;
+			mark_exhausted_in_loser_tree(&(rm_p->tournament), i);
+		}
 		else
 		{
-			// comes here only if mmap succeeds, will happen always, unless the run is empty
+			rm_p->runs[i] = its_p;
+			revise_run_head(rm_p, i);
+			read_ahead_next_region_of_run(rm_p, i);
+		}
+	}
+
+	build_loser_tree(&(rm_p->tournament));
+}
+
+static int is_empty_run_merger(const run_merger* rm_p)
+{
+	return is_exhausted_loser_tree(&(rm_p->tournament));
+}
 
-			// embed_ptrs[0] is used to store the materialized keys
-			its_p->embed_ptrs[0] = &(keys[(total_input_runs_count++) * (inputs->key_element_count)]);
+// the smallest head tuple across all runs
+static void* get_top_of_run_merger(const run_merger* rm_p)
+{
+	return rm_p->runs[get_winner_of_loser_tree(&(rm_p->tournament))]->embed_regions[0].tuple;
+}
 
-			// revise materialized keys before pushing it to mergeable_open_runs
-			revise_materialized_keys_in_interim_tuple_store(o, its_p);
+// advances the run with the smallest head tuple, deleting it if it gets exhausted
+static void advance_run_merger(run_merger* rm_p)
+{
+	const input_values* inputs = rm_p->o->inputs;
+	uint32_t winner = get_winner_of_loser_tree(&(rm_p->tournament));
+	interim_tuple_store* its_p = rm_p->runs[winner];
 
-			push_to_pheap(&mergeable_open_runs, its_p);
-			total_output_size_in_bytes += get_total_bytes_in_interim_tuple_store(its_p);
-		}
+	uint64_t old_region_offset = its_p->embed_regions[0].region_offset;
+	uint64_t next_tuple_offset = next_tuple_offset_for_interim_tuple_region(&(its_p->embed_regions[0]));
+	if(!mmap_for_reading_tuple(its_p, &(its_p->embed_regions[0]), next_tuple_offset, &(inputs->record_def->size_def), inputs->min_run_size))
+	{
+		// implies there are no more tuples
+		unmap_all_embed_regions_in_interim_tuple_store(its_p);
+		delete_interim_tuple_store(its_p);
+		rm_p->runs[winner] = NULL;
+		mark_exhausted_in_loser_tree(&(rm_p->tournament), winner);
 	}
+	else
+	{
+		revise_run_head(rm_p, winner);
+
+		// the run moved on to the next region, so start reading the one after it
+		if(its_p->embed_regions[0].region_offset != old_region_offset)
+			read_ahead_next_region_of_run(rm_p, winner);
+	}
+
+	replay_winner_of_loser_tree(&(rm_p->tournament));
+}
+
+// deletes the runs that are still remaining, and accounts this merge in the metrics of its merge pass
+static void deinitialize_run_merger(run_merger* rm_p, int level_for_merged_run, uint64_t bytes_written)
+{
+	input_values* inputs = rm_p->o->inputs;
+
+	struct rusage usage_at_end;
+	getrusage(RUSAGE_THREAD, &usage_at_end);
+
+	merge_pass_counters* mpc_p = &(inputs->merge_passes[level_for_merged_run]);
+	atomic_fetch_add_explicit(&(mpc_p->merges_count), 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&(mpc_p->runs_read_count), rm_p->runs_count, memory_order_relaxed);
+	atomic_fetch_add_explicit(&(mpc_p->bytes_read), rm_p->total_bytes, memory_order_relaxed);
+	atomic_fetch_add_explicit(&(mpc_p->bytes_written), bytes_written, memory_order_relaxed);
+	atomic_fetch_add_explicit(&(mpc_p->minor_page_faults), usage_at_end.ru_minflt - rm_p->usage_at_start.ru_minflt, memory_order_relaxed);
+	atomic_fetch_add_explicit(&(mpc_p->major_page_faults), usage_at_end.ru_majflt - rm_p->usage_at_start.ru_majflt, memory_order_relaxed);
+
+	for(uint32_t i = 0; i < rm_p->runs_count; i++)
+		if(rm_p->runs[i] != NULL)
+			delete_interim_tuple_store(rm_p->runs[i]);
+
+	deinitialize_loser_tree(&(rm_p->tournament));
+	free(rm_p->runs);
+	free(rm_p->keys);
+	free(rm_p->nkeys);
+}
+
+static void merge_into_run_job(operator* o, void* param)
+{
+	input_values* inputs = o->inputs;
+	tuples_down_counter result_counter = inputs->result_counter;
+
+	tuple_runs* input_param = param;
 
-	// create output run
-	interim_tuple_store* output_its_p = get_new_interim_tuple_store(total_output_size_in_bytes);
+	// open runs
+	run_merger mergeable_open_runs;
+	initialize_run_merger(&mergeable_open_runs, o, input_param);
+
+	// create output run, it is written once sequentially, so let it be written back in large sequential writes
+	interim_tuple_store* output_its_p = get_new_interim_tuple_store(mergeable_open_runs.total_bytes);
+	enable_write_behind_for_interim_tuple_store(output_its_p);
 
-	// merge all one by one from the top into output_its_p or produce them if possible
-	while(!is_empty_pheap(&mergeable_open_runs) && can_decrement_tuples_down_counter(&result_counter))
+	// merge all one by one from the top into output_its_p
+	while(!is_empty_run_merger(&mergeable_open_runs) && can_decrement_tuples_down_counter(&result_counter))
 	{
 		// every 1000 tuples, make sue that the operator is not killed
 		if(((output_its_p->tuples_count % 1000) == 0) && can_not_proceed_for_execution_operator(o))
 			break;
 
-		interim_tuple_store* its_p = (interim_tuple_store*) get_top_of_pheap(&mergeable_open_runs);
-
-		// copy the top tuple of its_p into (append it to) output_its_p
+		// copy the top tuple into (append it to) output_its_p
 		decrement_tuples_down_counter(&result_counter);
-		append_tuple_to_interim_tuple_store2(output_its_p, &(output_its_p->embed_regions[0]), its_p->embed_regions[0].tuple, &(inputs->record_def->size_def), inputs->min_run_size);
-
-		// go next on its_p, and insert it back into mergeable_open_runs
-		{
-			uint64_t next_tuple_offset = next_tuple_offset_for_interim_tuple_region(&(its_p->embed_regions[0]));
-			if(!mmap_for_reading_tuple(its_p, &(its_p->embed_regions[0]), next_tuple_offset, &(inputs->record_def->size_def), inputs->min_run_size))
-			{
-				// implies there are no more tuples
-
-				total_input_runs_count--;
-				remove_from_pheap(&mergeable_open_runs, its_p);
-
-				unmap_all_embed_regions_in_interim_tuple_store(its_p);
-				delete_interim_tuple_store(its_p);
-			}
-			else
-			{
-				// revise materialized keys before heapify-ing it in mergeable_open_runs
-				revise_materialized_keys_in_interim_tuple_store(o, its_p);
+		append_tuple_to_interim_tuple_store2(output_its_p, &(output_its_p->embed_regions[0]), get_top_of_run_merger(&mergeable_open_runs), &(inputs->record_def->size_def), inputs->min_run_size);
 
-				heapify_for_in_pheap(&mergeable_open_runs, its_p);
-			}
-		}
+		// go next on the run that the top tuple came from
+		advance_run_merger(&mergeable_open_runs);
 	}
 
 	// destroy if any is still remaining
-	if(!is_empty_pheap(&mergeable_open_runs))
-		remove_all_from_pheap(&mergeable_open_runs, DELETE_ON_NOTIFY_FOR_INTERIM_TUPLE_STORE);
+	deinitialize_run_merger(&mergeable_open_runs, input_param->level_for_merged_run, get_total_bytes_in_interim_tuple_store(output_its_p));
 
-	// free the keys
-	free(keys);
+	// a merged run with all the tuples needed, has its last tuple as a tighter threshold
+	if(get_top_n_threshold(inputs) != NULL && !can_decrement_tuples_down_counter(&result_counter))
+		tighten_top_n_threshold(get_top_n_threshold(inputs), NULL, output_its_p->embed_regions[0].tuple, o->self_query_plan->curr_tx);
 
 	// unmap the write-side region
 	unmap_all_embed_regions_in_interim_tuple_store(output_its_p);
@@ -273,77 +438,28 @@ static void merge_into_produce_job(operator* o, void* param)
 
 	tuple_runs* input_param = param;
 
-	// malloc keys a datum[], to be used by all the runs existing in pheap until they are all merged and destroyed
-	datum* keys = malloc(inputs->N_way_sort * inputs->key_element_count * sizeof(datum));
-
 	// open runs
-	pheap mergeable_open_runs;
-	initialize_pheap(&mergeable_open_runs, MIN_HEAP, LEFTIST, &contexted_comparator(o, compare_interim_tuple_stores_for_pheap_runs), offsetof(interim_tuple_store, embed_node_php));
-
-	uint64_t total_input_runs_count = 0;
-
-	// populate runs in mergeable_open_runs
-	for(interim_tuple_store* its_p = pop_run_from_tuple_runs(input_param); its_p != NULL; its_p = pop_run_from_tuple_runs(input_param))
-	{
-		if(!mmap_for_reading_tuple(its_p, &(its_p->embed_regions[0]), 0, &(inputs->record_def->size_def), inputs->min_run_size))
-			delete_interim_tuple_store(its_p);
-		else
-		{
-			// comes here only if mmap succeeds, will happen always, unless the run is empty
-
-			// embed_ptrs[0] is used to store the materialized keys
-			its_p->embed_ptrs[0] = &(keys[(total_input_runs_count++) * (inputs->key_element_count)]);
-
-			// revise materialized keys before pushing it to mergeable_open_runs
-			revise_materialized_keys_in_interim_tuple_store(o, its_p);
-
-			push_to_pheap(&mergeable_open_runs, its_p);
-		}
-	}
+	run_merger mergeable_open_runs;
+	initialize_run_merger(&mergeable_open_runs, o, input_param);
 
 	int produce_failed = 0;
 
-	// merge all one by one from the top into output_its_p or produce them if possible
-	while(!is_empty_pheap(&mergeable_open_runs) && can_decrement_tuples_down_counter(&result_counter))
+	// merge all one by one from the top and produce them
+	while(!is_empty_run_merger(&mergeable_open_runs) && can_decrement_tuples_down_counter(&result_counter))
 	{
-		interim_tuple_store* its_p = (interim_tuple_store*) get_top_of_pheap(&mergeable_open_runs);
-
 		decrement_tuples_down_counter(&result_counter);
-		if(!produce_tuple_from_operator(o, its_p->embed_regions[0].tuple))
+		if(!produce_tuple_from_operator(o, get_top_of_run_merger(&mergeable_open_runs)))
 		{
 			produce_failed = 1;
 			break;
 		}
 
-		// go next on its_p, and insert it back into mergeable_open_runs
-		{
-			uint64_t next_tuple_offset = next_tuple_offset_for_interim_tuple_region(&(its_p->embed_regions[0]));
-			if(!mmap_for_reading_tuple(its_p, &(its_p->embed_regions[0]), next_tuple_offset, &(inputs->record_def->size_def), inputs->min_run_size))
-			{
-				// implies there are no more tuples
-
-				total_input_runs_count--;
-				remove_from_pheap(&mergeable_open_runs, its_p);
-
-				unmap_all_embed_regions_in_interim_tuple_store(its_p);
-				delete_interim_tuple_store(its_p);
-			}
-			else
-			{
-				// revise materialized keys before heapify-ing it in mergeable_open_runs
-				revise_materialized_keys_in_interim_tuple_store(o, its_p);
-
-				heapify_for_in_pheap(&mergeable_open_runs, its_p);
-			}
-		}
+		// go next on the run that the top tuple came from
+		advance_run_merger(&mergeable_open_runs);
 	}
 
 	// destroy if any is still remaining
-	if(!is_empty_pheap(&mergeable_open_runs))
-		remove_all_from_pheap(&mergeable_open_runs, DELETE_ON_NOTIFY_FOR_INTERIM_TUPLE_STORE);
-
-	// free the keys
-	free(keys);
+	deinitialize_run_merger(&mergeable_open_runs, input_param->level_for_merged_run, 0);
 
 	// add input_param back to free list
 	pthread_mutex_lock(&(inputs->runs_lock));
@@ -589,6 +705,10 @@ static void execute(operator* o)
 			return ;
 		}
 
+		// skip the tuples, that the runs sorted so far prove can never be in the result
+		if(tuple != NULL && get_top_n_threshold(inputs) != NULL && is_beyond_top_n_threshold(get_top_n_threshold(inputs), &(inputs->top_n_cache), tuple, o->self_query_plan->curr_tx))
+			continue;
+
 		if(tuple != NULL)
 		{
 			if(inputs->input_un_sorted_run == NULL)
@@ -664,6 +784,9 @@ static void clean_up_resources(operator* o)
 
 	free(inputs->key_dtis);
 
+	deinitialize_top_n_threshold_cache(&(inputs->top_n_cache));
+	deinitialize_top_n_threshold(&(inputs->top_n));
+
 	pthread_mutex_destroy(&(inputs->runs_lock));
 }
 
@@ -702,7 +825,8 @@ operator_resource_counter setup_sort_operator(operator* o, tuples_down_counter r
 	const tuple_def* record_def = get_tuple_def_for_tuples_to_be_consumed_from(input_operator);
 
 	// there are max_concurrent_jobs_count number of additional jobs each one doing atmost 1 comparison
-	operator_resource_counter result = {.buffer_counter = 2 * has_extended_type_info3(record_def, key_element_count, key_element_ids, PERSISTENT_EXT_SUB_TYPE) * max_concurrent_jobs_count, .job_counter = max_concurrent_jobs_count + 1};
+	// and each of them holds an unsorted run and its sorted copy in memory
+	operator_resource_counter result = {.buffer_counter = 2 * has_extended_type_info3(record_def, key_element_count, key_element_ids, PERSISTENT_EXT_SUB_TYPE) * max_concurrent_jobs_count, .job_counter = max_concurrent_jobs_count + 1, .interim_memory_counter = 2 * min_run_size * max_concurrent_jobs_count};
 	if(o == NULL)
 		return result;
 
@@ -737,6 +861,8 @@ operator_resource_counter setup_sort_operator(operator* o, tuples_down_counter r
 	for(uint32_t j = 0; j < key_element_count; j++)
 		inputs->key_dtis[j] = get_type_info_for_element_from_tuple_def(inputs->record_def, key_element_ids[j]);
 
+	initialize_top_n_threshold(&(inputs->top_n), inputs->record_def, key_element_ids, key_compare_direction, key_element_count);
+	initialize_top_n_threshold_cache(&(inputs->top_n_cache));
 	initialize_tuple_runs(&(inputs->un_sorted_runs));
 	for(int i = 0; i < MAX_LEVELS; i++)
 		initialize_tuple_runs(&(inputs->sorted_runs[i]));
@@ -751,4 +877,31 @@ operator_resource_counter setup_sort_operator(operator* o, tuples_down_counter r
 	}
 
 	return result;
-}
\ No newline at end of file
+}
+
+uint32_t get_merge_pass_metrics_for_sort_operator(const operator* o, sort_merge_pass_metrics* passes, uint32_t passes_count)
+{
+	const input_values* inputs = o->inputs;
+
+	uint32_t merge_passes_done = 0;
+	for(uint32_t i = 1; i <= MAX_LEVELS; i++)
+	{
+		const merge_pass_counters* mpc_p = &(inputs->merge_passes[i]);
+		sort_merge_pass_metrics metrics = {
+			.merges_count = atomic_load_explicit(&(mpc_p->merges_count), memory_order_relaxed),
+			.runs_read_count = atomic_load_explicit(&(mpc_p->runs_read_count), memory_order_relaxed),
+			.bytes_read = atomic_load_explicit(&(mpc_p->bytes_read), memory_order_relaxed),
+			.bytes_written = atomic_load_explicit(&(mpc_p->bytes_written), memory_order_relaxed),
+			.minor_page_faults = atomic_load_explicit(&(mpc_p->minor_page_faults), memory_order_relaxed),
+			.major_page_faults = atomic_load_explicit(&(mpc_p->major_page_faults), memory_order_relaxed),
+		};
+
+		if(metrics.merges_count > 0)
+			merge_passes_done = i;
+
+		if(i <= passes_count)
+			passes[i-1] = metrics;
+	}
+
+	return merge_passes_done;
+}
@@ -0,0 +1,602 @@
+#include<rhendb/query_plan.h>
+
+#include<rhendb/operator_resource_counter.h>
+
+#include<rhendb/transaction.h>
+
+#include<rhendb/mvcc_header.h>
+#include<rhendb/mvcc_snapshot.h>
+
+#include<rhendb/fetched_table.h>
+
+#include<tupleindexer/heap_page/heap_page.h>
+#include<tupleindexer/heap_table/heap_table.h>
+#include<tupleindexer/blob_store/blob_store.h>
+#include<tupleindexer/utils/heap_table_accumulative_notifier.h>
+
+#include<pthread.h>
+#include<stdatomic.h>
+#include<stdio.h>
+#include<stdlib.h>
+
+// counters behind the vaccum_metrics, they are atomic so that they can be read while the vaccum jobs are running
+typedef struct vaccum_counters vaccum_counters;
+struct vaccum_counters
+{
+	_Atomic uint64_t partitions_vaccummed_count;
+	_Atomic uint64_t heap_pages_scanned_count;
+	_Atomic uint64_t heap_pages_vaccummed_count;
+	_Atomic uint64_t heap_pages_skipped_count;
+	_Atomic uint64_t tuples_vaccummed_count;
+	_Atomic uint64_t tuples_frozen_count;
+	_Atomic uint64_t blobs_discarded_count;
+	_Atomic uint64_t unused_space_entries_fixed_count;
+};
+
+typedef struct input_values input_values;
+struct input_values
+{
+	// the table being vaccummed, all of its partitions are vaccummed, from the first to the last one
+	const fetched_table* ftabl;
+
+	// taken once at the setup, the tuples deleted by the transactions committed before it are not visible to anyone
+	uint256 vaccum_horizon_transaction_id;
+
+	// number of jobs that may vaccum the partitions of this table concurrently, one job is assigned
+	// to atmost one partition at any point of time
+	uint32_t max_concurrent_jobs_count;
+
+	// same as in the scan_operator
+	pthread_mutex_t partition_pos_lock; // also protects active_vaccum_job_count
+	uint64_t partition_pos;
+	uint32_t active_vaccum_job_count;
+
+	int vaccum_jobs_started; // this flag will be set if the vaccum jobs were started by the execute function
+
+	vaccum_counters counters;
+
+	transaction* tx;
+};
+
+// buffers requested from the bufferpool_usage_limiter, for every heap page vaccummed, the heap page and a page of the heap_table or the blob_store
+#define VACCUM_BUFFERS_PER_HEAP_PAGE 2
+
+// bytes of a blob discarded in a single call, all of a blob is discarded in a single mini transaction
+#define VACCUM_BLOB_DISCARD_SIZE (32 * 1024 * 1024)
+
+#define HTAN_CAPACITY       30
+#define HTAN_FIX_THRESHOLD  13
+
+static void fix_unused_space_entries_after_vaccum(operator* o, heap_table_accumulative_notifier* htan_p, const heap_table_tuple_defs* httd_p, int force_fix)
+{
+	input_values* inputs = o->inputs;
+
+	rage_engine* engine = &(inputs->tx->rdb->persistent_acid_rage_engine);
+
+	if(!force_fix)
+	{
+		if(get_notification_count_for_heap_table_accumulative_notifier(htan_p) < HTAN_FIX_THRESHOLD)
+			return;
+	}
+
+	uint64_t root_page_id, page_id;
+	uint32_t unused_space;
+	while(pop_from_heap_table_accumulative_notifier(htan_p, &root_page_id, &unused_space, &page_id))
+	{
+		// a scan may have claimed this heap page, and not yet locked it, so it must not be freed now, a later vaccum will fix the entry
+		if(!try_begin_fixing_unused_space_entries(&(inputs->tx->rdb->heap_table_walks_guard), root_page_id))
+			continue;
+
+		// do this in a separate mini transaction, even if it fails we will be just fine
+		uint64_t page_latches_to_be_borrowed = 0;
+		int abort_error = 0;
+		void* min_tx_id = engine->allot_new_sub_transaction_id(engine->context, page_latches_to_be_borrowed);
+
+		fix_unused_space_in_heap_table(root_page_id, unused_space, page_id, httd_p, engine->pam_p, engine->pmm_p, min_tx_id, &abort_error);
+
+		engine->complete_sub_transaction(engine->context, min_tx_id, 0, NULL, 0, &page_latches_to_be_borrowed);
+
+		end_fixing_unused_space_entries(&(inputs->tx->rdb->heap_table_walks_guard), root_page_id);
+
+		if(!abort_error)
+			atomic_fetch_add_explicit(&(inputs->counters.unused_space_entries_fixed_count), 1, memory_order_relaxed);
+	}
+}
+
+// discards all the chunks of the blob starting at blob_head from the blob_store of the partition, retries on an abort
+static void discard_blob(operator* o, uint64_t blobs_root_page_id, tuple_pointer blob_head, heap_table_accumulative_notifier* blob_htan_p)
+{
+	input_values* inputs = o->inputs;
+
+	rage_engine* engine = &(inputs->tx->rdb->persistent_acid_rage_engine);
+
+	while(1)
+	{
+		uint64_t page_latches_to_be_borrowed = 0;
+		int abort_error = 0;
+		void* min_tx_id = engine->allot_new_sub_transaction_id(engine->context, page_latches_to_be_borrowed);
+
+		blob_store_write_iterator* bswi_p = get_new_blob_store_write_iterator(blobs_root_page_id, blob_head, get_NULL_tuple_pointer(&(engine->pam_p->pas)), &(engine->bstd), engine->pam_p, engine->pmm_p, min_tx_id, &abort_error);
+		if(abort_error)
+			goto ABORT_ERROR;
+
+		while(0 < discard_from_head_in_blob(bswi_p, VACCUM_BLOB_DISCARD_SIZE, &HEAP_TABLE_ACCUMULATIVE_NOTIFIER(blob_htan_p), min_tx_id, &abort_error) && !abort_error);
+
+		delete_blob_store_write_iterator(bswi_p, min_tx_id, &abort_error);
+		if(abort_error)
+			goto ABORT_ERROR;
+
+		engine->complete_sub_transaction(engine->context, min_tx_id, 0, NULL, 0, &page_latches_to_be_borrowed);
+
+		atomic_fetch_add_explicit(&(inputs->counters.blobs_discarded_count), 1, memory_order_relaxed);
+		return;
+
+		ABORT_ERROR:;
+		engine->complete_sub_transaction(engine->context, min_tx_id, 0, NULL, 0, &page_latches_to_be_borrowed);
+		continue;
+	}
+}
+
+// tomb stones the tuples at candidate_tuple_indices on the heap page, in a single mini transaction, rechecking that they can still be vaccummed, the rest of them are frozen if they need to be
+// unused_space_in_entry is the unused space of this page, as tracked by the heap_table
+// then discards the blobs of the extended columns of the tomb stoned tuples
+static void vaccum_heap_page(operator* o, uint64_t partition_index_in_info, uint64_t page_id, uint32_t unused_space_in_entry, const uint32_t* candidate_tuple_indices, uint32_t candidates_count, heap_table_accumulative_notifier* heap_htan_p, heap_table_accumulative_notifier* blob_htan_p)
+{
+	input_values* inputs = o->inputs;
+
+	rage_engine* engine = &(inputs->tx->rdb->persistent_acid_rage_engine);
+
+	const rhendb_table_partition* table_partition = &(inputs->ftabl->table_partitions_info[partition_index_in_info]);
+	const tuple_def* partition_tuple_def = &(inputs->ftabl->table_partition_tuple_defs[partition_index_in_info]);
+
+	tuple_def mvcc_def;
+	initialize_tuple_def(&mvcc_def, (data_type_info*)(partition_tuple_def->type_info->containees[0].al.type_info));
+
+	// heads of the blobs of the tomb stoned tuples, they can only be discarded once the mini transaction tomb stoning them has completed
+	uint64_t blob_heads_capacity = ((uint64_t)candidates_count) * partition_tuple_def->type_info->element_count;
+	tuple_pointer* blob_heads = malloc(sizeof(tuple_pointer) * blob_heads_capacity);
+	if(blob_heads == NULL)
+		exit(-1);
+	uint64_t blob_heads_count = 0;
+	uint64_t tuples_vaccummed_count = 0;
+	uint64_t tuples_frozen_count = 0;
+
+	uint64_t page_latches_to_be_borrowed = 0;
+	int abort_error = 0;
+	void* min_tx_id = engine->allot_new_sub_transaction_id(engine->context, page_latches_to_be_borrowed);
+
+	persistent_page ppage = acquire_persistent_page_with_lock(engine->pam_p, min_tx_id, page_id, WRITE_LOCK, &abort_error);
+	if(abort_error)
+		goto ABORT_ERROR;
+
+	for(uint32_t i = 0; i < candidates_count; i++)
+	{
+		uint32_t tuple_index = candidate_tuple_indices[i];
+
+		// some other vaccum could have got to it first
+		if(!exists_tuple_on_persistent_page(&ppage, engine->pam_p->pas.page_size, &(partition_tuple_def->size_def), tuple_index))
+			continue;
+
+		const void* heap_record = get_nth_tuple_on_persistent_page(&ppage, engine->pam_p->pas.page_size, &(partition_tuple_def->size_def), tuple_index);
+		if(heap_record == NULL)
+			continue;
+
+		{
+			datum mvcc_hdr_datum;
+			get_value_from_element_from_tuple(&mvcc_hdr_datum, partition_tuple_def, STATIC_POSITION(0), heap_record);
+
+			mvcc_header mvcchdr;
+			read_mvcc_header(&mvcchdr, mvcc_hdr_datum.tuple_value, &mvcc_def);
+
+			int were_hints_updated = 0;
+			if(!can_vaccum_tuple_for_mvcc(&mvcchdr, &(inputs->tx->rdb->tsg), inputs->vaccum_horizon_transaction_id, &were_hints_updated))
+			{
+				// the tuple lives on, so freeze it instead, if it needs to be
+				if(!freeze_tuple_for_mvcc(&mvcchdr, &(inputs->tx->rdb->tsg), inputs->vaccum_horizon_transaction_id, &were_hints_updated))
+					continue;
+
+				// keep the serialized mvcc buffer in its own block so its variable length type does not span the goto
+				{
+					char mvcc_hdr_serialized[get_maximum_tuple_size(&mvcc_def)];
+					write_mvcc_header(mvcc_hdr_serialized, &mvcc_def, &mvcchdr);
+					set_element_in_tuple_in_place_on_persistent_page(engine->pmm_p, min_tx_id, &ppage, engine->pam_p->pas.page_size, partition_tuple_def, tuple_index, STATIC_POSITION(0), &((datum){.tuple_value = mvcc_hdr_serialized}), &abort_error);
+				}
+				if(abort_error)
+					goto ABORT_ERROR;
+
+				tuples_frozen_count++;
+				continue;
+			}
+		}
+
+		// the last element of an extended type is the tuple_pointer to the head of its blob, it is NULL if the whole value fit in its prefix
+		uint64_t blob_heads_count_before = blob_heads_count;
+		for(uint32_t c = 1; c < partition_tuple_def->type_info->element_count; c++)
+		{
+			const data_type_info* col_dti = partition_tuple_def->type_info->containees[c].al.type_info;
+			if(!is_extended_type_info(col_dti))
+				continue;
+
+			datum uval;
+			if(!get_value_from_element_from_tuple(&uval, partition_tuple_def, STATIC_POSITION(c, col_dti->element_count - 1), heap_record) || is_datum_NULL(&uval))
+				continue;
+
+			tuple_pointer blob_head = get_tuple_pointer(uval.tuple_value, &(engine->pam_p->pas));
+			if(!is_tuple_pointer_NULL(blob_head, &(engine->pam_p->pas)))
+				blob_heads[blob_heads_count++] = blob_head;
+		}
+
+		discard_tuple_on_persistent_page(engine->pmm_p, min_tx_id, &ppage, engine->pam_p->pas.page_size, &(partition_tuple_def->size_def), tuple_index, &abort_error);
+		if(abort_error)
+		{
+			blob_heads_count = blob_heads_count_before;
+			goto ABORT_ERROR;
+		}
+
+		tuples_vaccummed_count++;
+	}
+
+	// the tomb stones made space on this page, so its entry in the heap_table needs fixing
+	if(tuples_vaccummed_count > 0 && unused_space_in_entry != get_unused_space_on_heap_page(&ppage, &(engine->pam_p->pas), partition_tuple_def))
+		push_to_heap_table_accumulative_notifier(heap_htan_p, table_partition->heap_root_page_id, unused_space_in_entry, ppage.page_id);
+
+	release_lock_on_persistent_page(engine->pam_p, min_tx_id, &ppage, NONE_OPTION, &abort_error);
+	if(abort_error)
+		goto ABORT_ERROR;
+
+	// nothing is flushed, a crash may bring back the tomb stoned (or unfrozen) tuples, that the next vaccum will take care of
+	// a truncation of the transaction table is logged after it in the same WAL, so it never survives a crash without these freezes
+	engine->complete_sub_transaction(engine->context, min_tx_id, 0, NULL, 0, &page_latches_to_be_borrowed);
+
+	atomic_fetch_add_explicit(&(inputs->counters.heap_pages_vaccummed_count), 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&(inputs->counters.tuples_vaccummed_count), tuples_vaccummed_count, memory_order_relaxed);
+	atomic_fetch_add_explicit(&(inputs->counters.tuples_frozen_count), tuples_frozen_count, memory_order_relaxed);
+
+	// a crash from here on only leaks the remaining blobs, discarding them before their tuples could have discarded them twice
+	for(uint64_t i = 0; i < blob_heads_count; i++)
+		discard_blob(o, table_partition->blobs_root_page_id, blob_heads[i], blob_htan_p);
+
+	free(blob_heads);
+	return;
+
+	ABORT_ERROR:;
+	if(!is_persistent_page_NULL(&ppage, engine->pam_p))
+		release_lock_on_persistent_page(engine->pam_p, min_tx_id, &ppage, NONE_OPTION, &abort_error);
+	engine->complete_sub_transaction(engine->context, min_tx_id, 0, NULL, 0, &page_latches_to_be_borrowed);
+
+	// this page is just skipped, the next vaccum will take care of it
+	atomic_fetch_add_explicit(&(inputs->counters.heap_pages_skipped_count), 1, memory_order_relaxed);
+	free(blob_heads);
+}
+
+// vaccums every heap page of the partition at partition_index_in_info,
+// returns 0, only if this partition could not be vaccummed completely, in which case the caller must kill itself
+static int vaccum_partition(operator* o, uint64_t partition_index_in_info)
+{
+	input_values* inputs = o->inputs;
+
+	rage_engine* engine = &(inputs->tx->rdb->persistent_acid_rage_engine);
+
+	const rhendb_table_partition* table_partition = &(inputs->ftabl->table_partitions_info[partition_index_in_info]);
+	const tuple_def* partition_tuple_def = &(inputs->ftabl->table_partition_tuple_defs[partition_index_in_info]);
+
+	// the mvcc_header is always the first element of the record of any partition
+	tuple_def mvcc_def;
+	initialize_tuple_def(&mvcc_def, (data_type_info*)(partition_tuple_def->type_info->containees[0].al.type_info));
+
+	heap_table_tuple_defs httd;
+	init_heap_table_tuple_definitions(&httd, &(engine->pam_p->pas), partition_tuple_def);
+
+	// accumulative notifiers: one for the partition's heap table, one for its blob store
+	heap_table_accumulative_notifier heap_htan;
+	heap_table_accumulative_notifier blob_htan;
+	initialize_heap_table_accumulative_notifier(&heap_htan, HTAN_CAPACITY);
+	initialize_heap_table_accumulative_notifier(&blob_htan, HTAN_CAPACITY);
+
+	// tuple_indices of the tuples, that could be vaccummed on the current heap page
+	uint32_t candidates_capacity = 0;
+	uint32_t* candidate_tuple_indices = NULL;
+
+	int result = 1;
+
+	int abort_error = 0;
+
+	heap_table_iterator* hti_p = get_new_heap_table_iterator(table_partition->heap_root_page_id, 0, 0, &httd, engine->pam_p, NULL, &abort_error);
+	if(abort_error)
+		goto ABORT_ERROR;
+
+	while(1)
+	{
+		if(can_not_proceed_for_execution_operator(o))
+		{
+			result = 0;
+			break;
+		}
+
+		// do not use more of the bufferpool than the queries allow us
+		int shutdown_called = 0;
+		if(0 == request_resources_from_resource_usage_limiter(inputs->tx->rdb->bufferpool_usage_limiter, VACCUM_BUFFERS_PER_HEAP_PAGE, VACCUM_BUFFERS_PER_HEAP_PAGE, BLOCKING, &shutdown_called))
+		{
+			result = 0;
+			break;
+		}
+
+		uint32_t unused_space = 0;
+		int entry_needs_fixing = 0;
+		persistent_page ppage = lock_and_get_curr_heap_page_heap_table_iterator(hti_p, 0 /* READ_LOCK */, &unused_space, &entry_needs_fixing, NULL, &abort_error);
+		if(abort_error)
+		{
+			give_back_resources_to_resource_usage_limiter(inputs->tx->rdb->bufferpool_usage_limiter, VACCUM_BUFFERS_PER_HEAP_PAGE);
+			goto ABORT_ERROR;
+		}
+
+		// no more heap pages left in this partition
+		if(is_persistent_page_NULL(&ppage, engine->pam_p))
+		{
+			give_back_resources_to_resource_usage_limiter(inputs->tx->rdb->bufferpool_usage_limiter, VACCUM_BUFFERS_PER_HEAP_PAGE);
+			break;
+		}
+
+		uint64_t page_id = ppage.page_id;
+		uint32_t tuple_count = get_tuple_count_on_persistent_page(&ppage, engine->pam_p->pas.page_size, &(partition_tuple_def->size_def));
+
+		if(tuple_count > candidates_capacity)
+		{
+			candidates_capacity = tuple_count;
+			candidate_tuple_indices = realloc(candidate_tuple_indices, sizeof(uint32_t) * candidates_capacity);
+			if(candidate_tuple_indices == NULL)
+				exit(-1);
+		}
+
+		// find the vaccummable (or freezable) tuples with just a read lock, so that the pages with nothing to vaccum are never write locked
+		uint32_t candidates_count = 0;
+		for(uint32_t tuple_index = 0; tuple_index < tuple_count; tuple_index++)
+		{
+			if(!exists_tuple_on_persistent_page(&ppage, engine->pam_p->pas.page_size, &(partition_tuple_def->size_def), tuple_index))
+				continue;
+
+			const void* heap_record = get_nth_tuple_on_persistent_page(&ppage, engine->pam_p->pas.page_size, &(partition_tuple_def->size_def), tuple_index);
+			if(heap_record == NULL)
+				continue;
+
+			datum mvcc_hdr_datum;
+			get_value_from_element_from_tuple(&mvcc_hdr_datum, partition_tuple_def, STATIC_POSITION(0), heap_record);
+
+			mvcc_header mvcchdr;
+			read_mvcc_header(&mvcchdr, mvcc_hdr_datum.tuple_value, &mvcc_def);
+
+			int were_hints_updated = 0;
+			if(can_vaccum_tuple_for_mvcc(&mvcchdr, &(inputs->tx->rdb->tsg), inputs->vaccum_horizon_transaction_id, &were_hints_updated)
+				|| freeze_tuple_for_mvcc(&mvcchdr, &(inputs->tx->rdb->tsg), inputs->vaccum_horizon_transaction_id, &were_hints_updated))
+				candidate_tuple_indices[candidates_count++] = tuple_index;
+		}
+
+		release_lock_on_persistent_page(engine->pam_p, NULL, &ppage, NONE_OPTION, &abort_error);
+		if(abort_error)
+		{
+			give_back_resources_to_resource_usage_limiter(inputs->tx->rdb->bufferpool_usage_limiter, VACCUM_BUFFERS_PER_HEAP_PAGE);
+			goto ABORT_ERROR;
+		}
+
+		atomic_fetch_add_explicit(&(inputs->counters.heap_pages_scanned_count), 1, memory_order_relaxed);
+
+		if(candidates_count > 0)
+			vaccum_heap_page(o, partition_index_in_info, page_id, unused_space, candidate_tuple_indices, candidates_count, &heap_htan, &blob_htan);
+		else if(entry_needs_fixing) // an entry left unfixed by an earlier vaccum, while this heap_table was being scanned
+			push_to_heap_table_accumulative_notifier(&heap_htan, table_partition->heap_root_page_id, unused_space, page_id);
+
+		fix_unused_space_entries_after_vaccum(o, &heap_htan, &httd, 0);
+		fix_unused_space_entries_after_vaccum(o, &blob_htan, &(engine->bstd.httd), 0);
+
+		give_back_resources_to_resource_usage_limiter(inputs->tx->rdb->bufferpool_usage_limiter, VACCUM_BUFFERS_PER_HEAP_PAGE);
+
+		int went_next = next_heap_table_iterator(hti_p, NULL, &abort_error);
+		if(abort_error)
+			goto ABORT_ERROR;
+		if(!went_next)
+			break;
+	}
+
+	delete_heap_table_iterator(hti_p, NULL, &abort_error);
+	hti_p = NULL;
+	if(abort_error)
+		goto ABORT_ERROR;
+
+	if(result)
+		atomic_fetch_add_explicit(&(inputs->counters.partitions_vaccummed_count), 1, memory_order_relaxed);
+
+	// fix whatever is remaining
+	fix_unused_space_entries_after_vaccum(o, &heap_htan, &httd, 1);
+	fix_unused_space_entries_after_vaccum(o, &blob_htan, &(engine->bstd.httd), 1);
+
+	deinitialize_heap_table_accumulative_notifier(&heap_htan);
+	deinitialize_heap_table_accumulative_notifier(&blob_htan);
+	free(candidate_tuple_indices);
+	deinit_heap_table_tuple_definitions(&httd);
+
+	return result;
+
+	ABORT_ERROR:;
+
+	kill_signal_for_self_operator(o, get_dstring_pointing_to_literal_cstring("vaccum_read_only_mini_tx_aborted"));
+
+	if(hti_p != NULL)
+		delete_heap_table_iterator(hti_p, NULL, &abort_error);
+
+	// the entries tracked so far, must still be fixed
+	fix_unused_space_entries_after_vaccum(o, &heap_htan, &httd, 1);
+	fix_unused_space_entries_after_vaccum(o, &blob_htan, &(engine->bstd.httd), 1);
+
+	deinitialize_heap_table_accumulative_notifier(&heap_htan);
+	deinitialize_heap_table_accumulative_notifier(&blob_htan);
+	free(candidate_tuple_indices);
+	deinit_heap_table_tuple_definitions(&httd);
+
+	return 0;
+}
+
+// a single job, it keeps picking up the next partition that is yet to be vaccummed, until there are none left
+static void vaccum_partitions_job(operator* o, void* param)
+{
+	input_values* inputs = o->inputs;
+
+	while(1)
+	{
+		if(can_not_proceed_for_execution_operator(o))
+			break;
+
+		// pick up the next partition that no other job has picked up yet
+		pthread_mutex_lock(&(inputs->partition_pos_lock));
+		uint64_t partition_index_in_info = inputs->partition_pos;
+		if(partition_index_in_info < inputs->ftabl->partitions_count)
+			inputs->partition_pos++;
+		pthread_mutex_unlock(&(inputs->partition_pos_lock));
+
+		// all the partitions have been picked up already
+		if(partition_index_in_info >= inputs->ftabl->partitions_count)
+			break;
+
+		if(!vaccum_partition(o, partition_index_in_info))
+			break;
+	}
+
+	// this job is done vaccumming, if it was the last one, the operator must be woken up to kill itself
+	pthread_mutex_lock(&(inputs->partition_pos_lock));
+	inputs->active_vaccum_job_count--;
+	int wake_up_operator = (inputs->active_vaccum_job_count == 0);
+	pthread_mutex_unlock(&(inputs->partition_pos_lock));
+
+	if(wake_up_operator)
+		trigger_execution_on_operator(o);
+}
+
+static void start_vaccum_jobs(operator* o)
+{
+	input_values* inputs = o->inputs;
+
+	pthread_mutex_lock(&(inputs->partition_pos_lock));
+	if(!(inputs->vaccum_jobs_started))
+	{
+		inputs->vaccum_jobs_started = 1;
+
+		// one job per partition, but never more than max_concurrent_jobs_count of them
+		uint32_t new_vaccum_jobs = min(inputs->max_concurrent_jobs_count, inputs->ftabl->partitions_count);
+		while(new_vaccum_jobs > 0)
+		{
+			if(!run_concurrent_job_for_operator(o, NULL, vaccum_partitions_job))
+				break;
+			inputs->active_vaccum_job_count++;
+			new_vaccum_jobs--;
+		}
+	}
+	pthread_mutex_unlock(&(inputs->partition_pos_lock));
+}
+
+static void execute(operator* o)
+{
+	input_values* inputs = o->inputs;
+
+	// on the very first execution, spawn the jobs that will do the vaccumming
+	if(!(inputs->vaccum_jobs_started))
+		start_vaccum_jobs(o);
+	else
+	{
+		// the operator is woken up by every job that finishes, it may only kill itself once all of them are done
+		pthread_mutex_lock(&(inputs->partition_pos_lock));
+		uint32_t active_vaccum_job_count = inputs->active_vaccum_job_count;
+		pthread_mutex_unlock(&(inputs->partition_pos_lock));
+
+		if(active_vaccum_job_count == 0)
+			kill_signal_for_self_operator(o, get_dstring_pointing_to_literal_cstring("completed_and_killed"));
+	}
+
+	return ;
+}
+
+static void clean_up_resources(operator* o)
+{
+	input_values* inputs = o->inputs;
+
+	pthread_mutex_destroy(&(inputs->partition_pos_lock));
+}
+
+static void free_resources(operator* o)
+{
+	input_values* inputs = o->inputs;
+
+	free(inputs);
+}
+
+operator_resource_counter setup_vaccum_operator(operator* o, query_plan* qp, const fetched_table* ftabl, uint32_t max_concurrent_jobs_count)
+{
+	transaction* tx = qp->curr_tx;
+
+	if(tx->snapshot == NULL)
+	{
+		printf("must have a snapshot for vaccum_operator\n");
+		exit(-1);
+	}
+
+	if(max_concurrent_jobs_count == 0)
+	{
+		printf("max_concurrent_jobs_count can not be 0 for vaccum_operator\n");
+		exit(-1);
+	}
+
+	// we can not vaccum more than partition number of tables at once
+	max_concurrent_jobs_count = min(max_concurrent_jobs_count, ftabl->partitions_count);
+
+	// the buffers are requested from the bufferpool_usage_limiter by the jobs themselves, for every heap page
+	operator_resource_counter result = {.buffer_counter = 0, .job_counter = max_concurrent_jobs_count, .thread_counter = max_concurrent_jobs_count};
+	if(o == NULL)
+		return result;
+
+	o->execute = execute;
+	o->operator_release_latches_and_store_context = OPERATOR_RELEASE_LATCH_NO_OP_FUNCTION;
+	o->clean_up_resources = clean_up_resources;
+	o->free_resources = free_resources;
+
+	// vaccum produces no tuples
+	init_tuple_transformers(&(o->output_tuple_transformers), NULL);
+
+	o->inputs = malloc(sizeof(input_values));
+	*((input_values*)(o->inputs)) = (input_values){
+		.ftabl = ftabl,
+		.vaccum_horizon_transaction_id = get_vaccum_horizon_transaction_id(&(tx->rdb->tx_table)),
+		.max_concurrent_jobs_count = max_concurrent_jobs_count,
+		.partition_pos = 0,
+		.active_vaccum_job_count = 0,
+		.vaccum_jobs_started = 0,
+		.tx = tx,
+	};
+
+	input_values* inputs = o->inputs;
+	pthread_mutex_init(&(inputs->partition_pos_lock), NULL);
+	atomic_init(&(inputs->counters.partitions_vaccummed_count), 0);
+	atomic_init(&(inputs->counters.heap_pages_scanned_count), 0);
+	atomic_init(&(inputs->counters.heap_pages_vaccummed_count), 0);
+	atomic_init(&(inputs->counters.heap_pages_skipped_count), 0);
+	atomic_init(&(inputs->counters.tuples_vaccummed_count), 0);
+	atomic_init(&(inputs->counters.tuples_frozen_count), 0);
+	atomic_init(&(inputs->counters.blobs_discarded_count), 0);
+	atomic_init(&(inputs->counters.unused_space_entries_fixed_count), 0);
+
+	return result;
+}
+
+vaccum_metrics get_metrics_for_vaccum_operator(const operator* o)
+{
+	const input_values* inputs = o->inputs;
+
+	return (vaccum_metrics){
+		.vaccum_horizon_transaction_id = inputs->vaccum_horizon_transaction_id,
+		.partitions_vaccummed_count = atomic_load_explicit(&(inputs->counters.partitions_vaccummed_count), memory_order_relaxed),
+		.heap_pages_scanned_count = atomic_load_explicit(&(inputs->counters.heap_pages_scanned_count), memory_order_relaxed),
+		.heap_pages_vaccummed_count = atomic_load_explicit(&(inputs->counters.heap_pages_vaccummed_count), memory_order_relaxed),
+		.heap_pages_skipped_count = atomic_load_explicit(&(inputs->counters.heap_pages_skipped_count), memory_order_relaxed),
+		.tuples_vaccummed_count = atomic_load_explicit(&(inputs->counters.tuples_vaccummed_count), memory_order_relaxed),
+		.tuples_frozen_count = atomic_load_explicit(&(inputs->counters.tuples_frozen_count), memory_order_relaxed),
+		.blobs_discarded_count = atomic_load_explicit(&(inputs->counters.blobs_discarded_count), memory_order_relaxed),
+		.unused_space_entries_fixed_count = atomic_load_explicit(&(inputs->counters.unused_space_entries_fixed_count), memory_order_relaxed),
+	};
+}
\ No newline at end of file
@@ -63,9 +63,9 @@ static void trigger_all_consumers_for_operator_UNSAFE(operator* o, int force_tri
 	}
 }
 
-static void* async_clean_up_resource_wrapper(void* o_vp)
+static void async_clean_up_resource_wrapper(operator_job* job)
 {
-	operator* o = o_vp;
+	operator* o = job->o;
 
 	pthread_mutex_lock(&(o->output_lock));
 	trigger_all_consumers_for_operator_UNSAFE(o, 1); // force trigger all consumers, this is done once, for the last time, to wake up all sleeping for data from this guy
@@ -79,8 +79,6 @@ static void* async_clean_up_resource_wrapper(void* o_vp)
 	o->state = OPERATOR_CLEANED_UP;
 	pthread_cond_broadcast(&(o->wait_until_completion));
 	pthread_mutex_unlock(&(o->state_lock));
-
-	return NULL;
 }
 
 // returns true, if the operator was killed
@@ -97,8 +95,8 @@ static int process_kill_signal_if_received_for_operator_UNSAFE(operator* o)
 		// mark it and put it in killed state
 		o->state = OPERATOR_KILLED;
 
-		// push this operator's clean_up_resources function to the global thread pool
-		if(!submit_job_executor(o->self_query_plan->curr_tx->rdb->operator_thread_pool, (void* (*)(void*))(async_clean_up_resource_wrapper), o, NULL, NULL, BLOCKING))
+		// push this operator's clean_up_resources function to the operator_scheduler
+		if(!schedule_operator_job(&(o->self_query_plan->curr_tx->rdb->operator_scheduler), async_clean_up_resource_wrapper, o, NULL, NULL))
 		{
 			printf("ISSUE in query_plan : COULD NOT PUSH A OPERATOR'S CLEAN_UP JOB TO QUEUE IT\n");
 			exit(-1);
@@ -111,9 +109,9 @@ static int process_kill_signal_if_received_for_operator_UNSAFE(operator* o)
 	return 0;
 }
 
-static void* internal_execute(void* o_vp)
+static void internal_execute(operator_job* job)
 {
-	operator* o = o_vp;
+	operator* o = job->o;
 
 	while(1)
 	{
@@ -135,10 +133,10 @@ static void* internal_execute(void* o_vp)
 		pthread_mutex_unlock(&(o->state_lock));
 
 		if(was_killed)
-			return NULL;
+			return;
 
 		if(!should_run)
-			return NULL;
+			return;
 
 		o->execute(o);
 
@@ -162,13 +160,11 @@ static void* internal_execute(void* o_vp)
 		pthread_mutex_unlock(&(o->state_lock));
 
 		if(was_killed)
-			return NULL;
+			return;
 
 		if(!was_triggered_while_we_were_running)
-			return NULL;
+			return;
 	}
-
-	return NULL;
 }
 
 void trigger_execution_on_operator(operator* o)
@@ -203,27 +199,17 @@ void trigger_execution_on_operator(operator* o)
 	if(!should_queue)
 		return;
 
-	if(!submit_job_executor(o->self_query_plan->curr_tx->rdb->operator_thread_pool, (void* (*)(void*))(internal_execute), o, NULL, NULL, BLOCKING))
+	// if called from a worker (i.e. by the producer of o), o is pushed to its own deque, and runs next on the same worker, with the produced tuples still in its cache
+	if(!schedule_operator_job(&(o->self_query_plan->curr_tx->rdb->operator_scheduler), internal_execute, o, NULL, NULL))
 	{
 		printf("ISSUE in query_plan : COULD NOT PUSH A OPERATOR'S JOB TO QUEUE IT\n");
 		exit(-1);
 	}
 }
 
-typedef struct operator_job_wrapper_params operator_job_wrapper_params;
-struct operator_job_wrapper_params
-{
-	operator* o;
-	void* param;
-	void (*operator_job_function)(operator* o, void* param);
-};
-
-static void* operator_job_wrapper_function(void* ojwp_vp)
+static void operator_job_wrapper_function(operator_job* job)
 {
-	operator_job_wrapper_params ojwp = *((operator_job_wrapper_params*)(ojwp_vp));
-	free(ojwp_vp);
-
-	operator* o = ojwp.o;
+	operator* o = job->o;
 
 	int was_killed = 0;
 	int should_run = 0;
@@ -242,22 +228,17 @@ static void* operator_job_wrapper_function(void* ojwp_vp)
 	pthread_mutex_unlock(&(o->state_lock));
 
 	if(was_killed)
-		return NULL;
+		return;
 
 	if(!should_run)
-		return NULL;
+		return;
 
-	ojwp.operator_job_function(ojwp.o, ojwp.param);
+	job->operator_job_function(o, job->param);
 
 	pthread_mutex_lock(&(o->state_lock));
 	o->running_jobs_count--;
-	was_killed = process_kill_signal_if_received_for_operator_UNSAFE(o);
+	process_kill_signal_if_received_for_operator_UNSAFE(o);
 	pthread_mutex_unlock(&(o->state_lock));
-
-	if(was_killed)
-		return NULL;
-
-	return NULL;
 }
 
 int run_concurrent_job_for_operator(operator* o, void* param, void (*operator_job_function)(operator* o, void* param))
@@ -283,16 +264,9 @@ int run_concurrent_job_for_operator(operator* o, void* param, void (*operator_jo
 	if(!should_queue)
 		return 0;
 
-	// allocate the parameter for the operator_job_wrapper_function
-	operator_job_wrapper_params* ojwp_p = malloc(sizeof(operator_job_wrapper_params));
-	(*ojwp_p) = (operator_job_wrapper_params){
-		.o = o,
-		.param = param,
-		.operator_job_function = operator_job_function,
-	};
-
-	// and push it to thread pool for execution in a concurrent threadpool
-	if(!submit_job_executor(o->self_query_plan->curr_tx->rdb->operator_thread_pool, (void* (*)(void*))(operator_job_wrapper_function), ojwp_p, NULL, NULL, BLOCKING))
+	// the operator_job carries the param and the operator_job_function, so nothing needs to be allocated here
+	// it is pushed to the deque of the worker running o, the idle workers steal it from there
+	if(!schedule_operator_job(&(o->self_query_plan->curr_tx->rdb->operator_scheduler), operator_job_wrapper_function, o, param, operator_job_function))
 	{
 		printf("ISSUE in query_plan : COULD NOT PUSH A PAUSED OPERATOR TO RUN IT\n");
 		exit(-1);
@@ -324,6 +298,14 @@ int acquire_lock_on_resource_from_operator(operator* o, uint32_t resource_type,
 	int latches_released = 0;
 	int non_blocking = (timeout_in_microseconds == NON_BLOCKING);
 
+	// an uncontended lock is taken, without the lock_manager_external_lock
+	if(!can_not_proceed_for_execution_operator(o))
+	{
+		lock_result locking_result;
+		if(try_fast_acquire_lock_with_lock_manager(&(o->self_query_plan->curr_tx->rdb->lck_table), o->self_query_plan->curr_tx, resource_type, resource_id, resource_id_size, new_lock_mode, &locking_result))
+			return 1;
+	}
+
 	pthread_mutex_lock(&(o->self_query_plan->curr_tx->rdb->lock_manager_external_lock));
 
 	int wait_error = 0;
@@ -379,6 +361,10 @@ int acquire_lock_on_resource_from_operator(operator* o, uint32_t resource_type,
 
 void release_lock_on_resource_from_operator(operator* o, uint32_t resource_type, uint8_t* resource_id, uint8_t resource_id_size)
 {
+	// no one is waiting for it, so no one needs to be notified
+	if(try_fast_release_lock_with_lock_manager(&(o->self_query_plan->curr_tx->rdb->lck_table), o->self_query_plan->curr_tx, resource_type, resource_id, resource_id_size))
+		return;
+
 	pthread_mutex_lock(&(o->self_query_plan->curr_tx->rdb->lock_manager_external_lock));
 
 	release_lock_with_lock_manager(&(o->self_query_plan->curr_tx->rdb->lck_table), o->self_query_plan->curr_tx, o, resource_type, resource_id, resource_id_size);
@@ -399,82 +385,223 @@ void OPERATOR_FREE_RESOURCE_NO_OP_FUNCTION(operator* o)
 	}
 }
 
-#define MIN_OUTPUT_BUFFER_STORE_SIZE (64 * 1024 * 1024)
-#define MAX_OUTPUT_BUFFER_COUNT 2
-#define MIN_BYTES_TO_MMAP (2 * 1024 * 1024)
+void set_output_buffer_policy_for_operator(operator* o, operator_output_buffer_policy output_buffer_policy)
+{
+	if(output_buffer_policy.initial_output_buffer_size == 0 || output_buffer_policy.initial_output_buffer_size > output_buffer_policy.max_output_buffer_size)
+	{
+		printf("initial_output_buffer_size must be non zero and atmost max_output_buffer_size, for output_buffer_policy of an operator\n");
+		exit(-1);
+	}
 
-int produce_tuple_from_operator(operator* o, void* tuple)
+	if(output_buffer_policy.max_output_buffer_count == 0)
+	{
+		printf("max_output_buffer_count can not be 0, for output_buffer_policy of an operator\n");
+		exit(-1);
+	}
+
+	if(output_buffer_policy.min_bytes_to_notify == 0 || output_buffer_policy.min_bytes_to_notify > output_buffer_policy.max_bytes_to_notify)
+	{
+		printf("min_bytes_to_notify must be non zero and atmost max_bytes_to_notify, for output_buffer_policy of an operator\n");
+		exit(-1);
+	}
+
+	o->output_buffer_policy = output_buffer_policy;
+	o->output_buffer_size = output_buffer_policy.initial_output_buffer_size;
+	o->bytes_to_notify = output_buffer_policy.min_bytes_to_notify;
+}
+
+// the min_bytes_to_mmap for reading or writing to the output_buffers, it never makes us extend an output_buffer beyond the current output_buffer_size
+static uint32_t get_min_bytes_to_mmap_for_output_buffers(const operator* o)
 {
-	int pushed = 0;
+	return min(o->output_buffer_policy.min_bytes_to_mmap, o->output_buffer_size);
+}
 
-	// perform the output transformations
-	int need_to_free_output_tuple = 0;
-	tuple = process_tuple_transformers(&(o->output_tuple_transformers), tuple, &need_to_free_output_tuple);
-	if(tuple == NULL) // this implies selection/filter failed, so just return success for the produce operation
-		return 1;
+// the consumers must be notified once these many bytes are produced
+// it starts at the min_bytes_to_notify, and then adapts to the rate at which the consumers drain the output_buffers, see adapt_bytes_to_notify_UNSAFE
+static uint64_t get_bytes_to_notify_UNSAFE(const operator* o)
+{
+	return o->bytes_to_notify;
+}
 
-	pthread_mutex_lock(&(o->output_lock));
+// called only when the consumers are about to be notified, before triggering them
+// a consumer that is still triggered, has not consumed anything since it was last notified, i.e. it drains slower than we produce
+// notifying it more often only costs us the output_lock and it the wake ups, so the bytes_to_notify are doubled (upto the max_bytes_to_notify)
+// else all the consumers have drained the output_buffers and are waiting on us, so the bytes_to_notify are halved, to feed them sooner
+// but never below a batch (OPERATOR_TUPLE_BATCH_SIZE) of tuples worth of bytes as per the average tuple size observed, and never below the min_bytes_to_notify
+static void adapt_bytes_to_notify_UNSAFE(operator* o)
+{
+	int has_lagging_consumers = 0;
+	for(const consumption_iterator* cit_p = get_head_of_linkedlist(&(o->output_consumers)); (!has_lagging_consumers) && (cit_p != NULL); cit_p = get_next_of_in_linkedlist(&(o->output_consumers), cit_p))
+		has_lagging_consumers = (cit_p->was_consumer_triggered && (!can_not_proceed_for_execution_operator(cit_p->consumer)));
+
+	if(has_lagging_consumers)
+		o->bytes_to_notify = min(o->bytes_to_notify * 2, o->output_buffer_policy.max_bytes_to_notify);
+	else
+	{
+		uint64_t min_bytes_to_notify = o->output_buffer_policy.min_bytes_to_notify;
+		if(o->output_tuples_produced > 0)
+			min_bytes_to_notify = min(max((o->output_bytes_produced / o->output_tuples_produced) * OPERATOR_TUPLE_BATCH_SIZE, min_bytes_to_notify), o->output_buffer_policy.max_bytes_to_notify);
+		o->bytes_to_notify = max(o->bytes_to_notify / 2, min_bytes_to_notify);
+	}
+}
 
-	// make sure that there is some alive consumer
+// returns 1, if there is atleast 1 consumer that is alive, only then should anything be pushed to the output_buffers
+static int has_alive_consumers_UNSAFE(operator* o)
+{
 	int there_are_consumers = 0;
 	// loop while there are no consumers, we are supposed to find one
 	for(const consumption_iterator* cit_p = get_head_of_linkedlist(&(o->output_consumers)); (!there_are_consumers) && (cit_p != NULL); cit_p = get_next_of_in_linkedlist(&(o->output_consumers), cit_p))
 		there_are_consumers = (there_are_consumers || (!can_not_proceed_for_execution_operator(cit_p->consumer)));
+	return there_are_consumers;
+}
 
-	// proceed only if some consumer is alive
-	if(there_are_consumers)
-	{
-		pushed = 1;
-
-		// fetch tail, create one and insert if it does not exists
-		interim_tuple_store* its_p = (interim_tuple_store*) get_tail_of_singlylist(&(o->output_buffers));
+// appends the tuple to the tail of the output_buffers, creating a new tail if required
+static void append_tuple_to_output_buffers_UNSAFE(operator* o, const void* tuple)
+{
+	// fetch tail, create one and insert if it does not exists
+	interim_tuple_store* its_p = (interim_tuple_store*) get_tail_of_singlylist(&(o->output_buffers));
 
-		int produce_new_tuple_store = 0;
+	int produce_new_tuple_store = 0;
 
-		if(its_p == NULL) // no output_buffers, e surely need to make 1
-			produce_new_tuple_store = 1;
-		else if(o->output_buffers_count < MAX_OUTPUT_BUFFER_COUNT) // there are some, so make one only if the tail has more than minimum bytes
-			produce_new_tuple_store = (get_total_bytes_in_interim_tuple_store(its_p) >= MIN_OUTPUT_BUFFER_STORE_SIZE);
-		else // else do not make one
-			produce_new_tuple_store = 0;
+	if(its_p == NULL) // no output_buffers, e surely need to make 1
+		produce_new_tuple_store = 1;
+	else if(o->output_buffers_count < o->output_buffer_policy.max_output_buffer_count) // there are some, so make one only if the tail has more than minimum bytes
+		produce_new_tuple_store = (get_total_bytes_in_interim_tuple_store(its_p) >= o->output_buffer_size);
+	else // else do not make one
+		produce_new_tuple_store = 0;
 
-		if(produce_new_tuple_store)
+	if(produce_new_tuple_store)
+	{
+		// we are producing a new buffer/chunk for tuples, so unmap the regions for the previous tail
+		if(its_p != NULL)
 		{
-			// we are producing a new buffer/chunk for tuples, so unmap the regions for the previous tail
-			if(its_p != NULL)
-				unmap_all_embed_regions_in_interim_tuple_store(its_p);
+			unmap_all_embed_regions_in_interim_tuple_store(its_p);
 
-			its_p = (interim_tuple_store*) get_head_of_singlylist(&(o->free_output_buffers));
-			if(its_p != NULL)
-				remove_head_from_singlylist(&(o->free_output_buffers));
-			else
-				its_p = get_new_interim_tuple_store(MIN_OUTPUT_BUFFER_STORE_SIZE);
+			// the previous tail got filled up, so the result is larger than we assumed, hence grow the next one
+			o->output_buffer_size = min(o->output_buffer_size * 2, o->output_buffer_policy.max_output_buffer_size);
+		}
 
-			if(!insert_tail_in_singlylist(&(o->output_buffers), its_p))
-				exit(-1);
-			o->output_buffers_count++;
+		its_p = (interim_tuple_store*) get_head_of_singlylist(&(o->free_output_buffers));
+		if(its_p != NULL)
+			remove_head_from_singlylist(&(o->free_output_buffers));
+		else
+		{
+			its_p = get_new_interim_tuple_store(o->output_buffer_size);
+			// consumers read the output_buffers concurrently through their own interim_tuple_regions, so they must never be spilled
+			disable_spill_for_interim_tuple_store(its_p);
 		}
 
-		// append the tuple in this tail interim_tuple_store
-		append_tuple_to_interim_tuple_store2(its_p, &(its_p->embed_regions[0]), tuple, &(get_output_def_for_tuple_transformers(&(o->output_tuple_transformers))->size_def), MIN_BYTES_TO_MMAP);
-		o->output_buffer_bytes_unnotified += get_tuple_size(get_output_def_for_tuple_transformers(&(o->output_tuple_transformers)), tuple);
+		if(!insert_tail_in_singlylist(&(o->output_buffers), its_p))
+			exit(-1);
+		o->output_buffers_count++;
+
+		// publish the new output_tail, its offset must be reset first, so that no consumer ever reads a published_offset of the new tail, along with the old tail
+		atomic_store_explicit(&(o->output_tail_published_offset), 0, memory_order_release);
+		atomic_store_explicit(&(o->output_tail), its_p, memory_order_release);
 	}
 
-	// wake up all consumers, only if we pushed
-	if(pushed && o->output_buffer_bytes_unnotified >= MIN_BYTES_TO_MMAP)
+	// append the tuple in this tail interim_tuple_store
+	append_tuple_to_interim_tuple_store2(its_p, &(its_p->embed_regions[0]), tuple, &(get_output_def_for_tuple_transformers(&(o->output_tuple_transformers))->size_def), get_min_bytes_to_mmap_for_output_buffers(o));
+	uint32_t tuple_size = get_tuple_size(get_output_def_for_tuple_transformers(&(o->output_tuple_transformers)), tuple);
+	o->output_buffer_bytes_unnotified += tuple_size;
+	o->output_tuples_produced++;
+	o->output_bytes_produced += tuple_size;
+}
+
+// make all the tuples appended to the output_tail so far, visible to the consumers that read it without the output_lock
+static void publish_output_tail_UNSAFE(operator* o)
+{
+	interim_tuple_store* its_p = (interim_tuple_store*) get_tail_of_singlylist(&(o->output_buffers));
+	if(its_p != NULL)
+		atomic_store_explicit(&(o->output_tail_published_offset), get_total_bytes_in_interim_tuple_store(its_p), memory_order_release);
+}
+
+int produce_tuple_from_operator(operator* o, void* tuple)
+{
+	return produce_tuples_from_operator(o, &tuple, 1);
+}
+
+int produce_tuples_from_operator(operator* o, void** tuples, uint32_t tuples_count)
+{
+	int pushed = 1;
+
+	for(uint32_t batch_start = 0; pushed && batch_start < tuples_count; batch_start += OPERATOR_TUPLE_BATCH_SIZE)
 	{
-		o->output_buffer_bytes_unnotified = 0;
-		trigger_all_consumers_for_operator_UNSAFE(o, 0); // do not force trigger all consumers, trigger only the ones that were not triggered in the past
-	}
+		uint32_t batch_size = min(OPERATOR_TUPLE_BATCH_SIZE, tuples_count - batch_start);
 
-	pthread_mutex_unlock(&(o->output_lock));
+		// perform the output transformations, for the whole batch, outside the output_lock
+		void* output_tuples[OPERATOR_TUPLE_BATCH_SIZE];
+		int need_to_free_output_tuples[OPERATOR_TUPLE_BATCH_SIZE];
+		uint32_t output_tuples_count = 0; // number of tuples that survived the transformations
+		for(uint32_t i = 0; i < batch_size; i++)
+		{
+			need_to_free_output_tuples[i] = 0;
+			output_tuples[i] = process_tuple_transformers(&(o->output_tuple_transformers), tuples[batch_start + i], &(need_to_free_output_tuples[i]));
+			if(output_tuples[i] != NULL) // a NULL implies selection/filter failed, so it is just not produced
+				output_tuples_count++;
+		}
+
+		// nothing survived the transformations, so the produce operation is a success, without even taking the lock
+		if(output_tuples_count == 0)
+			continue;
+
+		pthread_mutex_lock(&(o->output_lock));
+
+		// proceed only if some consumer is alive
+		pushed = has_alive_consumers_UNSAFE(o);
+
+		if(pushed)
+		{
+			for(uint32_t i = 0; i < batch_size; i++)
+				if(output_tuples[i] != NULL)
+					append_tuple_to_output_buffers_UNSAFE(o, output_tuples[i]);
+			publish_output_tail_UNSAFE(o);
+
+			// wake up all consumers, only if we pushed
+			if(o->output_buffer_bytes_unnotified >= get_bytes_to_notify_UNSAFE(o))
+			{
+				o->output_buffer_bytes_unnotified = 0;
+				adapt_bytes_to_notify_UNSAFE(o);
+				trigger_all_consumers_for_operator_UNSAFE(o, 0); // do not force trigger all consumers, trigger only the ones that were not triggered in the past
+			}
+		}
 
-	if(need_to_free_output_tuple)
-		free(tuple);
+		pthread_mutex_unlock(&(o->output_lock));
+
+		for(uint32_t i = 0; i < batch_size; i++)
+			if(need_to_free_output_tuples[i])
+				free(output_tuples[i]);
+	}
 
 	return pushed;
 }
 
+int append_to_output_batch_for_operator(operator* o, operator_output_batch* ob, void* tuple)
+{
+	ob->tuples[ob->tuples_count++] = tuple;
+
+	if(ob->tuples_count == OPERATOR_TUPLE_BATCH_SIZE)
+		return flush_output_batch_for_operator(o, ob);
+
+	return 1;
+}
+
+int flush_output_batch_for_operator(operator* o, operator_output_batch* ob)
+{
+	int produced = produce_tuples_from_operator(o, ob->tuples, ob->tuples_count);
+
+	discard_output_batch_for_operator(ob);
+
+	return produced;
+}
+
+void discard_output_batch_for_operator(operator_output_batch* ob)
+{
+	for(uint32_t i = 0; i < ob->tuples_count; i++)
+		free(ob->tuples[i]);
+	ob->tuples_count = 0;
+}
+
 consumption_iterator* create_consumption_iterator(operator* producer, operator* consumer, void (*notify_callback)(operator* consumer, consumption_iterator* cit_p), consumption_iterator* clone_cit_p)
 {
 	if(clone_cit_p != NULL)
@@ -529,7 +656,7 @@ consumption_iterator* create_consumption_iterator(operator* producer, operator*
 	pthread_mutex_unlock(&(producer->output_lock));
 
 	if(perform_mmap_for_reading)
-		mmap_for_reading_tuple_from_snapshot(&perform_mmap_for_reading_snapshot, &(cit_p->curr_region), offset, &(get_tuple_def_for_tuples_to_be_consumed_from(producer)->size_def), MIN_BYTES_TO_MMAP);
+		mmap_for_reading_tuple_from_snapshot(&perform_mmap_for_reading_snapshot, &(cit_p->curr_region), offset, &(get_tuple_def_for_tuples_to_be_consumed_from(producer)->size_def), producer->output_buffer_policy.min_bytes_to_mmap);
 
 	return cit_p;
 }
@@ -562,6 +689,8 @@ static void destroy_all_un_referenced_output_buffers_UNSAFE(operator* o)
 
 		// else it becomes safe to discard the its_p, the head of the output_buffers
 		remove_head_from_singlylist(&(o->output_buffers));
+		if(its_p == atomic_load_explicit(&(o->output_tail), memory_order_relaxed))
+			atomic_store_explicit(&(o->output_tail), NULL, memory_order_release);
 		reinitialize_interim_tuple_store(its_p, UINT64_MAX);
 		insert_tail_in_singlylist(&(o->free_output_buffers), its_p);
 		o->output_buffers_count--;
@@ -621,12 +750,56 @@ int points_to_same_tuple_for_consumtion_iterators(const consumption_iterator* ci
 	return points_to_same_tuple;
 }
 
-const void* consume_for_consumption_iterator(consumption_iterator* cit_p, int* no_more_data)
+// consumes the tuple right after the curr_region, without taking the output_lock, only if the curr_store is the output_tail and the tuple is published
+// returns NULL, if the output_lock must be taken to consume the next tuple
+static const void* consume_from_output_tail(consumption_iterator* cit_p, uint64_t* readable_end)
+{
+	// the first tuple of any curr_store needs the output_lock, to pick the curr_store
+	// curr_store is only ever modified by this very consumer, so it is safe to read it here
+	if(cit_p->curr_store == NULL || is_empty_interim_tuple_region(&(cit_p->curr_region)))
+		return NULL;
+
+	// read the published_offset, only if it belongs to our curr_store
+	// output_tail can not go back to our curr_store, once it moves ahead, because our curr_store is referenced by us and can not be reused, so a recheck suffices
+	if(atomic_load_explicit(&(cit_p->producer->output_tail), memory_order_acquire) != cit_p->curr_store)
+		return NULL;
+	uint64_t published_offset = atomic_load_explicit(&(cit_p->producer->output_tail_published_offset), memory_order_acquire);
+	if(atomic_load_explicit(&(cit_p->producer->output_tail), memory_order_acquire) != cit_p->curr_store)
+		return NULL;
+
+	uint64_t offset = next_tuple_offset_for_interim_tuple_region(&(cit_p->curr_region));
+
+	// fd is never changed for an interim_tuple_store, and the tuples before published_offset are never modified, so this snapshot is a consistent one
+	interim_tuple_store_snapshot published_snapshot = {
+		.total_size = published_offset,
+		.next_tuple_offset = published_offset,
+		.tuples_count = 0, // unused
+		.fd = cit_p->curr_store->fd,
+	};
+
+	if(!mmap_for_reading_tuple_from_snapshot(&published_snapshot, &(cit_p->curr_region), offset, &(get_tuple_def_for_tuples_to_be_consumed_from(cit_p->producer)->size_def), cit_p->producer->output_buffer_policy.min_bytes_to_mmap))
+		return NULL;
+
+	// something was consumed, so clear the was_triggered flag, so that we would receive the next trigger
+	atomic_store_explicit(&(cit_p->was_consumer_triggered), 0, memory_order_release);
+
+	(*readable_end) = published_offset;
+	return cit_p->curr_region.tuple;
+}
+
+// same as consume_for_consumption_iterator(), but also returns the next_tuple_offset of the snapshot of the curr_store that the tuple was read from
+// every tuple that ends before readable_end is completely written and can be read without the output_lock
+static const void* consume_for_consumption_iterator_with_readable_end(consumption_iterator* cit_p, int* no_more_data, uint64_t* readable_end)
 {
 	// return values
 	const void* tuple = NULL;
 	(*no_more_data) = 0;
 
+	// attempt the lock free path first
+	tuple = consume_from_output_tail(cit_p, readable_end);
+	if(tuple != NULL)
+		return tuple;
+
 	// to forcefully perform the mmap outside the output_lock
 	uint64_t offset = 0;
 	int perform_mmap_for_reading = 0; // flag to set, if we need to do mmap
@@ -695,13 +868,64 @@ const void* consume_for_consumption_iterator(consumption_iterator* cit_p, int* n
 
 	if(perform_mmap_for_reading)
 	{
-		mmap_for_reading_tuple_from_snapshot(&perform_mmap_for_reading_snapshot, &(cit_p->curr_region), offset, &(get_tuple_def_for_tuples_to_be_consumed_from(cit_p->producer)->size_def), MIN_BYTES_TO_MMAP);
+		mmap_for_reading_tuple_from_snapshot(&perform_mmap_for_reading_snapshot, &(cit_p->curr_region), offset, &(get_tuple_def_for_tuples_to_be_consumed_from(cit_p->producer)->size_def), cit_p->producer->output_buffer_policy.min_bytes_to_mmap);
 		tuple = cit_p->curr_region.tuple;
+		(*readable_end) = perform_mmap_for_reading_snapshot.next_tuple_offset;
 	}
 
 	return tuple;
 }
 
+const void* consume_for_consumption_iterator(consumption_iterator* cit_p, int* no_more_data)
+{
+	uint64_t readable_end = 0;
+	return consume_for_consumption_iterator_with_readable_end(cit_p, no_more_data, &readable_end);
+}
+
+uint32_t consume_batch_for_consumption_iterator(consumption_iterator* cit_p, const void** tuples, uint32_t max_tuples_count, int* no_more_data)
+{
+	(*no_more_data) = 0;
+
+	if(max_tuples_count == 0)
+		return 0;
+
+	// the first tuple is consumed just as before, this takes care of moving to the next curr_store and of the mmap
+	uint64_t readable_end = 0;
+	const void* tuple = consume_for_consumption_iterator_with_readable_end(cit_p, no_more_data, &readable_end);
+	if(tuple == NULL)
+		return 0;
+
+	tuples[0] = tuple;
+	uint32_t tuples_count = 1;
+
+	const tuple_size_def* tpl_sz_d = &(get_tuple_def_for_tuples_to_be_consumed_from(cit_p->producer)->size_def);
+
+	// the remaining tuples must have been completely written before the snapshot was taken, and must also be completely inside the mapped curr_region
+	// such tuples can be handed out without the output_lock and without any further mmap calls
+	readable_end = min(readable_end, end_offset_for_interim_tuple_region(&(cit_p->curr_region)));
+
+	while(tuples_count < max_tuples_count)
+	{
+		uint64_t next_tuple_offset = next_tuple_offset_for_interim_tuple_region(&(cit_p->curr_region));
+
+		// there must be enough bytes to read the size of the next tuple
+		if(next_tuple_offset + get_minimum_tuple_size_using_tuple_size_def(tpl_sz_d) > readable_end)
+			break;
+
+		void* next_tuple = cit_p->curr_region.region_memory + (next_tuple_offset - cit_p->curr_region.region_offset);
+
+		// and the complete next tuple must be readable
+		if(next_tuple_offset + get_tuple_size_using_tuple_size_def(tpl_sz_d, next_tuple) > readable_end)
+			break;
+
+		// move the iterator forward, so that the next consume starts right after this tuple
+		cit_p->curr_region.tuple = next_tuple;
+		tuples[tuples_count++] = next_tuple;
+	}
+
+	return tuples_count;
+}
+
 const tuple_def* get_tuple_def_for_tuples_to_be_consumed_from(operator* o)
 {
 	return get_output_def_for_tuple_transformers(&(o->output_tuple_transformers));
@@ -743,8 +967,13 @@ operator* get_new_registered_operator_for_query_plan(query_plan* qp)
 	initialize_singlylist(&(o->output_buffers), offsetof(interim_tuple_store, embed_node_sl));
 	o->output_buffers_count = 0;
 	o->output_buffer_bytes_unnotified = 0;
+	set_output_buffer_policy_for_operator(o, DEFAULT_OPERATOR_OUTPUT_BUFFER_POLICY);
+	o->output_tuples_produced = 0;
+	o->output_bytes_produced = 0;
 	initialize_singlylist(&(o->free_output_buffers), offsetof(interim_tuple_store, embed_node_sl));
 	initialize_linkedlist(&(o->output_consumers), offsetof(consumption_iterator, embed_node_for_output_consumers));
+	atomic_init(&(o->output_tail), NULL);
+	atomic_init(&(o->output_tail_published_offset), 0);
 	init_tuple_transformers(&(o->output_tuple_transformers), NULL); // must initialize it again, unless it is the sink operator
 
 	pthread_mutex_init(&(o->state_lock), NULL);
@@ -892,7 +1121,7 @@ void destroy_query_plan(query_plan* qp, dstring* kill_reasons)
 	free(qp);
 }
 
-// below 2 functions get called by the lock_manager with the lock held, so we do not need to take the lock_manager_external_lock
+// below 3 functions get called by the lock_manager with the lock held, so we do not need to take the lock_manager_external_lock
 
 void notify_unblocked(void* context_p, void* transaction_vp, void* task_vp)
 {
@@ -924,4 +1153,23 @@ void notify_deadlocked(void* context_p, void* transaction_vp)
 	}
 	else
 		printf("notify_deadlocked( trx_id = %"PRIuPTR" )\n\n",  ((uintptr_t)transaction_vp));
-}
\ No newline at end of file
+}
+
+int is_younger_transaction(void* context_p, void* transaction1_vp, void* transaction2_vp)
+{
+	// test transactions, are just numbers
+	if(((uintptr_t)transaction1_vp) < 1024 || ((uintptr_t)transaction2_vp) < 1024)
+		return ((uintptr_t)transaction1_vp) > ((uintptr_t)transaction2_vp);
+
+	transaction* tx1 = transaction1_vp;
+	transaction* tx2 = transaction2_vp;
+
+	// a transaction without a self_transaction_id has not yet written anything, so it is the cheapest to abort
+	if(!tx1->snapshot->has_self_transaction_id)
+		return tx2->snapshot->has_self_transaction_id;
+	if(!tx2->snapshot->has_self_transaction_id)
+		return 0;
+
+	// transaction_ids are assigned in increasing order, so the younger one has the larger transaction_id
+	return compare_uint256(tx1->snapshot->self_transaction_id, tx2->snapshot->self_transaction_id) > 0;
+}
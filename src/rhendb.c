@@ -12,7 +12,7 @@
 #define TX_TABLE_ROOT_PAGE_ID_KEY "AAA-tx_table_root_page_id"
 #define CATALOG_ROOT_PAGE_ID_KEY  "AAB-catalog_root_page_id"
 
-static void initialize_system_root_tables(rhendb* rdb, uint64_t max_concurrent_users_count)
+static void initialize_system_root_tables(rhendb* rdb, uint64_t max_concurrent_users_count, uint64_t group_commit_latency_us, uint32_t group_commit_max_batch_size, int is_asynchronous_commit_default, uint64_t async_commit_flush_period_us)
 {
 	data_type_info* system_roots_record = malloc(sizeof_tuple_data_type_info(2));
 	initialize_tuple_data_type_info(system_roots_record, "system_roots_record", 0, 64, 2);
@@ -77,7 +77,7 @@ static void initialize_system_root_tables(rhendb* rdb, uint64_t max_concurrent_u
 		// create transaction table here
 		{
 			uint64_t tx_table_root_page_id = rdb->persistent_acid_rage_engine.pam_p->pas.NULL_PAGE_ID;
-			initialize_transaction_table(&(rdb->tx_table), &(tx_table_root_page_id), &(rdb->persistent_acid_rage_engine), max_concurrent_users_count);
+			initialize_transaction_table(&(rdb->tx_table), &(tx_table_root_page_id), &(rdb->persistent_acid_rage_engine), max_concurrent_users_count, group_commit_latency_us, group_commit_max_batch_size, is_asynchronous_commit_default, async_commit_flush_period_us);
 
 			init_tuple(&(system_roots_record_def), tuple_buffer);
 			set_element_in_tuple(&(system_roots_record_def), STATIC_POSITION(0), tuple_buffer, &((datum){.string_value = TX_TABLE_ROOT_PAGE_ID_KEY, .string_size = sizeof(TX_TABLE_ROOT_PAGE_ID_KEY)}), 100);
@@ -154,7 +154,7 @@ static void initialize_system_root_tables(rhendb* rdb, uint64_t max_concurrent_u
 				// compare with key and initialize transaction table here
 				if(0 == strncmp(TX_TABLE_ROOT_PAGE_ID_KEY, system_table_name.string_value, system_table_name.string_size))
 				{
-					initialize_transaction_table(&(rdb->tx_table), &(system_root_page_id), &(rdb->persistent_acid_rage_engine), max_concurrent_users_count);
+					initialize_transaction_table(&(rdb->tx_table), &(system_root_page_id), &(rdb->persistent_acid_rage_engine), max_concurrent_users_count, group_commit_latency_us, group_commit_max_batch_size, is_asynchronous_commit_default, async_commit_flush_period_us);
 				}
 
 				// compare with key and initialize catalog tables here
@@ -193,13 +193,16 @@ void initialize_rhendb(rhendb* rdb, const char* database_file_name,
 		uint32_t page_size_mte, uint32_t lsn_width, uint64_t bufferpool_frame_count, uint64_t wale_buffer_count,
 			uint64_t page_latch_wait_us, uint64_t page_lock_wait_us,
 			uint64_t checkpoint_period_us,
+			uint64_t group_commit_latency_us, uint32_t group_commit_max_batch_size,
+			int is_asynchronous_commit_default, uint64_t async_commit_flush_period_us,
 		uint32_t page_size_vps,
 			uint64_t truncator_period_us,
+		uint64_t deadlock_detection_period_us,
 		uint64_t max_concurrent_users_count)
 {
-	if(bufferpool_frame_count < 32 || max_concurrent_users_count == 0 || wale_buffer_count < 32)
+	if(bufferpool_frame_count < 32 || max_concurrent_users_count == 0 || wale_buffer_count < 32 || group_commit_max_batch_size == 0)
 	{
-		printf("must params => bufferpool_frame_count >= 32, max_concurrent_users_count > 0 and wale_buffer_count >= 32: check failed\n");
+		printf("must params => bufferpool_frame_count >= 32, max_concurrent_users_count > 0, wale_buffer_count >= 32 and group_commit_max_batch_size > 0: check failed\n");
 		exit(-1);
 	}
 
@@ -212,11 +215,14 @@ void initialize_rhendb(rhendb* rdb, const char* database_file_name,
 
 	rdb->operator_thread_pool_usage_limiter = new_resource_usage_limiter(threadpool_count);
 
-	rdb->operator_thread_pool = new_executor(CACHED_THREAD_POOL_EXECUTOR, threadpool_count, JOB_QUEUE_AS_LINKEDLIST, 1000000ULL, NULL, NULL, NULL, 0);
+	// the threadpool_count is only the admission limit, the operator_scheduler starts its workers lazily, only as many as the operators need at once
+	initialize_operator_scheduler(&(rdb->operator_scheduler), threadpool_count);
 
 	// 10% of the bufferpool resource usage is restricted to be used for periodic flush job and the rest for spare pages
 	rdb->bufferpool_usage_limiter = new_resource_usage_limiter(bufferpool_frame_count * 0.8);
 
+	initialize_heap_table_walks_guard(&(rdb->heap_table_walks_guard));
+
 	rdb->persistent_acid_rage_engine = get_rage_engine_for_min_tx_engine(database_file_name, page_size_mte, page_id_width, lsn_width, bufferpool_frame_count, wale_buffer_count, page_latch_wait_us, page_lock_wait_us, checkpoint_period_us, 2 * 1000000, 200 * 1000000);
 	// modify to allow only flushing 10% of the bufferpool by periodic job at any instant
 	pthread_mutex_lock(&(((mini_transaction_engine*)(rdb->persistent_acid_rage_engine.context))->global_lock));
@@ -228,29 +234,46 @@ void initialize_rhendb(rhendb* rdb, const char* database_file_name,
 	// system table initialization
 
 	// for tx_table, ...
-	initialize_system_root_tables(rdb, max_concurrent_users_count);
+	initialize_system_root_tables(rdb, max_concurrent_users_count, group_commit_latency_us, group_commit_max_batch_size, is_asynchronous_commit_default, async_commit_flush_period_us);
 
 	// initialize the transaction status getter interface
 	rdb->tsg = (transaction_status_getter){&(rdb->tx_table), (transaction_status (*)(void *, uint256))(get_transaction_status)};
 
 	// for lck_table
 	pthread_mutex_init(&(rdb->lock_manager_external_lock), NULL);
-	initialize_lock_manager(&(rdb->lck_table), &(rdb->lock_manager_external_lock), &((const lock_manager_notifier){rdb, notify_unblocked, notify_deadlocked}), &(rdb->volatile_rage_engine));
+	initialize_lock_manager(&(rdb->lck_table), &(rdb->lock_manager_external_lock), &((const lock_manager_notifier){rdb, notify_unblocked, notify_deadlocked, is_younger_transaction}), &(rdb->volatile_rage_engine), deadlock_detection_period_us);
 
 	// for hash based query executions (hash-join, hash-groupby), we will need rash_table which needs rash_httd, hich get's initialized here, in this function
 	initialize_hash_table_tuple_defs_for_using_rash_table(rdb);
 }
 
+uint256 truncate_transaction_table_for_rhendb(rhendb* rdb, uint256 frozen_transaction_id)
+{
+	uint256 min_referenced_transaction_id;
+	if(get_min_transaction_id_referenced_by_catalog(&(rdb->cat_mgr), &min_referenced_transaction_id))
+		frozen_transaction_id = min_uint256(frozen_transaction_id, min_referenced_transaction_id);
+
+	return truncate_transaction_table(&(rdb->tx_table), frozen_transaction_id);
+}
+
 void deinitialize_rhendb(rhendb* rdb)
 {
 	delete_resource_usage_limiter(rdb->operator_thread_pool_usage_limiter, 0);
 
-	shutdown_executor(rdb->operator_thread_pool, 1);
-	delete_executor(rdb->operator_thread_pool);
+	deinitialize_operator_scheduler(&(rdb->operator_scheduler));
 
 	delete_resource_usage_limiter(rdb->bufferpool_usage_limiter, 0);
 
+	deinitialize_heap_table_walks_guard(&(rdb->heap_table_walks_guard));
+
+	// makes the asynchronous commits durable, so it must be done before the persistent_acid_rage_engine goes away
+	deinitialize_transaction_table(&(rdb->tx_table));
+
 	deinitialize_mini_transaction_engine((mini_transaction_engine*)(rdb->persistent_acid_rage_engine.context));
 
+	// stops the deadlock_detector, its lock tables live in the volatile_rage_engine, so it must be done before the volatile_rage_engine goes away
+	deinitialize_lock_manager(&(rdb->lck_table));
+	pthread_mutex_destroy(&(rdb->lock_manager_external_lock));
+
 	deinitialize_volatile_page_store((volatile_page_store*)(rdb->volatile_rage_engine.context));
 }
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include<rhendb/transaction_status_cache.h>
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+
+void initialize_transaction_status_cache(transaction_status_cache* tsc_p, uint64_t capacity)
+{
+	tsc_p->sets_count = (capacity + TRANSACTION_STATUS_CACHE_WAYS - 1) / TRANSACTION_STATUS_CACHE_WAYS;
+	if(tsc_p->sets_count == 0)
+		tsc_p->sets_count = 1;
+
+	tsc_p->sets = calloc(tsc_p->sets_count, sizeof(transaction_status_cache_set));
+	if(tsc_p->sets == NULL)
+	{
+		printf("FAILED to allocate memory for transaction_status_cache\n");
+		exit(-1);
+	}
+
+	for(uint64_t i = 0; i < tsc_p->sets_count; i++)
+		pthread_mutex_init(&(tsc_p->sets[i].insert_lock), NULL);
+}
+
+// consecutive transaction_ids go to consecutive sets
+static transaction_status_cache_set* get_set_for_transaction_id(transaction_status_cache* tsc_p, uint256 transaction_id)
+{
+	return &(tsc_p->sets[transaction_id.limbs[0] % tsc_p->sets_count]);
+}
+
+// reads the entry consistently, returns 0 if the entry was being written concurrently
+static int read_transaction_status_cache_entry(transaction_status_cache_entry* e, uint256* transaction_id, transaction_status* status)
+{
+	uint64_t sequence_before = atomic_load_explicit(&(e->sequence), memory_order_acquire);
+	if(sequence_before & 1)
+		return 0;
+
+	memcpy(transaction_id, &(e->transaction_id), sizeof(uint256));
+	memcpy(status, &(e->status), sizeof(transaction_status));
+
+	atomic_thread_fence(memory_order_acquire);
+	uint64_t sequence_after = atomic_load_explicit(&(e->sequence), memory_order_relaxed);
+
+	return sequence_before == sequence_after;
+}
+
+int find_in_transaction_status_cache(transaction_status_cache* tsc_p, uint256 transaction_id, transaction_status* status)
+{
+	transaction_status_cache_set* set_p = get_set_for_transaction_id(tsc_p, transaction_id);
+
+	for(uint32_t i = 0; i < TRANSACTION_STATUS_CACHE_WAYS; i++)
+	{
+		transaction_status_cache_entry* e = &(set_p->entries[i]);
+
+		uint256 entry_transaction_id;
+		transaction_status entry_status;
+		if(!read_transaction_status_cache_entry(e, &entry_transaction_id, &entry_status))
+			continue;
+
+		if(entry_status == 0 || compare_uint256(entry_transaction_id, transaction_id) != 0)
+			continue;
+
+		// only write the is_referenced bit if it is not set, so that the hits on the hot entries do not keep bouncing its cache line
+		if(!atomic_load_explicit(&(e->is_referenced), memory_order_relaxed))
+			atomic_store_explicit(&(e->is_referenced), 1, memory_order_relaxed);
+
+		(*status) = entry_status;
+		return 1;
+	}
+
+	return 0;
+}
+
+void insert_in_transaction_status_cache(transaction_status_cache* tsc_p, uint256 transaction_id, transaction_status status)
+{
+	transaction_status_cache_set* set_p = get_set_for_transaction_id(tsc_p, transaction_id);
+
+	pthread_mutex_lock(&(set_p->insert_lock));
+
+	// only the inserts write the entries, and they are serialized by the insert_lock, so the entries can be read here directly
+	for(uint32_t i = 0; i < TRANSACTION_STATUS_CACHE_WAYS; i++)
+	{
+		if(set_p->entries[i].status != 0 && compare_uint256(set_p->entries[i].transaction_id, transaction_id) == 0)
+		{
+			pthread_mutex_unlock(&(set_p->insert_lock));
+			return;
+		}
+	}
+
+	// pick an empty entry or the first one not referenced, since the clock_hand last passed it
+	transaction_status_cache_entry* victim = NULL;
+	while(victim == NULL)
+	{
+		transaction_status_cache_entry* e = &(set_p->entries[set_p->clock_hand]);
+		set_p->clock_hand = (set_p->clock_hand + 1) % TRANSACTION_STATUS_CACHE_WAYS;
+
+		if(e->status == 0 || !atomic_exchange_explicit(&(e->is_referenced), 0, memory_order_relaxed))
+			victim = e;
+	}
+
+	// write it, while its sequence is odd
+	uint64_t sequence = atomic_load_explicit(&(victim->sequence), memory_order_relaxed);
+	atomic_store_explicit(&(victim->sequence), sequence + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+
+	victim->transaction_id = transaction_id;
+	victim->status = status;
+	atomic_store_explicit(&(victim->is_referenced), 1, memory_order_relaxed); // it was inserted for being looked up, so give it a second chance
+
+	atomic_store_explicit(&(victim->sequence), sequence + 2, memory_order_release);
+
+	pthread_mutex_unlock(&(set_p->insert_lock));
+}
+
+void deinitialize_transaction_status_cache(transaction_status_cache* tsc_p)
+{
+	for(uint64_t i = 0; i < tsc_p->sets_count; i++)
+		pthread_mutex_destroy(&(tsc_p->sets[i].insert_lock));
+	free(tsc_p->sets);
+	tsc_p->sets = NULL;
+	tsc_p->sets_count = 0;
+}
@@ -0,0 +1,114 @@
+#include<rhendb/transaction_status_page_mirror.h>
+
+#include<stdio.h>
+#include<stdlib.h>
+
+#define MAX_MIRRORABLE_BUCKET_ID ((uint64_t)TRANSACTION_STATUS_PAGE_MIRROR_DIRECTORY_SIZE * TRANSACTION_STATUS_PAGE_MIRROR_CHUNK_SIZE)
+
+void initialize_transaction_status_page_mirror(transaction_status_page_mirror* tspm_p, uint32_t statuses_per_page, uint64_t max_pages_count)
+{
+	tspm_p->statuses_per_page = statuses_per_page;
+	tspm_p->max_pages_count = max_pages_count;
+	pthread_mutex_init(&(tspm_p->insert_lock), NULL);
+	tspm_p->pages_count = 0;
+	for(uint32_t i = 0; i < TRANSACTION_STATUS_PAGE_MIRROR_DIRECTORY_SIZE; i++)
+		atomic_init(&(tspm_p->directory[i]), NULL);
+}
+
+static const uint8_t* get_mirrored_page(const transaction_status_page_mirror* tspm_p, uint64_t bucket_id)
+{
+	if(bucket_id >= MAX_MIRRORABLE_BUCKET_ID)
+		return NULL;
+
+	_Atomic(const uint8_t*)* chunk = atomic_load_explicit(&(tspm_p->directory[bucket_id / TRANSACTION_STATUS_PAGE_MIRROR_CHUNK_SIZE]), memory_order_acquire);
+	if(chunk == NULL)
+		return NULL;
+
+	return atomic_load_explicit(&(chunk[bucket_id % TRANSACTION_STATUS_PAGE_MIRROR_CHUNK_SIZE]), memory_order_acquire);
+}
+
+int find_in_transaction_status_page_mirror(const transaction_status_page_mirror* tspm_p, uint256 transaction_id, transaction_status* status)
+{
+	// only the transaction_ids that fit in 64 bits could be in a mirrored page
+	if(transaction_id.limbs[1] != 0 || transaction_id.limbs[2] != 0 || transaction_id.limbs[3] != 0)
+		return 0;
+
+	const uint8_t* page = get_mirrored_page(tspm_p, transaction_id.limbs[0] / tspm_p->statuses_per_page);
+	if(page == NULL)
+		return 0;
+
+	(*status) = get_status_on_mirrored_transaction_status_page(page, transaction_id.limbs[0] % tspm_p->statuses_per_page);
+	return 1;
+}
+
+int can_insert_in_transaction_status_page_mirror(transaction_status_page_mirror* tspm_p, uint64_t bucket_id)
+{
+	if(bucket_id >= MAX_MIRRORABLE_BUCKET_ID)
+		return 0;
+
+	pthread_mutex_lock(&(tspm_p->insert_lock));
+	int is_full = (tspm_p->pages_count >= tspm_p->max_pages_count);
+	pthread_mutex_unlock(&(tspm_p->insert_lock));
+
+	return (!is_full) && (get_mirrored_page(tspm_p, bucket_id) == NULL);
+}
+
+int insert_in_transaction_status_page_mirror(transaction_status_page_mirror* tspm_p, uint64_t bucket_id, uint8_t* page)
+{
+	if(bucket_id >= MAX_MIRRORABLE_BUCKET_ID)
+	{
+		free(page);
+		return 0;
+	}
+
+	pthread_mutex_lock(&(tspm_p->insert_lock));
+
+	// someone else may have mirrored it, while we were reading it
+	if(tspm_p->pages_count >= tspm_p->max_pages_count || get_mirrored_page(tspm_p, bucket_id) != NULL)
+	{
+		pthread_mutex_unlock(&(tspm_p->insert_lock));
+		free(page);
+		return 0;
+	}
+
+	// only the inserts write the directory, and they are serialized by the insert_lock, so it can be read here relaxed
+	_Atomic(const uint8_t*)* chunk = atomic_load_explicit(&(tspm_p->directory[bucket_id / TRANSACTION_STATUS_PAGE_MIRROR_CHUNK_SIZE]), memory_order_relaxed);
+	if(chunk == NULL)
+	{
+		chunk = malloc(sizeof(_Atomic(const uint8_t*)) * TRANSACTION_STATUS_PAGE_MIRROR_CHUNK_SIZE);
+		if(chunk == NULL)
+		{
+			printf("FAILED to allocate memory for transaction_status_page_mirror\n");
+			exit(-1);
+		}
+		for(uint32_t i = 0; i < TRANSACTION_STATUS_PAGE_MIRROR_CHUNK_SIZE; i++)
+			atomic_init(&(chunk[i]), NULL);
+
+		atomic_store_explicit(&(tspm_p->directory[bucket_id / TRANSACTION_STATUS_PAGE_MIRROR_CHUNK_SIZE]), chunk, memory_order_release);
+	}
+
+	atomic_store_explicit(&(chunk[bucket_id % TRANSACTION_STATUS_PAGE_MIRROR_CHUNK_SIZE]), page, memory_order_release);
+	tspm_p->pages_count++;
+
+	pthread_mutex_unlock(&(tspm_p->insert_lock));
+
+	return 1;
+}
+
+void deinitialize_transaction_status_page_mirror(transaction_status_page_mirror* tspm_p)
+{
+	for(uint32_t i = 0; i < TRANSACTION_STATUS_PAGE_MIRROR_DIRECTORY_SIZE; i++)
+	{
+		_Atomic(const uint8_t*)* chunk = atomic_load_explicit(&(tspm_p->directory[i]), memory_order_relaxed);
+		if(chunk == NULL)
+			continue;
+
+		for(uint32_t j = 0; j < TRANSACTION_STATUS_PAGE_MIRROR_CHUNK_SIZE; j++)
+			free((void*)atomic_load_explicit(&(chunk[j]), memory_order_relaxed));
+		free(chunk);
+		atomic_store_explicit(&(tspm_p->directory[i]), NULL, memory_order_relaxed);
+	}
+
+	pthread_mutex_destroy(&(tspm_p->insert_lock));
+	tspm_p->pages_count = 0;
+}
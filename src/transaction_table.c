@@ -1,5 +1,7 @@
 #include<rhendb/transaction_table.h>
 
+#include<posixutils/pthread_cond_utils.h>
+
 #include<stdlib.h>
 #include<unistd.h>
 
@@ -18,29 +20,6 @@ static int compare_active_transaction_id_entry(const void* a, const void* b)
 	return compare_uint256_with_ptrs(&(((const active_transaction_id_entry*)a)->transaction_id), &(((const active_transaction_id_entry*)b)->transaction_id));
 }
 
-// entry for the transaction_table_cache cachemap
-typedef struct passive_transaction_id_entry passive_transaction_id_entry;
-struct passive_transaction_id_entry
-{
-	// this transaction_id will be in either TX_ABORTED or TX_COMMITTED status, check the status attribute
-	uint256 transaction_id; // note: it should always be the first attribute
-
-	// this status will be either TX_ABORTED or TX_COMMITTED, only
-	transaction_status status;
-
-	cchnode embed_node;
-};
-
-static int compare_passive_transaction_id_entry(const void* a, const void* b)
-{
-	return compare_uint256_with_ptrs(&(((const passive_transaction_id_entry*)a)->transaction_id), &(((const passive_transaction_id_entry*)b)->transaction_id));
-}
-
-static cy_uint hash_passive_transaction_id_entry(const void* a)
-{
-	return ((const passive_transaction_id_entry*)a)->transaction_id.limbs[0];
-}
-
 /*
 	internal table functions
 	Note: You do not need lock to access the persistent transaction table as the MinTxEngine will take care of the ACID-compliant access to it
@@ -119,8 +98,69 @@ static int get_transaction_status_from_table(transaction_table* ttbl, uint256 tr
 	return 0;
 }
 
-// this is the maximum transaction_id that was never assigned
-static void get_min_unassigned_transaction_id(transaction_table* ttbl, uint256* transaction_id)
+// reads all the transaction statuses as is, from the bitmap page of the bucket_id into a mirrored page, fails if the bitmap page does not exist
+static int get_all_transaction_statuses_of_bucket_from_table(transaction_table* ttbl, uint64_t bucket_id, uint8_t* mirrored_page)
+{
+	while(1)
+	{
+		// initialize result to 0, i.e. not yet produced
+		int result = 0;
+
+		int abort_error = 0;
+
+		page_table_range_locker* ptrl_p = NULL;
+		persistent_page bucket_page = get_NULL_persistent_page(ttbl->ttbl_engine->pam_p);
+
+		ptrl_p = get_new_page_table_range_locker(ttbl->transaction_table_root_page_id, (bucket_range){.first_bucket_id = bucket_id, .last_bucket_id = bucket_id}, ttbl->pttd_p, ttbl->ttbl_engine->pam_p, NULL, NULL, &abort_error);
+		if(abort_error)
+			goto ABORT_ERROR;
+
+		uint64_t bucket_page_id = get_from_page_table(ptrl_p, bucket_id, NULL, &abort_error);
+		if(abort_error)
+			goto ABORT_ERROR;
+
+		if(bucket_page_id != ttbl->ttbl_engine->pam_p->pas.NULL_PAGE_ID)
+		{
+			bucket_page = acquire_persistent_page_with_lock(ttbl->ttbl_engine->pam_p, NULL, bucket_page_id, READ_LOCK, &abort_error);
+			if(abort_error)
+				goto ABORT_ERROR;
+
+			for(uint32_t sub_bucket_id = 0; sub_bucket_id < ttbl->transaction_statuses_per_bitmap_page; sub_bucket_id++)
+			{
+				uint64_t status_field = get_bit_field_on_bitmap_page(&bucket_page, sub_bucket_id, &(ttbl->ttbl_engine->pam_p->pas), ttbl->bitmap_page_tuple_def_p);
+				set_status_on_mirrored_transaction_status_page(mirrored_page, sub_bucket_id, status_field);
+			}
+
+			result = 1;
+		}
+
+		// release all resources now
+		ABORT_ERROR:;
+		if(!is_persistent_page_NULL(&bucket_page, ttbl->ttbl_engine->pam_p))
+		{
+			release_lock_on_persistent_page(ttbl->ttbl_engine->pam_p, NULL, &bucket_page, NONE_OPTION, &abort_error);
+			bucket_page = get_NULL_persistent_page(ttbl->ttbl_engine->pam_p);
+		}
+		if(ptrl_p != NULL)
+		{
+			delete_page_table_range_locker(ptrl_p, NULL, NULL, NULL, &abort_error);
+			ptrl_p = NULL;
+		}
+
+		// if read done, i.e. no abort_error, then return result
+		if(abort_error == 0)
+			return result;
+
+		// sleep for a second and try again
+		sleep(1);
+	}
+
+	// never reaches here
+	return 0;
+}
+
+// this is the maximum transaction_id that was never assigned, also returns the transaction_id below which the transaction table was truncated
+static void get_min_unassigned_transaction_id(transaction_table* ttbl, uint256* transaction_id, uint256* truncated_transaction_id)
 {
 	while(1)
 	{
@@ -166,6 +206,19 @@ static void get_min_unassigned_transaction_id(transaction_table* ttbl, uint256*
 		else // if none exists ask the callee to start allotting new transactions from 0
 			(*transaction_id) = get_0_uint256();
 
+		// find the least non-NULL bucket_id, the bitmap pages of all the buckets before it were freed by truncate_transaction_table()
+		{
+			uint64_t first_bucket_id = 0;
+			uint64_t first_bucket_page_id = find_non_NULL_PAGE_ID_in_page_table(ptrl_p, &first_bucket_id, GREATER_THAN_EQUALS, NULL, &abort_error);
+			if(abort_error)
+				goto ABORT_ERROR;
+
+			if(first_bucket_page_id != ttbl->ttbl_engine->pam_p->pas.NULL_PAGE_ID)
+				mul_uint256(truncated_transaction_id, get_uint256(first_bucket_id), get_uint256(ttbl->transaction_statuses_per_bitmap_page));
+			else
+				(*truncated_transaction_id) = get_0_uint256();
+		}
+
 		// release all resources now
 		ABORT_ERROR:;
 		if(!is_persistent_page_NULL(&bucket_page, ttbl->ttbl_engine->pam_p))
@@ -191,21 +244,11 @@ static void get_min_unassigned_transaction_id(transaction_table* ttbl, uint256*
 	return ;
 }
 
-// updates transaction status for the transaction_id on the table, as is creates a new page_table entry and a bitmap page if required
+// updates transaction statuses for the statuses_count sub_bucket_ids of the bitmap page of bucket_id on the table, in a single mini transaction, as is creates a new page_table entry and a bitmap page if required
 // if a flush is set an immediate flush is performed while committing the mini transaction that performed the write
 // must never fail
-static int set_transaction_status_in_table(transaction_table* ttbl, uint256 transaction_id, transaction_status status, int flush)
+static int set_transaction_statuses_of_bucket_in_table(transaction_table* ttbl, uint64_t bucket_id, const uint32_t* sub_bucket_ids, const transaction_status* statuses, uint32_t statuses_count, int flush)
 {
-	uint64_t bucket_id;
-	uint32_t sub_bucket_id;
-
-	{
-		uint256 q;
-		uint256 r = div_uint256(&q, transaction_id, get_uint256(ttbl->transaction_statuses_per_bitmap_page));
-		bucket_id = q.limbs[0];
-		sub_bucket_id = r.limbs[0];
-	}
-
 	uint64_t page_latches_to_be_borrowed = 0;
 
 	while(1)
@@ -245,9 +288,12 @@ static int set_transaction_status_in_table(transaction_table* ttbl, uint256 tran
 				goto ABORT_ERROR;
 		}
 
-		set_bit_field_on_bitmap_page(&bucket_page, sub_bucket_id, (uint64_t)(status), &(ttbl->ttbl_engine->pam_p->pas), ttbl->bitmap_page_tuple_def_p, ttbl->ttbl_engine->pmm_p, sub_transaction_id, &abort_error);
-		if(abort_error)
-			goto ABORT_ERROR;
+		for(uint32_t i = 0; i < statuses_count; i++)
+		{
+			set_bit_field_on_bitmap_page(&bucket_page, sub_bucket_ids[i], (uint64_t)(statuses[i]), &(ttbl->ttbl_engine->pam_p->pas), ttbl->bitmap_page_tuple_def_p, ttbl->ttbl_engine->pmm_p, sub_transaction_id, &abort_error);
+			if(abort_error)
+				goto ABORT_ERROR;
+		}
 
 		// release all resources now
 		ABORT_ERROR:;
@@ -275,64 +321,274 @@ static int set_transaction_status_in_table(transaction_table* ttbl, uint256 tran
 	return 0;
 }
 
+// updates transaction status for the transaction_id on the table, same as above
+static int set_transaction_status_in_table(transaction_table* ttbl, uint256 transaction_id, transaction_status status, int flush)
+{
+	uint64_t bucket_id;
+	uint32_t sub_bucket_id;
+
+	{
+		uint256 q;
+		uint256 r = div_uint256(&q, transaction_id, get_uint256(ttbl->transaction_statuses_per_bitmap_page));
+		bucket_id = q.limbs[0];
+		sub_bucket_id = r.limbs[0];
+	}
+
+	return set_transaction_statuses_of_bucket_in_table(ttbl, bucket_id, &sub_bucket_id, &status, 1, flush);
+}
+
 // --
 
+// entry for the group_commit_queue, it lives on the stack of the committer waiting for it to be written
+typedef struct group_commit_entry group_commit_entry;
+struct group_commit_entry
+{
+	uint256 transaction_id;
+
+	// TX_COMMITTED or TX_ABORTED
+	transaction_status status;
+
+	// set only for a TX_COMMITTED, the batch is flushed if any of its entries need it
+	int needs_flush;
+
+	// set by the leader, once the status is on the disk and the entry is out of the group_commit_queue
+	int is_written;
+
+	slnode embed_node;
+};
+
+static int compare_group_commit_entry_ptrs(const void* a, const void* b)
+{
+	return compare_uint256((*((const group_commit_entry**)a))->transaction_id, (*((const group_commit_entry**)b))->transaction_id);
+}
+
 /*
-	internal cache functions
-	must be called with transaction_table_cache_lock held in write lock mode (exclusive lock)
+	internal functions for the group commit
+	must be called with the group_commit_lock held, unless mentioned otherwise
 */
 
-// reads the transaction status as is from the cache, fails if the entry does not exists in the cache
-// if an entry is found it is bumped in the cache, so as to avoid immediate eviction
-static int get_transaction_status_from_cache(transaction_table* ttbl, uint256 transaction_id, transaction_status* status)
+// must also be called with transaction_table_cache_lock held in write lock mode, right after the transaction_id is removed from the currently_active_transaction_ids
+static void enqueue_for_group_commit(transaction_table* ttbl, group_commit_entry* e)
 {
-	// find one that equals, else fail with 0
-	const passive_transaction_id_entry* ptid_p = find_equals_in_cachemap(&(ttbl->transaction_table_cache), &transaction_id);
-	if(ptid_p == NULL)
-		return 0;
+	insert_tail_in_singlylist(&(ttbl->group_commit_queue), e);
+	ttbl->group_commit_queue_size++;
 
-	// then bump the found entry, retrieve status and return 1
-	bump_element_in_cachemap(&(ttbl->transaction_table_cache), ptid_p);
-	(*status) = ptid_p->status;
-	return 1;
+	// wake up the leader, if the batch it is waiting for is full
+	if(ttbl->has_group_commit_leader && ttbl->group_commit_batch_size == 0 && ttbl->group_commit_queue_size >= ttbl->group_commit_max_batch_size)
+		pthread_cond_broadcast(&(ttbl->group_commit_wait));
+}
+
+// must also be called with transaction_table_lock held in read (or write) lock mode, if the status must be consistent with the one on the disk, as the leader removes the entries after writing them
+// returns 1 and sets the status, if the transaction_id is enqueued and not yet written to the disk
+static int find_in_group_commit_queue(transaction_table* ttbl, uint256 transaction_id, transaction_status* status)
+{
+	for(const group_commit_entry* e = get_head_of_singlylist(&(ttbl->group_commit_queue)); e != NULL; e = get_next_of_in_singlylist(&(ttbl->group_commit_queue), e))
+	{
+		if(compare_uint256(e->transaction_id, transaction_id) == 0)
+		{
+			(*status) = e->status;
+			return 1;
+		}
+	}
+	return 0;
 }
 
-// inserts a new entry in the cache for the given transaction_id OR updates and bumps it, if an entry for the transaction_id exists
-static void set_transaction_status_in_cache(transaction_table* ttbl, uint256 transaction_id, transaction_status status)
+// must be called with transaction_table_lock held in write lock mode, and without the group_commit_lock
+// writes all the statuses of the batch, with one mini transaction per bitmap page, flushing only the last one, if any of them needs a flush
+// returns 1, if it flushed
+static int write_group_commit_batch(transaction_table* ttbl, group_commit_entry** batch, uint32_t batch_size)
 {
-	// find one that equals
-	passive_transaction_id_entry* ptid_p = (passive_transaction_id_entry*) find_equals_in_cachemap(&(ttbl->transaction_table_cache), &transaction_id);
+	// sort them, so that the statuses of the same bitmap page are adjacent
+	qsort(batch, batch_size, sizeof(group_commit_entry*), compare_group_commit_entry_ptrs);
+
+	int needs_flush = 0;
+	for(uint32_t i = 0; i < batch_size; i++)
+		needs_flush = needs_flush || batch[i]->needs_flush;
+
+	uint32_t sub_bucket_ids[batch_size];
+	transaction_status statuses[batch_size];
 
-	if(ptid_p == NULL)
+	uint32_t i = 0;
+	while(i < batch_size)
 	{
-		// if there is space for a new entry create a new one
-		if(get_element_count_cachemap(&(ttbl->transaction_table_cache)) < ttbl->transaction_table_cache_capacity)
+		uint64_t bucket_id = 0;
+		uint32_t statuses_count = 0;
+
+		for(; i < batch_size; i++)
 		{
-			// if find fails, allocate a new entry
-			ptid_p = malloc(sizeof(passive_transaction_id_entry));
-			if(ptid_p == NULL)
-				exit(-1);
+			uint256 q;
+			uint256 r = div_uint256(&q, batch[i]->transaction_id, get_uint256(ttbl->transaction_statuses_per_bitmap_page));
+			if(statuses_count > 0 && q.limbs[0] != bucket_id)
+				break;
+			bucket_id = q.limbs[0];
+			sub_bucket_ids[statuses_count] = r.limbs[0];
+			statuses[statuses_count] = batch[i]->status;
+			statuses_count++;
 		}
-		else // else evict an existing one
+
+		// the mini transactions are logged in the order of their completion, so flushing the last one also makes all the prior ones durable
+		set_transaction_statuses_of_bucket_in_table(ttbl, bucket_id, sub_bucket_ids, statuses, statuses_count, needs_flush && (i == batch_size));
+	}
+
+	return needs_flush;
+}
+
+// remembers the transaction_ids of the batch that were committed without a flush, i.e. asynchronously, and are not yet durable
+// if the batch was flushed, then all the prior asynchronous commits are durable now
+static void track_undurable_transaction_ids(transaction_table* ttbl, group_commit_entry** batch, uint32_t batch_size, int was_flushed)
+{
+	if(was_flushed)
+	{
+		ttbl->has_undurable_transaction_ids = 0;
+		ttbl->has_flushing_transaction_ids = 0;
+		return;
+	}
+
+	for(uint32_t i = 0; i < batch_size; i++)
+	{
+		if(batch[i]->status != TX_COMMITTED)
+			continue;
+
+		if(!ttbl->has_undurable_transaction_ids)
 		{
-			ptid_p = (passive_transaction_id_entry*) get_evictable_element_from_cachemap(&(ttbl->transaction_table_cache));
-			remove_from_cachemap(&(ttbl->transaction_table_cache), ptid_p);
+			ttbl->has_undurable_transaction_ids = 1;
+			ttbl->min_undurable_transaction_id = batch[i]->transaction_id;
 		}
+		else
+			ttbl->min_undurable_transaction_id = min_uint256(ttbl->min_undurable_transaction_id, batch[i]->transaction_id);
+	}
+}
+
+// returns 1, if the status of the transaction_id may not yet be durable, it may also return 1 for an already durable one, that is above an undurable one
+static int is_undurable_transaction_id(transaction_table* ttbl, uint256 transaction_id)
+{
+	transaction_status status;
+	if(find_in_group_commit_queue(ttbl, transaction_id, &status))
+		return 1;
+	if(ttbl->has_undurable_transaction_ids && compare_uint256(transaction_id, ttbl->min_undurable_transaction_id) >= 0)
+		return 1;
+	if(ttbl->has_flushing_transaction_ids && compare_uint256(transaction_id, ttbl->min_flushing_transaction_id) >= 0)
+		return 1;
+	return 0;
+}
 
-		// initialize it
-		ptid_p->transaction_id = transaction_id;
-		ptid_p->status = status;
-		initialize_cchnode(&(ptid_p->embed_node));
+// must be called without any locks held
+// waits for the status of e to be written to the disk, writing it (as the leader), along with the other enqueued ones, if no one else is doing it
+static void wait_for_group_commit(transaction_table* ttbl, group_commit_entry* e)
+{
+	pthread_mutex_lock(&(ttbl->group_commit_lock));
 
-		// insert it
-		insert_in_cachemap(&(ttbl->transaction_table_cache), ptid_p);
+	while(!e->is_written)
+	{
+		// someone else is the leader, wait for it to write our status or for it to give up leadership
+		if(ttbl->has_group_commit_leader)
+		{
+			pthread_cond_wait(&(ttbl->group_commit_wait), &(ttbl->group_commit_lock));
+			continue;
+		}
+
+		ttbl->has_group_commit_leader = 1;
+
+		// wait for the batch to fill up, but atmost for group_commit_latency_us
+		uint64_t timeout_in_microseconds = ttbl->group_commit_latency_us;
+		while(ttbl->group_commit_queue_size < ttbl->group_commit_max_batch_size && timeout_in_microseconds > 0)
+		{
+			if(pthread_cond_timedwait_for_microseconds(&(ttbl->group_commit_wait), &(ttbl->group_commit_lock), &timeout_in_microseconds))
+				break;
+		}
+
+		// take the batch from the head of the group_commit_queue, e is in the queue, so the batch is never empty
+		ttbl->group_commit_batch_size = (ttbl->group_commit_queue_size < ttbl->group_commit_max_batch_size) ? ttbl->group_commit_queue_size : ttbl->group_commit_max_batch_size;
+		group_commit_entry* batch[ttbl->group_commit_batch_size];
+		{
+			group_commit_entry* b = (group_commit_entry*) get_head_of_singlylist(&(ttbl->group_commit_queue));
+			for(uint32_t i = 0; i < ttbl->group_commit_batch_size; i++)
+			{
+				batch[i] = b;
+				b = (group_commit_entry*) get_next_of_in_singlylist(&(ttbl->group_commit_queue), b);
+			}
+		}
+		uint32_t batch_size = ttbl->group_commit_batch_size;
+
+		pthread_mutex_unlock(&(ttbl->group_commit_lock));
+
+		write_lock(&(ttbl->transaction_table_lock), BLOCKING);
+
+		int was_flushed = write_group_commit_batch(ttbl, batch, batch_size);
+
+		// remove the written entries, before releasing the transaction_table_lock, so that the readers find them either in the group_commit_queue or on the disk
+		pthread_mutex_lock(&(ttbl->group_commit_lock));
+
+		track_undurable_transaction_ids(ttbl, batch, batch_size, was_flushed);
+
+		for(uint32_t i = 0; i < batch_size; i++)
+		{
+			group_commit_entry* w = (group_commit_entry*) get_head_of_singlylist(&(ttbl->group_commit_queue));
+			remove_head_from_singlylist(&(ttbl->group_commit_queue));
+			ttbl->group_commit_queue_size--;
+			w->is_written = 1;
+		}
+
+		write_unlock(&(ttbl->transaction_table_lock));
+
+		// give up the leadership, and wake up the committers, if e was not in the batch we will be the leader again
+		ttbl->has_group_commit_leader = 0;
+		ttbl->group_commit_batch_size = 0;
+		pthread_cond_broadcast(&(ttbl->group_commit_wait));
 	}
-	else
+
+	pthread_mutex_unlock(&(ttbl->group_commit_lock));
+}
+
+// body of the async_commit_flusher thread
+// every async_commit_flush_period_us, it makes the asynchronous commits durable, by rewriting the (already written) status of the minimum of them with a flush, forcing the WAL
+static void* async_commit_flusher(void* ttbl_p)
+{
+	transaction_table* ttbl = ttbl_p;
+
+	pthread_mutex_lock(&(ttbl->group_commit_lock));
+
+	while(1)
 	{
-		// else if found, set status and bump the element
-		ptid_p->status = status;
-		bump_element_in_cachemap(&(ttbl->transaction_table_cache), ptid_p);
+		uint64_t timeout_in_microseconds = ttbl->async_commit_flush_period_us;
+		while(!ttbl->stop_async_commit_flusher && timeout_in_microseconds > 0)
+		{
+			if(pthread_cond_timedwait_for_microseconds(&(ttbl->group_commit_wait), &(ttbl->group_commit_lock), &timeout_in_microseconds))
+				break;
+		}
+
+		if(!ttbl->has_undurable_transaction_ids)
+		{
+			// nothing to flush, and asked to stop
+			if(ttbl->stop_async_commit_flusher)
+				break;
+			continue;
+		}
+
+		ttbl->has_flushing_transaction_ids = 1;
+		ttbl->min_flushing_transaction_id = ttbl->min_undurable_transaction_id;
+		ttbl->has_undurable_transaction_ids = 0;
+		uint256 transaction_id = ttbl->min_flushing_transaction_id;
+
+		pthread_mutex_unlock(&(ttbl->group_commit_lock));
+
+		// all the statuses in flushing were completely written, before we took them, so forcing the WAL now, makes them all durable
+		// rewriting a status that is already on the disk is idempotent, so a read lock suffices, same as fixing the TX_IN_PROGRESS-s before boot
+		read_lock(&(ttbl->transaction_table_lock), READ_PREFERRING, BLOCKING);
+		set_transaction_status_in_table(ttbl, transaction_id, TX_COMMITTED, 1);
+		read_unlock(&(ttbl->transaction_table_lock));
+
+		pthread_mutex_lock(&(ttbl->group_commit_lock));
+
+		ttbl->has_flushing_transaction_ids = 0;
+
+		// wake up the ones waiting for their durability
+		pthread_cond_broadcast(&(ttbl->group_commit_wait));
 	}
+
+	pthread_mutex_unlock(&(ttbl->group_commit_lock));
+
+	return NULL;
 }
 
 // --
@@ -390,8 +646,95 @@ static int remove_from_currently_active_transaction_ids(transaction_table* ttbl,
 
 // --
 
-void initialize_transaction_table(transaction_table* ttbl, uint64_t* root_page_id, rage_engine* ttbl_engine, uint32_t transaction_table_cache_capacity)
+// number of bitmap pages freed in a single mini transaction, by truncate_transaction_table()
+#define TRUNCATION_BATCH_SIZE 64
+
+// frees atmost TRUNCATION_BATCH_SIZE bitmap pages of the buckets in the range [first_bucket_id, end_bucket_id), and removes them from the page_table, in a single mini transaction
+// returns the bucket_id, before which all the bitmap pages have been freed
+// must never fail
+static uint64_t free_bitmap_pages_of_buckets_in_table(transaction_table* ttbl, uint64_t first_bucket_id, uint64_t end_bucket_id)
 {
+	uint64_t page_latches_to_be_borrowed = 0;
+
+	while(1)
+	{
+		int abort_error = 0;
+
+		page_table_range_locker* ptrl_p = NULL;
+		persistent_page bucket_page = get_NULL_persistent_page(ttbl->ttbl_engine->pam_p);
+
+		uint64_t bucket_id = first_bucket_id;
+
+		void* sub_transaction_id = ttbl->ttbl_engine->allot_new_sub_transaction_id(ttbl->ttbl_engine->context, page_latches_to_be_borrowed);
+
+		ptrl_p = get_new_page_table_range_locker(ttbl->transaction_table_root_page_id, (bucket_range){.first_bucket_id = first_bucket_id, .last_bucket_id = end_bucket_id - 1}, ttbl->pttd_p, ttbl->ttbl_engine->pam_p, ttbl->ttbl_engine->pmm_p, sub_transaction_id, &abort_error);
+		if(abort_error)
+			goto ABORT_ERROR;
+
+		for(uint32_t freed_count = 0; freed_count < TRUNCATION_BATCH_SIZE && bucket_id < end_bucket_id; freed_count++)
+		{
+			uint64_t bucket_page_id = find_non_NULL_PAGE_ID_in_page_table(ptrl_p, &bucket_id, GREATER_THAN_EQUALS, sub_transaction_id, &abort_error);
+			if(abort_error)
+				goto ABORT_ERROR;
+
+			// no more bitmap pages in the range
+			if(bucket_page_id == ttbl->ttbl_engine->pam_p->pas.NULL_PAGE_ID || bucket_id >= end_bucket_id)
+			{
+				bucket_id = end_bucket_id;
+				break;
+			}
+
+			bucket_page = acquire_persistent_page_with_lock(ttbl->ttbl_engine->pam_p, sub_transaction_id, bucket_page_id, WRITE_LOCK, &abort_error);
+			if(abort_error)
+				goto ABORT_ERROR;
+
+			release_lock_on_persistent_page(ttbl->ttbl_engine->pam_p, sub_transaction_id, &bucket_page, FREE_PAGE, &abort_error);
+			if(abort_error)
+				goto ABORT_ERROR;
+			bucket_page = get_NULL_persistent_page(ttbl->ttbl_engine->pam_p);
+
+			set_in_page_table(ptrl_p, bucket_id, ttbl->ttbl_engine->pam_p->pas.NULL_PAGE_ID, sub_transaction_id, &abort_error);
+			if(abort_error)
+				goto ABORT_ERROR;
+
+			bucket_id++;
+		}
+
+		// release all resources now
+		ABORT_ERROR:;
+		if(!is_persistent_page_NULL(&bucket_page, ttbl->ttbl_engine->pam_p))
+		{
+			release_lock_on_persistent_page(ttbl->ttbl_engine->pam_p, sub_transaction_id, &bucket_page, NONE_OPTION, &abort_error);
+			bucket_page = get_NULL_persistent_page(ttbl->ttbl_engine->pam_p);
+		}
+		if(ptrl_p != NULL)
+		{
+			delete_page_table_range_locker(ptrl_p, NULL, NULL, sub_transaction_id, &abort_error);
+			ptrl_p = NULL;
+		}
+
+		// not flushed, if lost in a crash, the truncation is just redone by the next call
+		ttbl->ttbl_engine->complete_sub_transaction(ttbl->ttbl_engine->context, sub_transaction_id, 0, NULL, 0, &page_latches_to_be_borrowed);
+
+		if(abort_error == 0)
+			return bucket_id;
+
+		// sleep for a second and try again
+		sleep(1);
+	}
+
+	// never reaches here
+	return first_bucket_id;
+}
+
+void initialize_transaction_table(transaction_table* ttbl, uint64_t* root_page_id, rage_engine* ttbl_engine, uint32_t transaction_table_cache_capacity, uint64_t group_commit_latency_us, uint32_t group_commit_max_batch_size, int is_asynchronous_commit_default, uint64_t async_commit_flush_period_us)
+{
+	if(group_commit_max_batch_size == 0)
+	{
+		printf("BUG (in transaction_table) :: group_commit_max_batch_size must be atleast 1\n");
+		exit(-1);
+	}
+
 	// initialize the root_page_id of the persistent transaction table
 	ttbl->transaction_table_root_page_id = (*root_page_id);
 
@@ -446,16 +789,44 @@ void initialize_transaction_table(transaction_table* ttbl, uint64_t* root_page_i
 
 	// initialize active and passive transaction_id caches
 	initialize_bst(&(ttbl->currently_active_transaction_ids), RED_BLACK_TREE, &simple_comparator(compare_active_transaction_id_entry), offsetof(active_transaction_id_entry, embed_node));
-	ttbl->transaction_table_cache_capacity = transaction_table_cache_capacity;
-	initialize_cachemap(&(ttbl->transaction_table_cache), NULL, NEVER_PINNED, ((transaction_table_cache_capacity / 5) + 5), &simple_hasher(hash_passive_transaction_id_entry), &simple_comparator(compare_passive_transaction_id_entry), offsetof(passive_transaction_id_entry, embed_node));
+	initialize_transaction_status_cache(&(ttbl->transaction_table_cache), transaction_table_cache_capacity);
+	initialize_transaction_status_page_mirror(&(ttbl->transaction_table_mirror), ttbl->transaction_statuses_per_bitmap_page, MAX_MIRRORED_TRANSACTION_STATUS_PAGES);
 	initialize_linkedlist(&(ttbl->active_mvcc_snapshots), offsetof(mvcc_snapshot, embed_node));
+	ttbl->snapshot_generation = 0;
+	ttbl->shared_mvcc_snapshot = NULL;
+
+	// initialize the group commit
+	pthread_mutex_init(&(ttbl->group_commit_lock), NULL);
+	pthread_cond_init_with_monotonic_clock(&(ttbl->group_commit_wait));
+	initialize_singlylist(&(ttbl->group_commit_queue), offsetof(group_commit_entry, embed_node));
+	ttbl->group_commit_queue_size = 0;
+	ttbl->has_group_commit_leader = 0;
+	ttbl->group_commit_batch_size = 0;
+	ttbl->group_commit_latency_us = group_commit_latency_us;
+	ttbl->group_commit_max_batch_size = group_commit_max_batch_size;
 
 	// compute the overflow_transaction_id, that you not go at or beyond
 	mul_uint256(&(ttbl->overflow_transaction_id), get_uint256(UINT64_MAX), get_uint256(ttbl->transaction_statuses_per_bitmap_page));
 
 	// initialize transaction_ids that are assignable
-	get_min_unassigned_transaction_id(ttbl, &(ttbl->next_assignable_transaction_id_at_boot));
+	get_min_unassigned_transaction_id(ttbl, &(ttbl->next_assignable_transaction_id_at_boot), &(ttbl->truncated_transaction_id));
 	ttbl->next_assignable_transaction_id = ttbl->next_assignable_transaction_id_at_boot;
+	ttbl->reserved_transaction_ids_end = ttbl->next_assignable_transaction_id_at_boot;
+	ttbl->reserved_transaction_ids_written_end = ttbl->next_assignable_transaction_id_at_boot;
+	ttbl->is_reserving_transaction_ids_ahead = 0;
+	ttbl->cached_vaccum_horizon_transaction_id = ttbl->next_assignable_transaction_id_at_boot;
+
+	// initialize the asynchronous commit, and start its flusher
+	ttbl->is_asynchronous_commit_default = is_asynchronous_commit_default && (async_commit_flush_period_us > 0);
+	ttbl->async_commit_flush_period_us = async_commit_flush_period_us;
+	ttbl->has_undurable_transaction_ids = 0;
+	ttbl->has_flushing_transaction_ids = 0;
+	ttbl->stop_async_commit_flusher = 0;
+	if(ttbl->async_commit_flush_period_us > 0 && pthread_create(&(ttbl->async_commit_flusher), NULL, async_commit_flusher, ttbl))
+	{
+		printf("FAILED to start the async_commit_flusher for the transaction_table\n");
+		exit(-1);
+	}
 }
 
 #include<rhendb/mvcc_snapshot.h>
@@ -473,6 +844,166 @@ static void mvcc_snapshot_inserter(const void* data, const void* additional_para
 	}
 }
 
+/*
+	internal functions for the mvcc_snapshots
+	must be called with transaction_table_cache_lock held in write lock mode
+*/
+
+// revises snp for the current instance in time, snp must not be referenced by any other transaction
+static void revise_mvcc_snapshot(transaction_table* ttbl, mvcc_snapshot* snp)
+{
+	begin_taking_mvcc_snapshot(snp, ttbl->next_assignable_transaction_id);
+	for_each_in_order_in_currently_active_transaction_ids(ttbl, mvcc_snapshot_inserter, snp);
+	finalize_mvcc_snapshot(snp);
+	snp->generation = ttbl->snapshot_generation;
+}
+
+// creates a new snapshot without a self_transaction_id, and links it in the active_mvcc_snapshots
+static mvcc_snapshot* take_new_mvcc_snapshot(transaction_table* ttbl)
+{
+	mvcc_snapshot* snp = get_new_mvcc_snapshot();
+
+	// link it in the global linkedlist
+	insert_tail_in_linkedlist(&(ttbl->active_mvcc_snapshots), snp);
+
+	revise_mvcc_snapshot(ttbl, snp);
+
+	return snp;
+}
+
+static void minimize_vaccum_horizon_transaction_id(const void* data, const void* additional_params)
+{
+	uint256* vaccum_horizon_transaction_id = (uint256*) additional_params;
+
+	mvcc_snapshot* snp = (mvcc_snapshot*) data;
+
+	if(snp->has_self_transaction_id)
+		(*vaccum_horizon_transaction_id) = min_uint256((*vaccum_horizon_transaction_id), snp->self_transaction_id);
+
+	(*vaccum_horizon_transaction_id) = min_uint256((*vaccum_horizon_transaction_id), snp->least_unassigned_transaction_id);
+
+	if(NULL != get_in_progress_transaction_ids_for_mvcc_snapshot(snp, 0))
+		(*vaccum_horizon_transaction_id) = min_uint256((*vaccum_horizon_transaction_id), *get_in_progress_transaction_ids_for_mvcc_snapshot(snp, 0));
+}
+
+// must be called with transaction_table_cache_lock held in read or write lock mode
+static uint256 get_vaccum_horizon_transaction_id_unlocked(transaction_table* ttbl)
+{
+	uint256 vaccum_horizon_transaction_id = ttbl->next_assignable_transaction_id;
+
+	for_each_in_linkedlist(&(ttbl->active_mvcc_snapshots), minimize_vaccum_horizon_transaction_id, &vaccum_horizon_transaction_id);
+
+	return vaccum_horizon_transaction_id;
+}
+
+// releases a reference to the snp, and deletes it if it was the last one
+static void release_mvcc_snapshot(transaction_table* ttbl, mvcc_snapshot* snp)
+{
+	if(atomic_fetch_sub_explicit(&(snp->reference_count), 1, memory_order_relaxed) > 1)
+		return;
+
+	if(ttbl->shared_mvcc_snapshot == snp)
+		ttbl->shared_mvcc_snapshot = NULL;
+
+	// the vaccum horizon can move up, only if this snp was (one of) what bounded it
+	uint256 snp_vaccum_horizon_transaction_id = ttbl->next_assignable_transaction_id;
+	minimize_vaccum_horizon_transaction_id(snp, &snp_vaccum_horizon_transaction_id);
+
+	remove_from_linkedlist(&(ttbl->active_mvcc_snapshots), snp);
+	delete_mvcc_snapshot(snp);
+
+	if(compare_uint256(snp_vaccum_horizon_transaction_id, ttbl->cached_vaccum_horizon_transaction_id) <= 0)
+		ttbl->cached_vaccum_horizon_transaction_id = get_vaccum_horizon_transaction_id_unlocked(ttbl);
+}
+
+// returns a snapshot equivalent to snp, that only the caller references and that is not going to be shared anymore, so that it can be modified
+static mvcc_snapshot* make_private_mvcc_snapshot(transaction_table* ttbl, mvcc_snapshot* snp)
+{
+	// reference_count is only incremented with a read lock, so it is stable here
+	if(atomic_load_explicit(&(snp->reference_count), memory_order_relaxed) == 1)
+	{
+		if(ttbl->shared_mvcc_snapshot == snp)
+			ttbl->shared_mvcc_snapshot = NULL;
+		return snp;
+	}
+
+	mvcc_snapshot* clone_p = clone_mvcc_snapshot(snp);
+	insert_tail_in_linkedlist(&(ttbl->active_mvcc_snapshots), clone_p);
+
+	release_mvcc_snapshot(ttbl, snp);
+
+	return clone_p;
+}
+
+// must be called without the transaction_table_cache_lock held, so that the flush of the mini transaction does not block the readers and the writers
+// reserves atmost TRANSACTION_ID_RESERVATION_BATCH_SIZE transaction_ids starting at the reserve_from, all on the same bitmap page, with a single flush
+// returns the end of the range reserved, this range depends only on the reserve_from
+// concurrent reservations may start from the same (or a stale) reserve_from, and by the time a late one writes, some of those transaction_ids may be assigned and even completed
+// so only the transaction_ids at or above the reserved_transaction_ids_written_end are set TX_IN_PROGRESS, a transaction_id is never written TX_IN_PROGRESS twice
+static uint256 reserve_transaction_ids(transaction_table* ttbl, uint256 reserve_from)
+{
+	uint64_t bucket_id;
+	uint32_t first_sub_bucket_id;
+
+	{
+		uint256 q;
+		uint256 r = div_uint256(&q, reserve_from, get_uint256(ttbl->transaction_statuses_per_bitmap_page));
+		bucket_id = q.limbs[0];
+		first_sub_bucket_id = r.limbs[0];
+	}
+
+	// the overflow_transaction_id is at a bitmap page boundary, so not crossing it keeps us below it
+	uint32_t reserve_count = ttbl->transaction_statuses_per_bitmap_page - first_sub_bucket_id;
+	if(reserve_count > TRANSACTION_ID_RESERVATION_BATCH_SIZE)
+		reserve_count = TRANSACTION_ID_RESERVATION_BATCH_SIZE;
+
+	uint256 reserve_end;
+	add_uint256(&reserve_end, reserve_from, get_uint256(reserve_count));
+
+	write_lock(&(ttbl->transaction_table_lock), BLOCKING);
+
+	// skip the transaction_ids that an other reservation has already written, they are all in [reserve_from, reserve_end), as it is a contiguous range on the same bitmap page
+	uint32_t skip_count = 0;
+	if(compare_uint256(ttbl->reserved_transaction_ids_written_end, reserve_end) >= 0)
+		skip_count = reserve_count;
+	else if(compare_uint256(ttbl->reserved_transaction_ids_written_end, reserve_from) > 0)
+	{
+		uint256 d;
+		sub_uint256(&d, ttbl->reserved_transaction_ids_written_end, reserve_from);
+		skip_count = d.limbs[0];
+	}
+
+	if(skip_count < reserve_count)
+	{
+		uint32_t write_count = reserve_count - skip_count;
+		uint32_t sub_bucket_ids[write_count];
+		transaction_status statuses[write_count];
+		for(uint32_t i = 0; i < write_count; i++)
+		{
+			sub_bucket_ids[i] = first_sub_bucket_id + skip_count + i;
+			statuses[i] = TX_IN_PROGRESS;
+		}
+
+		set_transaction_statuses_of_bucket_in_table(ttbl, bucket_id, sub_bucket_ids, statuses, write_count, 1);
+
+		ttbl->reserved_transaction_ids_written_end = reserve_end;
+	}
+
+	write_unlock(&(ttbl->transaction_table_lock));
+
+	return reserve_end;
+}
+
+// must be called with transaction_table_cache_lock held in write lock mode
+// a reservation started from a reserve_from at or below the reserved_transaction_ids_end, extends it contiguously, so the max of them is the new end
+static void publish_reserved_transaction_ids(transaction_table* ttbl, uint256 reserve_end)
+{
+	if(compare_uint256(reserve_end, ttbl->reserved_transaction_ids_end) > 0)
+		ttbl->reserved_transaction_ids_end = reserve_end;
+}
+
+// --
+
 mvcc_snapshot* get_new_transaction_id(transaction_table* ttbl, mvcc_snapshot* snp)
 {
 	// it is NO-OP function, if the provided snp already has a self_transaction_id
@@ -481,18 +1012,29 @@ mvcc_snapshot* get_new_transaction_id(transaction_table* ttbl, mvcc_snapshot* sn
 
 	write_lock(&(ttbl->transaction_table_cache_lock), BLOCKING);
 
+	// first create a read only snapshot if one does not exists, else make sure that we are not sharing it with anyone, before we give it a self_transaction_id
 	if(snp == NULL)
+		snp = take_new_mvcc_snapshot(ttbl);
+	else
+		snp = make_private_mvcc_snapshot(ttbl, snp);
+
+	// the next_assignable_transaction_id must already be TX_IN_PROGRESS on the disk (so it does not get reassigned after a crash), reserve some more if it is not
+	// this happens only if the reservations ahead (below) could not keep up, the transaction_table_cache_lock is released while the reservation is being flushed
+	while(compare_uint256(ttbl->next_assignable_transaction_id, ttbl->reserved_transaction_ids_end) >= 0)
 	{
-		// first create a read only snapshot if one does not exists
-		snp = get_new_mvcc_snapshot();
+		if(compare_uint256(ttbl->reserved_transaction_ids_end, ttbl->overflow_transaction_id) >= 0)
+		{
+			printf("BUG (in transaction_table) :: transaction id overflow occurred\n");
+			exit(-1);
+		}
+
+		uint256 reserve_from = ttbl->reserved_transaction_ids_end;
+		write_unlock(&(ttbl->transaction_table_cache_lock));
 
-		// link it in the global linkedlist
-		insert_tail_in_linkedlist(&(ttbl->active_mvcc_snapshots), snp);
+		uint256 reserve_end = reserve_transaction_ids(ttbl, reserve_from);
 
-		// setup mvcc snapshot's read only view
-		begin_taking_mvcc_snapshot(snp, ttbl->next_assignable_transaction_id);
-		for_each_in_order_in_currently_active_transaction_ids(ttbl, mvcc_snapshot_inserter, snp);
-		finalize_mvcc_snapshot(snp);
+		write_lock(&(ttbl->transaction_table_cache_lock), BLOCKING);
+		publish_reserved_transaction_ids(ttbl, reserve_end);
 	}
 
 	// then assign it the next possible assignable transaction_id
@@ -517,42 +1059,154 @@ mvcc_snapshot* get_new_transaction_id(transaction_table* ttbl, mvcc_snapshot* sn
 		exit(-1);
 	}
 
-	write_lock(&(ttbl->transaction_table_lock), BLOCKING);
+	// once half of the reserved transaction_ids are assigned, this writer reserves the next batch, after releasing the transaction_table_cache_lock
+	// so the upcoming writers find their transaction_ids already reserved, and no one flushes while holding the transaction_table_cache_lock
+	int needs_reservation_ahead = 0;
+	uint256 reserve_from;
+	{
+		uint256 half_batch_ahead;
+		add_uint256(&half_batch_ahead, ttbl->next_assignable_transaction_id, get_uint256(TRANSACTION_ID_RESERVATION_BATCH_SIZE / 2));
+		if(!(ttbl->is_reserving_transaction_ids_ahead)
+			&& compare_uint256(half_batch_ahead, ttbl->reserved_transaction_ids_end) >= 0
+			&& compare_uint256(ttbl->reserved_transaction_ids_end, ttbl->overflow_transaction_id) < 0)
+		{
+			ttbl->is_reserving_transaction_ids_ahead = 1;
+			needs_reservation_ahead = 1;
+			reserve_from = ttbl->reserved_transaction_ids_end;
+		}
+	}
 
 	write_unlock(&(ttbl->transaction_table_cache_lock));
 
-	// set the transaction status in the persistent table, with flush=1 (so it does not get reassigned after a crash)
-	set_transaction_status_in_table(ttbl, snp->self_transaction_id, TX_IN_PROGRESS, 1);
+	if(needs_reservation_ahead)
+	{
+		uint256 reserve_end = reserve_transaction_ids(ttbl, reserve_from);
 
-	write_unlock(&(ttbl->transaction_table_lock));
+		write_lock(&(ttbl->transaction_table_cache_lock), BLOCKING);
+		publish_reserved_transaction_ids(ttbl, reserve_end);
+		ttbl->is_reserving_transaction_ids_ahead = 0;
+		write_unlock(&(ttbl->transaction_table_cache_lock));
+	}
 
 	return snp;
 }
 
 mvcc_snapshot* get_or_revise_mvcc_snapshot(transaction_table* ttbl, mvcc_snapshot* snp)
 {
+	// no transaction has completed since snp or the shared_mvcc_snapshot was taken, then they are as good as a new one, so just use them
+	read_lock(&(ttbl->transaction_table_cache_lock), READ_PREFERRING, BLOCKING);
+
+	if(snp != NULL && snp->generation == ttbl->snapshot_generation)
+	{
+		read_unlock(&(ttbl->transaction_table_cache_lock));
+		return snp;
+	}
+
+	if(snp == NULL && ttbl->shared_mvcc_snapshot != NULL && ttbl->shared_mvcc_snapshot->generation == ttbl->snapshot_generation)
+	{
+		snp = ttbl->shared_mvcc_snapshot;
+		atomic_fetch_add_explicit(&(snp->reference_count), 1, memory_order_relaxed);
+		read_unlock(&(ttbl->transaction_table_cache_lock));
+		return snp;
+	}
+
+	read_unlock(&(ttbl->transaction_table_cache_lock));
+
 	write_lock(&(ttbl->transaction_table_cache_lock), BLOCKING);
 
-	// if a snp does not exist, create one
-	if(snp == NULL)
+	// a snp shared with others, can not be revised, so it is released and replaced
+	if(snp != NULL && atomic_load_explicit(&(snp->reference_count), memory_order_relaxed) > 1)
 	{
-		// create a read only snapshot if one does not exists
-		snp = get_new_mvcc_snapshot();
+		release_mvcc_snapshot(ttbl, snp);
+		snp = NULL;
+	}
 
-		// link it in the global linkedlist
-		insert_tail_in_linkedlist(&(ttbl->active_mvcc_snapshots), snp);
+	if(snp == NULL)
+	{
+		// check again, someone may have taken a new shared_mvcc_snapshot, while we were waiting for the write lock
+		if(ttbl->shared_mvcc_snapshot != NULL && ttbl->shared_mvcc_snapshot->generation == ttbl->snapshot_generation)
+		{
+			snp = ttbl->shared_mvcc_snapshot;
+			atomic_fetch_add_explicit(&(snp->reference_count), 1, memory_order_relaxed);
+		}
+		else
+		{
+			snp = take_new_mvcc_snapshot(ttbl);
+			ttbl->shared_mvcc_snapshot = snp;
+		}
 	}
+	else
+	{
+		// setup mvcc snapshot's read only view
+		revise_mvcc_snapshot(ttbl, snp);
 
-	// setup mvcc snapshot's read only view
-	begin_taking_mvcc_snapshot(snp, ttbl->next_assignable_transaction_id);
-	for_each_in_order_in_currently_active_transaction_ids(ttbl, mvcc_snapshot_inserter, snp);
-	finalize_mvcc_snapshot(snp);
+		// only a read-only snapshot may be shared
+		if(!snp->has_self_transaction_id)
+			ttbl->shared_mvcc_snapshot = snp;
+	}
 
 	write_unlock(&(ttbl->transaction_table_cache_lock));
 
 	return snp;
 }
 
+static uint64_t get_bucket_id_for_transaction_id(const transaction_table* ttbl, uint256 transaction_id)
+{
+	uint256 q;
+	div_uint256(&q, transaction_id, get_uint256(ttbl->transaction_statuses_per_bitmap_page));
+	return q.limbs[0];
+}
+
+// mirrors the bitmap page of the bucket_id, if all its transaction_ids are below the vaccum horizon, i.e. they all have completed and their statuses will never change
+// must be called with transaction_table_cache_lock held in read mode and then transaction_table_lock held in read mode, so that no completed transaction is still being written to the disk
+static void mirror_bucket_if_completed(transaction_table* ttbl, uint64_t bucket_id)
+{
+	// first_transaction_id of the next bucket must not be above the vaccum horizon, the cached one is never above the actual one, and it is never above the next_assignable_transaction_id
+	// this is checked first, as it does not take any lock, while it fails for the lookups of all the recent transaction_ids
+	uint256 next_bucket_first_transaction_id;
+	mul_uint256(&next_bucket_first_transaction_id, get_uint256(bucket_id + 1), get_uint256(ttbl->transaction_statuses_per_bitmap_page));
+	if(compare_uint256(next_bucket_first_transaction_id, ttbl->cached_vaccum_horizon_transaction_id) > 0)
+		return;
+
+	if(!can_insert_in_transaction_status_page_mirror(&(ttbl->transaction_table_mirror), bucket_id))
+		return;
+
+	uint8_t* mirrored_page = malloc(get_bytes_per_mirrored_transaction_status_page(&(ttbl->transaction_table_mirror)));
+	if(mirrored_page == NULL)
+		exit(-1);
+
+	if(!get_all_transaction_statuses_of_bucket_from_table(ttbl, bucket_id, mirrored_page))
+	{
+		free(mirrored_page);
+		return;
+	}
+
+	uint256 bucket_first_transaction_id;
+	mul_uint256(&bucket_first_transaction_id, get_uint256(bucket_id), get_uint256(ttbl->transaction_statuses_per_bitmap_page));
+
+	for(uint32_t sub_bucket_id = 0; sub_bucket_id < ttbl->transaction_statuses_per_bitmap_page; sub_bucket_id++)
+	{
+		transaction_status status = get_status_on_mirrored_transaction_status_page(mirrored_page, sub_bucket_id);
+		if(status == TX_COMMITTED || status == TX_ABORTED)
+			continue;
+
+		// same as in get_transaction_status(), a TX_IN_PROGRESS before boot is TX_ABORTED, even if it is not yet fixed on the disk
+		uint256 transaction_id;
+		add_uint256(&transaction_id, bucket_first_transaction_id, get_uint256(sub_bucket_id));
+		if(status == TX_IN_PROGRESS && compare_uint256(transaction_id, ttbl->next_assignable_transaction_id_at_boot) < 0)
+		{
+			set_status_on_mirrored_transaction_status_page(mirrored_page, sub_bucket_id, TX_ABORTED);
+			continue;
+		}
+
+		// an unassigned or an in progress transaction_id, can not be mirrored
+		free(mirrored_page);
+		return;
+	}
+
+	insert_in_transaction_status_page_mirror(&(ttbl->transaction_table_mirror), bucket_id, mirrored_page);
+}
+
 transaction_status get_transaction_status(transaction_table* ttbl, uint256 transaction_id)
 {
 	// if transaction_id >= overflow_transaction_id, then there is a bug
@@ -562,25 +1216,39 @@ transaction_status get_transaction_status(transaction_table* ttbl, uint256 trans
 		exit(-1);
 	}
 
-	write_lock(&(ttbl->transaction_table_cache_lock), BLOCKING);
+	// try to get the mirrored or the cached copy first, without any locks, these are never TX_IN_PROGRESS and never change
+	transaction_status status = 0;
+	if(find_in_transaction_status_page_mirror(&(ttbl->transaction_table_mirror), transaction_id, &status))
+		return status;
+	if(find_in_transaction_status_cache(&(ttbl->transaction_table_cache), transaction_id, &status))
+		return status;
+
+	// on a miss, we only read the currently_active_transaction_ids and the table, so a read lock suffices
+	read_lock(&(ttbl->transaction_table_cache_lock), READ_PREFERRING, BLOCKING);
 
 	// check if it is currently active
 	if(NULL != find_in_currently_active_transaction_ids(ttbl, transaction_id))
 	{
-		write_unlock(&(ttbl->transaction_table_cache_lock));
+		read_unlock(&(ttbl->transaction_table_cache_lock));
 		return TX_IN_PROGRESS;
 	}
 
-	// try to get the cached copy, now it can not be TX_IN_PROGRESS transaction
-	transaction_status status = 0;
-	if(get_transaction_status_from_cache(ttbl, transaction_id, &status))
+	// the reserved transaction_ids are TX_IN_PROGRESS on the disk, even before they are assigned
+	if(compare_uint256(transaction_id, ttbl->next_assignable_transaction_id) >= 0)
 	{
-		write_unlock(&(ttbl->transaction_table_cache_lock));
-		return status;
+		printf("BUG (in transaction_table) :: attempt to get transaction status for transaction id, that was never assigned\n");
+		exit(-1);
 	}
 
 	read_lock(&(ttbl->transaction_table_lock), READ_PREFERRING, BLOCKING);
 
+	// the bitmap page of this transaction_id is already freed, the tuples referring to it must have been frozen before that
+	if(compare_uint256(transaction_id, ttbl->truncated_transaction_id) < 0)
+	{
+		printf("BUG (in transaction_table) :: attempt to get transaction status for transaction id, that was truncated (and should have been frozen)\n");
+		exit(-1);
+	}
+
 	// try and fetch it from the disk
 	if(!get_transaction_status_from_table(ttbl, transaction_id, &status))
 	{
@@ -595,18 +1263,33 @@ transaction_status get_transaction_status(transaction_table* ttbl, uint256 trans
 		set_transaction_status_in_table(ttbl, transaction_id, TX_ABORTED, 0); // this operation can be done in just read lock as it is idempotent, and concurrent reads will always eventually get the fixed value, so a flush is not necessary
 		status = TX_ABORTED;
 	}
+	else if(status == TX_IN_PROGRESS) // it is not active, so it has completed, but its status is still waiting in the group_commit_queue to be written
+	{
+		pthread_mutex_lock(&(ttbl->group_commit_lock));
+		int found = find_in_group_commit_queue(ttbl, transaction_id, &status);
+		pthread_mutex_unlock(&(ttbl->group_commit_lock));
+
+		if(!found)
+		{
+			printf("BUG (in transaction_table) :: a completed transaction is neither on the disk nor in the group_commit_queue\n");
+			exit(-1);
+		}
+	}
+
+	// mirror its whole bitmap page if it can be, so that the lookups for the neighbouring transaction_ids do not come here
+	mirror_bucket_if_completed(ttbl, get_bucket_id_for_transaction_id(ttbl, transaction_id));
 
 	read_unlock(&(ttbl->transaction_table_lock));
 
 	// insert a cached copy for it, to next time find it quickly
-	set_transaction_status_in_cache(ttbl, transaction_id, status);
+	insert_in_transaction_status_cache(&(ttbl->transaction_table_cache), transaction_id, status);
 
-	write_unlock(&(ttbl->transaction_table_cache_lock));
+	read_unlock(&(ttbl->transaction_table_cache_lock));
 
 	return status;
 }
 
-int update_transaction_status(transaction_table* ttbl, mvcc_snapshot* snp, transaction_status status)
+int update_transaction_status(transaction_table* ttbl, mvcc_snapshot* snp, transaction_status status, commit_durability durability)
 {
 	// if transaction_id >= overflow_transaction_id, then there is a bug
 	if(snp->has_self_transaction_id && compare_uint256(snp->self_transaction_id, ttbl->overflow_transaction_id) >= 0)
@@ -627,8 +1310,8 @@ int update_transaction_status(transaction_table* ttbl, mvcc_snapshot* snp, trans
 	uint256 transaction_id = snp->self_transaction_id;
 	int is_valid_transaction_id = snp->has_self_transaction_id;
 
-	remove_from_linkedlist(&(ttbl->active_mvcc_snapshots), snp);
-	delete_mvcc_snapshot(snp);
+	// a shared snapshot is only deleted by the last transaction using it
+	release_mvcc_snapshot(ttbl, snp);
 
 	if(!is_valid_transaction_id)
 	{
@@ -645,49 +1328,134 @@ int update_transaction_status(transaction_table* ttbl, mvcc_snapshot* snp, trans
 	}
 	remove_from_currently_active_transaction_ids(ttbl, transaction_id);
 
-	// insert a cached copy for it
-	set_transaction_status_in_cache(ttbl, transaction_id, status);
+	// a transaction completed, so any snapshot taken until now may not see what a new one would
+	ttbl->snapshot_generation++;
 
-	write_lock(&(ttbl->transaction_table_lock), BLOCKING);
+	// insert a cached copy for it
+	insert_in_transaction_status_cache(&(ttbl->transaction_table_cache), transaction_id, status);
 
-	write_unlock(&(ttbl->transaction_table_cache_lock));
+	// asynchronous commits need the async_commit_flusher to eventually make them durable
+	int is_asynchronous = (ttbl->async_commit_flush_period_us > 0) && ((durability == ASYNCHRONOUS_COMMIT) || (durability == DEFAULT_COMMIT && ttbl->is_asynchronous_commit_default));
 
-	// update the actual on-disk transaction table, with flush-ing only if it is meant to commit (so that a crash still thinks of it being committed)
+	// enqueue it to be written to the on-disk transaction table, with flush-ing only if it is meant to commit synchronously (so that a crash still thinks of it being committed)
 	// a transaction abort may fail upon a crash, but it's status after a crash being in-progress still means it is aborted
-	// NOTE: upon getting an undesired behaviour, just make the flush parameter of the below call equal to 1 (making it a bit unoptimized), and hope for the best!!!
-	set_transaction_status_in_table(ttbl, transaction_id, status, (status == TX_COMMITTED));
+	// NOTE: upon getting an undesired behaviour, just make the needs_flush of the below entry equal to 1 (making it a bit unoptimized), and hope for the best!!!
+	// it is enqueued before releasing the transaction_table_cache_lock, so that a reader never finds it neither active, nor in the group_commit_queue, nor on the disk
+	group_commit_entry e = {.transaction_id = transaction_id, .status = status, .needs_flush = (status == TX_COMMITTED && !is_asynchronous), .is_written = 0};
+	initialize_slnode(&(e.embed_node));
 
-	write_unlock(&(ttbl->transaction_table_lock));
+	pthread_mutex_lock(&(ttbl->group_commit_lock));
+	enqueue_for_group_commit(ttbl, &e);
+	pthread_mutex_unlock(&(ttbl->group_commit_lock));
+
+	write_unlock(&(ttbl->transaction_table_cache_lock));
+
+	// wait until it is on the disk, possibly writing it ourselves along with the others enqueued
+	wait_for_group_commit(ttbl, &e);
 
 	return 1;
 }
 
-static void minimize_vaccum_horizon_transaction_id(const void* data, const void* additional_params)
+uint256 get_vaccum_horizon_transaction_id(transaction_table* ttbl)
 {
-	uint256* vaccum_horizon_transaction_id = (uint256*) additional_params;
+	read_lock(&(ttbl->transaction_table_cache_lock), READ_PREFERRING, BLOCKING);
 
-	mvcc_snapshot* snp = (mvcc_snapshot*) data;
+	uint256 vaccum_horizon_transaction_id = get_vaccum_horizon_transaction_id_unlocked(ttbl);
 
-	if(snp->has_self_transaction_id)
-		(*vaccum_horizon_transaction_id) = min_uint256((*vaccum_horizon_transaction_id), snp->self_transaction_id);
+	read_unlock(&(ttbl->transaction_table_cache_lock));
 
-	(*vaccum_horizon_transaction_id) = min_uint256((*vaccum_horizon_transaction_id), snp->least_unassigned_transaction_id);
+	return vaccum_horizon_transaction_id;
+}
 
-	if(NULL != get_in_progress_transaction_ids_for_mvcc_snapshot(snp, 0))
-		(*vaccum_horizon_transaction_id) = min_uint256((*vaccum_horizon_transaction_id), *get_in_progress_transaction_ids_for_mvcc_snapshot(snp, 0));
+uint256 get_durability_horizon_transaction_id(transaction_table* ttbl)
+{
+	read_lock(&(ttbl->transaction_table_cache_lock), READ_PREFERRING, BLOCKING);
+	pthread_mutex_lock(&(ttbl->group_commit_lock));
+
+	// a transaction_id is always either active, in the group_commit_queue, undurable (or flushing), or durable, moving only in that order, so this never decreases
+	uint256 durability_horizon_transaction_id = ttbl->next_assignable_transaction_id;
+
+	const active_transaction_id_entry* atid_p = find_smallest_in_bst(&(ttbl->currently_active_transaction_ids));
+	if(atid_p != NULL)
+		durability_horizon_transaction_id = min_uint256(durability_horizon_transaction_id, atid_p->transaction_id);
+
+	for(const group_commit_entry* e = get_head_of_singlylist(&(ttbl->group_commit_queue)); e != NULL; e = get_next_of_in_singlylist(&(ttbl->group_commit_queue), e))
+		durability_horizon_transaction_id = min_uint256(durability_horizon_transaction_id, e->transaction_id);
+
+	if(ttbl->has_undurable_transaction_ids)
+		durability_horizon_transaction_id = min_uint256(durability_horizon_transaction_id, ttbl->min_undurable_transaction_id);
+	if(ttbl->has_flushing_transaction_ids)
+		durability_horizon_transaction_id = min_uint256(durability_horizon_transaction_id, ttbl->min_flushing_transaction_id);
+
+	pthread_mutex_unlock(&(ttbl->group_commit_lock));
+	read_unlock(&(ttbl->transaction_table_cache_lock));
+
+	return durability_horizon_transaction_id;
 }
 
-uint256 get_vaccum_horizon_transaction_id(transaction_table* ttbl)
+void wait_for_durability_of_transaction_id(transaction_table* ttbl, uint256 transaction_id)
 {
-	uint256 vaccum_horizon_transaction_id;
+	pthread_mutex_lock(&(ttbl->group_commit_lock));
 
+	// woken up by the leader after every batch and by the async_commit_flusher after every flush
+	while(is_undurable_transaction_id(ttbl, transaction_id))
+		pthread_cond_wait(&(ttbl->group_commit_wait), &(ttbl->group_commit_lock));
+
+	pthread_mutex_unlock(&(ttbl->group_commit_lock));
+}
+
+uint256 truncate_transaction_table(transaction_table* ttbl, uint256 frozen_transaction_id)
+{
+	// the transaction_ids at or above the vaccum horizon may still be looked up by the active transactions, even if they were frozen
 	read_lock(&(ttbl->transaction_table_cache_lock), READ_PREFERRING, BLOCKING);
+	uint256 truncation_horizon_transaction_id = min_uint256(frozen_transaction_id, get_vaccum_horizon_transaction_id_unlocked(ttbl));
+	read_unlock(&(ttbl->transaction_table_cache_lock));
 
-	vaccum_horizon_transaction_id = ttbl->next_assignable_transaction_id;
+	// the bitmap page of the transaction_id right below the truncation horizon is kept, so that get_min_unassigned_transaction_id() always finds the last assigned one at boot
+	uint64_t end_bucket_id = 0;
+	if(compare_uint256(truncation_horizon_transaction_id, get_0_uint256()) > 0)
+	{
+		uint256 last_transaction_id;
+		sub_uint256(&last_transaction_id, truncation_horizon_transaction_id, get_uint256(1));
+		end_bucket_id = get_bucket_id_for_transaction_id(ttbl, last_transaction_id);
+	}
 
-	for_each_in_linkedlist(&(ttbl->active_mvcc_snapshots), minimize_vaccum_horizon_transaction_id, &vaccum_horizon_transaction_id);
+	while(1)
+	{
+		// a batch at a time, so that the status lookups from the table are not blocked for long
+		write_lock(&(ttbl->transaction_table_lock), BLOCKING);
 
-	read_unlock(&(ttbl->transaction_table_cache_lock));
+		uint64_t first_bucket_id = get_bucket_id_for_transaction_id(ttbl, ttbl->truncated_transaction_id);
+		if(first_bucket_id >= end_bucket_id)
+		{
+			uint256 truncated_transaction_id = ttbl->truncated_transaction_id;
+			write_unlock(&(ttbl->transaction_table_lock));
+			return truncated_transaction_id;
+		}
 
-	return vaccum_horizon_transaction_id;
+		first_bucket_id = free_bitmap_pages_of_buckets_in_table(ttbl, first_bucket_id, end_bucket_id);
+		mul_uint256(&(ttbl->truncated_transaction_id), get_uint256(first_bucket_id), get_uint256(ttbl->transaction_statuses_per_bitmap_page));
+
+		write_unlock(&(ttbl->transaction_table_lock));
+	}
 }
+
+void deinitialize_transaction_table(transaction_table* ttbl)
+{
+	// the async_commit_flusher flushes the pending asynchronous commits, before it exits
+	if(ttbl->async_commit_flush_period_us > 0)
+	{
+		pthread_mutex_lock(&(ttbl->group_commit_lock));
+		ttbl->stop_async_commit_flusher = 1;
+		pthread_cond_broadcast(&(ttbl->group_commit_wait));
+		pthread_mutex_unlock(&(ttbl->group_commit_lock));
+
+		pthread_join(ttbl->async_commit_flusher, NULL);
+	}
+
+	pthread_mutex_destroy(&(ttbl->group_commit_lock));
+	pthread_cond_destroy(&(ttbl->group_commit_wait));
+
+	deinitialize_transaction_status_page_mirror(&(ttbl->transaction_table_mirror));
+	deinitialize_transaction_status_cache(&(ttbl->transaction_table_cache));
+}
\ No newline at end of file
@@ -125,6 +125,41 @@ int main()
 
 	printf("----------------------------------------------\n\n");
 
+	// force a spill, by shrinking the interim memory budget to what is already in use, and a few pages more
+
+	set_interim_memory_budget(get_interim_memory_in_use() + sysconf(_SC_PAGE_SIZE) * 4);
+
+	interim_tuple_store* spill_its_p = get_new_interim_tuple_store(0);
+	printf("spill_its_p is_in_memory = %d\n\n", spill_its_p->is_in_memory);
+
+	for(int i = 0; i < 4; i++)
+		append_all_tuples(spill_its_p, 1000, (char* []){ROHAN, DVIVEDI, NULL});
+
+	if(spill_its_p->is_in_memory)
+	{
+		printf("TEST FAILED :: spill_its_p did not spill to a temp file, after growing beyond the interim memory budget\n");
+		exit(-1);
+	}
+
+	// the its_p is still in memory, so this copies from a memfd to a temp file, across file systems
+	uint64_t tuples_count_before_append = spill_its_p->tuples_count;
+	append_all_from_another_interim_tuple_store(spill_its_p, its_p);
+	if(spill_its_p->tuples_count != tuples_count_before_append + its_p->tuples_count)
+	{
+		printf("TEST FAILED :: appending all from an in memory interim_tuple_store to a spilled one, lost tuples\n");
+		exit(-1);
+	}
+
+	printf("----------------------------------------------\n\n");
+
+	print_all_tuples(spill_its_p);
+
+	printf("----------------------------------------------\n\n");
+
+	delete_interim_tuple_store(spill_its_p);
+
+	set_interim_memory_budget(DEFAULT_INTERIM_MEMORY_BUDGET);
+
 	// deinit start
 
 	delete_interim_tuple_store(its_p);
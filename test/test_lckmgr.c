@@ -1,9 +1,16 @@
 #include<rhendb/rhendb.h>
 
 #include<stdlib.h>
+#include<pthread.h>
+#include<time.h>
+#include<unistd.h>
 
 #define USERS_COUNT 10
 
+#define BENCHMARK_MAX_THREADS 8
+#define BENCHMARK_ACQUIRES_PER_THREAD 1000000
+#define BENCHMARK_RESOURCES_PER_THREAD 64
+
 void get_lock_mode(lock_manager* lckmgr_p, uintptr_t transaction_id, uintptr_t task_id, uint32_t resource_type, uint64_t resource_id)
 {
 	printf("<-get_lock_mode( trx_id = %"PRIuPTR" , task_id = %"PRIuPTR" , r_type = %"PRIu32" , r_id = %"PRIu64" )\n\n", transaction_id, task_id, resource_type, resource_id);
@@ -54,6 +61,111 @@ void conclude_all_business(lock_manager* lckmgr_p, uintptr_t transaction_id)
 	printf("-> POSSIBLY_CONCLUDED\n\n");
 }
 
+// resource_id of a tuple lock, its prefixes being the resource_id-s of its partition and its table
+typedef struct tuple_resource_id tuple_resource_id;
+struct tuple_resource_id
+{
+	uint64_t table_id;
+	uint64_t partition_id;
+	uint64_t tuple_pointer;
+};
+
+void acquire_tuple_lock(lock_manager* lckmgr_p, uintptr_t transaction_id, uint32_t resource_type, uint64_t table_id, uint64_t partition_id, uint64_t tuple_pointer, uint32_t new_lock_mode, int non_blocking)
+{
+	printf("<-acquire_tuple_lock( trx_id = %"PRIuPTR" , r_type = %"PRIu32" , r_id = %"PRIu64":%"PRIu64":%"PRIu64", %s , %s )\n\n", transaction_id, resource_type, table_id, partition_id, tuple_pointer, ((new_lock_mode == 0) ? "READ" : "WRITE"), ((non_blocking) ? "NON_BLOCKING" : "BLOCKING"));
+	tuple_resource_id resource_id = {table_id, partition_id, tuple_pointer};
+	lock_result res = acquire_lock_with_lock_manager(lckmgr_p, (void*)transaction_id, (void*)transaction_id, resource_type, (uint8_t*)(&resource_id), sizeof(tuple_resource_id), new_lock_mode, non_blocking);
+	printf("-> %s\n\n", lock_result_strings[res]);
+}
+
+typedef struct benchmark_params benchmark_params;
+struct benchmark_params
+{
+	rhendb* rdb;
+	uint32_t resource_type;
+	uintptr_t transaction_id;
+	uint64_t slow_path_count;
+};
+
+// each thread locks its own resources, so there are no conflicts, and all of them together hold far fewer than MAX_IN_MEMORY_LOCK_ENTRIES, so every lock must be taken on the fast path
+void* benchmark_thread(void* param)
+{
+	benchmark_params* bp = param;
+	lock_manager* lckmgr_p = &(bp->rdb->lck_table);
+
+	for(uint64_t i = 0; i < BENCHMARK_ACQUIRES_PER_THREAD; i++)
+	{
+		uint64_t resource_id = (((uint64_t)(bp->transaction_id)) << 32) | (i % BENCHMARK_RESOURCES_PER_THREAD);
+		uint32_t lock_mode = (i % 2) ? RW_DB_LOCK_W_MODE : RW_DB_LOCK_R_MODE;
+
+		lock_result res;
+		if(!try_fast_acquire_lock_with_lock_manager(lckmgr_p, (void*)(bp->transaction_id), bp->resource_type, (uint8_t*)(&resource_id), sizeof(uint64_t), lock_mode, &res))
+		{
+			pthread_mutex_lock(&(bp->rdb->lock_manager_external_lock));
+			res = acquire_lock_with_lock_manager(lckmgr_p, (void*)(bp->transaction_id), (void*)(bp->transaction_id), bp->resource_type, (uint8_t*)(&resource_id), sizeof(uint64_t), lock_mode, 1);
+			pthread_mutex_unlock(&(bp->rdb->lock_manager_external_lock));
+			bp->slow_path_count++;
+		}
+
+		if(res == LOCKING_FAILED)
+		{
+			printf("benchmark thread %"PRIuPTR" failed to acquire lock on %"PRIu64"\n", bp->transaction_id, resource_id);
+			exit(-1);
+		}
+
+		if(!try_fast_release_lock_with_lock_manager(lckmgr_p, (void*)(bp->transaction_id), bp->resource_type, (uint8_t*)(&resource_id), sizeof(uint64_t)))
+		{
+			pthread_mutex_lock(&(bp->rdb->lock_manager_external_lock));
+			release_lock_with_lock_manager(lckmgr_p, (void*)(bp->transaction_id), (void*)(bp->transaction_id), bp->resource_type, (uint8_t*)(&resource_id), sizeof(uint64_t));
+			pthread_mutex_unlock(&(bp->rdb->lock_manager_external_lock));
+			bp->slow_path_count++;
+		}
+	}
+
+	return NULL;
+}
+
+void benchmark_lock_manager(rhendb* rdb, uint32_t resource_type, uint32_t threads_count)
+{
+	pthread_t threads[BENCHMARK_MAX_THREADS];
+	benchmark_params params[BENCHMARK_MAX_THREADS];
+
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for(uint32_t t = 0; t < threads_count; t++)
+	{
+		params[t] = (benchmark_params){.rdb = rdb, .resource_type = resource_type, .transaction_id = 1000 + t, .slow_path_count = 0};
+		pthread_create(&(threads[t]), NULL, benchmark_thread, &(params[t]));
+	}
+
+	uint64_t slow_path_count = 0;
+	for(uint32_t t = 0; t < threads_count; t++)
+	{
+		pthread_join(threads[t], NULL);
+		slow_path_count += params[t].slow_path_count;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1000000000.0;
+	uint64_t acquires_count = ((uint64_t)threads_count) * BENCHMARK_ACQUIRES_PER_THREAD;
+	printf("threads = %"PRIu32" : %"PRIu64" acquires in %lf seconds -> %lf acquires/sec (%"PRIu64" on the slow path)\n", threads_count, acquires_count, seconds, acquires_count / seconds, slow_path_count);
+
+	if(slow_path_count != 0)
+	{
+		printf("TEST FAILED :: %"PRIu64" conflict free acquires/releases fell back to the slow path\n", slow_path_count);
+		exit(-1);
+	}
+
+	for(uint32_t t = 0; t < threads_count; t++)
+	{
+		pthread_mutex_lock(&(rdb->lock_manager_external_lock));
+		conclude_all_business_with_lock_manager(&(rdb->lck_table), (void*)(params[t].transaction_id));
+		pthread_mutex_unlock(&(rdb->lock_manager_external_lock));
+	}
+}
+
 int main()
 {
 	rhendb rdb;
@@ -62,8 +174,11 @@ int main()
 		512, 8, 80, 80,
 			10000ULL, 100000ULL,
 			10000000ULL,
+			100ULL, 64,
+			0, 10000ULL,
 		4096,
 			10000000ULL,
+		100000ULL,
 		USERS_COUNT);
 	printf("database initialized\n\n");
 
@@ -129,6 +244,65 @@ int main()
 
 	debug_print_lock_manager_tables(&(rdb.lck_table));
 
+	printf("testing lock escalation\n\n");
+
+	uint32_t TABLE_RESOURCE_TYPE = register_lock_type_with_lock_manager(&(rdb.lck_table), HIERARCHICAL_DB_LOCK);
+	uint32_t PARTITION_RESOURCE_TYPE = register_lock_type_with_lock_manager(&(rdb.lck_table), HIERARCHICAL_DB_LOCK);
+	uint32_t TUPLE_RESOURCE_TYPE = register_lock_type_with_lock_manager(&(rdb.lck_table), RW_DB_LOCK);
+	set_parent_for_lock_type_with_lock_manager(&(rdb.lck_table), PARTITION_RESOURCE_TYPE, TABLE_RESOURCE_TYPE, sizeof(uint64_t), 0);
+	set_parent_for_lock_type_with_lock_manager(&(rdb.lck_table), TUPLE_RESOURCE_TYPE, PARTITION_RESOURCE_TYPE, 2 * sizeof(uint64_t), 4);
+
+	// transaction 5 reads a tuple of partition 1, and then updates more than 4 tuples of partition 0, escalating them to a X lock on partition 0
+	acquire_tuple_lock(&(rdb.lck_table), 5, TUPLE_RESOURCE_TYPE, 7, 1, 100, RW_DB_LOCK_R_MODE, 1);
+	for(uint64_t tuple_pointer = 0; tuple_pointer < 5; tuple_pointer++)
+		acquire_tuple_lock(&(rdb.lck_table), 5, TUPLE_RESOURCE_TYPE, 7, 0, tuple_pointer, RW_DB_LOCK_W_MODE, 1);
+
+	debug_print_lock_manager_tables(&(rdb.lck_table));
+
+	// the tuples of partition 0 are now covered by the escalated lock
+	acquire_tuple_lock(&(rdb.lck_table), 5, TUPLE_RESOURCE_TYPE, 7, 0, 55, RW_DB_LOCK_W_MODE, 1);
+
+	// transaction 6 can not read any tuple of partition 0, but it can read the tuples of partition 1
+	acquire_tuple_lock(&(rdb.lck_table), 6, TUPLE_RESOURCE_TYPE, 7, 0, 200, RW_DB_LOCK_R_MODE, 1);
+	acquire_tuple_lock(&(rdb.lck_table), 6, TUPLE_RESOURCE_TYPE, 7, 1, 100, RW_DB_LOCK_R_MODE, 1);
+
+	// transaction 6 reads more than 4 tuples of partition 1, escalating them to a S lock on partition 1, which is compatible with the read lock of transaction 5
+	for(uint64_t tuple_pointer = 101; tuple_pointer < 105; tuple_pointer++)
+		acquire_tuple_lock(&(rdb.lck_table), 6, TUPLE_RESOURCE_TYPE, 7, 1, tuple_pointer, RW_DB_LOCK_R_MODE, 1);
+
+	debug_print_lock_manager_tables(&(rdb.lck_table));
+
+	conclude_all_business(&(rdb.lck_table), 5);
+	conclude_all_business(&(rdb.lck_table), 6);
+
+	debug_print_lock_manager_tables(&(rdb.lck_table));
+
+	// transactions 8 and 9 wait for each other, the deadlock_detector must notify the younger one i.e. 9
+	acquire_lock(&(rdb.lck_table), 8, 0, RESOURCE_TYPE_0, 80, RW_DB_LOCK_W_MODE, 0);
+	acquire_lock(&(rdb.lck_table), 9, 0, RESOURCE_TYPE_0, 90, RW_DB_LOCK_W_MODE, 0);
+	acquire_lock(&(rdb.lck_table), 8, 0, RESOURCE_TYPE_0, 90, RW_DB_LOCK_W_MODE, 0);
+	acquire_lock(&(rdb.lck_table), 9, 0, RESOURCE_TYPE_0, 80, RW_DB_LOCK_W_MODE, 0);
+
+	// wait for a few deadlock detection periods
+	usleep(500000);
+
+	{
+		deadlock_detector_stats dd_stats = get_deadlock_detector_stats_from_lock_manager(&(rdb.lck_table));
+		printf("deadlock_detector : runs = %"PRIu64", deadlocks = %"PRIu64", stale_cycles = %"PRIu64", max_latency = %"PRIu64" us, last_run_wait_edges = %"PRIu64", last_run_duration = %"PRIu64" us\n\n", dd_stats.detection_runs_count, dd_stats.deadlocks_count, dd_stats.stale_cycles_count, dd_stats.max_detection_latency_us, dd_stats.last_run_wait_edges_count, dd_stats.last_run_duration_us);
+	}
+
+	conclude_all_business(&(rdb.lck_table), 9);
+	conclude_all_business(&(rdb.lck_table), 8);
+
+	debug_print_lock_manager_tables(&(rdb.lck_table));
+
+	printf("benchmarking lock manager\n\n");
+	for(uint32_t threads_count = 1; threads_count <= BENCHMARK_MAX_THREADS; threads_count *= 2)
+		benchmark_lock_manager(&rdb, RESOURCE_TYPE_0, threads_count);
+	printf("\n");
+
+	debug_print_lock_manager_tables(&(rdb.lck_table));
+
 	deinitialize_rhendb(&rdb);
 
 	return 0;
@@ -183,6 +183,32 @@ int main()
 			}
 		}
 
+		// the least in progress transaction_id of the snapshot, is the vaccum horizon, if it were the only snapshot
+		uint256 vaccum_horizon_transaction_id = get_uint256(7);
+
+		for(uint32_t xmin_i = 0; xmin_i < header_ids_count; xmin_i++)
+		{
+			for(uint32_t xmax_i = 0; xmax_i < header_ids_count; xmax_i++)
+			{
+				mvcc_header hdr = {.is_xmin_NULL = are_equal_uint256(header_ids[xmin_i].transaction_id, get_uint256(0)), .xmin = header_ids[xmin_i], .is_xmax_NULL = are_equal_uint256(header_ids[xmax_i].transaction_id, get_uint256(0)), .xmax = header_ids[xmax_i]};
+				int were_hints_updated = 0;
+				int can_vaccum = can_vaccum_tuple_for_mvcc(&hdr, &tsg, vaccum_horizon_transaction_id, &were_hints_updated);
+				int was_frozen = (!can_vaccum) && freeze_tuple_for_mvcc(&hdr, &tsg, vaccum_horizon_transaction_id, &were_hints_updated);
+				print_mvcc_header(&hdr);printf("\n\n");
+				printf("can_vaccum=%d was_frozen=%d is_visible_after=%d\n\n\n", can_vaccum, was_frozen, is_tuple_visible_to_mvcc_snapshot(snap, &hdr, &tsg, &were_hints_updated));
+
+				// a NULL xmin or an aborted xmin (5, 600 and 805), or an xmax committed below the vaccum horizon (1), makes the tuple vaccummable
+				int expected_can_vaccum = (xmin_i == 9) || (xmin_i == 1) || (xmin_i == 5) || (xmin_i == 8) || (xmax_i == 0);
+				// else it gets frozen, for an xmin committed below the vaccum horizon (1), or an xmax aborted below it (5)
+				int expected_was_frozen = (!expected_can_vaccum) && ((xmin_i == 0) || (xmax_i == 1));
+				if(can_vaccum != expected_can_vaccum || was_frozen != expected_was_frozen)
+				{
+					printf("TEST FAILED :: expected can_vaccum=%d was_frozen=%d\n", expected_can_vaccum, expected_was_frozen);
+					exit(-1);
+				}
+			}
+		}
+
 		delete_mvcc_snapshot(snap);
 	}
 
@@ -269,8 +269,11 @@ int main()
 		512, 8, 80, 80,
 			10000ULL, 100000ULL,
 			10000000ULL,
+			100ULL, 64,
+			0, 10000ULL,
 		4096,
 			60000000ULL,
+		100000ULL,
 		USERS_COUNT);
 	printf("database initialized\n\n");
 
@@ -21,8 +21,11 @@ int main()
 		512, 8, 80, 80,
 			10000ULL, 100000ULL,
 			10000000ULL,
+			100ULL, 64,
+			0, 10000ULL,
 		4096,
 			10000000ULL,
+		100000ULL,
 		USERS_COUNT);
 
 	mvcc_snapshot* t1 = get_new_transaction_id(&(rdb.tx_table), NULL);
@@ -40,7 +43,7 @@ int main()
 	print_vaccum_horizon_transaction_id(&(rdb.tx_table));printf("\n\n\n");
 
 	printf("ABORTING : %"PRIu64"\n\n\n", t2->self_transaction_id.limbs[0]);
-	update_transaction_status(&(rdb.tx_table), t2, TX_ABORTED);
+	update_transaction_status(&(rdb.tx_table), t2, TX_ABORTED, DEFAULT_COMMIT);
 	print_vaccum_horizon_transaction_id(&(rdb.tx_table));printf("\n\n\n");
 
 	t1 = get_or_revise_mvcc_snapshot(&(rdb.tx_table), t1);
@@ -56,7 +59,7 @@ int main()
 	print_vaccum_horizon_transaction_id(&(rdb.tx_table));printf("\n\n\n");
 
 	printf("COMMITTING : %"PRIu64"\n\n\n", t3->self_transaction_id.limbs[0]);
-	update_transaction_status(&(rdb.tx_table), t3, TX_COMMITTED);
+	update_transaction_status(&(rdb.tx_table), t3, TX_COMMITTED, DEFAULT_COMMIT);
 	print_vaccum_horizon_transaction_id(&(rdb.tx_table));printf("\n\n\n");
 
 	mvcc_snapshot* t5 = get_or_revise_mvcc_snapshot(&(rdb.tx_table), NULL);
@@ -66,7 +69,7 @@ int main()
 	print_vaccum_horizon_transaction_id(&(rdb.tx_table));printf("\n\n\n");
 
 	printf("ABORTING : %"PRIu64"\n\n\n", t1->self_transaction_id.limbs[0]);
-	update_transaction_status(&(rdb.tx_table), t1, TX_ABORTED);
+	update_transaction_status(&(rdb.tx_table), t1, TX_ABORTED, DEFAULT_COMMIT);
 	print_vaccum_horizon_transaction_id(&(rdb.tx_table));printf("\n\n\n");
 
 	t4 = get_or_revise_mvcc_snapshot(&(rdb.tx_table), t4);
@@ -0,0 +1,330 @@
+#include<rhendb/rhendb.h>
+
+#include<rhendb/transaction.h>
+#include<rhendb/operators.h>
+#include<rhendb/tuple_transformers.h>
+
+#include<tupleindexer/utils/heap_table_accumulative_notifier.h>
+
+#include<stdlib.h>
+#include<unistd.h>
+
+#define USERS_COUNT 10
+
+#define ROWS_COUNT 300
+
+// every row whose key is a multiple of 3 is deleted, and then vaccummed
+#define IS_TO_BE_DELETED(key) (((key) % 3) == 0)
+#define DELETED_ROWS_COUNT ((ROWS_COUNT + 2) / 3)
+#define LIVE_ROWS_COUNT (ROWS_COUNT - DELETED_ROWS_COUNT)
+
+data_type_info* record_type_info;
+tuple_def record_def;
+
+void initialize_tuple_defs()
+{
+	record_type_info = malloc(sizeof_tuple_data_type_info(2));
+	initialize_tuple_data_type_info(record_type_info, "record", 0, 100, 2);
+
+	strcpy(record_type_info->containees[0].field_name, "key");
+	record_type_info->containees[0].al.type_info = UINT_NON_NULLABLE[8];
+
+	strcpy(record_type_info->containees[1].field_name, "value");
+	record_type_info->containees[1].al.type_info = UINT_NON_NULLABLE[8];
+
+	initialize_tuple_def(&record_def, record_type_info);
+
+	print_tuple_def(&record_def);
+	printf("\n\n");
+}
+
+void deinitialize_tuple_defs()
+{
+	free(record_type_info);
+}
+
+rhendb_attribute table_attributes[] = {
+	{.attribute_name = "key", .base_type = RHENDB_UINT, .size = 8},
+	{.attribute_name = "value", .base_type = RHENDB_UINT, .size = 8},
+};
+
+positional_accessor insertion_accessors[] = {
+	STATIC_POSITION(0),
+	STATIC_POSITION(1),
+};
+
+// the scans output (partition_id, tuple_pointer, heap_tuple), and the heap_tuple has the mvcc_header at position 0 followed by the columns
+#define SCAN_OUTPUT_FLAGS (PARTITION_ID_IN_OUTPUT | TUPLE_POINTER_IN_OUTPUT | HEAP_TUPLE_IN_OUTPUT)
+positional_accessor partition_id_accessor = STATIC_POSITION(0);
+positional_accessor tuple_pointer_accessor = STATIC_POSITION(1);
+positional_accessor key_accessor = STATIC_POSITION(2, 1);
+positional_accessor value_accessor = STATIC_POSITION(2, 2);
+
+void* generator(void* generator_context, const tuple_def* generator_tuple_def)
+{
+	uint64_t* generator_number = generator_context;
+
+	if((*generator_number) >= ROWS_COUNT)
+		return NULL;
+
+	void* generated = malloc(get_maximum_tuple_size(generator_tuple_def));
+
+	init_tuple(generator_tuple_def, generated);
+	set_element_in_tuple(generator_tuple_def, STATIC_POSITION(0), generated, &(datum){.uint_value = (*generator_number)}, UINT32_MAX);
+	set_element_in_tuple(generator_tuple_def, STATIC_POSITION(1), generated, &(datum){.uint_value = (*generator_number) * (*generator_number)}, UINT32_MAX);
+
+	(*generator_number)++;
+	return generated;
+}
+
+static void destroy_NOP(tuple_transformer* tt_p){}
+
+static void* process_to_be_deleted(tuple_transformer* tt_p, void* tuple)
+{
+	datum key;
+	get_value_from_element_from_tuple(&key, tt_p->input_def, key_accessor, tuple);
+	if(IS_TO_BE_DELETED(key.uint_value))
+		return tuple;
+	else
+		return NULL;
+}
+
+typedef struct visible_rows visible_rows;
+struct visible_rows
+{
+	uint64_t count;
+	int seen[ROWS_COUNT];
+};
+
+int check_visible_row_consumer(void* consumer_context, const void* tuple, const tuple_def* input_tuple_def)
+{
+	visible_rows* vr = consumer_context;
+
+	datum key;
+	datum value;
+	get_value_from_element_from_tuple(&key, input_tuple_def, key_accessor, tuple);
+	get_value_from_element_from_tuple(&value, input_tuple_def, value_accessor, tuple);
+
+	if(key.uint_value >= ROWS_COUNT || IS_TO_BE_DELETED(key.uint_value) || vr->seen[key.uint_value] || value.uint_value != key.uint_value * key.uint_value)
+	{
+		printf("TEST FAILED :: unexpected visible row : ");
+		print_tuple(tuple, input_tuple_def);
+		printf("\n");
+		exit(-1);
+	}
+
+	vr->seen[key.uint_value] = 1;
+	vr->count++;
+
+	return 1;
+}
+
+void run_query_plan(query_plan* qp)
+{
+	start_all_operators_for_query_plan(qp);
+
+	wait_for_shutdown_of_query_plan(qp);
+
+	dstring kill_reasons = new_dstring("", 0);
+	destroy_query_plan(qp, &kill_reasons);
+
+	printf("KILL REASONS : \n");
+	printf_dstring(&kill_reasons);
+	deinit_dstring(&kill_reasons);
+	printf("\nKILL REASONS END\n\n");
+}
+
+void commit_transaction(transaction* tx)
+{
+	update_transaction_status(&(tx->rdb->tx_table), tx->snapshot, TX_COMMITTED, DEFAULT_COMMIT);
+	tx->snapshot = NULL;
+	tx->transaction_id = NULL;
+}
+
+int main()
+{
+	rhendb rdb;
+	initialize_rhendb(&rdb, "./test.db",
+		5,
+		512, 8, 80, 80,
+			10000ULL, 100000ULL,
+			10000000ULL,
+			100ULL, 64,
+			0, 10000ULL,
+		4096,
+			10000000ULL,
+		100000ULL,
+		USERS_COUNT);
+	printf("database initialized\n\n");
+
+	initialize_tuple_defs();
+
+	transaction tx = initialize_transaction(&rdb);
+
+	char table_name[64] = {};
+	snprintf(table_name, sizeof(table_name), "vaccum_test_%d", (int)getpid());
+
+	// create the table, in a transaction of its own
+	{
+		tx.snapshot = get_new_transaction_id(&(rdb.tx_table), NULL);
+		tx.transaction_id = &(tx.snapshot->self_transaction_id);
+
+		if(create_table(&(rdb.cat_mgr), tx.snapshot, table_name, table_attributes, sizeof(table_attributes)/sizeof(rhendb_attribute)) == 0)
+		{
+			printf("TEST FAILED :: could not create table %s\n", table_name);
+			exit(-1);
+		}
+
+		commit_transaction(&tx);
+	}
+
+	// insert all the rows, and commit
+	tx.snapshot = get_new_transaction_id(&(rdb.tx_table), NULL);
+	tx.transaction_id = &(tx.snapshot->self_transaction_id);
+
+	fetched_table* ftabl = fetch_table_from_catalog_manager(&(rdb.cat_mgr), tx.snapshot, table_name, 0);
+	if(ftabl == NULL)
+	{
+		printf("TEST FAILED :: could not fetch table %s\n", table_name);
+		exit(-1);
+	}
+
+	{
+		uint64_t generator_number = 0;
+		heap_table_accumulative_notifier global_heap_htan;
+		initialize_heap_table_accumulative_notifier(&global_heap_htan, 64);
+
+		query_plan* qp = get_new_query_plan(&tx, 2);
+
+		operator* g = get_new_registered_operator_for_query_plan(qp);
+		setup_generator_operator(g, generator, &generator_number, &record_def);
+
+		operator* ins = get_new_registered_operator_for_query_plan(qp);
+		setup_insertion_operator(ins, g, insertion_accessors, ftabl, 0, &HEAP_TABLE_ACCUMULATIVE_NOTIFIER(&global_heap_htan), 0);
+
+		run_query_plan(qp);
+
+		deinitialize_heap_table_accumulative_notifier(&global_heap_htan);
+
+		if(generator_number != ROWS_COUNT)
+		{
+			printf("TEST FAILED :: generated only %"PRIu64" rows\n", generator_number);
+			exit(-1);
+		}
+
+		commit_transaction(&tx);
+	}
+	printf("inserted %d rows\n\n", ROWS_COUNT);
+
+	// delete every row with a key multiple of 3, and commit
+	{
+		tx.snapshot = get_new_transaction_id(&(rdb.tx_table), NULL);
+		tx.transaction_id = &(tx.snapshot->self_transaction_id);
+
+		query_plan* qp = get_new_query_plan(&tx, 2);
+
+		operator* s = get_new_registered_operator_for_query_plan(qp);
+		setup_scan_operator(s, qp, ftabl, 4, SCAN_OUTPUT_FLAGS, 0);
+		append_tuple_transformer(&(s->output_tuple_transformers), get_new_tuple_transformer(NULL, get_tuple_def_for_tuples_to_be_consumed_from(s), get_tuple_def_for_tuples_to_be_consumed_from(s), process_to_be_deleted, destroy_NOP));
+
+		operator* d = get_new_registered_operator_for_query_plan(qp);
+		setup_deletion_operator(d, s, &partition_id_accessor, &tuple_pointer_accessor, ftabl, 64, 0, 0);
+
+		run_query_plan(qp);
+
+		commit_transaction(&tx);
+	}
+	printf("deleted %d rows\n\n", DELETED_ROWS_COUNT);
+
+	// vaccum the table, no transaction is active, so the vaccum horizon is above the deleting transaction
+	{
+		tx.snapshot = get_or_revise_mvcc_snapshot(&(rdb.tx_table), NULL);
+
+		query_plan* qp = get_new_query_plan(&tx, 1);
+
+		operator* v = get_new_registered_operator_for_query_plan(qp);
+		setup_vaccum_operator(v, qp, ftabl, 4);
+
+		start_all_operators_for_query_plan(qp);
+		wait_for_shutdown_of_query_plan(qp);
+
+		vaccum_metrics vm = get_metrics_for_vaccum_operator(v);
+		printf("partitions_vaccummed_count = %"PRIu64"\n", vm.partitions_vaccummed_count);
+		printf("heap_pages_scanned_count = %"PRIu64"\n", vm.heap_pages_scanned_count);
+		printf("heap_pages_vaccummed_count = %"PRIu64"\n", vm.heap_pages_vaccummed_count);
+		printf("heap_pages_skipped_count = %"PRIu64"\n", vm.heap_pages_skipped_count);
+		printf("tuples_vaccummed_count = %"PRIu64"\n", vm.tuples_vaccummed_count);
+		printf("tuples_frozen_count = %"PRIu64"\n", vm.tuples_frozen_count);
+		printf("blobs_discarded_count = %"PRIu64"\n", vm.blobs_discarded_count);
+		printf("unused_space_entries_fixed_count = %"PRIu64"\n\n", vm.unused_space_entries_fixed_count);
+
+		dstring kill_reasons = new_dstring("", 0);
+		destroy_query_plan(qp, &kill_reasons);
+		printf("KILL REASONS : \n");
+		printf_dstring(&kill_reasons);
+		deinit_dstring(&kill_reasons);
+		printf("\nKILL REASONS END\n\n");
+
+		update_transaction_status(&(rdb.tx_table), tx.snapshot, TX_COMMITTED, DEFAULT_COMMIT);
+		tx.snapshot = NULL;
+
+		if(vm.partitions_vaccummed_count != ftabl->partitions_count || vm.heap_pages_skipped_count != 0)
+		{
+			printf("TEST FAILED :: vaccum did not complete for all the partitions\n");
+			exit(-1);
+		}
+
+		if(vm.tuples_vaccummed_count != DELETED_ROWS_COUNT)
+		{
+			printf("TEST FAILED :: expected %d tuples vaccummed\n", DELETED_ROWS_COUNT);
+			exit(-1);
+		}
+
+		// the inserting transaction committed below the vaccum horizon, so every live tuple gets its xmin frozen
+		if(vm.tuples_frozen_count != LIVE_ROWS_COUNT)
+		{
+			printf("TEST FAILED :: expected %d tuples frozen\n", LIVE_ROWS_COUNT);
+			exit(-1);
+		}
+	}
+
+	// scan again with a new snapshot, only the live rows must be visible, each exactly once
+	{
+		visible_rows* vr = calloc(1, sizeof(visible_rows));
+
+		tx.snapshot = get_or_revise_mvcc_snapshot(&(rdb.tx_table), NULL);
+
+		query_plan* qp = get_new_query_plan(&tx, 2);
+
+		operator* s = get_new_registered_operator_for_query_plan(qp);
+		setup_scan_operator(s, qp, ftabl, 4, SCAN_OUTPUT_FLAGS, 0);
+
+		operator* c = get_new_registered_operator_for_query_plan(qp);
+		setup_consumer_operator(c, s, check_visible_row_consumer, vr);
+
+		run_query_plan(qp);
+
+		update_transaction_status(&(rdb.tx_table), tx.snapshot, TX_COMMITTED, DEFAULT_COMMIT);
+		tx.snapshot = NULL;
+
+		if(vr->count != LIVE_ROWS_COUNT)
+		{
+			printf("TEST FAILED :: expected %d visible rows, found %"PRIu64"\n", LIVE_ROWS_COUNT, vr->count);
+			exit(-1);
+		}
+
+		free(vr);
+	}
+
+	destroy_fetched_table(ftabl);
+
+	deinitialize_transaction(&tx);
+
+	deinitialize_tuple_defs();
+
+	deinitialize_rhendb(&rdb);
+
+	printf("TEST COMPLETED\n");
+
+	return 0;
+}